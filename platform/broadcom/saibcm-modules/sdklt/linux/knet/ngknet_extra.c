@@ -43,6 +43,10 @@
 #include <linux/delay.h>
 #include <linux/bitops.h>
 #include <linux/time.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/percpu.h>
+#include <linux/math64.h>
 
 #include <lkm/ngknet_dev.h>
 #include <bcmcnet/bcmcnet_core.h>
@@ -50,8 +54,17 @@
 #include "ngknet_extra.h"
 #include "ngknet_callback.h"
 
-/*! Defalut Rx tick for Rx rate limit control. */
-#define NGKNET_EXTRA_RATE_LIMIT_DEFAULT_RX_TICK 10
+/*! Rx rate limit burst in 1/N second of the rate. */
+#define NGKNET_EXTRA_RATE_LIMIT_BURST_DIV 10
+
+/*! Maximum refill interval for Rx rate limit in nanoseconds. */
+#define NGKNET_EXTRA_RATE_LIMIT_MAX_REFILL_NS NSEC_PER_SEC
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,16,0)
+#define NGKNET_EXTRA_RATE_LIMIT_HRTIMER_MODE HRTIMER_MODE_REL_SOFT
+#else
+#define NGKNET_EXTRA_RATE_LIMIT_HRTIMER_MODE HRTIMER_MODE_REL
+#endif
 
 static struct ngknet_rl_ctrl rl_ctrl;
 
@@ -428,100 +441,316 @@ ngknet_rx_pkt_filter(struct ngknet_dev *dev, struct sk_buff *skb, struct net_dev
 }
 
 static void
-ngknet_rl_process(timer_context_t data)
+ngknet_rl_bucket_config(struct ngknet_rl_bucket *rb, int rate)
 {
-    struct ngknet_rl_ctrl *rc = timer_arg(rc, data, timer);
-    struct ngknet_dev *dev;
-    unsigned long flags;
-    int idx;
-
-    spin_lock_irqsave(&rc->lock, flags);
-    rc->rx_pkts = 0;
-    for (idx = 0; idx < NUM_PDMA_DEV_MAX; idx++) {
-        dev = &rc->devs[idx];
-        if (rc->dev_active[idx] && rc->dev_paused[idx]) {
-            bcmcnet_pdma_dev_rx_resume(&dev->pdma_dev);
-            rl_ctrl.dev_paused[dev->dev_info.dev_no] = 0;
+    int burst;
+
+    if (rate == rb->rate) {
+        return;
+    }
+
+    burst = rate / NGKNET_EXTRA_RATE_LIMIT_BURST_DIV;
+    rb->burst = burst > 0 ? burst : 1;
+    atomic_set(&rb->tokens, rb->burst);
+    atomic64_set(&rb->refill_ns, ktime_get_ns());
+    /* Publish the burst and tokens before the rate enables the bucket */
+    smp_wmb();
+    WRITE_ONCE(rb->rate, rate);
+}
+
+static void
+ngknet_rl_bucket_refill(struct ngknet_rl_bucket *rb, int rate)
+{
+    uint64_t now = ktime_get_ns();
+    uint64_t last = atomic64_read(&rb->refill_ns);
+    uint64_t elapsed = now - last;
+    uint64_t add;
+    int tokens;
+
+    if ((int64_t)(now - last) <= 0) {
+        return;
+    }
+    if (elapsed > NGKNET_EXTRA_RATE_LIMIT_MAX_REFILL_NS) {
+        elapsed = NGKNET_EXTRA_RATE_LIMIT_MAX_REFILL_NS;
+    }
+    add = div_u64(elapsed * rate, NSEC_PER_SEC);
+    if (!add) {
+        return;
+    }
+
+    /* Only the winner of the timestamp update adds the tokens */
+    if (atomic64_cmpxchg(&rb->refill_ns, last, now) != last) {
+        return;
+    }
+
+    do {
+        tokens = atomic_read(&rb->tokens);
+        if (tokens >= rb->burst) {
+            break;
+        }
+    } while (atomic_cmpxchg(&rb->tokens, tokens,
+                            min_t(uint64_t, tokens + add, rb->burst)) != tokens);
+}
+
+/*
+ * A queue may be held paused by its own bucket and by the device bucket.
+ * Each side clears its own flag and then resumes only if the other side
+ * holds no pause, so the last one to release the queue resumes it. The
+ * barriers make sure at least one side sees both flags cleared.
+ */
+static void
+ngknet_rl_resume(struct ngknet_rl_bucket *rb)
+{
+    struct ngknet_dev *dev = rb->dev;
+    int di = dev->dev_info.dev_no;
+    int qi;
+
+    clear_bit(0, &rb->paused);
+    smp_mb__after_atomic();
+
+    if (!rl_ctrl.dev_active[di]) {
+        return;
+    }
+
+    if (rb->queue < 0) {
+        for (qi = 0; qi < (int)dev->pdma_dev.ctrl.nb_rxq && qi < NUM_Q_MAX; qi++) {
+            if (!test_bit(0, &rl_ctrl.rxq_rl[di][qi].paused)) {
+                dev->pdma_dev.ops->rx_queue_resume(&dev->pdma_dev, qi);
+            }
         }
+    } else if (!test_bit(0, &rl_ctrl.dev_rl[di].paused)) {
+        dev->pdma_dev.ops->rx_queue_resume(&dev->pdma_dev, rb->queue);
     }
-    spin_unlock_irqrestore(&rc->lock, flags);
+}
+
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4,16,0)
+/*
+ * Without soft hrtimers the callback runs in hard-IRQ context, while the
+ * resume ops may go through register access hooks of the device, so hand
+ * the resume off to a tasklet.
+ */
+static void
+ngknet_rl_resume_task(unsigned long data)
+{
+    ngknet_rl_resume((struct ngknet_rl_bucket *)data);
+}
+#endif
+
+static enum hrtimer_restart
+ngknet_rl_process(struct hrtimer *timer)
+{
+    struct ngknet_rl_bucket *rb = container_of(timer, struct ngknet_rl_bucket, timer);
+
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4,16,0)
+    tasklet_schedule(&rb->resume_task);
+#else
+    ngknet_rl_resume(rb);
+#endif
+
+    return HRTIMER_NORESTART;
+}
+
+static int
+ngknet_rl_bucket_take(struct ngknet_rl_bucket *rb, int si)
+{
+    struct ngknet_dev *dev = rb->dev;
+    struct ngknet_rl_stats *st;
+    int rate = READ_ONCE(rb->rate);
+    int di = dev->dev_info.dev_no;
+    uint64_t wait_ns;
+
+    if (rate <= 0) {
+        return 0;
+    }
+    smp_rmb();
+
+    ngknet_rl_bucket_refill(rb, rate);
+    if (atomic_dec_if_positive(&rb->tokens) >= 0) {
+        return 0;
+    }
+
+    st = rl_ctrl.stats ? this_cpu_ptr(rl_ctrl.stats) : NULL;
+    if (st) {
+        st->drops[di][si]++;
+    }
+
+    if (!test_and_set_bit(0, &rb->paused)) {
+        if (rb->queue < 0) {
+            bcmcnet_pdma_dev_rx_suspend(&dev->pdma_dev);
+        } else {
+            dev->pdma_dev.ops->rx_queue_suspend(&dev->pdma_dev, rb->queue);
+        }
+        if (st) {
+            st->pauses[di][si]++;
+        }
+        /* Resume once half of a burst has been refilled */
+        wait_ns = div_u64((uint64_t)max(rb->burst / 2, 1) * NSEC_PER_SEC, rate);
+        hrtimer_start(&rb->timer, ns_to_ktime(wait_ns),
+                      NGKNET_EXTRA_RATE_LIMIT_HRTIMER_MODE);
+    }
+
+    return -1;
+}
 
-    rc->timer.expires = jiffies + HZ / rc->rx_ticks;
-    add_timer(&rc->timer);
+static void
+ngknet_rl_bucket_init(struct ngknet_rl_bucket *rb, struct ngknet_dev *dev,
+                      int queue)
+{
+    rb->rate = 0;
+    rb->dev = dev;
+    rb->queue = queue;
+    hrtimer_init(&rb->timer, CLOCK_MONOTONIC,
+                 NGKNET_EXTRA_RATE_LIMIT_HRTIMER_MODE);
+    rb->timer.function = ngknet_rl_process;
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4,16,0)
+    tasklet_init(&rb->resume_task, ngknet_rl_resume_task, (unsigned long)rb);
+#endif
+}
+
+static void
+ngknet_rl_bucket_cancel(struct ngknet_rl_bucket *rb)
+{
+    hrtimer_cancel(&rb->timer);
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4,16,0)
+    tasklet_kill(&rb->resume_task);
+#endif
 }
 
 void
 ngknet_rx_rate_limit_init(struct ngknet_dev *devs)
 {
+    int di, qi;
+
     sal_memset(&rl_ctrl, 0, sizeof(rl_ctrl));
-    rl_ctrl.rx_ticks = NGKNET_EXTRA_RATE_LIMIT_DEFAULT_RX_TICK;
-    setup_timer(&rl_ctrl.timer, ngknet_rl_process, (timer_context_t)&rl_ctrl);
-    spin_lock_init(&rl_ctrl.lock);
     rl_ctrl.devs = devs;
+    for (di = 0; di < NUM_PDMA_DEV_MAX; di++) {
+        ngknet_rl_bucket_init(&rl_ctrl.dev_rl[di], &devs[di], -1);
+        for (qi = 0; qi < NUM_Q_MAX; qi++) {
+            ngknet_rl_bucket_init(&rl_ctrl.rxq_rl[di][qi], &devs[di], qi);
+        }
+    }
+    /* Counters are optional, rate limiting works without them */
+    rl_ctrl.stats = alloc_percpu(struct ngknet_rl_stats);
 }
 
 void
 ngknet_rx_rate_limit_cleanup(void)
 {
-    del_timer_sync(&rl_ctrl.timer);
+    int di, qi;
+
+    for (di = 0; di < NUM_PDMA_DEV_MAX; di++) {
+        ngknet_rl_bucket_cancel(&rl_ctrl.dev_rl[di]);
+        for (qi = 0; qi < NUM_Q_MAX; qi++) {
+            ngknet_rl_bucket_cancel(&rl_ctrl.rxq_rl[di][qi]);
+        }
+    }
+    if (rl_ctrl.stats) {
+        free_percpu(rl_ctrl.stats);
+        rl_ctrl.stats = NULL;
+    }
 }
 
-int
-ngknet_rx_rate_limit_started(void)
+void
+ngknet_rx_rate_limit_start(struct ngknet_dev *dev)
 {
-    return rl_ctrl.started;
+    rl_ctrl.dev_active[dev->dev_info.dev_no] = 1;
 }
 
 void
-ngknet_rx_rate_limit_start(struct ngknet_dev *dev)
+ngknet_rx_rate_limit_stop(struct ngknet_dev *dev)
 {
-    unsigned long flags;
+    int di = dev->dev_info.dev_no;
+    int qi;
 
-    spin_lock_irqsave(&rl_ctrl.lock, flags);
-    rl_ctrl.dev_active[dev->dev_info.dev_no] = 1;
-    spin_unlock_irqrestore(&rl_ctrl.lock, flags);
+    rl_ctrl.dev_active[di] = 0;
 
-    if (!rl_ctrl.started) {
-        rl_ctrl.started = 1;
-        rl_ctrl.timer.expires = jiffies + HZ / rl_ctrl.rx_ticks;
-        add_timer(&rl_ctrl.timer);
+    /* Rx is restarted by the caller, just drop the pending resumes */
+    ngknet_rl_bucket_cancel(&rl_ctrl.dev_rl[di]);
+    clear_bit(0, &rl_ctrl.dev_rl[di].paused);
+    for (qi = 0; qi < NUM_Q_MAX; qi++) {
+        ngknet_rl_bucket_cancel(&rl_ctrl.rxq_rl[di][qi]);
+        clear_bit(0, &rl_ctrl.rxq_rl[di][qi].paused);
     }
 }
 
-void
-ngknet_rx_rate_limit_stop(struct ngknet_dev *dev)
+int
+ngknet_rx_rate_limit(struct ngknet_dev *dev, int queue, int limit)
 {
-    unsigned long flags;
+    int di = dev->dev_info.dev_no;
+    struct ngknet_rl_bucket *rb = &rl_ctrl.dev_rl[di];
+
+    if (!rl_ctrl.dev_active[di]) {
+        return 0;
+    }
+
+    /* Device rate follows the module parameter */
+    if (limit != READ_ONCE(rb->rate) && !test_bit(0, &rb->paused)) {
+        ngknet_rl_bucket_config(rb, limit);
+    }
 
-    spin_lock_irqsave(&rl_ctrl.lock, flags);
-    rl_ctrl.dev_active[dev->dev_info.dev_no] = 0;
-    spin_unlock_irqrestore(&rl_ctrl.lock, flags);
+    if (queue >= 0 && queue < NUM_Q_MAX &&
+        ngknet_rl_bucket_take(&rl_ctrl.rxq_rl[di][queue], 1 + queue)) {
+        return -1;
+    }
+
+    return ngknet_rl_bucket_take(rb, 0);
 }
 
-void
-ngknet_rx_rate_limit(struct ngknet_dev *dev, int limit)
+int
+ngknet_rx_queue_rate_limit_set(int dev_no, int queue, int rate)
 {
-    unsigned long flags;
+    struct ngknet_rl_bucket *rb;
 
-    /* To support lower rate, we should use smaller tick (larger interval). */
-    if (limit < 1000) {
-        rl_ctrl.rx_ticks = (limit + 99) / 100;
-    } else {
-        rl_ctrl.rx_ticks = NGKNET_EXTRA_RATE_LIMIT_DEFAULT_RX_TICK;
+    if (dev_no < 0 || dev_no >= NUM_PDMA_DEV_MAX ||
+        queue < 0 || queue >= NUM_Q_MAX) {
+        return SHR_E_PARAM;
     }
 
-    spin_lock_irqsave(&rl_ctrl.lock, flags);
-    if ((++rl_ctrl.rx_pkts + rl_ctrl.rx_overruns > limit / rl_ctrl.rx_ticks) &&
-        !rl_ctrl.dev_paused[dev->dev_info.dev_no] &&
-        rl_ctrl.dev_active[dev->dev_info.dev_no]) {
-        rl_ctrl.dev_paused[dev->dev_info.dev_no] = 1;
-        rl_ctrl.rx_overruns = 0;
-        bcmcnet_pdma_dev_rx_suspend(&dev->pdma_dev);
+    rb = &rl_ctrl.rxq_rl[dev_no][queue];
+    if (rate <= 0) {
+        WRITE_ONCE(rb->rate, 0);
+        /* A pending resume still fires and restarts the queue */
+        return SHR_E_NONE;
     }
-    if (rl_ctrl.dev_paused[dev->dev_info.dev_no]) {
-        rl_ctrl.rx_overruns++;
+    ngknet_rl_bucket_config(rb, rate);
+
+    return SHR_E_NONE;
+}
+
+int
+ngknet_rx_rate_limit_status_get(int dev_no, int queue, int *rate, int *paused,
+                                uint64_t *drops, uint64_t *pauses)
+{
+    struct ngknet_rl_bucket *rb;
+    struct ngknet_rl_stats *st;
+    int si, cpu;
+
+    if (dev_no < 0 || dev_no >= NUM_PDMA_DEV_MAX ||
+        queue < -1 || queue >= NUM_Q_MAX) {
+        return SHR_E_PARAM;
     }
-    spin_unlock_irqrestore(&rl_ctrl.lock, flags);
+
+    if (queue < 0) {
+        rb = &rl_ctrl.dev_rl[dev_no];
+        si = 0;
+    } else {
+        rb = &rl_ctrl.rxq_rl[dev_no][queue];
+        si = 1 + queue;
+    }
+
+    *rate = READ_ONCE(rb->rate);
+    *paused = test_bit(0, &rb->paused);
+    *drops = 0;
+    *pauses = 0;
+    if (rl_ctrl.stats) {
+        for_each_possible_cpu(cpu) {
+            st = per_cpu_ptr(rl_ctrl.stats, cpu);
+            *drops += st->drops[dev_no][si];
+            *pauses += st->pauses[dev_no][si];
+        }
+    }
+
+    return SHR_E_NONE;
 }
 
 void
@@ -116,49 +116,85 @@ ngknet_rx_pkt_filter(struct ngknet_dev *dev, struct sk_buff *skb, struct net_dev
                      struct net_device **mndev, struct sk_buff **mskb);
 
 /*!
- * \brief Rx rate limit control.
+ * \brief Rx rate limit token bucket.
  *
- * This contains all the control information for Rx rate limit such as
- * the number of Rx packets, status related to Rx rate limit, etc.
+ * Tokens are refilled at the configured rate, up to the burst size. A
+ * packet which finds the bucket empty is dropped, and Rx is suspended
+ * on the bucket's queue (or on all queues of the device for the device
+ * bucket). A high resolution timer resumes Rx once enough tokens have
+ * been refilled for the next burst.
+ */
+struct ngknet_rl_bucket {
+    /*! Rate in packets per second, no limit if not positive */
+    int rate;
+
+    /*! Burst size in packets */
+    int burst;
+
+    /*! Available tokens */
+    atomic_t tokens;
+
+    /*! Time of last refill in nanoseconds */
+    atomic64_t refill_ns;
+
+    /*! Rx suspended due to no tokens (bit 0) */
+    unsigned long paused;
+
+    /*! Resume timer */
+    struct hrtimer timer;
+
+    /*! Resume handoff out of hard-IRQ timer context on older kernels */
+    struct tasklet_struct resume_task;
+
+    /*! Device */
+    struct ngknet_dev *dev;
+
+    /*! Rx queue, or -1 for all Rx queues of the device */
+    int queue;
+};
+
+/*!
+ * \brief Rx rate limit counters.
  *
- * The rate limit is kernel-oriented, i.e. all the Rx packets from any
- * device/channel will be accounted for. Once the received packets reach
- * the limit value in an 1-Sec interval, the driver API XXXX_rx_suspend()
- * will be called to suspend Rx. The 1-Sec basis timer will call the driver
- * API XXXX_rx_resume() to resume Rx and reset rate-related status/counters
- * at the begin of the next 1-Sec interval.
+ * Index 0 accounts for the device bucket and index 1 + queue for the
+ * Rx queue buckets. The counters are kept per CPU.
+ */
+struct ngknet_rl_stats {
+    /*! Packets dropped due to no tokens */
+    uint64_t drops[NUM_PDMA_DEV_MAX][NUM_Q_MAX + 1];
+
+    /*! Times Rx was suspended due to no tokens */
+    uint64_t pauses[NUM_PDMA_DEV_MAX][NUM_Q_MAX + 1];
+};
+
+/*!
+ * \brief Rx rate limit control.
+ *
+ * Each device has one token bucket for its aggregate Rx rate and one
+ * token bucket per Rx queue. Packets are accounted for in the Rx NAPI
+ * context of their queue without taking any lock.
  *
- * The NGKNET module parameter 'rx_rate_limit' is used to decide the maximum
- * Rx rate. Disable Rx rate limit if set 0. It can be set when inserting
- * NGKNET module or modified using its SYSFS attributions.
+ * The NGKNET module parameter 'rx_rate_limit' sets the aggregate rate of
+ * each device, and a negative value disables it. It can be set when
+ * inserting NGKNET module or modified through procfs. Per Rx queue rates
+ * are set through procfs, so that flooding CPU queues (e.g. sFlow) can
+ * be limited without pausing the queues carrying control protocols.
  */
 struct ngknet_rl_ctrl {
-    /*! Rx packets */
-    int rx_pkts;
-
-    /*! Rx overruns */
-    int rx_overruns;
+    /*! Device buckets */
+    struct ngknet_rl_bucket dev_rl[NUM_PDMA_DEV_MAX];
 
-    /*! Rx ticks */
-    int rx_ticks;
+    /*! Rx queue buckets */
+    struct ngknet_rl_bucket rxq_rl[NUM_PDMA_DEV_MAX][NUM_Q_MAX];
 
     /*! Active devices under rate control */
     int dev_active[NUM_PDMA_DEV_MAX];
 
-    /*! Paused devices due to no Rx credit */
-    int dev_paused[NUM_PDMA_DEV_MAX];
-
-    /*! Rate limit timer */
-    struct timer_list timer;
-
-    /*! Rate limit lock */
-    spinlock_t lock;
+    /*! Per-CPU counters */
+    struct ngknet_rl_stats __percpu *stats;
 
     /*! Devices */
     struct ngknet_dev *devs;
-
-    /*! Rate limit status indicator */
-    int started;
 };
 
 /*!
@@ -175,12 +211,6 @@ ngknet_rx_rate_limit_init(struct ngknet_dev *devs);
 extern void
 ngknet_rx_rate_limit_cleanup(void);
 
-/*!
- * \brief Get Rx rate limit state.
- */
-extern int
-ngknet_rx_rate_limit_started(void);
-
 /*!
  * \brief Start Rx rate limit.
  *
@@ -201,9 +231,44 @@ ngknet_rx_rate_limit_stop(struct ngknet_dev *dev);
  * \brief Limit Rx rate.
  *
  * \param [in] dev Device structure point.
+ * \param [in] queue Rx queue number.
+ * \param [in] limit Device Rx rate limit.
+ *
+ * \retval 0 Packet is within the limits.
+ * \retval -1 Packet should be dropped.
  */
-extern void
-ngknet_rx_rate_limit(struct ngknet_dev *dev, int limit);
+extern int
+ngknet_rx_rate_limit(struct ngknet_dev *dev, int queue, int limit);
+
+/*!
+ * \brief Set Rx queue rate limit.
+ *
+ * \param [in] dev_no Device number.
+ * \param [in] queue Rx queue number.
+ * \param [in] rate Rx rate in packets per second, no limit if not positive.
+ *
+ * \retval SHR_E_NONE No errors.
+ * \retval SHR_E_PARAM Invalid device or queue.
+ */
+extern int
+ngknet_rx_queue_rate_limit_set(int dev_no, int queue, int rate);
+
+/*!
+ * \brief Get Rx rate limit status of a device.
+ *
+ * \param [in] dev_no Device number.
+ * \param [in] queue Rx queue number, or -1 for the device.
+ * \param [out] rate Configured rate.
+ * \param [out] paused Rx currently suspended.
+ * \param [out] drops Dropped packets.
+ * \param [out] pauses Number of times Rx was suspended.
+ *
+ * \retval SHR_E_NONE No errors.
+ * \retval SHR_E_PARAM Invalid device or queue.
+ */
+extern int
+ngknet_rx_rate_limit_status_get(int dev_no, int queue, int *rate, int *paused,
+                                uint64_t *drops, uint64_t *pauses);
 
 /*!
  * \brief Schedule Tx queue.
@@ -138,7 +138,7 @@ MODULE_PARM_DESC(rx_buffer_size,
 static int rx_rate_limit = -1;
 MODULE_PARAM(rx_rate_limit, int, 0);
 MODULE_PARM_DESC(rx_rate_limit,
-"Rx rate limit (pps, default -1 no limit)");
+"Rx rate limit per device (pps, default -1 no limit)");
 /*! \endcond */
 
 /*! \cond */
@@ -481,6 +481,13 @@ ngknet_netif_recv(struct net_device *ndev, struct sk_buff *skb)
         napi = (struct napi_struct *)pdev->ctrl.grp[gi].intr_hdl[qi].priv;
     }
 
+    /* Rate limit */
+    if (ngknet_rx_rate_limit(dev, pkh->queue_id, rx_rate_limit)) {
+        priv->stats.rx_dropped++;
+        dev_kfree_skb_any(skb);
+        return SHR_E_NONE;
+    }
+
    /* FIXME: File CSP on KASAN warning on use-after-free in ngknet_netif_recv */
     skb_len = skb->len;
     napi_gro_receive(napi, skb);
@@ -488,15 +495,6 @@ ngknet_netif_recv(struct net_device *ndev, struct sk_buff *skb)
     priv->stats.rx_packets++;
     priv->stats.rx_bytes += skb_len;
 
-
-    /* Rate limit */
-    if (rx_rate_limit >= 0) {
-        if (!ngknet_rx_rate_limit_started()) {
-            ngknet_rx_rate_limit_start(dev);
-        }
-        ngknet_rx_rate_limit(dev, rx_rate_limit);
-    }
-
     return SHR_E_NONE;
 }
 
@@ -1209,9 +1207,7 @@ ngknet_enet_open(struct net_device *ndev)
         }
 
         /* Start rate limit */
-        if (rx_rate_limit >= 0) {
-            ngknet_rx_rate_limit_start(dev);
-        }
+        ngknet_rx_rate_limit_start(dev);
 
         /* Notify the stack of the actual queue counts. */
         rv = netif_set_real_num_rx_queues(dev->net_dev, pdev->ctrl.nb_rxq);
@@ -1278,9 +1274,7 @@ ngknet_enet_stop(struct net_device *ndev)
 
     if (priv->netif.id <= 0) {
         /* Stop rate limit */
-        if (rx_rate_limit >= 0) {
-            ngknet_rx_rate_limit_stop(dev);
-        }
+        ngknet_rx_rate_limit_stop(dev);
 
         for (gi = 0; gi < pdev->num_groups; gi++) {
             if (!pdev->ctrl.grp[gi].attached) {
@@ -2527,9 +2521,7 @@ ngknet_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
         break;
     case NGKNET_DEV_SUSPEND:
         DBG_CMD(("NGKNET_DEV_SUSPEND\n"));
-        if (rx_rate_limit >= 0) {
-            ngknet_rx_rate_limit_stop(dev);
-        }
+        ngknet_rx_rate_limit_stop(dev);
         if (ioc.iarg[0]) {
             /* Graceful suspend */
             ioc.rc = bcmcnet_pdma_dev_suspend(pdev);
@@ -2541,9 +2533,7 @@ ngknet_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
     case NGKNET_DEV_RESUME:
         DBG_CMD(("NGKNET_DEV_RESUME\n"));
         ioc.rc = bcmcnet_pdma_dev_resume(pdev);
-        if (rx_rate_limit >= 0) {
-            ngknet_rx_rate_limit_start(dev);
-        }
+        ngknet_rx_rate_limit_start(dev);
         break;
     case NGKNET_DEV_VNET_WAIT:
         DBG_CMD(("NGKNET_DEV_VNET_WAIT\n"));
@@ -432,11 +432,54 @@ static struct proc_ops proc_pkt_stats_fops = {
     .proc_release =     proc_pkt_stats_release,
 };
 
+static void
+proc_rate_limit_bucket_show(struct seq_file *m, int di, int qi)
+{
+    uint64_t drops, pauses;
+    int rate, paused;
+
+    if (SHR_FAILURE(ngknet_rx_rate_limit_status_get(di, qi, &rate, &paused,
+                                                    &drops, &pauses))) {
+        return;
+    }
+    if (qi >= 0 && rate <= 0 && !drops) {
+        return;
+    }
+
+    if (qi < 0) {
+        seq_printf(m, "  all:    ");
+    } else {
+        seq_printf(m, "  rxq%-3d: ", qi);
+    }
+    if (rate > 0) {
+        seq_printf(m, "%10d pps", rate);
+    } else {
+        seq_printf(m, "%10s    ", "-");
+    }
+    seq_printf(m, " %-7s drops: %-12llu pauses: %llu\n",
+               paused ? "paused" : "running", drops, pauses);
+}
+
 static int
 proc_rate_limit_show(struct seq_file *m, void *v)
 {
+    struct ngknet_dev *dev;
+    int di, qi;
+
     seq_printf(m, "Rx rate limit: %d pps\n", ngknet_rx_rate_limit_get());
 
+    for (di = 0; di < NUM_PDMA_DEV_MAX; di++) {
+        dev = &ngknet_devices[di];
+        if (!(dev->flags & NGKNET_DEV_ACTIVE)) {
+            continue;
+        }
+        seq_printf(m, "dev%d:\n", di);
+        proc_rate_limit_bucket_show(m, di, -1);
+        for (qi = 0; qi < dev->pdma_dev.ctrl.nb_rxq; qi++) {
+            proc_rate_limit_bucket_show(m, di, qi);
+        }
+    }
+
     return 0;
 }
 
@@ -446,20 +489,45 @@ proc_rate_limit_open(struct inode *inode, struct file *file)
     return single_open(file, proc_rate_limit_show, NULL);
 }
 
+/*
+ * Write "<pps>" to set the Rx rate limit of each device, or
+ * "<dev>:<rxq>=<pps>" to set the rate limit of an Rx queue.
+ * A rate which is not positive removes the limit.
+ */
 static ssize_t
 proc_rate_limit_write(struct file *file, const char *buf,
                       size_t count, loff_t *loff)
 {
-    char limit_str[9] = {0};
-    int rate_limit;
+    char limit_str[32] = {0};
+    char *ptr;
+    int rate_limit, di, qi;
 
-    if (copy_from_user(limit_str, buf, sizeof(limit_str) - 1)) {
+    if (copy_from_user(limit_str, buf,
+                       min(count, sizeof(limit_str) - 1))) {
         return -EFAULT;
     }
-    rate_limit = simple_strtol(limit_str, NULL, 10);
 
-    ngknet_rx_rate_limit_set(rate_limit);
-    printk("Rx rate limit set to: %d pps\n", rate_limit);
+    ptr = strchr(limit_str, '=');
+    if (!ptr) {
+        rate_limit = simple_strtol(limit_str, NULL, 10);
+
+        ngknet_rx_rate_limit_set(rate_limit);
+        printk("Rx rate limit set to: %d pps\n", rate_limit);
+
+        return count;
+    }
+
+    rate_limit = simple_strtol(ptr + 1, NULL, 10);
+    di = simple_strtol(limit_str, &ptr, 10);
+    if (*ptr != ':') {
+        return -EINVAL;
+    }
+    qi = simple_strtol(ptr + 1, NULL, 10);
+    if (SHR_FAILURE(ngknet_rx_queue_rate_limit_set(di, qi, rate_limit))) {
+        return -EINVAL;
+    }
+    printk("Rx rate limit of dev%d rxq%d set to: %d pps\n",
+           di, qi, rate_limit);
 
     return count;
 }
@@ -67,6 +67,12 @@
 #include <linux/seq_file.h>
 #include <linux/if_vlan.h>
 #include <linux/nsproxy.h>
+#include <linux/timex.h>
+#include <linux/math64.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,3,0)
+#include <linux/jump_label.h>
+#define BKN_USE_STATIC_KEYS
+#endif
 
 
 MODULE_AUTHOR("Broadcom Corporation");
@@ -226,29 +232,74 @@ MODULE_PARM_DESC(ft_vid,
 #define DBG_LVL_PDMP_RX 0x80000
 #define DBG_LVL_PTP     0x100000
 
-#define DBG_VERB(_s)    do { if (debug & DBG_LVL_VERB) gprintk _s; } while (0)
-#define DBG_PKT(_s)     do { if (debug & DBG_LVL_PKT)  gprintk _s; } while (0)
-#define DBG_SKB(_s)     do { if (debug & DBG_LVL_SKB)  gprintk _s; } while (0)
-#define DBG_CMD(_s)     do { if (debug & DBG_LVL_CMD)  gprintk _s; } while (0)
-#define DBG_EVT(_s)     do { if (debug & DBG_LVL_EVT)  gprintk _s; } while (0)
-#define DBG_IRQ(_s)     do { if (debug & DBG_LVL_IRQ)  gprintk _s; } while (0)
-#define DBG_NAPI(_s)    do { if (debug & DBG_LVL_NAPI) gprintk _s; } while (0)
-#define DBG_PDMP(_s)    do { if (debug & DBG_LVL_PDMP) gprintk _s; } while (0)
-#define DBG_FLTR(_s)    do { if (debug & DBG_LVL_FLTR) gprintk _s; } while (0)
-#define DBG_KCOM(_s)    do { if (debug & DBG_LVL_KCOM) gprintk _s; } while (0)
-#define DBG_RCPU(_s)    do { if (debug & DBG_LVL_RCPU) gprintk _s; } while (0)
-#define DBG_WARN(_s)    do { if (debug & DBG_LVL_WARN) gprintk _s; } while (0)
-#define DBG_NDEV(_s)    do { if (debug & DBG_LVL_NDEV) gprintk _s; } while (0)
-#define DBG_INST(_s)    do { if (debug & DBG_LVL_INST) gprintk _s; } while (0)
-#define DBG_DUNE(_s)    do { if (debug & DBG_LVL_DUNE) gprintk _s; } while (0)
-#define DBG_DCB_TX(_s)  do { if (debug & (DBG_LVL_DCB|DBG_LVL_DCB_TX)) \
+/*
+ * All debug output is gated by a static key which is only enabled while
+ * the debug level is non-zero, such that disabled debug costs a single
+ * patched-out branch on the Rx/Tx paths.
+ */
+#ifdef BKN_USE_STATIC_KEYS
+static DEFINE_STATIC_KEY_FALSE(bkn_debug_key);
+#define BKN_DBG_KEY_ON()        static_branch_unlikely(&bkn_debug_key)
+#else
+#define BKN_DBG_KEY_ON()        unlikely(debug != 0)
+#endif
+#define BKN_DBG_ON(_lvl)        (BKN_DBG_KEY_ON() && (debug & (_lvl)))
+
+#define DBG_VERB(_s)    do { if (BKN_DBG_ON(DBG_LVL_VERB)) gprintk _s; } while (0)
+#define DBG_PKT(_s)     do { if (BKN_DBG_ON(DBG_LVL_PKT))  gprintk _s; } while (0)
+#define DBG_SKB(_s)     do { if (BKN_DBG_ON(DBG_LVL_SKB))  gprintk _s; } while (0)
+#define DBG_CMD(_s)     do { if (BKN_DBG_ON(DBG_LVL_CMD))  gprintk _s; } while (0)
+#define DBG_EVT(_s)     do { if (BKN_DBG_ON(DBG_LVL_EVT))  gprintk _s; } while (0)
+#define DBG_IRQ(_s)     do { if (BKN_DBG_ON(DBG_LVL_IRQ))  gprintk _s; } while (0)
+#define DBG_NAPI(_s)    do { if (BKN_DBG_ON(DBG_LVL_NAPI)) gprintk _s; } while (0)
+#define DBG_PDMP(_s)    do { if (BKN_DBG_ON(DBG_LVL_PDMP)) gprintk _s; } while (0)
+#define DBG_FLTR(_s)    do { if (BKN_DBG_ON(DBG_LVL_FLTR)) gprintk _s; } while (0)
+#define DBG_KCOM(_s)    do { if (BKN_DBG_ON(DBG_LVL_KCOM)) gprintk _s; } while (0)
+#define DBG_RCPU(_s)    do { if (BKN_DBG_ON(DBG_LVL_RCPU)) gprintk _s; } while (0)
+#define DBG_WARN(_s)    do { if (BKN_DBG_ON(DBG_LVL_WARN)) gprintk _s; } while (0)
+#define DBG_NDEV(_s)    do { if (BKN_DBG_ON(DBG_LVL_NDEV)) gprintk _s; } while (0)
+#define DBG_INST(_s)    do { if (BKN_DBG_ON(DBG_LVL_INST)) gprintk _s; } while (0)
+#define DBG_DUNE(_s)    do { if (BKN_DBG_ON(DBG_LVL_DUNE)) gprintk _s; } while (0)
+#define DBG_DCB_TX(_s)  do { if (BKN_DBG_ON(DBG_LVL_DCB|DBG_LVL_DCB_TX)) \
                                  gprintk _s; } while (0)
-#define DBG_DCB_RX(_s)  do { if (debug & (DBG_LVL_DCB|DBG_LVL_DCB_RX)) \
+#define DBG_DCB_RX(_s)  do { if (BKN_DBG_ON(DBG_LVL_DCB|DBG_LVL_DCB_RX)) \
                                  gprintk _s; } while (0)
-#define DBG_DCB(_s)     do { if (debug & (DBG_LVL_DCB|DBG_LVL_DCB_TX| \
-                                          DBG_LVL_DCB_RX)) \
+#define DBG_DCB(_s)     do { if (BKN_DBG_ON(DBG_LVL_DCB|DBG_LVL_DCB_TX| \
+                                            DBG_LVL_DCB_RX)) \
                                  gprintk _s; } while (0)
-#define DBG_PTP(_s)    do { if (debug & DBG_LVL_PTP) gprintk _s; } while (0)
+#define DBG_PTP(_s)    do { if (BKN_DBG_ON(DBG_LVL_PTP)) gprintk _s; } while (0)
+
+/* DCB and packet dumps are only formatted if enabled for the direction */
+#define BKN_DUMP_DCB_ON(_txrx) \
+    BKN_DBG_ON((_txrx) == XGS_DMA_TX_CHAN ? \
+               (DBG_LVL_DCB|DBG_LVL_DCB_TX) : (DBG_LVL_DCB|DBG_LVL_DCB_RX))
+#define BKN_DUMP_PKT_ON(_txrx) \
+    BKN_DBG_ON((_txrx) == XGS_DMA_TX_CHAN ? \
+               (DBG_LVL_PDMP|DBG_LVL_PDMP_TX) : (DBG_LVL_PDMP|DBG_LVL_PDMP_RX))
+
+static void
+bkn_debug_set(int level)
+{
+    debug = level;
+#ifdef BKN_USE_STATIC_KEYS
+    if (level) {
+        static_branch_enable(&bkn_debug_key);
+    } else {
+        static_branch_disable(&bkn_debug_key);
+    }
+#endif
+}
+
+/*
+ * Rx stage profiling (see /proc/bcm/knet/rx_prof) is gated the same way.
+ */
+#ifdef BKN_USE_STATIC_KEYS
+static DEFINE_STATIC_KEY_FALSE(bkn_rx_prof_key);
+#define BKN_RX_PROF_ON()        static_branch_unlikely(&bkn_rx_prof_key)
+#else
+static int bkn_rx_prof_enable;
+#define BKN_RX_PROF_ON()        unlikely(bkn_rx_prof_enable)
+#endif
 
 
 /* This flag is used to indicate if debugging packet function is open or closed */
@@ -575,6 +626,7 @@ typedef struct bkn_switch_info_s {
     struct net_device **ndevs;  /* Indexed array of ndev_list */
     int ndev_max;               /* Size of indexed array */
     struct list_head rxpf_list; /* Associated Rx packet filters */
+    struct list_head rxpf_groups; /* Rx packet filter classifier groups */
     volatile void *base_addr;   /* Base address for PCI register access */
     struct BKN_DMA_DEV *dma_dev;    /* Required for DMA memory control */
     struct pci_dev *pdev;       /* Required for DMA memory control */
@@ -689,6 +741,11 @@ typedef struct bkn_switch_info_s {
         uint32_t pkts_d_callback;   /* Rx drop - consumed by call-back */
         uint32_t pkts_d_no_link;    /* Rx drop - software link down */
         uint32_t pkts_d_no_api_buf; /* Rx drop - no API buffers */
+        uint32_t prof_pkts;         /* Rx packets profiled */
+        uint32_t prof_netif_pkts;   /* Rx packets profiled up to netif */
+        uint64_t prof_skb_cycles;   /* DMA done to SKB and metadata ready */
+        uint64_t prof_fltr_cycles;  /* Filter lookup */
+        uint64_t prof_netif_cycles; /* Filter match to netif_receive done */
     } rx[NUM_RX_CHAN];
 } bkn_switch_info_t;
 
@@ -972,10 +1029,37 @@ typedef struct bkn_priv_s {
 #endif
 } bkn_priv_t;
 
+/*
+ * Rx packet filters which share OOB/packet data offsets, sizes and mask
+ * are collected in a classifier group, in which they are hashed on their
+ * match data.
+ */
+#define BKN_RXPF_HASH_SIZE      64
+
+typedef struct bkn_filter_group_s {
+    struct list_head list;
+    int refcnt;                 /* Number of filters in group */
+    uint16_t oob_data_offset;
+    uint16_t oob_data_size;
+    uint16_t pkt_data_offset;
+    uint16_t pkt_data_size;
+    uint8_t mask[KCOM_FILTER_BYTES_MAX];
+    int sig_cnt;                /* Number of bytes with non-zero mask */
+    int sig_oob_cnt;            /* Number of those taken from OOB data */
+    uint16_t sig_idx[KCOM_FILTER_BYTES_MAX]; /* Index into filter data */
+    uint16_t sig_off[KCOM_FILTER_BYTES_MAX]; /* Offset into OOB/packet */
+    struct list_head bucket[BKN_RXPF_HASH_SIZE];
+} bkn_filter_group_t;
+
 typedef struct bkn_filter_s {
     struct list_head list;
     int dev_no;
     unsigned long hits;
+    struct list_head hlist;     /* Classifier hash bucket entry */
+    bkn_filter_group_t *group;  /* Classifier group */
+    uint32_t hash;              /* Hash of match data */
+    int hashed;                 /* Filter data can match (see group mask) */
+    int rank;                   /* Position in rxpf_list */
     kcom_filter_t kf;
 } bkn_filter_t;
 
@@ -2109,7 +2193,7 @@ bkn_init_dcbs(bkn_switch_info_t *sinfo)
 }
 
 static void
-bkn_dump_dcb(char *prefix, uint32_t *dcb, int wsize, int txrx)
+_bkn_dump_dcb(char *prefix, uint32_t *dcb, int wsize, int txrx)
 {
     if (XGS_DMA_TX_CHAN == txrx) {
         if (wsize > 4) {
@@ -2133,17 +2217,11 @@ bkn_dump_dcb(char *prefix, uint32_t *dcb, int wsize, int txrx)
 }
 
 static void
-bkn_dump_pkt(uint8_t *data, int size, int txrx)
+_bkn_dump_pkt(uint8_t *data, int size, int txrx)
 {
     int idx;
     char str[128];
 
-    if (!(debug & DBG_LVL_PDMP) &&
-        !(txrx == XGS_DMA_TX_CHAN && debug & DBG_LVL_PDMP_TX) &&
-        !(txrx == XGS_DMA_RX_CHAN && debug & DBG_LVL_PDMP_RX)) {
-        return;
-    }
-
     for (idx = 0; idx < size; idx++) {
         if ((idx & 0xf) == 0) {
             sprintf(str, "%04x: ", idx);
@@ -2163,6 +2241,20 @@ bkn_dump_pkt(uint8_t *data, int size, int txrx)
     }
 }
 
+#define bkn_dump_dcb(_prefix, _dcb, _wsize, _txrx) \
+    do { \
+        if (BKN_DUMP_DCB_ON(_txrx)) { \
+            _bkn_dump_dcb(_prefix, _dcb, _wsize, _txrx); \
+        } \
+    } while (0)
+
+#define bkn_dump_pkt(_data, _size, _txrx) \
+    do { \
+        if (BKN_DUMP_PKT_ON(_txrx)) { \
+            _bkn_dump_pkt(_data, _size, _txrx); \
+        } \
+    } while (0)
+
 static bkn_switch_info_t *
 bkn_sinfo_from_unit(int unit)
 {
@@ -2629,97 +2721,268 @@ device_is_sand(bkn_switch_info_t *sinfo)
     return (is_dpp | is_dnx);
 }
 
-static bkn_filter_t *
-bkn_match_rx_pkt(bkn_switch_info_t *sinfo, uint8_t *pkt, int pktlen,
-                 void *meta, int chan, bkn_filter_t *cbf)
+static int
+bkn_rxpf_group_equal(bkn_filter_group_t *group, kcom_filter_t *kf)
+{
+    if (group->oob_data_offset != kf->oob_data_offset ||
+        group->oob_data_size != kf->oob_data_size ||
+        group->pkt_data_offset != kf->pkt_data_offset ||
+        group->pkt_data_size != kf->pkt_data_size) {
+        return 0;
+    }
+    return memcmp(group->mask, kf->mask.b,
+                  kf->oob_data_size + kf->pkt_data_size) == 0;
+}
+
+static void
+bkn_rxpf_group_init(bkn_filter_group_t *group, kcom_filter_t *kf)
+{
+    int size, idx, cnt;
+
+    memset(group, 0, sizeof(*group));
+    group->oob_data_offset = kf->oob_data_offset;
+    group->oob_data_size = kf->oob_data_size;
+    group->pkt_data_offset = kf->pkt_data_offset;
+    group->pkt_data_size = kf->pkt_data_size;
+    size = kf->oob_data_size + kf->pkt_data_size;
+    memcpy(group->mask, kf->mask.b, size);
+
+    /* Only bytes with a non-zero mask take part in hashing and matching */
+    cnt = 0;
+    for (idx = 0; idx < size; idx++) {
+        if (group->mask[idx] == 0) {
+            continue;
+        }
+        group->sig_idx[cnt] = idx;
+        if (idx < kf->oob_data_size) {
+            group->sig_off[cnt] = kf->oob_data_offset + idx;
+            group->sig_oob_cnt++;
+        } else {
+            group->sig_off[cnt] = kf->pkt_data_offset +
+                                  (idx - kf->oob_data_size);
+        }
+        cnt++;
+    }
+    group->sig_cnt = cnt;
+
+    for (idx = 0; idx < BKN_RXPF_HASH_SIZE; idx++) {
+        INIT_LIST_HEAD(&group->bucket[idx]);
+    }
+}
+
+static inline uint32_t
+bkn_rxpf_hash_byte(uint32_t hash, uint8_t byte)
+{
+    return (hash ^ byte) * 16777619U;
+}
+
+static uint32_t
+bkn_rxpf_filter_hash(bkn_filter_group_t *group, kcom_filter_t *kf)
+{
+    uint32_t hash = 2166136261U;
+    int idx;
+
+    for (idx = 0; idx < group->sig_cnt; idx++) {
+        hash = bkn_rxpf_hash_byte(hash, kf->data.b[group->sig_idx[idx]]);
+    }
+    return hash;
+}
+
+static inline uint32_t
+bkn_rxpf_pkt_hash(bkn_filter_group_t *group, uint8_t *pkt, uint8_t *oob)
+{
+    uint32_t hash = 2166136261U;
+    int idx;
+
+    for (idx = 0; idx < group->sig_oob_cnt; idx++) {
+        hash = bkn_rxpf_hash_byte(hash,
+                                  oob[group->sig_off[idx]] & group->mask[group->sig_idx[idx]]);
+    }
+    for (; idx < group->sig_cnt; idx++) {
+        hash = bkn_rxpf_hash_byte(hash,
+                                  pkt[group->sig_off[idx]] & group->mask[group->sig_idx[idx]]);
+    }
+    return hash;
+}
+
+/*
+ * A filter whose data has bits set outside of its mask can never match.
+ */
+static int
+bkn_rxpf_filter_hashable(kcom_filter_t *kf)
+{
+    int size, idx;
+
+    size = kf->oob_data_size + kf->pkt_data_size;
+    for (idx = 0; idx < size; idx++) {
+        if (kf->data.b[idx] & ~kf->mask.b[idx]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Rebuild hash buckets after rxpf_list has changed. Filters are added
+ * to the buckets in list order, so each bucket is sorted by rank.
+ * Must be called with the device lock held.
+ */
+static void
+bkn_rxpf_rebuild(bkn_switch_info_t *sinfo)
 {
     struct list_head *list;
+    bkn_filter_group_t *group;
     bkn_filter_t *filter;
-    kcom_filter_t scratch, *kf;
-    uint8_t *oob = (uint8_t *)meta;
-    int size, wsize;
-    int idx, match;
+    int idx, rank;
+
+    list_for_each(list, &sinfo->rxpf_groups) {
+        group = (bkn_filter_group_t *)list;
+        for (idx = 0; idx < BKN_RXPF_HASH_SIZE; idx++) {
+            INIT_LIST_HEAD(&group->bucket[idx]);
+        }
+    }
 
+    rank = 0;
     list_for_each(list, &sinfo->rxpf_list) {
         filter = (bkn_filter_t *)list;
-        kf = &filter->kf;
-        if (kf->pkt_data_offset + kf->pkt_data_size > pktlen) {
-            continue;
+        filter->rank = rank++;
+        if (filter->hashed) {
+            list_add_tail(&filter->hlist,
+                          &filter->group->bucket[filter->hash &
+                                                 (BKN_RXPF_HASH_SIZE - 1)]);
         }
-        memcpy(&scratch.data.b[0],
-               &oob[kf->oob_data_offset], kf->oob_data_size);
-        memcpy(&scratch.data.b[kf->oob_data_size],
-               &pkt[kf->pkt_data_offset], kf->pkt_data_size);
-        size = kf->oob_data_size + kf->pkt_data_size;
-        wsize = BYTES2WORDS(size);
-        DBG_VERB(("Filter: size = %d (%d), data = 0x%08x, mask = 0x%08x\n",
-                  size, wsize, kf->data.w[0], kf->mask.w[0]));
+    }
+}
 
-        if (device_is_sand(sinfo)) {
-            DBG_DUNE(("Filter: size = %d (wsize %d)\n", size, wsize));
-            for (idx = 0; idx < wsize; idx++)
-            {
-                DBG_DUNE(("OOB[%d]: 0x%08x [0x%08x]\n", idx, kf->data.w[idx], kf->mask.w[idx]));
+static inline int
+bkn_rxpf_chan_match(bkn_switch_info_t *sinfo, kcom_filter_t *kf, int chan)
+{
+    if (device_is_dnx(sinfo)) {
+        /*
+         * Mutliple RX channels are enabled on JR2 and above devices
+         * Bind between priority 0 and RX channel 0 is not checked, then all enabled RX channels can receive packets.
+         */
+        if (kf->priority && (kf->priority < (num_rx_prio * sinfo->rx_chans))) {
+            if (kf->priority < (num_rx_prio * chan) ||
+                kf->priority >= (num_rx_prio * (chan + 1))) {
+                return 0;
             }
-            DBG_DUNE(("Meta Data [+ Selected Raw packet data]\n"));
-            for (idx = 0; idx < wsize; idx++)
-            {
-                DBG_DUNE(("Scratch[%d]: 0x%08x\n", idx, scratch.data.w[idx]));
+        }
+    } else {
+        if (kf->priority < (num_rx_prio * sinfo->rx_chans)) {
+            if (kf->priority < (num_rx_prio * chan) ||
+                kf->priority >= (num_rx_prio * (chan + 1))) {
+                return 0;
             }
         }
+    }
+    return 1;
+}
+
+/*
+ * Compare masked OOB and packet data in place against the filter data.
+ */
+static inline int
+bkn_rxpf_data_match(bkn_filter_group_t *group, kcom_filter_t *kf,
+                    uint8_t *pkt, uint8_t *oob)
+{
+    int idx, didx;
+
+    for (idx = 0; idx < group->sig_oob_cnt; idx++) {
+        didx = group->sig_idx[idx];
+        if ((oob[group->sig_off[idx]] & group->mask[didx]) != kf->data.b[didx]) {
+            return 0;
+        }
+    }
+    for (; idx < group->sig_cnt; idx++) {
+        didx = group->sig_idx[idx];
+        if ((pkt[group->sig_off[idx]] & group->mask[didx]) != kf->data.b[didx]) {
+            return 0;
+        }
+    }
+    return 1;
+}
 
-        match = 1;
-        if (match) {
-            if (device_is_dnx(sinfo))
-            {
-                /*
-                 * Mutliple RX channels are enabled on JR2 and above devices
-                 * Bind between priority 0 and RX channel 0 is not checked, then all enabled RX channels can receive packets.
-                 */
-                if (kf->priority && (kf->priority < (num_rx_prio * sinfo->rx_chans))) {
-                    if (kf->priority < (num_rx_prio * chan) ||
-                        kf->priority >= (num_rx_prio * (chan + 1))) {
-                        match = 0;
-                    }
-                }
-            }
-            else {
-                if (kf->priority < (num_rx_prio * sinfo->rx_chans)) {
-                    if (kf->priority < (num_rx_prio * chan) ||
-                        kf->priority >= (num_rx_prio * (chan + 1))) {
-                        match = 0;
-                    }
-                }
-            }
+/*
+ * Linear walk of rxpf_list starting after the given filter. Only used
+ * when a callback filter declines a packet.
+ */
+static bkn_filter_t *
+bkn_rxpf_next_match(bkn_switch_info_t *sinfo, bkn_filter_t *filter,
+                    uint8_t *pkt, int pktlen, uint8_t *oob, int chan)
+{
+    struct list_head *list;
+    bkn_filter_group_t *group;
+
+    for (list = filter->list.next; list != &sinfo->rxpf_list;
+         list = list->next) {
+        filter = (bkn_filter_t *)list;
+        group = filter->group;
+        if (!filter->hashed ||
+            group->pkt_data_offset + group->pkt_data_size > pktlen) {
+            continue;
         }
-        if (match) {
-            for (idx = 0; idx < wsize; idx++) {
-                scratch.data.w[idx] &= kf->mask.w[idx];
-                if (scratch.data.w[idx] != kf->data.w[idx]) {
-                    match = 0;
-                    break;
-                }
+        if (bkn_rxpf_chan_match(sinfo, &filter->kf, chan) &&
+            bkn_rxpf_data_match(group, &filter->kf, pkt, oob)) {
+            return filter;
+        }
+    }
+    return NULL;
+}
+
+static bkn_filter_t *
+bkn_match_rx_pkt(bkn_switch_info_t *sinfo, uint8_t *pkt, int pktlen,
+                 void *meta, int chan, bkn_filter_t *cbf)
+{
+    struct list_head *list, *blist;
+    bkn_filter_group_t *group;
+    bkn_filter_t *filter, *best;
+    kcom_filter_t *kf;
+    uint8_t *oob = (uint8_t *)meta;
+    uint32_t hash;
+
+    /* Find the lowest ranked matching filter across all groups */
+    best = NULL;
+    list_for_each(list, &sinfo->rxpf_groups) {
+        group = (bkn_filter_group_t *)list;
+        if (group->pkt_data_offset + group->pkt_data_size > pktlen) {
+            continue;
+        }
+        hash = bkn_rxpf_pkt_hash(group, pkt, oob);
+        list_for_each(blist, &group->bucket[hash & (BKN_RXPF_HASH_SIZE - 1)]) {
+            filter = list_entry(blist, bkn_filter_t, hlist);
+            if (best && filter->rank >= best->rank) {
+                break;
+            }
+            if (filter->hash == hash &&
+                bkn_rxpf_chan_match(sinfo, &filter->kf, chan) &&
+                bkn_rxpf_data_match(group, &filter->kf, pkt, oob)) {
+                best = filter;
+                break;
             }
         }
-        if (match) {
-            if (kf->dest_type == KCOM_DEST_T_CB) {
-                /* Check for custom filters */
-                if (knet_filter_cb != NULL && cbf != NULL) {
-                    memset(cbf, 0, sizeof(*cbf));
-                    memcpy(&cbf->kf, kf, sizeof(cbf->kf));
-                    if (knet_filter_cb(pkt, pktlen, sinfo->dev_no,
-                                       meta, chan, &cbf->kf)) {
-                        filter->hits++;
-                        return cbf;
-                    }
-                } else {
-                    DBG_FLTR(("Match, but not filter callback\n"));
-                }
-            } else {
+    }
+
+    filter = best;
+    while (filter) {
+        kf = &filter->kf;
+        if (kf->dest_type != KCOM_DEST_T_CB) {
+            filter->hits++;
+            return filter;
+        }
+        /* Check for custom filters */
+        if (knet_filter_cb != NULL && cbf != NULL) {
+            memset(cbf, 0, sizeof(*cbf));
+            memcpy(&cbf->kf, kf, sizeof(cbf->kf));
+            if (knet_filter_cb(pkt, pktlen, sinfo->dev_no,
+                               meta, chan, &cbf->kf)) {
                 filter->hits++;
-                return filter;
+                return cbf;
             }
+        } else {
+            DBG_FLTR(("Match, but not filter callback\n"));
         }
+        filter = bkn_rxpf_next_match(sinfo, filter, pkt, pktlen, oob, chan);
     }
 
     return NULL;
@@ -4130,6 +4393,7 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
     struct sk_buff *mskb = NULL;
     uint32_t *rx_cb_meta;
     int metalen;
+    cycles_t prof_dma = 0, prof_skb = 0, prof_fltr = 0;
 
     if (!sinfo->rx[chan].running) {
         /* Rx not ready */
@@ -4137,19 +4401,25 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
     }
 
     while (dcbs_done < budget) {
-        char str[32];
-
         if (!sinfo->rx[chan].running) {
             /* DCBs might be cleaned up when bkn_knet_hw_reset is triggered. */
             return 0;
         }
-        sprintf(str, "Rx DCB (%d)", sinfo->rx[chan].dirty);
         desc = &sinfo->rx[chan].desc[sinfo->rx[chan].dirty];
         dcb = desc->dcb_mem;
-        bkn_dump_dcb(str, dcb, sinfo->dcb_wsize, XGS_DMA_RX_CHAN);
+        if (BKN_DUMP_DCB_ON(XGS_DMA_RX_CHAN)) {
+            char str[32];
+
+            sprintf(str, "Rx DCB (%d)", sinfo->rx[chan].dirty);
+            _bkn_dump_dcb(str, dcb, sinfo->dcb_wsize, XGS_DMA_RX_CHAN);
+        }
         if ((dcb[sinfo->dcb_wsize-1] & (1 << 31)) == 0) {
             break;
         }
+        prof_dma = prof_skb = prof_fltr = 0;
+        if (BKN_RX_PROF_ON()) {
+            prof_dma = get_cycles();
+        }
         if ((sinfo->cmic_type == 'x' && (dcb[2] & (1 << 16)) == 0) ||
             (sinfo->cmic_type != 'x' && (dcb[1] & (1 << 16)) == 0)) {
             sinfo->rx[chan].chain_complete = 1;
@@ -4294,9 +4564,15 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
             } else {
                 match_data = meta;
             }
+            if (prof_dma) {
+                prof_skb = get_cycles();
+            }
             filter = bkn_match_rx_pkt(sinfo, skb->data + pkt_hdr_size + skip_hdrlen,
                                       pktlen - pkt_hdr_size, match_data,
                                       chan, &cbf);
+            if (prof_dma) {
+                prof_fltr = get_cycles();
+            }
 
             if ((dcb[sinfo->dcb_wsize-1] & 0xf0000) != 0x30000) {
                 /* Fragment or error */
@@ -4492,6 +4768,11 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                         netif_rx(skb);
                     }
                     spin_lock(&sinfo->lock);
+                    if (prof_fltr) {
+                        sinfo->rx[chan].prof_netif_pkts++;
+                        sinfo->rx[chan].prof_netif_cycles +=
+                            get_cycles() - prof_fltr;
+                    }
                     /*
                      * Re-enable configuration API once the spinlock
                      * is regained.
@@ -4515,6 +4796,11 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
             sinfo->rx[chan].pkts_d_no_match++;
             priv->stats.rx_dropped++;
         }
+        if (prof_fltr) {
+            sinfo->rx[chan].prof_pkts++;
+            sinfo->rx[chan].prof_skb_cycles += prof_skb - prof_dma;
+            sinfo->rx[chan].prof_fltr_cycles += prof_fltr - prof_skb;
+        }
         dcb[sinfo->dcb_wsize-1] &= ~(1 << 31);
         if (++sinfo->rx[chan].dirty >= MAX_RX_DCBS) {
             sinfo->rx[chan].dirty = 0;
@@ -4850,13 +5136,17 @@ bkn_do_tx(bkn_switch_info_t *sinfo)
     }
 
     while (dcbs_done < MAX_TX_DCBS) {
-        char str[32];
         if (sinfo->tx.free == MAX_TX_DCBS) {
             break;
         }
-        sprintf(str, "Tx DCB (%d)", sinfo->tx.dirty);
         desc = &sinfo->tx.desc[sinfo->tx.dirty];
-        bkn_dump_dcb(str, desc->dcb_mem, sinfo->dcb_wsize, XGS_DMA_TX_CHAN);
+        if (BKN_DUMP_DCB_ON(XGS_DMA_TX_CHAN)) {
+            char str[32];
+
+            sprintf(str, "Tx DCB (%d)", sinfo->tx.dirty);
+            _bkn_dump_dcb(str, desc->dcb_mem, sinfo->dcb_wsize,
+                          XGS_DMA_TX_CHAN);
+        }
         if ((desc->dcb_mem[sinfo->dcb_wsize-1] & (1 << 31)) == 0) {
             break;
         }
@@ -4974,7 +5264,7 @@ bkn_api_tx(bkn_switch_info_t *sinfo)
                                bkn_dcb_chain_t, list);
         DBG_DCB_TX(("Start API Tx DMA, first DCB @ 0x%08x (%d DCBs).\n",
                     (uint32_t)dcb_chain->dcb_dma, dcb_chain->dcb_cnt));
-        for (i = 0; i < dcb_chain->dcb_cnt && debug & DBG_LVL_PDMP; i++) {
+        for (i = 0; i < dcb_chain->dcb_cnt && BKN_DBG_ON(DBG_LVL_PDMP); i++) {
             if (CDMA_CH(sinfo, XGS_DMA_TX_CHAN) && i == dcb_chain->dcb_cnt - 1) {
                 break;
             }
@@ -6745,6 +7035,7 @@ bkn_create_sinfo(int dev_no)
     memset(sinfo, 0, sizeof(*sinfo));
     INIT_LIST_HEAD(&sinfo->ndev_list);
     INIT_LIST_HEAD(&sinfo->rxpf_list);
+    INIT_LIST_HEAD(&sinfo->rxpf_groups);
     sinfo->base_addr = lkbde_get_dev_virt(dev_no);
     sinfo->dma_dev = lkbde_get_dma_dev(dev_no);
     sinfo->pdev = lkbde_get_hw_dev(dev_no);
@@ -7536,7 +7827,7 @@ bkn_proc_debug_write(struct file *file, const char *buf,
 
     if ((ptr = strstr(debug_str, "debug=")) != NULL) {
         ptr += 6;
-        debug = simple_strtol(ptr, NULL, 0);
+        bkn_debug_set(simple_strtol(ptr, NULL, 0));
     } else {
         gprintk("Warning: unknown configuration setting\n");
     }
@@ -7768,6 +8059,134 @@ struct proc_ops bkn_proc_stats_file_ops = {
     .proc_release =     single_release,
 };
 
+/*
+ * Rx Profiling Proc Entry
+ *
+ * Average CPU cycles per packet spent in each stage of the SKB Rx path:
+ * DMA done to SKB/metadata ready, filter lookup, and filter match to
+ * netif_receive_skb done (netif packets only).
+ */
+static uint64_t
+bkn_rx_prof_avg(uint64_t cycles, uint32_t pkts)
+{
+    return pkts ? div_u64(cycles, pkts) : 0;
+}
+
+static int
+bkn_proc_rx_prof_show(struct seq_file *m, void *v)
+{
+    int unit = 0;
+    struct list_head *list;
+    bkn_switch_info_t *sinfo;
+    int chan;
+    unsigned long flags;
+
+    seq_printf(m, "Rx profiling %s (cycles/packet)\n",
+               BKN_RX_PROF_ON() ? "enabled" : "disabled");
+    list_for_each(list, &_sinfo_list) {
+        sinfo = (bkn_switch_info_t *)list;
+        spin_lock_irqsave(&sinfo->lock, flags);
+
+        seq_printf(m, "Device Rx profile (unit %d):\n", unit);
+        for (chan = 0; chan < sinfo->rx_chans; chan++) {
+            seq_printf(m, "  Rx%d packets %10u  skb %8llu  filter %8llu\n",
+                       chan, sinfo->rx[chan].prof_pkts,
+                       bkn_rx_prof_avg(sinfo->rx[chan].prof_skb_cycles,
+                                       sinfo->rx[chan].prof_pkts),
+                       bkn_rx_prof_avg(sinfo->rx[chan].prof_fltr_cycles,
+                                       sinfo->rx[chan].prof_pkts));
+            seq_printf(m, "  Rx%d netif   %10u  netif_receive %8llu\n",
+                       chan, sinfo->rx[chan].prof_netif_pkts,
+                       bkn_rx_prof_avg(sinfo->rx[chan].prof_netif_cycles,
+                                       sinfo->rx[chan].prof_netif_pkts));
+        }
+
+        unit++;
+        spin_unlock_irqrestore(&sinfo->lock, flags);
+    }
+    return 0;
+}
+
+static int bkn_proc_rx_prof_open(struct inode * inode, struct file * file)
+{
+    return single_open(file, bkn_proc_rx_prof_show, NULL);
+}
+
+/*
+ * Rx Profiling Proc Write Entry
+ *
+ *   Syntax:
+ *   [<unit>:]enable|disable|clear
+ *
+ *   Enable and disable apply to all units.
+ *
+ *   Examples:
+ *   enable
+ *   0:clear
+ */
+static ssize_t
+bkn_proc_rx_prof_write(struct file *file, const char *buf,
+                       size_t count, loff_t *loff)
+{
+    bkn_switch_info_t *sinfo;
+    char debug_str[40];
+    unsigned long flags;
+    int unit;
+    int chan;
+
+    if (count > sizeof(debug_str)) {
+        count = sizeof(debug_str) - 1;
+        debug_str[count] = '\0';
+    }
+    if (copy_from_user(debug_str, buf, count)) {
+        return -EFAULT;
+    }
+
+    unit = simple_strtol(debug_str, NULL, 10);
+    sinfo = bkn_sinfo_from_unit(unit);
+    if (sinfo == NULL) {
+        gprintk("Warning: unknown unit: %d\n", unit);
+        return count;
+    }
+
+    if (strstr(debug_str, "enable") != NULL) {
+#ifdef BKN_USE_STATIC_KEYS
+        static_branch_enable(&bkn_rx_prof_key);
+#else
+        bkn_rx_prof_enable = 1;
+#endif
+    } else if (strstr(debug_str, "disable") != NULL) {
+#ifdef BKN_USE_STATIC_KEYS
+        static_branch_disable(&bkn_rx_prof_key);
+#else
+        bkn_rx_prof_enable = 0;
+#endif
+    } else if (strstr(debug_str, "clear") != NULL) {
+        spin_lock_irqsave(&sinfo->lock, flags);
+        for (chan = 0; chan < sinfo->rx_chans; chan++) {
+            sinfo->rx[chan].prof_pkts = 0;
+            sinfo->rx[chan].prof_netif_pkts = 0;
+            sinfo->rx[chan].prof_skb_cycles = 0;
+            sinfo->rx[chan].prof_fltr_cycles = 0;
+            sinfo->rx[chan].prof_netif_cycles = 0;
+        }
+        spin_unlock_irqrestore(&sinfo->lock, flags);
+    } else {
+        gprintk("Warning: unknown configuration setting\n");
+    }
+
+    return count;
+}
+
+struct proc_ops bkn_proc_rx_prof_file_ops = {
+    PROC_OWNER(THIS_MODULE)
+    .proc_open =        bkn_proc_rx_prof_open,
+    .proc_read =        seq_read,
+    .proc_lseek =       seq_lseek,
+    .proc_write =       bkn_proc_rx_prof_write,
+    .proc_release =     single_release,
+};
+
 
 /*
  * Device Debug Statistics Proc Entry
@@ -8090,6 +8509,10 @@ bkn_proc_init(void)
     if (entry == NULL) {
         return -1;
     }
+    PROC_CREATE(entry, "rx_prof", 0666, bkn_proc_root, &bkn_proc_rx_prof_file_ops);
+    if (entry == NULL) {
+        return -1;
+    }
 
     return 0;
 }
@@ -8104,6 +8527,7 @@ bkn_proc_cleanup(void)
     remove_proc_entry("stats", bkn_proc_root);
     remove_proc_entry("dstats", bkn_proc_root);
     remove_proc_entry("ptp_stats", bkn_proc_root);
+    remove_proc_entry("rx_prof", bkn_proc_root);
     return 0;
 }
 
@@ -8986,6 +9410,7 @@ bkn_knet_filter_create(kcom_msg_filter_create_t *kmsg, int len)
     bkn_switch_info_t *sinfo;
     struct list_head *list;
     bkn_filter_t *filter, *lfilter;
+    bkn_filter_group_t *group;
     unsigned long flags;
     int found, id;
     int oob_offset_max;
@@ -9058,6 +9483,31 @@ bkn_knet_filter_create(kcom_msg_filter_create_t *kmsg, int len)
     memcpy(&filter->kf, &kmsg->filter, sizeof(filter->kf));
     filter->kf.id = id;
 
+    /* Find or create classifier group */
+    found = 0;
+    list_for_each(list, &sinfo->rxpf_groups) {
+        group = (bkn_filter_group_t *)list;
+        if (bkn_rxpf_group_equal(group, &filter->kf)) {
+            found = 1;
+            break;
+        }
+    }
+    if (!found) {
+        group = kmalloc(sizeof(*group), GFP_ATOMIC);
+        if (group == NULL) {
+            spin_unlock_irqrestore(&sinfo->lock, flags);
+            kfree(filter);
+            kmsg->hdr.status = KCOM_E_RESOURCE;
+            return sizeof(kcom_msg_hdr_t);
+        }
+        bkn_rxpf_group_init(group, &filter->kf);
+        list_add_tail(&group->list, &sinfo->rxpf_groups);
+    }
+    group->refcnt++;
+    filter->group = group;
+    filter->hashed = bkn_rxpf_filter_hashable(&filter->kf);
+    filter->hash = bkn_rxpf_filter_hash(group, &filter->kf);
+
     /* Add according to priority */
     found = 0;
     list_for_each(list, &sinfo->rxpf_list) {
@@ -9071,6 +9521,7 @@ bkn_knet_filter_create(kcom_msg_filter_create_t *kmsg, int len)
     if (!found) {
         list_add_tail(&filter->list, &sinfo->rxpf_list);
     }
+    bkn_rxpf_rebuild(sinfo);
 
     kmsg->filter.id = filter->kf.id;
 
@@ -9104,6 +9555,7 @@ bkn_knet_filter_destroy(kcom_msg_filter_destroy_t *kmsg, int len)
 {
     bkn_switch_info_t *sinfo;
     bkn_filter_t *filter;
+    bkn_filter_group_t *group;
     struct list_head *list;
     unsigned long flags;
     int found;
@@ -9135,10 +9587,22 @@ bkn_knet_filter_destroy(kcom_msg_filter_destroy_t *kmsg, int len)
 
     list_del(&filter->list);
 
+    /* Release classifier group with last filter */
+    group = filter->group;
+    if (--group->refcnt == 0) {
+        list_del(&group->list);
+    } else {
+        group = NULL;
+    }
+    bkn_rxpf_rebuild(sinfo);
+
     cfg_api_unlock(sinfo, &flags);
 
     DBG_VERB(("Removing filter ID %d.\n", filter->kf.id));
     kfree(filter);
+    if (group) {
+        kfree(group);
+    }
 
     return sizeof(kcom_msg_hdr_t);
 }
@@ -9512,6 +9976,7 @@ _cleanup(void)
     struct list_head *list;
     struct net_device *dev;
     bkn_filter_t *filter;
+    bkn_filter_group_t *group;
     bkn_priv_t *priv;
     bkn_switch_info_t *sinfo;
     unsigned long flags;
@@ -9562,6 +10027,12 @@ _cleanup(void)
             DBG_VERB(("Removing filter ID %d.\n", filter->kf.id));
             kfree(filter);
         }
+        while (!list_empty(&sinfo->rxpf_groups)) {
+            group = list_entry(sinfo->rxpf_groups.next,
+                               bkn_filter_group_t, list);
+            list_del(&group->list);
+            kfree(group);
+        }
 
         /* Destroy all associated virtual net devices */
         while (!list_empty(&sinfo->ndev_list)) {
@@ -9706,6 +10177,9 @@ _init(void)
         return -ENODEV;
     }
 
+    /* Apply debug level from module parameter */
+    bkn_debug_set(debug);
+
     /* Randomize Lower 3 bytes of the MAC address (TESTING ONLY) */
     get_random_bytes(&bkn_dev_mac[3], 3);
 
@@ -42,6 +42,8 @@
 #include <linux/skbuff.h>
 #include <linux/sched.h>
 #include <linux/netdevice.h>
+#include <linux/percpu.h>
+#include <linux/rcupdate.h>
 #include <net/net_namespace.h>
 #include <net/psample.h>
 #include "psample-cb.h"
@@ -96,7 +98,16 @@ MODULE_PARM_DESC(psample_size,
 static int psample_qlen = PSAMPLE_QLEN_DFLT;
 LKM_MOD_PARAM(psample_qlen, "i", int, 0);
 MODULE_PARM_DESC(psample_qlen,
-"psample queue length (default 1024 buffers)");
+"psample queue length per CPU (default 1024 buffers)");
+
+/* Logical ports covered by the port to netif map (HiGig port fields are 8 bits) */
+#define PSAMPLE_PORT_MAP_SIZE 256
+
+/* psample genetlink groups cached per CPU */
+#define PSAMPLE_GROUP_CACHE_SIZE 4
+
+/* Max samples sent to psample per NAPI poll */
+#define PSAMPLE_NAPI_WEIGHT 64
 
 #if !IS_ENABLED(CONFIG_PSAMPLE)
 inline struct 
@@ -104,6 +115,11 @@ psample_group *psample_group_get(struct net *net, u32 group_num)
 {
     return NULL;
 }
+
+inline void
+psample_group_put(struct psample_group *group)
+{
+}
 #endif
 
 /* driver proc entry root */
@@ -113,6 +129,7 @@ static struct proc_dir_entry *knet_cb_proc_root = NULL;
 /* psample general info */
 typedef struct {
     struct list_head netif_list;
+    psample_netif_t __rcu *port_map[PSAMPLE_PORT_MAP_SIZE];
     int netif_count;
     knet_hw_info_t hw;
     struct net *netns;
@@ -127,8 +144,6 @@ typedef struct psample_stats_s {
     unsigned long pkts_f_handled;
     unsigned long pkts_f_pass_through;
     unsigned long pkts_f_dst_mc;
-    unsigned long pkts_c_qlen_cur;
-    unsigned long pkts_c_qlen_hi;
     unsigned long pkts_d_qlen_max;
     unsigned long pkts_d_no_mem;
     unsigned long pkts_d_no_group;
@@ -149,19 +164,37 @@ typedef struct psample_meta_s {
 } psample_meta_t;
 
 typedef struct psample_pkt_s {
-    struct list_head list;
     struct psample_group *group;
     psample_meta_t meta;
-    struct sk_buff *skb;
+    struct sk_buff *skb;        /* preallocated, psample_size bytes */
+    struct sk_buff *oskb;       /* allocated for samples above psample_size */
 } psample_pkt_t;
 
-typedef struct psample_work_s {
-    struct list_head pkt_list;
-    struct work_struct wq;
-    spinlock_t lock;
-} psample_work_t;
-static psample_work_t g_psample_work = {0};
+typedef struct psample_group_cache_s {
+    u32 group_num;
+    struct psample_group *group;
+} psample_group_cache_t;
 
+/*
+ * Per-CPU sample ring. Samples are added by the filter callback and
+ * handed to psample by a NAPI poll on the same CPU, so the ring is
+ * single producer/single consumer and needs no lock.
+ */
+typedef struct psample_ring_s {
+    psample_pkt_t *pkts;
+    unsigned int size;          /* number of slots (power of 2) */
+    unsigned int head;          /* next slot to fill */
+    unsigned int tail;          /* next slot to send */
+    unsigned int qlen_hi;
+    struct napi_struct napi;
+    psample_group_cache_t groups[PSAMPLE_GROUP_CACHE_SIZE];
+} psample_ring_t;
+static DEFINE_PER_CPU(psample_ring_t, g_psample_ring);
+
+/* NAPI instances need a net_device */
+static struct net_device *g_psample_napi_dev = NULL;
+
+/* Caller must hold rcu_read_lock() while using the returned netif */
 static psample_netif_t*
 psample_netif_lookup_by_port(int unit, int port)
 {
@@ -169,7 +202,12 @@ psample_netif_lookup_by_port(int unit, int port)
     psample_netif_t *psample_netif = NULL;
     unsigned long flags;
 
-    /* look for port from list of available net_devices */
+    /* Fast path */
+    if (port >= 0 && port < PSAMPLE_PORT_MAP_SIZE) {
+        return rcu_dereference(g_psample_info.port_map[port]);
+    }
+
+    /* Slow path - look for port from list of available net_devices */
     spin_lock_irqsave(&g_psample_info.lock, flags);
     list_for_each(list, &g_psample_info.netif_list) {
         psample_netif = (psample_netif_t*)list;
@@ -181,7 +219,30 @@ psample_netif_lookup_by_port(int unit, int port)
     spin_unlock_irqrestore(&g_psample_info.lock, flags);
     return (NULL);
 }
-        
+
+/*
+ * Point the port map entry at the lowest ID netif on the port, which is
+ * the first one in the ID sorted netif list. Called with lock held.
+ */
+static void
+psample_port_map_update(int port)
+{
+    struct list_head *list;
+    psample_netif_t *psample_netif, *port_netif = NULL;
+
+    if (port < 0 || port >= PSAMPLE_PORT_MAP_SIZE) {
+        return;
+    }
+    list_for_each(list, &g_psample_info.netif_list) {
+        psample_netif = (psample_netif_t*)list;
+        if (psample_netif->port == port) {
+            port_netif = psample_netif;
+            break;
+        }
+    }
+    rcu_assign_pointer(g_psample_info.port_map[port], port_netif);
+}
+
 static int
 psample_info_get (int unit, psample_info_t *psample_info)
 {
@@ -354,6 +415,8 @@ psample_meta_get(int unit, uint8_t *pkt, void *pkt_meta, psample_meta_t *sflow_m
         return (-1);
     }
 
+    rcu_read_lock();
+
     /* find src port netif (no need to lookup CPU port) */
     if (srcport != 0) {
         if ((psample_netif = psample_netif_lookup_by_port(unit, srcport))) {
@@ -384,6 +447,8 @@ psample_meta_get(int unit, uint8_t *pkt, void *pkt_meta, psample_meta_t *sflow_m
         }
     }
 
+    rcu_read_unlock();
+
     PSAMPLE_CB_DBG_PRINT("%s: srcport %d, dstport %d, src_ifindex 0x%x, dst_ifindex 0x%x, trunc_size %d, sample_rate %d\n", 
             __func__, srcport, dstport, src_ifindex, dst_ifindex, sample_size, sample_rate);
 
@@ -395,58 +460,97 @@ psample_meta_get(int unit, uint8_t *pkt, void *pkt_meta, psample_meta_t *sflow_m
     return (0);
 }
 
+static struct psample_group *
+psample_group_cached_get(psample_ring_t *ring, u32 group_num)
+{
+    struct psample_group *group;
+    int idx;
+
+    for (idx = 0; idx < PSAMPLE_GROUP_CACHE_SIZE; idx++) {
+        if (ring->groups[idx].group == NULL) {
+            break;
+        }
+        if (ring->groups[idx].group_num == group_num) {
+            return ring->groups[idx].group;
+        }
+    }
+
+    /* Cache miss. The reference taken here is held until cleanup. */
+    group = psample_group_get(g_psample_info.netns, group_num);
+    if (group && idx < PSAMPLE_GROUP_CACHE_SIZE) {
+        ring->groups[idx].group_num = group_num;
+        ring->groups[idx].group = group;
+    }
+    return group;
+}
+
+static inline int
+psample_ring_empty(psample_ring_t *ring)
+{
+    return ring->tail == smp_load_acquire(&ring->head);
+}
+
 static void
-psample_task(struct work_struct *work)
+psample_send(psample_pkt_t *pkt)
 {
-    psample_work_t *psample_work = container_of(work, psample_work_t, wq);
-    unsigned long flags;
-    struct list_head *list_ptr, *list_next;
-    psample_pkt_t *pkt;
-
-    spin_lock_irqsave(&psample_work->lock, flags);
-    list_for_each_safe(list_ptr, list_next, &psample_work->pkt_list) {
-        /* dequeue pkt from list */
-        pkt = list_entry(list_ptr, psample_pkt_t, list);
-        list_del(list_ptr);
-        g_psample_stats.pkts_c_qlen_cur--;
-        spin_unlock_irqrestore(&psample_work->lock, flags);
- 
-        /* send to psample */
-        if (pkt) {
+    struct sk_buff *skb = pkt->oskb ? pkt->oskb : pkt->skb;
 #if ((IS_ENABLED(CONFIG_PSAMPLE) && LINUX_VERSION_CODE >= KERNEL_VERSION(5,13,0)) || \
      (defined PSAMPLE_MD_EXTENDED_ATTR && PSAMPLE_MD_EXTENDED_ATTR))
-            struct psample_metadata md = {0};
-            md.trunc_size = pkt->meta.trunc_size;
-            md.in_ifindex = pkt->meta.src_ifindex;
-            md.out_ifindex = pkt->meta.dst_ifindex;
+    struct psample_metadata md = {0};
+    md.trunc_size = pkt->meta.trunc_size;
+    md.in_ifindex = pkt->meta.src_ifindex;
+    md.out_ifindex = pkt->meta.dst_ifindex;
 #endif
-            PSAMPLE_CB_DBG_PRINT("%s: group 0x%x, trunc_size %d, src_ifdx 0x%x, dst_ifdx 0x%x, sample_rate %d\n",
-                    __func__, pkt->group->group_num, 
-                    pkt->meta.trunc_size, pkt->meta.src_ifindex, 
-                    pkt->meta.dst_ifindex, pkt->meta.sample_rate);
+    PSAMPLE_CB_DBG_PRINT("%s: group 0x%x, trunc_size %d, src_ifdx 0x%x, dst_ifdx 0x%x, sample_rate %d\n",
+            __func__, pkt->group->group_num, 
+            pkt->meta.trunc_size, pkt->meta.src_ifindex, 
+            pkt->meta.dst_ifindex, pkt->meta.sample_rate);
 
 #if ((IS_ENABLED(CONFIG_PSAMPLE) && LINUX_VERSION_CODE >= KERNEL_VERSION(5,13,0)) || \
      (defined PSAMPLE_MD_EXTENDED_ATTR && PSAMPLE_MD_EXTENDED_ATTR))
-            psample_sample_packet(pkt->group, 
-                                  pkt->skb,
-                                  pkt->meta.sample_rate,
-                                  &md);
+    psample_sample_packet(pkt->group, 
+                          skb,
+                          pkt->meta.sample_rate,
+                          &md);
 #else
-            psample_sample_packet(pkt->group, 
-                                  pkt->skb, 
-                                  pkt->meta.trunc_size,
-                                  pkt->meta.src_ifindex,
-                                  pkt->meta.dst_ifindex,
-                                  pkt->meta.sample_rate);
+    psample_sample_packet(pkt->group, 
+                          skb, 
+                          pkt->meta.trunc_size,
+                          pkt->meta.src_ifindex,
+                          pkt->meta.dst_ifindex,
+                          pkt->meta.sample_rate);
 #endif
-            g_psample_stats.pkts_f_psample_mod++;
- 
-            dev_kfree_skb_any(pkt->skb);
-            kfree(pkt);
+    g_psample_stats.pkts_f_psample_mod++;
+
+    /* psample copies the data, so the preallocated skb can be reused */
+    if (pkt->oskb) {
+        dev_kfree_skb_any(pkt->oskb);
+        pkt->oskb = NULL;
+    }
+    skb_trim(pkt->skb, 0);
+}
+
+static int
+psample_napi_poll(struct napi_struct *napi, int budget)
+{
+    psample_ring_t *ring = container_of(napi, psample_ring_t, napi);
+    int done = 0;
+
+    while (done < budget && !psample_ring_empty(ring)) {
+        psample_send(&ring->pkts[ring->tail & (ring->size - 1)]);
+        /* release slot to producer */
+        smp_store_release(&ring->tail, ring->tail + 1);
+        done++;
+    }
+
+    if (done < budget) {
+        napi_complete_done(napi, done);
+        /* pick up samples added after the ring was found empty */
+        if (!psample_ring_empty(ring)) {
+            napi_schedule(napi);
         }
-        spin_lock_irqsave(&psample_work->lock, flags);
     }
-    spin_unlock_irqrestore(&psample_work->lock, flags);
+    return done;
 }
 
 int 
@@ -454,6 +558,7 @@ psample_filter_cb(uint8_t * pkt, int size, int dev_no, void *pkt_meta,
                   int chan, kcom_filter_t *kf)
 {
     struct psample_group *group;
+    psample_ring_t *ring;
     psample_meta_t meta;   
     int rv = 0;
     static int info_get = 0;
@@ -472,7 +577,8 @@ psample_filter_cb(uint8_t * pkt, int size, int dev_no, void *pkt_meta,
     g_psample_stats.pkts_f_psample_cb++;
 
     /* get psample group info. psample genetlink group ID passed in kf->dest_id */
-    group = psample_group_get(g_psample_info.netns, kf->dest_id);
+    ring = this_cpu_ptr(&g_psample_ring);
+    group = psample_group_cached_get(ring, kf->dest_id);
     if (!group) {
         gprintk("%s: Could not find psample genetlink group %d\n", __func__, kf->cb_user_data);
         g_psample_stats.pkts_d_no_group++;
@@ -505,46 +611,46 @@ psample_filter_cb(uint8_t * pkt, int size, int dev_no, void *pkt_meta,
 
     /* drop if configured sample rate is 0 */
     if (meta.sample_rate > 0) {
-        unsigned long flags;
         psample_pkt_t *psample_pkt;
         struct sk_buff *skb;
+        unsigned int head, qlen;
 
-        if (g_psample_stats.pkts_c_qlen_cur >= psample_qlen) {
-            gprintk("%s: tail drop due to max qlen %d reached\n", __func__, psample_qlen);
-            g_psample_stats.pkts_d_qlen_max++;
+        if (!ring->pkts) {
+            g_psample_stats.pkts_d_not_ready++;
             goto PSAMPLE_FILTER_CB_PKT_HANDLED;
         }
 
-        if ((psample_pkt = kmalloc(sizeof(psample_pkt_t), GFP_ATOMIC)) == NULL) {
-            gprintk("%s: failed to alloc psample mem for pkt\n", __func__);
-            g_psample_stats.pkts_d_no_mem++;
+        head = ring->head;
+        qlen = head - smp_load_acquire(&ring->tail);
+        if (qlen >= ring->size) {
+            PSAMPLE_CB_DBG_PRINT("%s: tail drop due to max qlen %d reached\n", __func__, ring->size);
+            g_psample_stats.pkts_d_qlen_max++;
             goto PSAMPLE_FILTER_CB_PKT_HANDLED;
         }
-        memcpy(&psample_pkt->meta, &meta, sizeof(psample_meta_t));
-        psample_pkt->group = group;
 
-        if ((skb = dev_alloc_skb(meta.trunc_size)) == NULL) {
-            gprintk("%s: failed to alloc psample mem for pkt skb\n", __func__);
-            g_psample_stats.pkts_d_no_mem++;
-            goto PSAMPLE_FILTER_CB_PKT_HANDLED;
+        psample_pkt = &ring->pkts[head & (ring->size - 1)];
+        skb = psample_pkt->skb;
+        if (meta.trunc_size > skb_tailroom(skb)) {
+            if ((skb = dev_alloc_skb(meta.trunc_size)) == NULL) {
+                gprintk("%s: failed to alloc psample mem for pkt skb\n", __func__);
+                g_psample_stats.pkts_d_no_mem++;
+                goto PSAMPLE_FILTER_CB_PKT_HANDLED;
+            }
+            psample_pkt->oskb = skb;
         }
 
-        /* setup skb to point to pkt */
-        memcpy(skb->data, pkt, meta.trunc_size);
-        skb_put(skb, meta.trunc_size);
-        skb->len = meta.trunc_size;
-        psample_pkt->skb = skb;
+        /* copy truncated pkt into skb */
+        memcpy(skb_put(skb, meta.trunc_size), pkt, meta.trunc_size);
+        memcpy(&psample_pkt->meta, &meta, sizeof(psample_meta_t));
+        psample_pkt->group = group;
 
-        spin_lock_irqsave(&g_psample_work.lock, flags);
-        list_add_tail(&psample_pkt->list, &g_psample_work.pkt_list); 
-        
-        g_psample_stats.pkts_c_qlen_cur++;
-        if (g_psample_stats.pkts_c_qlen_cur > g_psample_stats.pkts_c_qlen_hi) {
-            g_psample_stats.pkts_c_qlen_hi = g_psample_stats.pkts_c_qlen_cur;
+        /* publish slot to NAPI poll */
+        smp_store_release(&ring->head, head + 1);
+        if (qlen + 1 > ring->qlen_hi) {
+            ring->qlen_hi = qlen + 1;
         }
 
-        schedule_work(&g_psample_work.wq);
-        spin_unlock_irqrestore(&g_psample_work.lock, flags);
+        napi_schedule(&ring->napi);
     } else {
         g_psample_stats.pkts_d_sampling_disabled++;
     }    
@@ -602,6 +708,7 @@ psample_netif_create_cb(int unit, kcom_netif_t *netif, struct net_device *dev)
         /* No holes - add to end of list */
         list_add_tail(&psample_netif->list, &g_psample_info.netif_list);
     }
+    psample_port_map_update(psample_netif->port);
     
     spin_unlock_irqrestore(&g_psample_info.lock, flags);
 
@@ -617,6 +724,7 @@ psample_netif_destroy_cb(int unit, kcom_netif_t *netif, struct net_device *dev)
     psample_netif_t *psample_netif;
     unsigned long flags; 
 
+    found = 0;
     if (!netif || !dev) {
         gprintk("%s: netif or net_device is NULL\n", __func__);
         return (-1);
@@ -629,8 +737,10 @@ psample_netif_destroy_cb(int unit, kcom_netif_t *netif, struct net_device *dev)
         if (netif->id == psample_netif->id) {
             found = 1; 
             list_del(&psample_netif->list);
+            psample_port_map_update(psample_netif->port);
             PSAMPLE_CB_DBG_PRINT("%s: removing psample netif '%s'\n", __func__, dev->name);
-            kfree(psample_netif);
+            /* filter callback may still hold it from the port map */
+            kfree_rcu(psample_netif, rcu);
             g_psample_info.netif_count--; 
             break;
         }
@@ -900,7 +1010,7 @@ psample_proc_debug_show(struct seq_file *m, void *v)
     seq_printf(m, "  pkt_hdr_size:    %d\n",   g_psample_info.hw.pkt_hdr_size);
     seq_printf(m, "  cdma_channels:   %d\n",   g_psample_info.hw.cdma_channels);
     seq_printf(m, "  netif_count:     %d\n",   g_psample_info.netif_count);
-    seq_printf(m, "  queue length:    %d\n",   psample_qlen);
+    seq_printf(m, "  queue length:    %d per CPU\n", psample_qlen);
 
     return 0;
 }
@@ -959,6 +1069,18 @@ struct proc_ops psample_proc_debug_file_ops = {
 static int
 psample_proc_stats_show(struct seq_file *m, void *v)
 {
+    psample_ring_t *ring;
+    unsigned long qlen_cur = 0, qlen_hi = 0;
+    int cpu;
+
+    for_each_possible_cpu(cpu) {
+        ring = per_cpu_ptr(&g_psample_ring, cpu);
+        qlen_cur += READ_ONCE(ring->head) - READ_ONCE(ring->tail);
+        if (ring->qlen_hi > qlen_hi) {
+            qlen_hi = ring->qlen_hi;
+        }
+    }
+
     seq_printf(m, "BCM KNET %s Callback Stats\n", PSAMPLE_CB_NAME);
     seq_printf(m, "  DCB type %d\n",                          g_psample_info.hw.dcb_type);
     seq_printf(m, "  pkts filter psample cb         %10lu\n", g_psample_stats.pkts_f_psample_cb);
@@ -966,8 +1088,8 @@ psample_proc_stats_show(struct seq_file *m, void *v)
     seq_printf(m, "  pkts handled by psample        %10lu\n", g_psample_stats.pkts_f_handled);
     seq_printf(m, "  pkts pass through              %10lu\n", g_psample_stats.pkts_f_pass_through);
     seq_printf(m, "  pkts with mc destination       %10lu\n", g_psample_stats.pkts_f_dst_mc);
-    seq_printf(m, "  pkts current queue length      %10lu\n", g_psample_stats.pkts_c_qlen_cur);
-    seq_printf(m, "  pkts high queue length         %10lu\n", g_psample_stats.pkts_c_qlen_hi);
+    seq_printf(m, "  pkts current queue length      %10lu\n", qlen_cur);
+    seq_printf(m, "  pkts high queue length per CPU %10lu\n", qlen_hi);
     seq_printf(m, "  pkts drop max queue length     %10lu\n", g_psample_stats.pkts_d_qlen_max);
     seq_printf(m, "  pkts drop no memory            %10lu\n", g_psample_stats.pkts_d_no_mem);
     seq_printf(m, "  pkts drop no psample group     %10lu\n", g_psample_stats.pkts_d_no_group);
@@ -996,14 +1118,12 @@ static ssize_t
 psample_proc_stats_write(struct file *file, const char *buf,
                     size_t count, loff_t *loff)
 {
-    int qlen_cur = 0;
-    unsigned long flags;
+    int cpu;
 
-    spin_lock_irqsave(&g_psample_work.lock, flags);
-    qlen_cur = g_psample_stats.pkts_c_qlen_cur;
     memset(&g_psample_stats, 0, sizeof(psample_stats_t));
-    g_psample_stats.pkts_c_qlen_cur = qlen_cur;
-    spin_unlock_irqrestore(&g_psample_work.lock, flags);
+    for_each_possible_cpu(cpu) {
+        per_cpu_ptr(&g_psample_ring, cpu)->qlen_hi = 0;
+    }
 
     return count;
 }
@@ -1016,9 +1136,107 @@ struct proc_ops psample_proc_stats_file_ops = {
     .proc_release =   single_release,
 };
 
+static void
+psample_rings_free(void)
+{
+    psample_ring_t *ring;
+    int cpu, idx;
+
+    for_each_possible_cpu(cpu) {
+        ring = per_cpu_ptr(&g_psample_ring, cpu);
+        if (ring->napi.poll) {
+            napi_disable(&ring->napi);
+            netif_napi_del(&ring->napi);
+            ring->napi.poll = NULL;
+        }
+        if (ring->pkts) {
+            for (idx = 0; idx < ring->size; idx++) {
+                if (ring->pkts[idx].skb) {
+                    dev_kfree_skb_any(ring->pkts[idx].skb);
+                }
+                if (ring->pkts[idx].oskb) {
+                    dev_kfree_skb_any(ring->pkts[idx].oskb);
+                }
+            }
+            kfree(ring->pkts);
+            ring->pkts = NULL;
+        }
+        for (idx = 0; idx < PSAMPLE_GROUP_CACHE_SIZE; idx++) {
+            if (ring->groups[idx].group) {
+                psample_group_put(ring->groups[idx].group);
+                ring->groups[idx].group = NULL;
+            }
+        }
+        ring->head = ring->tail = 0;
+    }
+    if (g_psample_napi_dev) {
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6,10,0)
+        free_netdev(g_psample_napi_dev);
+#else
+        kfree(g_psample_napi_dev);
+#endif
+        g_psample_napi_dev = NULL;
+    }
+}
+
+/*
+ * Set up one sample ring per CPU with psample_qlen preallocated skbs
+ * and a NAPI instance to drain it.
+ */
+static int
+psample_rings_init(void)
+{
+    psample_ring_t *ring;
+    unsigned int size;
+    int skb_size;
+    int cpu, idx;
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6,10,0)
+    g_psample_napi_dev = alloc_netdev_dummy(0);
+    if (!g_psample_napi_dev) {
+        return (-1);
+    }
+#else
+    g_psample_napi_dev = kzalloc(sizeof(struct net_device), GFP_KERNEL);
+    if (!g_psample_napi_dev) {
+        return (-1);
+    }
+    init_dummy_netdev(g_psample_napi_dev);
+#endif
+
+    skb_size = psample_size > 0 ? psample_size : PSAMPLE_SIZE_DFLT;
+    size = roundup_pow_of_two(psample_qlen > 0 ? psample_qlen : PSAMPLE_QLEN_DFLT);
+    for_each_possible_cpu(cpu) {
+        ring = per_cpu_ptr(&g_psample_ring, cpu);
+        memset(ring, 0, sizeof(*ring));
+        ring->pkts = kcalloc(size, sizeof(psample_pkt_t), GFP_KERNEL);
+        if (!ring->pkts) {
+            psample_rings_free();
+            return (-1);
+        }
+        ring->size = size;
+        for (idx = 0; idx < size; idx++) {
+            ring->pkts[idx].skb = dev_alloc_skb(skb_size);
+            if (!ring->pkts[idx].skb) {
+                psample_rings_free();
+                return (-1);
+            }
+        }
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6,1,0)
+        netif_napi_add_weight(g_psample_napi_dev, &ring->napi,
+                              psample_napi_poll, PSAMPLE_NAPI_WEIGHT);
+#else
+        netif_napi_add(g_psample_napi_dev, &ring->napi,
+                       psample_napi_poll, PSAMPLE_NAPI_WEIGHT);
+#endif
+        napi_enable(&ring->napi);
+    }
+    return (0);
+}
+
 int psample_cleanup(void)
 {
-    cancel_work_sync(&g_psample_work.wq);
+    psample_rings_free();
     remove_proc_entry("stats", psample_proc_root);
     remove_proc_entry("rate",  psample_proc_root);
     remove_proc_entry("size",  psample_proc_root);
@@ -1079,16 +1297,16 @@ int psample_init(void)
     /* clear data structs */
     memset(&g_psample_stats, 0, sizeof(psample_stats_t));
     memset(&g_psample_info, 0, sizeof(psample_info_t));
-    memset(&g_psample_work, 0, sizeof(psample_work_t));
 
     /* setup psample_info struct */
     INIT_LIST_HEAD(&g_psample_info.netif_list);
     spin_lock_init(&g_psample_info.lock);
 
-    /* setup psample work queue */
-    spin_lock_init(&g_psample_work.lock);
-    INIT_LIST_HEAD(&g_psample_work.pkt_list);
-    INIT_WORK(&g_psample_work.wq, psample_task);
+    /* setup per-CPU sample rings */
+    if (psample_rings_init() < 0) {
+        gprintk("%s: failed to alloc psample rings\n", __func__);
+        return (-1);
+    }
 
     /* get net namespace */
     g_psample_info.netns = get_net_ns_by_pid(current->pid);
@@ -41,6 +41,11 @@
 #include <linux/pci.h>
 #include <linux/module.h>
 #include <linux/if.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
+#include <linux/poll.h>
+#include <linux/timer.h>
+#include <linux/mutex.h>
 
 /* netif */
 #include <netif_osal.h>
@@ -280,6 +285,27 @@ typedef struct
     struct sk_buff                  **pptr_skb_ring;
 } HAL_TAU_PKT_RX_PDMA_T;
 
+typedef struct
+{
+    UI32_T                          unit;
+    void                            *ptr_mem;       /* vmalloc_user() memory mapped to user */
+    UI32_T                          mem_len;
+    HAL_TAU_PKT_RX_RING_HDR_T       *ptr_hdr;       /* written by kernel, never read back  */
+    UI32_T                          block_size;     /* ring geometry, published in ptr_hdr */
+    UI32_T                          block_num;
+    UI32_T                          first_block_offset;
+    UI32_T                          retire_tmo_ms;
+    UI32_T                          cur_blk;        /* block being filled by kernel        */
+    BOOL_T                          blk_open;       /* TRUE when cur_blk is being filled   */
+    UI32_T                          cur_offset;     /* next frame offset in cur_blk        */
+    UI32_T                          last_frame_offset;
+    UI32_T                          seq;
+    spinlock_t                      lock;           /* Rx done tasks and the retire timer  */
+    struct timer_list               retire_timer;
+    atomic_t                        mmap_cnt;
+
+} HAL_TAU_PKT_RX_RING_T;
+
 typedef struct
 {
     /* Rx system configuration */
@@ -303,6 +329,14 @@ typedef struct
                                                   * FALSE when rxStop
                                                   */
 
+    /* mmap Rx ring, replaces sw_queue for the packets to SDK if created.
+     * Kept across Rx init/deinit, the lock and wait queue are set up once
+     * at module init and outlive the ring, since poll() registrations do.
+     */
+    struct mutex                    rx_ring_lock;   /* ring create/destroy, mmap and poll */
+    wait_queue_head_t               rx_ring_wait;
+    HAL_TAU_PKT_RX_RING_T           *ptr_rx_ring;
+
 } HAL_TAU_PKT_RX_CB_T;
 
 /* ----------------------------------------------------------------------------------- Network Device */
@@ -2293,6 +2327,405 @@ _hal_tau_pkt_getPacketDest(
     }
 }
 
+/* ----------------------------------------------------------------------------------- Rx ring */
+#define HAL_TAU_PKT_RX_RING_GET_BLK(__ptr_ring__, __blk__)                         \
+    ((HAL_TAU_PKT_RX_RING_BLK_T *)((UI8_T *)(__ptr_ring__)->ptr_mem +              \
+        (__ptr_ring__)->first_block_offset +                                       \
+        (__ptr_ring__)->block_size * (__blk__)))
+
+/* Must be called with ptr_ring->lock held */
+static void
+_hal_tau_pkt_retireRxRingBlk(
+    HAL_TAU_PKT_RX_RING_T           *ptr_ring,
+    const BOOL_T                    is_tmo)
+{
+    HAL_TAU_PKT_RX_RING_BLK_T       *ptr_blk = HAL_TAU_PKT_RX_RING_GET_BLK(ptr_ring, ptr_ring->cur_blk);
+
+    ptr_blk->len_used = ptr_ring->cur_offset;
+
+    /* frames must be visible before the block is passed to user */
+    smp_wmb();
+    WRITE_ONCE(ptr_blk->status, HAL_TAU_PKT_RX_RING_BLK_STATUS_USER);
+
+    if (TRUE == is_tmo)
+    {
+        ptr_ring->ptr_hdr->retire_tmo++;
+    }
+    else
+    {
+        ptr_ring->ptr_hdr->retire_full++;
+    }
+
+    ptr_ring->blk_open = FALSE;
+    ptr_ring->cur_blk = (ptr_ring->cur_blk + 1) % ptr_ring->block_num;
+
+    wake_up_interruptible(&HAL_TAU_PKT_GET_RX_CB_PTR(ptr_ring->unit)->rx_ring_wait);
+}
+
+/* Must be called with ptr_ring->lock held */
+static NPS_ERROR_NO_T
+_hal_tau_pkt_openRxRingBlk(
+    HAL_TAU_PKT_RX_RING_T           *ptr_ring)
+{
+    HAL_TAU_PKT_RX_RING_BLK_T       *ptr_blk = HAL_TAU_PKT_RX_RING_GET_BLK(ptr_ring, ptr_ring->cur_blk);
+
+    if (HAL_TAU_PKT_RX_RING_BLK_STATUS_KERNEL != READ_ONCE(ptr_blk->status))
+    {
+        return (NPS_E_OTHERS);
+    }
+
+    /* user must be done with the block before it is overwritten */
+    smp_mb();
+
+    ptr_blk->seq = ptr_ring->seq++;
+    ptr_blk->pkt_num = 0;
+    ptr_blk->first_frame_offset = HAL_TAU_PKT_RX_RING_BLK_LEN;
+    ptr_blk->len_used = 0;
+
+    ptr_ring->cur_offset = HAL_TAU_PKT_RX_RING_BLK_LEN;
+    ptr_ring->last_frame_offset = 0;
+    ptr_ring->blk_open = TRUE;
+
+    if (0 != ptr_ring->retire_tmo_ms)
+    {
+        mod_timer(&ptr_ring->retire_timer,
+                  jiffies + msecs_to_jiffies(ptr_ring->retire_tmo_ms));
+    }
+
+    return (NPS_E_OK);
+}
+
+static void
+_hal_tau_pkt_handleRxRingTmo(
+    HAL_TAU_PKT_RX_RING_T           *ptr_ring)
+{
+    spin_lock(&ptr_ring->lock);
+    if (TRUE == ptr_ring->blk_open)
+    {
+        _hal_tau_pkt_retireRxRingBlk(ptr_ring, TRUE);
+    }
+    spin_unlock(&ptr_ring->lock);
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 15, 0)
+static void
+_hal_tau_pkt_retireRxRingTimer(
+    struct timer_list               *ptr_timer)
+{
+    HAL_TAU_PKT_RX_RING_T           *ptr_ring = from_timer(ptr_ring, ptr_timer, retire_timer);
+
+    _hal_tau_pkt_handleRxRingTmo(ptr_ring);
+}
+#else
+static void
+_hal_tau_pkt_retireRxRingTimer(
+    unsigned long                   data)
+{
+    _hal_tau_pkt_handleRxRingTmo((HAL_TAU_PKT_RX_RING_T *)data);
+}
+#endif
+
+/* FUNCTION NAME: _hal_tau_pkt_rxRingEnQueue
+ * PURPOSE:
+ *      To copy the packet to the mmap Rx ring shared with SDK.
+ * INPUT:
+ *      unit            -- The unit ID
+ *      channel         -- The target channel
+ *      ptr_sw_gpd      -- Pointer for the SW Rx GPD link list
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      NPS_E_OK        -- The packet is copied to the ring.
+ *      NPS_E_OTHERS    -- The packet is dropped.
+ * NOTES:
+ *      The SW GPD link list and the skb attached on it are always freed.
+ *      The packet is dropped if it does not fit in a block or if the next
+ *      block is still owned by user.
+ */
+static NPS_ERROR_NO_T
+_hal_tau_pkt_rxRingEnQueue(
+    const UI32_T                    unit,
+    const UI32_T                    channel,
+    HAL_TAU_PKT_RX_SW_GPD_T         *ptr_sw_gpd)
+{
+    HAL_TAU_PKT_RX_CB_T             *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
+    HAL_TAU_PKT_RX_RING_T           *ptr_ring = ptr_rx_cb->ptr_rx_ring;
+    HAL_TAU_PKT_RX_SW_GPD_T         *ptr_sw_first_gpd = ptr_sw_gpd;
+    HAL_TAU_PKT_RX_RING_BLK_T       *ptr_blk = NULL;
+    HAL_TAU_PKT_RX_RING_FRAME_T     *ptr_frame = NULL;
+    HAL_TAU_PKT_RX_RING_FRAME_T     *ptr_last_frame = NULL;
+    struct sk_buff                  *ptr_skb = NULL;
+    NPS_ADDR_T                      phy_addr = 0;
+    UI32_T                          buf_len = 0;
+    UI32_T                          total_len = 0;
+
+    /* unmap dma and get the ring space of the whole packet */
+    while (NULL != ptr_sw_gpd)
+    {
+        phy_addr = NPS_ADDR_32_TO_64(ptr_sw_gpd->rx_gpd.data_buf_addr_hi, ptr_sw_gpd->rx_gpd.data_buf_addr_lo);
+        ptr_skb = (struct sk_buff *)ptr_sw_gpd->ptr_cookie;
+        osal_skb_unmapDma(phy_addr, ptr_skb->len, DMA_FROM_DEVICE);
+
+        buf_len = (HAL_TAU_PKT_CH_LAST_GPD == ptr_sw_gpd->rx_gpd.ch)?
+            ptr_sw_gpd->rx_gpd.cnsm_buf_len : ptr_sw_gpd->rx_gpd.avbl_buf_len;
+        total_len += HAL_TAU_PKT_RX_RING_FRAME_LEN + HAL_TAU_PKT_RX_RING_ALIGN_LEN(buf_len);
+
+        ptr_sw_gpd = ptr_sw_gpd->ptr_next;
+    }
+
+    spin_lock_bh(&ptr_ring->lock);
+
+    if (total_len > ptr_ring->block_size - HAL_TAU_PKT_RX_RING_BLK_LEN)
+    {
+        ptr_ring->ptr_hdr->drop_oversize++;
+        spin_unlock_bh(&ptr_ring->lock);
+        HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_ERR | HAL_TAU_PKT_DBG_RX),
+                        "u=%u, rxch=%u, rx ring drop, pkt size=%u > block size=%u\n",
+                        unit, channel, total_len, ptr_ring->block_size);
+        _hal_tau_pkt_freeRxGpdList(unit, ptr_sw_first_gpd, TRUE);
+        return (NPS_E_OTHERS);
+    }
+
+    if ((TRUE == ptr_ring->blk_open) &&
+        (ptr_ring->cur_offset + total_len > ptr_ring->block_size))
+    {
+        _hal_tau_pkt_retireRxRingBlk(ptr_ring, FALSE);
+    }
+
+    if ((FALSE == ptr_ring->blk_open) &&
+        (NPS_E_OK != _hal_tau_pkt_openRxRingBlk(ptr_ring)))
+    {
+        ptr_ring->ptr_hdr->drop_no_block++;
+        spin_unlock_bh(&ptr_ring->lock);
+        _hal_tau_pkt_freeRxGpdList(unit, ptr_sw_first_gpd, TRUE);
+        return (NPS_E_OTHERS);
+    }
+
+    ptr_blk = HAL_TAU_PKT_RX_RING_GET_BLK(ptr_ring, ptr_ring->cur_blk);
+    if (0 != ptr_ring->last_frame_offset)
+    {
+        ptr_last_frame = (HAL_TAU_PKT_RX_RING_FRAME_T *)((UI8_T *)ptr_blk + ptr_ring->last_frame_offset);
+    }
+
+    ptr_sw_gpd = ptr_sw_first_gpd;
+    while (NULL != ptr_sw_gpd)
+    {
+        ptr_skb = (struct sk_buff *)ptr_sw_gpd->ptr_cookie;
+        buf_len = (HAL_TAU_PKT_CH_LAST_GPD == ptr_sw_gpd->rx_gpd.ch)?
+            ptr_sw_gpd->rx_gpd.cnsm_buf_len : ptr_sw_gpd->rx_gpd.avbl_buf_len;
+
+        ptr_frame = (HAL_TAU_PKT_RX_RING_FRAME_T *)((UI8_T *)ptr_blk + ptr_ring->cur_offset);
+        ptr_frame->next_offset = 0;
+        ptr_frame->channel = channel;
+        ptr_frame->buf_len = buf_len;
+        ptr_frame->rx_complete = ptr_sw_gpd->rx_complete;
+        osal_memcpy(&ptr_frame->rx_gpd, (void *)&ptr_sw_gpd->rx_gpd, sizeof(HAL_TAU_PKT_RX_GPD_T));
+        osal_memcpy((UI8_T *)ptr_frame + HAL_TAU_PKT_RX_RING_FRAME_LEN, ptr_skb->data, buf_len);
+
+        if (NULL != ptr_last_frame)
+        {
+            ptr_last_frame->next_offset = ptr_ring->cur_offset - ptr_ring->last_frame_offset;
+        }
+        ptr_last_frame = ptr_frame;
+        ptr_ring->last_frame_offset = ptr_ring->cur_offset;
+        ptr_ring->cur_offset += HAL_TAU_PKT_RX_RING_FRAME_LEN + HAL_TAU_PKT_RX_RING_ALIGN_LEN(buf_len);
+        ptr_blk->pkt_num++;
+
+        ptr_sw_gpd = ptr_sw_gpd->ptr_next;
+    }
+
+    if (0 == ptr_ring->retire_tmo_ms)
+    {
+        _hal_tau_pkt_retireRxRingBlk(ptr_ring, FALSE);
+    }
+
+    spin_unlock_bh(&ptr_ring->lock);
+
+    /* Must free kernel sw_gpd */
+    _hal_tau_pkt_freeRxGpdList(unit, ptr_sw_first_gpd, TRUE);
+
+    return (NPS_E_OK);
+}
+
+static void
+_hal_tau_pkt_flushRxRing(
+    const UI32_T                    unit)
+{
+    HAL_TAU_PKT_RX_CB_T             *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
+    HAL_TAU_PKT_RX_RING_T           *ptr_ring = ptr_rx_cb->ptr_rx_ring;
+
+    if (NULL == ptr_ring)
+    {
+        return;
+    }
+
+    spin_lock_bh(&ptr_ring->lock);
+    if (TRUE == ptr_ring->blk_open)
+    {
+        _hal_tau_pkt_retireRxRingBlk(ptr_ring, FALSE);
+    }
+    spin_unlock_bh(&ptr_ring->lock);
+
+    /* Return user thread waiting in poll() */
+    wake_up_interruptible(&ptr_rx_cb->rx_ring_wait);
+}
+
+/* Must be called with rx_ring_lock held */
+static void
+_hal_tau_pkt_destroyRxRing(
+    const UI32_T                    unit)
+{
+    HAL_TAU_PKT_RX_CB_T             *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
+    HAL_TAU_PKT_RX_RING_T           *ptr_ring = ptr_rx_cb->ptr_rx_ring;
+
+    if (NULL == ptr_ring)
+    {
+        return;
+    }
+
+    ptr_rx_cb->ptr_rx_ring = NULL;
+    del_timer_sync(&ptr_ring->retire_timer);
+    vfree(ptr_ring->ptr_mem);
+    osal_free(ptr_ring);
+}
+
+/* FUNCTION NAME: _hal_tau_pkt_setRxRing
+ * PURPOSE:
+ *      To create or destroy the mmap Rx ring for the packets to SDK.
+ * INPUT:
+ *      filp            -- The file of the netif device
+ *      unit            -- The unit ID
+ *      ptr_cookie      -- Pointer of the Rx ring cookie
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      NPS_E_OK        -- Successfully handle the IOCTL.
+ * NOTES:
+ *      The ring can be changed only when Rx is stopped, and destroyed only
+ *      when it is not mapped. The mapping length is returned in the cookie.
+ */
+static NPS_ERROR_NO_T
+_hal_tau_pkt_setRxRing(
+    struct file                         *filp,
+    const UI32_T                        unit,
+    HAL_TAU_PKT_IOCTL_RX_RING_COOKIE_T  *ptr_cookie)
+{
+    HAL_TAU_PKT_IOCTL_RX_RING_COOKIE_T  ioctl_data;
+    HAL_TAU_PKT_RX_CB_T                 *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
+    HAL_TAU_PKT_DRV_CB_T                *ptr_cb = HAL_TAU_PKT_GET_DRV_CB_PTR(unit);
+    HAL_TAU_PKT_RX_RING_T               *ptr_ring = NULL;
+    UI32_T                              mem_len = 0;
+    NPS_ERROR_NO_T                      rc = NPS_E_OK;
+
+    osal_io_copyFromUser(&ioctl_data, ptr_cookie, sizeof(HAL_TAU_PKT_IOCTL_RX_RING_COOKIE_T));
+    ioctl_data.mmap_len = 0;
+
+    mutex_lock(&ptr_rx_cb->rx_ring_lock);
+
+    if (0 != (ptr_cb->init_flag & HAL_TAU_PKT_INIT_RX_START))
+    {
+        HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_RX | HAL_TAU_PKT_DBG_ERR),
+                        "u=%u, set rx ring failed, rx started\n", unit);
+        rc = NPS_E_OTHERS;
+    }
+    else if (NULL != ptr_rx_cb->ptr_rx_ring)
+    {
+        if (0 != atomic_read(&ptr_rx_cb->ptr_rx_ring->mmap_cnt))
+        {
+            HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_RX | HAL_TAU_PKT_DBG_ERR),
+                            "u=%u, set rx ring failed, ring still mapped\n", unit);
+            rc = NPS_E_OTHERS;
+        }
+        else
+        {
+            _hal_tau_pkt_destroyRxRing(unit);
+        }
+    }
+
+    if ((NPS_E_OK == rc) && (0 != ioctl_data.block_num))
+    {
+        if ((0 != (ioctl_data.block_size % HAL_TAU_PKT_RX_RING_ALIGN)) ||
+            (ioctl_data.block_size < HAL_TAU_PKT_RX_RING_BLK_LEN + HAL_TAU_PKT_RX_RING_FRAME_LEN) ||
+            (ioctl_data.block_num > (INT_MAX - HAL_TAU_PKT_RX_RING_HDR_LEN - PAGE_SIZE) /
+                                    ioctl_data.block_size))
+        {
+            HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_RX | HAL_TAU_PKT_DBG_ERR),
+                            "u=%u, set rx ring failed, invalid block size=%u num=%u\n",
+                            unit, ioctl_data.block_size, ioctl_data.block_num);
+            rc = NPS_E_BAD_PARAMETER;
+        }
+        else
+        {
+            mem_len = PAGE_ALIGN(HAL_TAU_PKT_RX_RING_HDR_LEN +
+                                 ioctl_data.block_size * ioctl_data.block_num);
+        }
+    }
+
+    if ((NPS_E_OK == rc) && (0 != ioctl_data.block_num))
+    {
+        ptr_ring = osal_alloc(sizeof(HAL_TAU_PKT_RX_RING_T));
+        if (NULL != ptr_ring)
+        {
+            osal_memset(ptr_ring, 0x0, sizeof(HAL_TAU_PKT_RX_RING_T));
+            /* zeroed memory leaves all the blocks owned by kernel */
+            ptr_ring->ptr_mem = vmalloc_user(mem_len);
+        }
+        if ((NULL == ptr_ring) || (NULL == ptr_ring->ptr_mem))
+        {
+            HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_RX | HAL_TAU_PKT_DBG_ERR),
+                            "u=%u, set rx ring failed, alloc size=%u failed\n",
+                            unit, mem_len);
+            if (NULL != ptr_ring)
+            {
+                osal_free(ptr_ring);
+            }
+            rc = NPS_E_NO_MEMORY;
+        }
+    }
+
+    if ((NPS_E_OK == rc) && (NULL != ptr_ring))
+    {
+        ptr_ring->unit = unit;
+        ptr_ring->mem_len = mem_len;
+        ptr_ring->block_size = ioctl_data.block_size;
+        ptr_ring->block_num = ioctl_data.block_num;
+        ptr_ring->first_block_offset = HAL_TAU_PKT_RX_RING_HDR_LEN;
+        ptr_ring->retire_tmo_ms = ioctl_data.retire_tmo_ms;
+
+        /* the header only publishes the geometry, the kernel uses its own copy */
+        ptr_ring->ptr_hdr = (HAL_TAU_PKT_RX_RING_HDR_T *)ptr_ring->ptr_mem;
+        ptr_ring->ptr_hdr->block_size = ptr_ring->block_size;
+        ptr_ring->ptr_hdr->block_num = ptr_ring->block_num;
+        ptr_ring->ptr_hdr->first_block_offset = ptr_ring->first_block_offset;
+        ptr_ring->ptr_hdr->retire_tmo_ms = ptr_ring->retire_tmo_ms;
+        spin_lock_init(&ptr_ring->lock);
+        atomic_set(&ptr_ring->mmap_cnt, 0);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 15, 0)
+        timer_setup(&ptr_ring->retire_timer, _hal_tau_pkt_retireRxRingTimer, 0);
+#else
+        setup_timer(&ptr_ring->retire_timer, _hal_tau_pkt_retireRxRingTimer,
+                    (unsigned long)ptr_ring);
+#endif
+        ptr_rx_cb->ptr_rx_ring = ptr_ring;
+
+        /* poll() on this file waits on the ring of this unit */
+        filp->private_data = (void *)((NPS_HUGE_T)unit);
+        ioctl_data.mmap_len = ptr_ring->mem_len;
+
+        HAL_TAU_PKT_DBG(HAL_TAU_PKT_DBG_RX,
+                        "u=%u, rx ring created, block size=%u num=%u tmo=%ums\n",
+                        unit, ioctl_data.block_size, ioctl_data.block_num,
+                        ioctl_data.retire_tmo_ms);
+    }
+
+    mutex_unlock(&ptr_rx_cb->rx_ring_lock);
+
+    osal_io_copyToUser(&ptr_cookie->mmap_len, &ioctl_data.mmap_len, sizeof(UI32_T));
+    osal_io_copyToUser(&ptr_cookie->rc, &rc, sizeof(NPS_ERROR_NO_T));
+
+    return (NPS_E_OK);
+}
+
 /* FUNCTION NAME: _hal_tau_pkt_rxEnQueue
  * PURPOSE:
  *      To enqueue the packets to multiple queues.
@@ -2481,6 +2914,13 @@ _hal_tau_pkt_rxEnQueue(
         }
 #endif
     }
+    else if ((HAL_TAU_PKT_DEST_SDK == dest_type) && (NULL != ptr_rx_cb->ptr_rx_ring))
+    {
+        if (NPS_E_OK == _hal_tau_pkt_rxRingEnQueue(unit, channel, ptr_sw_first_gpd))
+        {
+            ptr_rx_cb->cnt.channel[channel].enque_ok++;
+        }
+    }
     else if (HAL_TAU_PKT_DEST_SDK == dest_type)
     {
         while (0 != _hal_tau_pkt_enQueue(&ptr_rx_cb->sw_queue[channel], ptr_sw_gpd))
@@ -2970,6 +3410,9 @@ _hal_tau_pkt_rxStop(
 
     osal_triggerEvent(&ptr_rx_cb->sync_sema);
 
+    /* pass the remaining packets in Rx ring to user and return poll() */
+    _hal_tau_pkt_flushRxRing(unit);
+
     return (rc);
 }
 
@@ -4696,7 +5139,8 @@ _hal_tau_pkt_initPktRxCb(
     HAL_TAU_PKT_RX_CHANNEL_T    channel = 0;
     UI32_T                      queue = 0;
 
-    osal_memset(ptr_rx_cb, 0x0, sizeof(HAL_TAU_PKT_RX_CB_T));
+    /* the mmap Rx ring state at the end is kept */
+    osal_memset(ptr_rx_cb, 0x0, offsetof(HAL_TAU_PKT_RX_CB_T, rx_ring_lock));
 
     ptr_rx_cb->sched_mode = HAL_DFLT_CFG_PKT_RX_SCHED_MODE;
 
@@ -6178,6 +6622,126 @@ _hal_tau_pkt_dev_rx(
     return (0);
 }
 
+static void
+_hal_tau_pkt_dev_vm_open(
+    struct vm_area_struct   *vma)
+{
+    HAL_TAU_PKT_RX_RING_T   *ptr_ring = vma->vm_private_data;
+
+    atomic_inc(&ptr_ring->mmap_cnt);
+}
+
+static void
+_hal_tau_pkt_dev_vm_close(
+    struct vm_area_struct   *vma)
+{
+    HAL_TAU_PKT_RX_RING_T   *ptr_ring = vma->vm_private_data;
+
+    atomic_dec(&ptr_ring->mmap_cnt);
+}
+
+static const struct vm_operations_struct _hal_tau_pkt_dev_vm_ops =
+{
+    .open           = _hal_tau_pkt_dev_vm_open,
+    .close          = _hal_tau_pkt_dev_vm_close,
+};
+
+/* The page offset of mmap() selects the unit of the Rx ring */
+static int
+_hal_tau_pkt_dev_mmap(
+    struct file             *file,
+    struct vm_area_struct   *vma)
+{
+    unsigned long           unit = vma->vm_pgoff;
+    HAL_TAU_PKT_RX_CB_T     *ptr_rx_cb = NULL;
+    HAL_TAU_PKT_RX_RING_T   *ptr_ring = NULL;
+    int                     ret = 0;
+
+    if (unit >= NPS_CFG_MAXIMUM_CHIPS_PER_SYSTEM)
+    {
+        return (-EINVAL);
+    }
+
+    ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
+
+    /* the ring cannot be destroyed until mmap_cnt is raised */
+    mutex_lock(&ptr_rx_cb->rx_ring_lock);
+
+    ptr_ring = ptr_rx_cb->ptr_rx_ring;
+    if (NULL == ptr_ring)
+    {
+        ret = -ENODEV;
+    }
+    else if ((vma->vm_end - vma->vm_start) > ptr_ring->mem_len)
+    {
+        ret = -EINVAL;
+    }
+    else
+    {
+        ret = remap_vmalloc_range(vma, ptr_ring->ptr_mem, 0);
+    }
+
+    if (0 == ret)
+    {
+        vma->vm_private_data = ptr_ring;
+        vma->vm_ops = &_hal_tau_pkt_dev_vm_ops;
+        _hal_tau_pkt_dev_vm_open(vma);
+    }
+
+    mutex_unlock(&ptr_rx_cb->rx_ring_lock);
+
+    return (ret);
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 16, 0)
+static __poll_t
+#else
+static unsigned int
+#endif
+_hal_tau_pkt_dev_poll(
+    struct file             *file,
+    poll_table              *wait)
+{
+    UI32_T                  unit = (UI32_T)((NPS_HUGE_T)file->private_data);
+    HAL_TAU_PKT_RX_CB_T     *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
+    HAL_TAU_PKT_RX_RING_T   *ptr_ring = NULL;
+    HAL_TAU_PKT_RX_RING_BLK_T *ptr_blk = NULL;
+    UI32_T                  blk;
+    unsigned int            mask = 0;
+
+    /* the wait queue is not freed with the ring, epoll may keep it */
+    poll_wait(file, &ptr_rx_cb->rx_ring_wait, wait);
+
+    mutex_lock(&ptr_rx_cb->rx_ring_lock);
+
+    ptr_ring = ptr_rx_cb->ptr_rx_ring;
+    if (NULL == ptr_ring)
+    {
+        mutex_unlock(&ptr_rx_cb->rx_ring_lock);
+        return (POLLERR);
+    }
+
+    for (blk = 0; blk < ptr_ring->block_num; blk++)
+    {
+        ptr_blk = HAL_TAU_PKT_RX_RING_GET_BLK(ptr_ring, blk);
+        if (HAL_TAU_PKT_RX_RING_BLK_STATUS_USER == READ_ONCE(ptr_blk->status))
+        {
+            mask |= (POLLIN | POLLRDNORM);
+            break;
+        }
+    }
+
+    mutex_unlock(&ptr_rx_cb->rx_ring_lock);
+
+    /* it means that rx stop flow, same as WAIT_RX_FREE returning failure */
+    if (FALSE == ptr_rx_cb->running)
+    {
+        mask |= POLLHUP;
+    }
+
+    return (mask);
+}
+
 static long
 _hal_tau_pkt_dev_ioctl(
     struct file             *filp,
@@ -6301,6 +6865,11 @@ _hal_tau_pkt_dev_ioctl(
             break;
 #endif
 
+        /* mmap Rx ring */
+        case HAL_TAU_PKT_IOCTL_TYPE_SET_RX_RING:
+            ret = _hal_tau_pkt_setRxRing(filp, unit, (HAL_TAU_PKT_IOCTL_RX_RING_COOKIE_T *)arg);
+            break;
+
         default:
             ret = -1;
             break;
@@ -6327,6 +6896,8 @@ static struct file_operations _hal_tau_pkt_dev_ops =
     .release        = _hal_tau_pkt_dev_close,
     .write          = _hal_tau_pkt_dev_tx,
     .read           = _hal_tau_pkt_dev_rx,
+    .mmap           = _hal_tau_pkt_dev_mmap,
+    .poll           = _hal_tau_pkt_dev_poll,
     .unlocked_ioctl = _hal_tau_pkt_dev_ioctl,
 #ifdef CONFIG_COMPAT
     .compat_ioctl   = _hal_tau_pkt_dev_compat_ioctl,
@@ -6344,6 +6915,8 @@ static struct miscdevice _hal_tau_pkt_dev =
 static int __init
 _hal_tau_pkt_init(void)
 {
+    UI32_T                  unit = 0;
+
     /* Register device */
     misc_register(&_hal_tau_pkt_dev);
 
@@ -6360,6 +6933,12 @@ _hal_tau_pkt_init(void)
     osal_memset(_hal_tau_pkt_drv_cb, 0x0,
                 NPS_CFG_MAXIMUM_CHIPS_PER_SYSTEM*sizeof(HAL_TAU_PKT_DRV_CB_T));
 
+    for (unit = 0; unit < NPS_CFG_MAXIMUM_CHIPS_PER_SYSTEM; unit++)
+    {
+        mutex_init(&_hal_tau_pkt_rx_cb[unit].rx_ring_lock);
+        init_waitqueue_head(&_hal_tau_pkt_rx_cb[unit].rx_ring_wait);
+    }
+
 #if defined(NETIF_EN_NETLINK)
     netif_nl_init();
 #endif
@@ -6392,6 +6971,11 @@ _hal_tau_pkt_exit(void)
     _hal_tau_pkt_destroyAllProfile(unit);
     _hal_tau_pkt_destroyAllIntf(unit);
 
+    /* 7th. Free the Rx ring, it cannot be mapped since the device is closed */
+    mutex_lock(&HAL_TAU_PKT_GET_RX_CB_PTR(unit)->rx_ring_lock);
+    _hal_tau_pkt_destroyRxRing(unit);
+    mutex_unlock(&HAL_TAU_PKT_GET_RX_CB_PTR(unit)->rx_ring_lock);
+
     osal_deinit();
 
     /* Unregister device */
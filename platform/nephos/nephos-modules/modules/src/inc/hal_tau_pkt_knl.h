@@ -2170,6 +2170,8 @@ typedef enum
     HAL_TAU_PKT_IOCTL_TYPE_NL_DESTROY_NETLINK,
     HAL_TAU_PKT_IOCTL_TYPE_NL_GET_NETLINK,
 #endif
+    /* mmap Rx ring */
+    HAL_TAU_PKT_IOCTL_TYPE_SET_RX_RING,      /* setRxRing         */
     HAL_TAU_PKT_IOCTL_TYPE_LAST
 
 } HAL_TAU_PKT_IOCTL_TYPE_T;
@@ -2248,6 +2250,80 @@ typedef struct
 
 } HAL_TAU_PKT_IOCTL_PORT_COOKIE_T;
 
+/* mmap Rx ring for the packets to SDK, modeled on PACKET_MMAP TPACKET_V3.
+ * The ring is mapped with mmap(fd, offset = unit * PAGE_SIZE) and starts with
+ * HAL_TAU_PKT_RX_RING_HDR_T, followed by block_num blocks of block_size bytes.
+ * Each block starts with HAL_TAU_PKT_RX_RING_BLK_T and carries pkt_num frames.
+ * Each frame is a HAL_TAU_PKT_RX_RING_FRAME_T followed by the GPD payload at
+ * HAL_TAU_PKT_RX_RING_FRAME_LEN. The GPDs of one packet are stored in adjacent
+ * frames of the same block, the last one has rx_gpd.ch set.
+ *
+ * The kernel fills one block at a time and passes it to user by setting the
+ * status to USER when it is full or the retire timeout expires, then wakes up
+ * poll(). The user sets the status back to KERNEL once the block is handled.
+ * Apart from the block status, the ring is output only to user: the kernel
+ * keeps its own copy of the geometry and never reads it back from the header.
+ */
+#define HAL_TAU_PKT_RX_RING_ALIGN                   (16)
+#define HAL_TAU_PKT_RX_RING_ALIGN_LEN(__len__)      \
+    (((__len__) + HAL_TAU_PKT_RX_RING_ALIGN - 1) & ~(HAL_TAU_PKT_RX_RING_ALIGN - 1))
+
+#define HAL_TAU_PKT_RX_RING_BLK_STATUS_KERNEL       (0)
+#define HAL_TAU_PKT_RX_RING_BLK_STATUS_USER         (1)
+
+typedef struct
+{
+    UI32_T                          block_size;
+    UI32_T                          block_num;
+    UI32_T                          first_block_offset;
+    UI32_T                          retire_tmo_ms;
+
+    /* counters */
+    UI32_T                          retire_full;        /* blocks retired since full          */
+    UI32_T                          retire_tmo;         /* blocks retired by timeout          */
+    UI32_T                          drop_no_block;      /* next block still owned by user     */
+    UI32_T                          drop_oversize;      /* packet larger than block           */
+
+} HAL_TAU_PKT_RX_RING_HDR_T;
+
+typedef struct
+{
+    volatile UI32_T                 status;
+    UI32_T                          seq;
+    UI32_T                          pkt_num;
+    UI32_T                          first_frame_offset; /* from the start of block */
+    UI32_T                          len_used;
+
+} HAL_TAU_PKT_RX_RING_BLK_T;
+
+typedef struct
+{
+    UI32_T                          next_offset;        /* from this frame, 0 for the last frame */
+    UI32_T                          channel;
+    UI32_T                          buf_len;            /* payload length                        */
+    BOOL_T                          rx_complete;        /* FALSE when PDMA error occurs          */
+    HAL_TAU_PKT_RX_GPD_T            rx_gpd;
+
+} HAL_TAU_PKT_RX_RING_FRAME_T;
+
+#define HAL_TAU_PKT_RX_RING_HDR_LEN     \
+    HAL_TAU_PKT_RX_RING_ALIGN_LEN(sizeof(HAL_TAU_PKT_RX_RING_HDR_T))
+#define HAL_TAU_PKT_RX_RING_BLK_LEN     \
+    HAL_TAU_PKT_RX_RING_ALIGN_LEN(sizeof(HAL_TAU_PKT_RX_RING_BLK_T))
+#define HAL_TAU_PKT_RX_RING_FRAME_LEN   \
+    HAL_TAU_PKT_RX_RING_ALIGN_LEN(sizeof(HAL_TAU_PKT_RX_RING_FRAME_T))
+
+typedef struct
+{
+    UI32_T                          unit;
+    UI32_T                          block_size;         /* setRxRing[In], multiple of HAL_TAU_PKT_RX_RING_ALIGN */
+    UI32_T                          block_num;          /* setRxRing[In], 0 to destroy the ring                 */
+    UI32_T                          retire_tmo_ms;      /* setRxRing[In], 0 to retire the block per packet      */
+    UI32_T                          mmap_len;           /* setRxRing[Out]                                       */
+    NPS_ERROR_NO_T                  rc;
+
+} HAL_TAU_PKT_IOCTL_RX_RING_COOKIE_T;
+
 #if defined(NETIF_EN_NETLINK)
 
 #define NPS_NETIF_NETLINK_NUM_MAX                   (256)
@@ -24,15 +24,46 @@
 #ifndef _ICCP_CMD_SHOW_H
 #define _ICCP_CMD_SHOW_H
 
+#include <stdint.h>
+#include "../include/port.h"
+
 #define ICCP_MAX_PORT_NAME 20
 #define ICCP_MAX_IP_STR_LEN 16
 
+/* Entries scanned per dump call, as a multiple of the entries returned */
+#define ICCP_DUMP_SCAN_FACTOR 8
+
+/* Server side filter of MAC, ARP and ND dumps */
+struct IccpDumpFilter
+{
+    int vid;                                /* 0 for any vlan */
+    char ifname[MAX_L_PORT_NAME + 1];       /* empty for any port */
+    uint8_t mac_prefix[ETHER_ADDR_LEN];
+    int mac_prefix_len;
+};
+
+/* Position of a dump walked in several calls, by the key of the last entry */
+struct IccpDumpCursor
+{
+    int csm_id;             /* mlag_id of the CSM being walked */
+    int started;            /* key below is set */
+    int done;
+    uint16_t vid;
+    uint8_t mac_addr[ETHER_ADDR_LEN];
+    uint32_t ip_addr[4];    /* ARP uses ip_addr[0] */
+};
+
 extern int iccp_mclag_config_dump(char * *buf, int *num, int mclag_id);
-extern int iccp_arp_dump(char * *buf, int *num, int mclag_id);
-extern int iccp_ndisc_dump(char * *buf, int *num, int mclag_id);
-extern int iccp_mac_dump(char * *buf, int *num, int mclag_id);
+extern int iccp_dump_filter_parse(struct IccpDumpFilter *filter, char *vlan, char *ifname, char *mac);
+extern int iccp_arp_dump_next(struct IccpDumpCursor *cursor, struct IccpDumpFilter *filter,
+                              int mclag_id, char *buf, int max_num);
+extern int iccp_ndisc_dump_next(struct IccpDumpCursor *cursor, struct IccpDumpFilter *filter,
+                                int mclag_id, char *buf, int max_num);
+extern int iccp_mac_dump_next(struct IccpDumpCursor *cursor, struct IccpDumpFilter *filter,
+                              int mclag_id, char *buf, int max_num);
 extern int iccp_local_if_dump(char * *buf, int *num, int mclag_id);
 extern int iccp_peer_if_dump(char * *buf, int *num, int mclag_id);
 extern int iccp_cmd_dbg_counter_dump(char * *buf, int *data_len, int mclag_id);
 extern int iccp_unique_ip_if_dump(char * *buf, int *num, int mclag_id);
+extern int iccp_trace_dump(char * *buf, int *num);
 #endif
@@ -38,6 +38,8 @@
 #include "../include/port.h"
 
 #define CSM_BUFFER_SIZE 65536
+/* Peer receive buffer, large enough for a max LDP message plus the next one's start */
+#define CSM_RECV_BUFFER_SIZE (CSM_BUFFER_SIZE * 2)
 
 #ifndef IFNAMSIZ
 #define IFNAMSIZ 16
@@ -71,12 +73,23 @@ struct IccpInfo
     uint32_t rejected_msg_id;
 };
 
+/* Buffers up to this size are kept inside the Msg node; covers ARP, ND and MAC messages */
+#define MSG_INLINE_BUF_SIZE 128
+
+/* Where Msg buf lives */
+#define MSG_BUF_INLINE 0
+#define MSG_BUF_POOL   1
+#define MSG_BUF_HEAP   2
+
 /* Receive message node */
 struct Msg
 {
     char* buf;
     size_t len;
+    uint8_t buf_type;
     TAILQ_ENTRY(Msg) tail;
+    RB_ENTRY(Msg) neigh_entry_rb; /* in arp_rb or ndisc_rb, while on arp_list or ndisc_list */
+    char inline_buf[MSG_INLINE_BUF_SIZE];
 };
 
 /* Connection state */
@@ -122,6 +135,10 @@ struct CSM
     int session_timeout;
     int peer_link_learning_enable;
 
+    /* Peer receive buffer, bytes of a partially received message stay at the front */
+    size_t recv_len;
+    char recv_buf[CSM_RECV_BUFFER_SIZE];
+
     /* Msg queue */
     TAILQ_HEAD(msg_list, Msg) msg_list;
 
@@ -148,6 +165,7 @@ struct CSM
 };
 int iccp_csm_send(struct CSM*, char*, int);
 int iccp_csm_init_msg(struct Msg**, char*, int);
+void iccp_csm_free_msg(struct Msg*);
 int iccp_csm_prepare_nak_msg(struct CSM*, char*, size_t);
 int iccp_csm_prepare_iccp_msg(struct CSM*, char*, size_t);
 int iccp_csm_prepare_capability_msg(struct CSM*, char*, size_t);
@@ -170,4 +188,5 @@ void iccp_csm_correspond_from_rg_disconnect_msg(struct CSM*, struct Msg*);
 
 int mlacp_bind_port_channel_to_csm(struct CSM* csm, const char *ifname);
 int iccp_csm_init_mac_msg(struct MACMsg **mac_msg, char* data, int len);
+void iccp_csm_free_mac_msg(struct MACMsg *mac_msg);
 #endif /* ICCP_CSM_H_ */
@@ -0,0 +1,91 @@
+/*
+ * iccp_mem_pool.h
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * The full GNU General Public License is included in this distribution in
+ * the file called "COPYING".
+ */
+
+#ifndef ICCP_MEM_POOL_H_
+#define ICCP_MEM_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/queue.h>
+
+/* Slabs are aligned to their size, so the slab of an object is found by masking its address */
+#define MEM_POOL_SLAB_SIZE      (64 * 1024)
+
+/* TLV buffers up to this size come from MEM_POOL_MSG_BUF, larger ones from the heap */
+#define MEM_POOL_MSG_BUF_SIZE   1024
+
+#define MEM_POOL_NAME_LEN       16
+
+typedef enum mem_pool_id
+{
+    MEM_POOL_MSG,       /* struct Msg */
+    MEM_POOL_MSG_BUF,   /* Msg buffers too large to be inline */
+    MEM_POOL_MAC_MSG,   /* struct MACMsg */
+    MEM_POOL_MAX
+} MEM_POOL_ID_e;
+
+struct MemPool;
+
+struct MemPoolSlab
+{
+    struct MemPool* pool;
+    void* free_list;        /* objects freed back to this slab */
+    uint32_t carved;        /* objects handed out at least once */
+    uint32_t in_use;
+    LIST_ENTRY(MemPoolSlab) next;
+};
+
+struct MemPool
+{
+    char name[MEM_POOL_NAME_LEN];
+    size_t obj_size;
+    uint32_t objs_per_slab;
+    uint32_t first_obj_offset;
+
+    /* Slabs with free objects, and slabs with none. Empty slabs are released,
+     * except for one spare, so memory goes back once entries are removed */
+    LIST_HEAD(mem_pool_partial_list, MemPoolSlab) partial_list;
+    LIST_HEAD(mem_pool_full_list, MemPoolSlab) full_list;
+    struct MemPoolSlab* spare_slab;
+
+    uint32_t in_use;
+    uint32_t high_water;
+    uint32_t slab_count;
+    uint32_t alloc_fail;
+};
+
+/* Pool counters, as reported in the debug counter dump */
+typedef struct mem_pool_dbg_counter_info
+{
+    char name[MEM_POOL_NAME_LEN];
+    uint32_t obj_size;
+    uint32_t in_use;
+    uint32_t high_water;
+    uint32_t slab_count;
+    uint32_t capacity;
+    uint32_t alloc_fail;
+} mem_pool_dbg_counter_info_t;
+
+void mem_pool_init(struct MemPool* pool, const char* name, size_t obj_size);
+void mem_pool_finalize(struct MemPool* pool);
+void* mem_pool_alloc(struct MemPool* pool);
+void mem_pool_free(void* obj);
+void mem_pool_get_dbg_counters(struct MemPool* pool, mem_pool_dbg_counter_info_t* counters);
+
+#endif /* ICCP_MEM_POOL_H_ */
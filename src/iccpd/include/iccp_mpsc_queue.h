@@ -0,0 +1,47 @@
+/*
+ * iccp_mpsc_queue.h
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * The full GNU General Public License is included in this distribution in
+ * the file called "COPYING".
+ */
+
+#ifndef ICCP_MPSC_QUEUE_H_
+#define ICCP_MPSC_QUEUE_H_
+
+#include <stddef.h>
+
+/* Intrusive lock-free queue, any number of threads may push and a single
+ * thread pops. Embed a MpscNode in the queued object. */
+struct MpscNode
+{
+    struct MpscNode* next;
+};
+
+struct MpscQueue
+{
+    struct MpscNode* head;      /* last pushed node, updated by producers */
+    struct MpscNode* tail;      /* next node to pop, owned by the consumer */
+    struct MpscNode stub;
+};
+
+#define MPSC_NODE_ENTRY(node, type, field) \
+    ((type*)((char*)(node) - offsetof(type, field)))
+
+void mpsc_queue_init(struct MpscQueue* queue);
+void mpsc_queue_push(struct MpscQueue* queue, struct MpscNode* node);
+struct MpscNode* mpsc_queue_pop(struct MpscQueue* queue);
+int mpsc_queue_empty(struct MpscQueue* queue);
+
+#endif /* ICCP_MPSC_QUEUE_H_ */
@@ -50,12 +50,37 @@ struct in6_pktinfo
     unsigned int ipi6_ifindex;  /* send/recv interface index */
 };
 
+typedef enum iccp_kernel_event_type
+{
+    ICCP_KERNEL_EVENT_NETLINK,      /* route netlink datagram */
+    ICCP_KERNEL_EVENT_NETLINK_ERR,  /* route netlink receive error */
+    ICCP_KERNEL_EVENT_ARP,          /* ARP reply */
+    ICCP_KERNEL_EVENT_NDISC         /* neighbor advertisement */
+} ICCP_KERNEL_EVENT_TYPE_e;
+
+/* Read by the kernel worker thread, handled by the scheduler thread */
+struct KernelEvent
+{
+    struct MpscNode node;
+    ICCP_KERNEL_EVENT_TYPE_e type;
+    int err;
+    int sys_errno;
+    unsigned int ifindex;
+    uint8_t addr[16];               /* IPv4 or IPv6 address, network order */
+    uint8_t mac_addr[ETHER_ADDR_LEN];
+    unsigned char *nl_buf;          /* from nl_recv(), freed once handled */
+    int nl_len;
+};
+
 int iccp_get_port_member_list(struct LocalInterface *lif);
 void iccp_event_handler_obj_input_newlink(struct nl_object *obj, void *arg);
 void iccp_event_handler_obj_input_dellink(struct nl_object *obj, void *arg);
 int iccp_system_init_netlink_socket();
 void iccp_system_dinit_netlink_socket();
 int iccp_init_netlink_event_fd(struct System *sys);
+int iccp_kernel_worker_init(struct System *sys);
+int iccp_kernel_worker_start(struct System *sys);
+void iccp_kernel_worker_stop(struct System *sys);
 int iccp_handle_events(struct System *sys);
 void update_if_ipmac_on_standby(struct LocalInterface *lif_po, int dir);
 int iccp_sys_local_if_list_get_addr();
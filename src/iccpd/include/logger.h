@@ -26,6 +26,7 @@
 
 #include <stdint.h>
 #include <syslog.h>
+#include <time.h>
 
 #include "../include/cmd_option.h"
 
@@ -43,22 +44,73 @@ typedef enum _iccpd_log_level_t
 #define LOGBUF_SIZE 1024
 #define ICCPD_UTILS_SYSLOG    (syslog)
 
-#define ICCPD_LOG_CRITICAL(tag, format, args ...) write_log(CRITICAL_LOG_LEVEL, tag, format, ## args)
-#define ICCPD_LOG_ERR(tag, format, args ...) write_log(ERR_LOG_LEVEL, tag, format, ## args)
-#define ICCPD_LOG_WARN(tag, format, args ...) write_log(WARN_LOG_LEVEL, tag, format, ## args)
-#define ICCPD_LOG_NOTICE(tag, format, args ...) write_log(NOTICE_LOG_LEVEL, tag, format, ## args)
-#define ICCPD_LOG_INFO(tag, format, args ...) write_log(INFO_LOG_LEVEL, tag, format, ## args)
-#define ICCPD_LOG_DEBUG(tag, format, args ...) write_log(DEBUG_LOG_LEVEL, tag, format, ## args)
+/* Logs above this level are compiled out */
+#ifndef ICCPD_LOG_LEVEL_MAX
+#define ICCPD_LOG_LEVEL_MAX   DEBUG_LOG_LEVEL
+#endif
+
+#define LOGGER_TAG_MAX_NUM    16
+#define LOGGER_TAG_NAME_LEN   32
+
+#define LOGGER_TRACE_RING_SIZE 2048   /* power of 2 */
+#define LOGGER_TRACE_TAG_LEN   24
+#define LOGGER_TRACE_MSG_LEN   200
+
+struct LoggerTag
+{
+    char name[LOGGER_TAG_NAME_LEN];
+    uint8_t log_level;
+};
 
 struct LoggerConfig
 {
     uint8_t console_log_enabled;
     uint8_t log_level;
     uint8_t init;
+    uint8_t trace_level;    /* logs up to this level go to the trace ring */
+    uint8_t active_level;   /* max of log_level and trace_level */
+    uint8_t tag_num;
+    struct LoggerTag tags[LOGGER_TAG_MAX_NUM];
 };
 
+/* Trace ring record, dumped by mclagdctl */
+struct LoggerTraceRecord
+{
+    uint64_t seq;
+    struct timespec ts;
+    uint8_t level;
+    char tag[LOGGER_TRACE_TAG_LEN];
+    char msg[LOGGER_TRACE_MSG_LEN];
+};
+
+extern struct LoggerConfig g_logger_config;
+
+/* Checked before the log arguments are evaluated */
+#define ICCPD_LOG_ENABLED(level, tag) \
+    ((level) <= ICCPD_LOG_LEVEL_MAX \
+     && ((level) <= g_logger_config.active_level \
+         || (__atomic_load_n(&g_logger_config.tag_num, __ATOMIC_RELAXED) != 0 \
+             && logger_tag_enabled(level, tag))))
+
+#define ICCPD_LOG(level, tag, format, args ...) \
+    do { \
+        if (ICCPD_LOG_ENABLED(level, tag)) \
+            write_log(level, tag, format, ## args); \
+    } while (0)
+
+#define ICCPD_LOG_CRITICAL(tag, format, args ...) ICCPD_LOG(CRITICAL_LOG_LEVEL, tag, format, ## args)
+#define ICCPD_LOG_ERR(tag, format, args ...) ICCPD_LOG(ERR_LOG_LEVEL, tag, format, ## args)
+#define ICCPD_LOG_WARN(tag, format, args ...) ICCPD_LOG(WARN_LOG_LEVEL, tag, format, ## args)
+#define ICCPD_LOG_NOTICE(tag, format, args ...) ICCPD_LOG(NOTICE_LOG_LEVEL, tag, format, ## args)
+#define ICCPD_LOG_INFO(tag, format, args ...) ICCPD_LOG(INFO_LOG_LEVEL, tag, format, ## args)
+#define ICCPD_LOG_DEBUG(tag, format, args ...) ICCPD_LOG(DEBUG_LOG_LEVEL, tag, format, ## args)
+
 struct LoggerConfig* logger_get_configuration();
 void logger_set_configuration(int log_level);
+void logger_set_trace_level(int level);
+int logger_set_tag_level(const char* tag, int level);
+int logger_tag_enabled(int level, const char* tag);
+int logger_trace_dump(struct LoggerTraceRecord* records, int max_num);
 char* log_level_to_string(int level);
 void log_setup(char* progname, char* path);
 void log_finalize();
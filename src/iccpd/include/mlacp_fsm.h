@@ -121,6 +121,7 @@ enum ICCP_DBG_CNTR_MSG
     ICCP_DBG_CNTR_MSG_STP_PO_PORT_MAP  = 26,
     ICCP_DBG_CNTR_MSG_STP_AGE_OUT      = 27,
     ICCP_DBG_CNTR_MSG_STP_COMMON_MSG   = 28,
+    ICCP_DBG_CNTR_MSG_SYNC_DIGEST      = 29,
     ICCP_DBG_CNTR_MSG_MAX
 };
 typedef enum ICCP_DBG_CNTR_MSG ICCP_DBG_CNTR_MSG_e;
@@ -148,6 +149,12 @@ typedef struct mlacp_dbg_counter_info
     uint64_t iccp_counters[ICCP_DBG_CNTR_MSG_MAX][ICCP_DBG_CNTR_DIR_MAX][ICCP_DBG_CNTR_STS_MAX];
 }mlacp_dbg_counter_info_t;
 
+/* ARP and ND entries of arp_list and ndisc_list, keyed by IP address */
+RB_HEAD(arp_rb_tree, Msg);
+RB_PROTOTYPE(arp_rb_tree, Msg, neigh_entry_rb, mlacp_arp_compare);
+RB_HEAD(ndisc_rb_tree, Msg);
+RB_PROTOTYPE(ndisc_rb_tree, Msg, neigh_entry_rb, mlacp_ndisc_compare);
+
 struct mLACP
 {
     int id;
@@ -173,13 +180,23 @@ struct mLACP
     TAILQ_HEAD(mac_msg_list, MACMsg) mac_msg_list;
 
     struct mac_rb_tree mac_rb;
+    struct arp_rb_tree arp_rb;     /* index of arp_list */
+    struct ndisc_rb_tree ndisc_rb; /* index of ndisc_list */
 
     LIST_HEAD(lif_list, LocalInterface) lif_list;
     LIST_HEAD(lif_purge_list, LocalInterface) lif_purge_list;
     LIST_HEAD(pif_list, PeerInterface) pif_list;
+    struct pif_hash_head pif_name_hash[PIF_HASH_SIZE]; /* pif_list by name */
 
     /* ICCP message tx/rx debug counters */
     mlacp_dbg_counter_info_t  dbg_counters;
+
+    /* Reconnect resync by table digest */
+    uint8_t peer_digest_support;        /* peer advertised digest support in stage sync */
+    uint8_t digest_wait;                /* tables not resynced yet, bit per MLACP_DIGEST_TABLE_e */
+    time_t digest_wait_time;
+    struct mLACPMACData *mac_snapshot;  /* peer MACs when the session went down */
+    int mac_snapshot_num;
 };
 
 void mlacp_init(struct CSM* csm, int all);
@@ -188,6 +205,7 @@ void mlacp_fsm_transit(struct CSM* csm);
 void mlacp_enqueue_msg(struct CSM*, struct Msg*);
 struct Msg* mlacp_dequeue_msg(struct CSM*);
 char* mlacp_state(struct CSM* csm);
+void mlacp_sync_mac_snapshot(struct CSM* csm);
 
 /* from app_csm*/
 extern int mlacp_bind_local_if(struct CSM* csm, struct LocalInterface* local_if);
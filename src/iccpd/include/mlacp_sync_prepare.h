@@ -60,4 +60,7 @@ int mlacp_prepare_for_if_up_ack(
     uint8_t           if_type,
     uint16_t          if_id,
     uint8_t           port_isolation_enable);
+int mlacp_prepare_for_sync_digest(struct CSM* csm, char* buf, size_t max_buf_size, uint8_t table, uint64_t* digest);
+int mlacp_prepare_for_sync_digest_support(struct CSM* csm, char* buf, size_t max_buf_size);
+int mlacp_prepare_for_sync_digest_ack(struct CSM* csm, char* buf, size_t max_buf_size, uint8_t table, uint8_t* mismatch);
 #endif
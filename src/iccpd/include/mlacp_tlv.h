@@ -469,6 +469,53 @@ struct mLACPIfUpAckTLV {
     uint16_t        if_id;                   /* LAG: agg_id */
 }__attribute__ ((packed));
 
+/*
+ * NOS: table digest, sent on reconnect instead of replaying the whole
+ * MAC/ARP/ND table. Entries are hashed into buckets by key; a bucket digest
+ * is the sum of the hashes of its entries. The receiver answers with a
+ * digest ack carrying the buckets that did not match, which are the only
+ * ones resynced.
+ */
+#define MLACP_DIGEST_BUCKET_NUM     1024
+#define MLACP_DIGEST_MAP_SIZE       (MLACP_DIGEST_BUCKET_NUM / 8)
+
+typedef uint8_t MLACP_DIGEST_TABLE_e;
+enum MLACP_DIGEST_TABLE_e
+{
+    MLACP_DIGEST_TABLE_MAC   = 0,
+    MLACP_DIGEST_TABLE_ARP   = 1,
+    MLACP_DIGEST_TABLE_NDISC = 2,
+    MLACP_DIGEST_TABLE_MAX
+};
+
+struct mLACPSyncDigestTLV
+{
+    ICCParameter    icc_parameter;
+    uint8_t         table;
+    uint8_t         reserved;
+    uint16_t        bucket_num;
+    uint64_t        digest[0];      /* net order */
+} __attribute__ ((packed));
+
+/*
+ * NOS: sent with the stage sync data, a peer which did not send it gets
+ * its tables resynced in full on reconnect
+ */
+struct mLACPSyncDigestSupportTLV
+{
+    ICCParameter    icc_parameter;
+    uint16_t        bucket_num;
+} __attribute__ ((packed));
+
+struct mLACPSyncDigestAckTLV
+{
+    ICCParameter    icc_parameter;
+    uint8_t         table;
+    uint8_t         reserved;
+    uint16_t        bucket_num;
+    uint8_t         mismatch[0];    /* bitmap of buckets resynced by sender */
+} __attribute__ ((packed));
+
 enum NEIGH_OP_TYPE
 {
     NEIGH_SYNC_LIF = 0,
@@ -45,6 +45,10 @@
  */
 #define MAX_L_PORT_NAME 20
 
+/* Buckets of the interface lookup hashes, power of 2 */
+#define LIF_HASH_SIZE 4096
+#define PIF_HASH_SIZE 256
+
 /* defined in RFC 7275 - 7.2.7 (p.59) */
 #define PORT_STATE_UP               0x00
 #define PORT_STATE_DOWN             0x01
@@ -121,9 +125,13 @@ struct PeerInterface
     struct CSM* csm;
 
     LIST_ENTRY(PeerInterface) mlacp_next;
+    LIST_ENTRY(PeerInterface) name_hash_next;
+    uint8_t name_hashed;
     struct vlan_rb_tree vlan_tree;
 };
 
+LIST_HEAD(pif_hash_head, PeerInterface);
+
 struct LocalInterface
 {
     int ifindex;
@@ -167,12 +175,21 @@ struct LocalInterface
     LIST_ENTRY(LocalInterface) system_purge_next;
     LIST_ENTRY(LocalInterface) mlacp_next;
     LIST_ENTRY(LocalInterface) mlacp_purge_next;
+    LIST_ENTRY(LocalInterface) name_hash_next;
+    LIST_ENTRY(LocalInterface) ifindex_hash_next;
+    LIST_ENTRY(LocalInterface) po_hash_next;
 };
 
+LIST_HEAD(lif_hash_head, LocalInterface);
+
+struct System;
+
 struct LocalInterface* local_if_create(int ifindex, char* ifname, int type, uint8_t state);
 struct LocalInterface* local_if_find_by_name(const char* ifname);
 struct LocalInterface* local_if_find_by_ifindex(int ifindex);
 struct LocalInterface* local_if_find_by_po_id(int po_id);
+void local_if_set_ifindex(struct LocalInterface* local_if, int ifindex);
+void local_if_hash_init(struct System* sys);
 
 void local_if_destroy(char *ifname);
 void local_if_change_flag_clear(void);
@@ -184,6 +201,8 @@ void local_if_finalize(struct LocalInterface*);
 
 struct PeerInterface* peer_if_create(struct CSM* csm, int peer_if_number, int type);
 struct PeerInterface* peer_if_find_by_name(struct CSM* csm, char* name);
+void peer_if_set_name(struct CSM* csm, struct PeerInterface* peer_if, const char* name, int len);
+void peer_if_hash_init(struct CSM* csm);
 
 void peer_if_destroy(struct PeerInterface* pif);
 int peer_if_add_vlan(struct PeerInterface* peer_if, uint16_t vlan_id);
@@ -27,6 +27,7 @@
 #include <err.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <pthread.h>
 #include <sys/select.h>
 
 #include <sys/time.h>
@@ -37,6 +38,8 @@
 #include <linux/netlink.h>
 
 #include "../include/port.h"
+#include "../include/iccp_mem_pool.h"
+#include "../include/iccp_mpsc_queue.h"
 
 #define FRONT_PANEL_PORT_PREFIX "Ethernet"
 #define PORTCHANNEL_PREFIX      "PortChannel"
@@ -129,6 +132,17 @@ do{\
     }\
 }while(0);
 
+/* Count several entries, e.g. FDB entries batched in one message */
+#define SYSTEM_ADD_SYNCD_TX_DBG_COUNTER(sys, syncd_msg_type, status, count)\
+do{\
+    SYNCD_TX_DBG_CNTR_MSG_e dbg_type;\
+    dbg_type = system_syncdtx_to_dbg_msg_type(syncd_msg_type);\
+    if (sys && ((dbg_type) < SYNCD_TX_DBG_CNTR_MSG_MAX) && ((status) < SYNCD_DBG_CNTR_STS_MAX))\
+    {\
+      sys->dbg_counters.syncd_tx_counters[dbg_type][status] += (count);\
+    }\
+}while(0);
+
 /* Count messages ICCP daemon received from MclagSyncd */
 #define SYSTEM_SET_SYNCD_RX_DBG_COUNTER(sys, syncd_msg_type, status)\
 do{\
@@ -239,6 +253,20 @@ do {\
     }\
 }while(0)
 
+/* Called from the kernel worker thread */
+#define SYSTEM_INCR_KERNEL_EVENT_SIGNAL_ERR_COUNTER(sys)\
+do {\
+    if (sys)\
+        __atomic_add_fetch(&(sys)->dbg_counters.kernel_event_signal_err_count, 1, __ATOMIC_RELAXED);\
+} while (0)
+
+/* Called from the kernel worker thread */
+#define SYSTEM_INCR_KERNEL_EVENT_THROTTLE_COUNTER(sys)\
+do {\
+    if (sys)\
+        __atomic_add_fetch(&(sys)->dbg_counters.kernel_event_throttle_count, 1, __ATOMIC_RELAXED);\
+} while (0)
+
 #define SYSTEM_INCR_NETLINK_RX_ERROR()\
 do {\
     struct System *sys;\
@@ -258,6 +286,8 @@ typedef struct system_dbg_counter_info
     uint32_t deladdr_count;
     uint32_t unknown_type_count;
     uint32_t rx_error_count;
+    uint32_t kernel_event_signal_err_count; /* kernel worker failed to wake up the scheduler */
+    uint32_t kernel_event_throttle_count;   /* kernel worker stopped reading on a full queue */
 
     /* Netlink link sub-message count */
     uint32_t unknown_if_name_count;
@@ -288,6 +318,8 @@ typedef struct system_dbg_counter_info
     uint32_t mac_entry_alloc_counter;
     uint32_t mac_entry_free_counter;
 
+    mem_pool_dbg_counter_info_t mem_pools[MEM_POOL_MAX];
+
     uint64_t syncd_tx_counters[SYNCD_TX_DBG_CNTR_MSG_MAX][SYNCD_DBG_CNTR_STS_MAX];
     uint64_t syncd_rx_counters[SYNCD_RX_DBG_CNTR_MSG_MAX][SYNCD_DBG_CNTR_STS_MAX];
 }system_dbg_counter_info_t;
@@ -309,6 +341,21 @@ struct System
     struct nl_sock * genric_event_sock;
     struct nl_sock * route_event_sock;
 
+    /* Kernel worker thread reads route_event_sock, arp_receive_fd and
+     * ndisc_receive_fd, and queues what it got on kernel_event_queue.
+     * kernel_event_fd wakes up the scheduler thread to handle it.
+     * The worker stops reading while kernel_event_depth is at the queue
+     * limit, and the scheduler thread resumes it by kernel_worker_resume_fd. */
+    pthread_t kernel_worker;
+    int kernel_worker_running;
+    int kernel_worker_throttled;
+    int kernel_worker_epoll_fd;
+    int kernel_worker_stop_fd;
+    int kernel_worker_resume_fd;
+    int kernel_event_fd;
+    int kernel_event_depth;
+    struct MpscQueue kernel_event_queue;
+
     int sig_pipe_r;
     int sig_pipe_w;
     int warmboot_start;
@@ -321,6 +368,14 @@ struct System
     LIST_HEAD(unq_ip_all_if_list, Unq_ip_If_info) unq_ip_if_list;
     LIST_HEAD(pending_vlan_mbr_if_list, PendingVlanMbrIf) pending_vlan_mbr_if_list;
 
+    /* Hash indexes of lif_list, by name, ifindex and port channel id */
+    struct lif_hash_head lif_name_hash[LIF_HASH_SIZE];
+    struct lif_hash_head lif_ifindex_hash[LIF_HASH_SIZE];
+    struct lif_hash_head lif_po_hash[LIF_HASH_SIZE];
+
+    /* Pools for Msg, Msg buffer and MACMsg allocations */
+    struct MemPool mem_pools[MEM_POOL_MAX];
+
     /* Settings */
     char* log_file_path;
     char* cmd_file_path;
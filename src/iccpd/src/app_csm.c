@@ -40,8 +40,7 @@
         while (!TAILQ_EMPTY(&(list))) { \
             msg = TAILQ_FIRST(&(list)); \
             TAILQ_REMOVE(&(list), msg, tail); \
-            free(msg->buf); \
-            free(msg); \
+            iccp_csm_free_msg(msg); \
         } \
         TAILQ_INIT(&(list)); \
     }
@@ -109,7 +108,7 @@ void app_csm_enqueue_msg(struct CSM* csm, struct Msg* msg)
     if (csm == NULL )
     {
         if (msg != NULL )
-            free(msg);
+            iccp_csm_free_msg(msg);
         return;
     }
     if (msg == NULL )
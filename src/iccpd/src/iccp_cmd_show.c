@@ -150,202 +150,315 @@ int iccp_mclag_config_dump(char * *buf,  int *num, int mclag_id)
     return EXEC_TYPE_SUCCESS;
 }
 
-int iccp_arp_dump(char * *buf, int *num, int mclag_id)
+/* CSM a dump cursor walks: the current one, or the next one by mclag id
+ * once the current one is finished or gone
+ */
+static struct CSM *iccp_dump_cursor_csm(struct System *sys, int mclag_id, struct IccpDumpCursor *cursor)
+{
+    struct CSM *csm = NULL;
+    struct CSM *next_csm = NULL;
+
+    LIST_FOREACH(csm, &(sys->csm_list), next)
+    {
+        if (mclag_id > 0 && csm->mlag_id != mclag_id)
+            continue;
+
+        if (cursor->started && csm->mlag_id == cursor->csm_id)
+            return csm;
+
+        if (csm->mlag_id > cursor->csm_id && (!next_csm || csm->mlag_id < next_csm->mlag_id))
+            next_csm = csm;
+    }
+
+    if (next_csm)
+    {
+        cursor->csm_id = next_csm->mlag_id;
+        cursor->started = 0;
+    }
+
+    return next_csm;
+}
+
+static int iccp_dump_filter_neigh(struct IccpDumpFilter *filter, char *ifname, uint8_t *mac_addr)
+{
+    char vlan_name[MAX_L_PORT_NAME];
+
+    if (filter->vid)
+    {
+        snprintf(vlan_name, sizeof(vlan_name), "Vlan%d", filter->vid);
+        if (strncmp(ifname, vlan_name, MAX_L_PORT_NAME) != 0)
+            return 0;
+    }
+
+    if (filter->ifname[0] && strncmp(ifname, filter->ifname, MAX_L_PORT_NAME) != 0)
+        return 0;
+
+    if (memcmp(mac_addr, filter->mac_prefix, filter->mac_prefix_len) != 0)
+        return 0;
+
+    return 1;
+}
+
+static int iccp_dump_filter_mac(struct IccpDumpFilter *filter, struct MACMsg *mac_msg)
+{
+    if (filter->vid && mac_msg->vid != filter->vid)
+        return 0;
+
+    if (filter->ifname[0]
+        && strncmp(mac_msg->ifname, filter->ifname, MAX_L_PORT_NAME) != 0
+        && strncmp(mac_msg->origin_ifname, filter->ifname, MAX_L_PORT_NAME) != 0)
+        return 0;
+
+    if (memcmp(mac_msg->mac_addr, filter->mac_prefix, filter->mac_prefix_len) != 0)
+        return 0;
+
+    return 1;
+}
+
+/* Parse the filter of a dump request, empty strings match everything */
+int iccp_dump_filter_parse(struct IccpDumpFilter *filter, char *vlan, char *ifname, char *mac)
+{
+    char *end = NULL;
+    unsigned long val;
+
+    memset(filter, 0, sizeof(struct IccpDumpFilter));
+
+    if (vlan[0])
+    {
+        val = strtoul(vlan, &end, 10);
+        if (*end != '\0' || val == 0 || val > 4095)
+            return MCLAG_ERROR;
+        filter->vid = val;
+    }
+
+    snprintf(filter->ifname, sizeof(filter->ifname), "%s", ifname);
+
+    /* MAC prefix as "xx:xx:..", up to a full address */
+    while (mac[0] && filter->mac_prefix_len < ETHER_ADDR_LEN)
+    {
+        if (!isxdigit(mac[0]))
+            return MCLAG_ERROR;
+
+        val = strtoul(mac, &end, 16);
+        if (end - mac > 2 || (*end != ':' && *end != '\0'))
+            return MCLAG_ERROR;
+
+        filter->mac_prefix[filter->mac_prefix_len++] = val;
+        mac = (*end == ':') ? end + 1 : end;
+    }
+
+    if (mac[0])
+        return MCLAG_ERROR;
+
+    return 0;
+}
+
+/* Fill buf with up to max_num ARP entries after the cursor
+ * Scans a bounded number of entries per call, so a filtered dump of a big
+ * table still gives the scheduler back between calls
+ */
+int iccp_arp_dump_next(struct IccpDumpCursor *cursor, struct IccpDumpFilter *filter,
+                       int mclag_id, char *buf, int max_num)
 {
     struct System *sys = NULL;
     struct CSM *csm = NULL;
     struct Msg *msg = NULL;
+    struct Msg msg_key;
+    struct ARPMsg arp_key;
     struct ARPMsg *iccpd_arp = NULL;
-    struct mclagd_arp_msg mclagd_arp;
+    struct mclagd_arp_msg *mclagd_arp = (struct mclagd_arp_msg *)buf;
     int arp_num = 0;
-    int id_exist = 0;
-    char * arp_buf = NULL;
-    int arp_buf_size = MCLAGDCTL_CMD_SIZE;
+    int scan_num = 0;
 
     if (!(sys = system_get_instance()))
     {
-        return EXEC_TYPE_NO_EXIST_SYS;
+        cursor->done = 1;
+        return 0;
     }
 
-    arp_buf = (char*)malloc(arp_buf_size);
-    if (!arp_buf)
-        return EXEC_TYPE_FAILED;
-
-    LIST_FOREACH(csm, &(sys->csm_list), next)
+    while (arp_num < max_num && scan_num < max_num * ICCP_DUMP_SCAN_FACTOR)
     {
-        if (mclag_id > 0)
+        if (!(csm = iccp_dump_cursor_csm(sys, mclag_id, cursor)))
         {
-            if (csm->mlag_id == mclag_id)
-                id_exist = 1;
-            else
-                continue;
+            cursor->done = 1;
+            break;
         }
 
-        TAILQ_FOREACH(msg, &MLACP(csm).arp_list, tail)
-        {
-            memset(&mclagd_arp, 0, sizeof(struct mclagd_arp_msg));
-            iccpd_arp = (struct ARPMsg*)msg->buf;
+        memset(&arp_key, 0, sizeof(struct ARPMsg));
+        arp_key.ipv4_addr = cursor->started ? cursor->ip_addr[0] : 0;
+        msg_key.buf = (char *)&arp_key;
+        msg = RB_NFIND(arp_rb_tree, &MLACP(csm).arp_rb, &msg_key);
+        if (msg && cursor->started && ((struct ARPMsg *)msg->buf)->ipv4_addr == cursor->ip_addr[0])
+            msg = RB_NEXT(arp_rb_tree, msg);
 
-            mclagd_arp.op_type = iccpd_arp->op_type;
-            mclagd_arp.learn_flag = iccpd_arp->learn_flag;
-            memcpy(mclagd_arp.ifname, iccpd_arp->ifname, strlen(iccpd_arp->ifname));
-            memcpy(mclagd_arp.ipv4_addr, show_ip_str(iccpd_arp->ipv4_addr), 16);
-            memcpy(mclagd_arp.mac_addr, iccpd_arp->mac_addr, 6);
+        for (; msg && arp_num < max_num && scan_num < max_num * ICCP_DUMP_SCAN_FACTOR;
+             msg = RB_NEXT(arp_rb_tree, msg))
+        {
+            iccpd_arp = (struct ARPMsg *)msg->buf;
+            cursor->started = 1;
+            cursor->ip_addr[0] = iccpd_arp->ipv4_addr;
+            scan_num++;
 
-            memcpy(arp_buf + MCLAGD_REPLY_INFO_HDR + arp_num * sizeof(struct mclagd_arp_msg),
-                   &mclagd_arp, sizeof(struct mclagd_arp_msg));
+            if (!iccp_dump_filter_neigh(filter, iccpd_arp->ifname, iccpd_arp->mac_addr))
+                continue;
 
+            memset(mclagd_arp, 0, sizeof(struct mclagd_arp_msg));
+            mclagd_arp->op_type = iccpd_arp->op_type;
+            mclagd_arp->learn_flag = iccpd_arp->learn_flag;
+            memcpy(mclagd_arp->ifname, iccpd_arp->ifname, strnlen(iccpd_arp->ifname, MAX_L_PORT_NAME));
+            memcpy(mclagd_arp->ipv4_addr, show_ip_str(iccpd_arp->ipv4_addr), 16);
+            memcpy(mclagd_arp->mac_addr, iccpd_arp->mac_addr, 6);
+            mclagd_arp++;
             arp_num++;
-
-            if ((arp_num + 1) * sizeof(struct mclagd_arp_msg) > (arp_buf_size - MCLAGD_REPLY_INFO_HDR))
-            {
-                arp_buf_size += MCLAGDCTL_CMD_SIZE;
-                arp_buf = (char*)realloc(arp_buf, arp_buf_size);
-                if (!arp_buf)
-                    return EXEC_TYPE_FAILED;
-            }
         }
-    }
 
-    *buf = arp_buf;
-    *num = arp_num;
-
-    if (mclag_id > 0 && !id_exist)
-        return EXEC_TYPE_NO_EXIST_MCLAGID;
+        /* This CSM is finished, go on with the next one */
+        if (!msg)
+            cursor->started = 0;
+    }
 
-    return EXEC_TYPE_SUCCESS;
+    return arp_num;
 }
 
-int iccp_ndisc_dump(char * *buf, int *num, int mclag_id)
+int iccp_ndisc_dump_next(struct IccpDumpCursor *cursor, struct IccpDumpFilter *filter,
+                         int mclag_id, char *buf, int max_num)
 {
     struct System *sys = NULL;
     struct CSM *csm = NULL;
     struct Msg *msg = NULL;
+    struct Msg msg_key;
+    struct NDISCMsg ndisc_key;
     struct NDISCMsg *iccpd_ndisc = NULL;
-    struct mclagd_ndisc_msg mclagd_ndisc;
+    struct mclagd_ndisc_msg *mclagd_ndisc = (struct mclagd_ndisc_msg *)buf;
     int ndisc_num = 0;
-    int id_exist = 0;
-    char *ndisc_buf = NULL;
-    int ndisc_buf_size = MCLAGDCTL_CMD_SIZE;
+    int scan_num = 0;
 
     if (!(sys = system_get_instance()))
     {
-        return EXEC_TYPE_NO_EXIST_SYS;
+        cursor->done = 1;
+        return 0;
     }
 
-    ndisc_buf = (char *)malloc(ndisc_buf_size);
-    if (!ndisc_buf)
-        return EXEC_TYPE_FAILED;
-
-    LIST_FOREACH(csm, &(sys->csm_list), next)
+    while (ndisc_num < max_num && scan_num < max_num * ICCP_DUMP_SCAN_FACTOR)
     {
-        if (mclag_id > 0)
+        if (!(csm = iccp_dump_cursor_csm(sys, mclag_id, cursor)))
         {
-            if (csm->mlag_id == mclag_id)
-                id_exist = 1;
-            else
-                continue;
+            cursor->done = 1;
+            break;
         }
 
-        TAILQ_FOREACH(msg, &MLACP(csm).ndisc_list, tail)
+        memset(&ndisc_key, 0, sizeof(struct NDISCMsg));
+        if (cursor->started)
+            memcpy(ndisc_key.ipv6_addr, cursor->ip_addr, 16);
+        msg_key.buf = (char *)&ndisc_key;
+        msg = RB_NFIND(ndisc_rb_tree, &MLACP(csm).ndisc_rb, &msg_key);
+        if (msg && cursor->started
+            && memcmp(((struct NDISCMsg *)msg->buf)->ipv6_addr, cursor->ip_addr, 16) == 0)
+            msg = RB_NEXT(ndisc_rb_tree, msg);
+
+        for (; msg && ndisc_num < max_num && scan_num < max_num * ICCP_DUMP_SCAN_FACTOR;
+             msg = RB_NEXT(ndisc_rb_tree, msg))
         {
-            memset(&mclagd_ndisc, 0, sizeof(struct mclagd_ndisc_msg));
             iccpd_ndisc = (struct NDISCMsg *)msg->buf;
+            cursor->started = 1;
+            memcpy(cursor->ip_addr, iccpd_ndisc->ipv6_addr, 16);
+            scan_num++;
 
-            mclagd_ndisc.op_type = iccpd_ndisc->op_type;
-            mclagd_ndisc.learn_flag = iccpd_ndisc->learn_flag;
-            memcpy(mclagd_ndisc.ifname, iccpd_ndisc->ifname, strlen(iccpd_ndisc->ifname));
-            memcpy(mclagd_ndisc.ipv6_addr, show_ipv6_str((char *)iccpd_ndisc->ipv6_addr), 46);
-            memcpy(mclagd_ndisc.mac_addr, iccpd_ndisc->mac_addr, 6);
-
-            memcpy(ndisc_buf + MCLAGD_REPLY_INFO_HDR + ndisc_num * sizeof(struct mclagd_ndisc_msg), &mclagd_ndisc, sizeof(struct mclagd_ndisc_msg));
+            if (!iccp_dump_filter_neigh(filter, iccpd_ndisc->ifname, iccpd_ndisc->mac_addr))
+                continue;
 
+            memset(mclagd_ndisc, 0, sizeof(struct mclagd_ndisc_msg));
+            mclagd_ndisc->op_type = iccpd_ndisc->op_type;
+            mclagd_ndisc->learn_flag = iccpd_ndisc->learn_flag;
+            memcpy(mclagd_ndisc->ifname, iccpd_ndisc->ifname, strnlen(iccpd_ndisc->ifname, MAX_L_PORT_NAME));
+            memcpy(mclagd_ndisc->ipv6_addr, show_ipv6_str((char *)iccpd_ndisc->ipv6_addr), 46);
+            memcpy(mclagd_ndisc->mac_addr, iccpd_ndisc->mac_addr, 6);
+            mclagd_ndisc++;
             ndisc_num++;
-
-            if ((ndisc_num + 1) * sizeof(struct mclagd_ndisc_msg) > (ndisc_buf_size - MCLAGD_REPLY_INFO_HDR))
-            {
-                ndisc_buf_size += MCLAGDCTL_CMD_SIZE;
-                ndisc_buf = (char *)realloc(ndisc_buf, ndisc_buf_size);
-                if (!ndisc_buf)
-                    return EXEC_TYPE_FAILED;
-            }
         }
-    }
 
-    *buf = ndisc_buf;
-    *num = ndisc_num;
-
-    if (mclag_id > 0 && !id_exist)
-        return EXEC_TYPE_NO_EXIST_MCLAGID;
+        if (!msg)
+            cursor->started = 0;
+    }
 
-    return EXEC_TYPE_SUCCESS;
+    return ndisc_num;
 }
 
-int iccp_mac_dump(char * *buf, int *num, int mclag_id)
+int iccp_mac_dump_next(struct IccpDumpCursor *cursor, struct IccpDumpFilter *filter,
+                       int mclag_id, char *buf, int max_num)
 {
     struct System *sys = NULL;
     struct CSM *csm = NULL;
-    struct Msg *msg = NULL;
+    struct MACMsg mac_key;
     struct MACMsg *iccpd_mac = NULL;
-    struct mclagd_mac_msg mclagd_mac;
+    struct mclagd_mac_msg *mclagd_mac = (struct mclagd_mac_msg *)buf;
     int mac_num = 0;
-    int id_exist = 0;
-    char * mac_buf = NULL;
-    int mac_buf_size = MCLAGDCTL_CMD_SIZE;
+    int scan_num = 0;
 
     if (!(sys = system_get_instance()))
     {
-        return EXEC_TYPE_NO_EXIST_SYS;
+        cursor->done = 1;
+        return 0;
     }
 
-    mac_buf = (char*)malloc(mac_buf_size);
-    if (!mac_buf)
-        return EXEC_TYPE_FAILED;
-
-    LIST_FOREACH(csm, &(sys->csm_list), next)
+    while (mac_num < max_num && scan_num < max_num * ICCP_DUMP_SCAN_FACTOR)
     {
-        if (mclag_id > 0)
+        if (!(csm = iccp_dump_cursor_csm(sys, mclag_id, cursor)))
         {
-            if (csm->mlag_id == mclag_id)
-                id_exist = 1;
-            else
-                continue;
+            cursor->done = 1;
+            break;
+        }
+
+        /* The tree is ordered by vid first, a vlan filter starts at its vid */
+        memset(&mac_key, 0, sizeof(struct MACMsg));
+        if (cursor->started)
+        {
+            mac_key.vid = cursor->vid;
+            memcpy(mac_key.mac_addr, cursor->mac_addr, ETHER_ADDR_LEN);
         }
+        else
+        {
+            mac_key.vid = filter->vid;
+        }
+        iccpd_mac = RB_NFIND(mac_rb_tree, &MLACP(csm).mac_rb, &mac_key);
+        if (iccpd_mac && cursor->started && iccpd_mac->vid == cursor->vid
+            && memcmp(iccpd_mac->mac_addr, cursor->mac_addr, ETHER_ADDR_LEN) == 0)
+            iccpd_mac = RB_NEXT(mac_rb_tree, iccpd_mac);
 
-        RB_FOREACH (iccpd_mac, mac_rb_tree, &MLACP(csm).mac_rb)
+        for (; iccpd_mac && mac_num < max_num && scan_num < max_num * ICCP_DUMP_SCAN_FACTOR;
+             iccpd_mac = RB_NEXT(mac_rb_tree, iccpd_mac))
         {
-            memset(&mclagd_mac, 0, sizeof(struct mclagd_mac_msg));
+            if (filter->vid && iccpd_mac->vid > filter->vid)
+            {
+                iccpd_mac = NULL;
+                break;
+            }
 
-            mclagd_mac.op_type = iccpd_mac->op_type;
-            mclagd_mac.fdb_type = iccpd_mac->fdb_type;
-            memcpy(mclagd_mac.mac_addr, iccpd_mac->mac_addr, ETHER_ADDR_LEN);
-            mclagd_mac.vid = iccpd_mac->vid;
-            memcpy(mclagd_mac.ifname, iccpd_mac->ifname, strlen(iccpd_mac->ifname));
-            memcpy(mclagd_mac.origin_ifname, iccpd_mac->origin_ifname, strlen(iccpd_mac->origin_ifname));
-            mclagd_mac.age_flag = iccpd_mac->age_flag;
+            cursor->started = 1;
+            cursor->vid = iccpd_mac->vid;
+            memcpy(cursor->mac_addr, iccpd_mac->mac_addr, ETHER_ADDR_LEN);
+            scan_num++;
 
-            memcpy(mac_buf + MCLAGD_REPLY_INFO_HDR + mac_num * sizeof(struct mclagd_mac_msg),
-                   &mclagd_mac, sizeof(struct mclagd_mac_msg));
+            if (!iccp_dump_filter_mac(filter, iccpd_mac))
+                continue;
 
+            memset(mclagd_mac, 0, sizeof(struct mclagd_mac_msg));
+            mclagd_mac->op_type = iccpd_mac->op_type;
+            mclagd_mac->fdb_type = iccpd_mac->fdb_type;
+            memcpy(mclagd_mac->mac_addr, iccpd_mac->mac_addr, ETHER_ADDR_LEN);
+            mclagd_mac->vid = iccpd_mac->vid;
+            memcpy(mclagd_mac->ifname, iccpd_mac->ifname, strnlen(iccpd_mac->ifname, MAX_L_PORT_NAME));
+            memcpy(mclagd_mac->origin_ifname, iccpd_mac->origin_ifname, strnlen(iccpd_mac->origin_ifname, MAX_L_PORT_NAME));
+            mclagd_mac->age_flag = iccpd_mac->age_flag;
+            mclagd_mac++;
             mac_num++;
-
-            if ((mac_num + 1) * sizeof(struct mclagd_mac_msg) > (mac_buf_size - MCLAGD_REPLY_INFO_HDR))
-            {
-                mac_buf_size += MCLAGDCTL_CMD_SIZE;
-                mac_buf = (char*)realloc(mac_buf, mac_buf_size);
-                if (!mac_buf)
-                    return EXEC_TYPE_FAILED;
-            }
-        }
         }
 
-    *buf = mac_buf;
-    *num = mac_num;
-
-    if (mclag_id > 0 && !id_exist)
-        return EXEC_TYPE_NO_EXIST_MCLAGID;
+        if (!iccpd_mac)
+            cursor->started = 0;
+    }
 
-    return EXEC_TYPE_SUCCESS;
+    return mac_num;
 }
 
 int iccp_local_if_dump(char * *buf,  int *num, int mclag_id)
@@ -706,6 +819,7 @@ int iccp_cmd_dbg_counter_dump(char **buf, int *data_len, int mclag_id)
     int buf_size = 0;
     int id_exist = 0;
     int num_csm = 0;
+    int i;
     bool is_first_csm;
 
     if (!(sys = system_get_instance()))
@@ -731,6 +845,8 @@ int iccp_cmd_dbg_counter_dump(char **buf, int *data_len, int mclag_id)
     memset(counter_buf, 0, buf_size);
     counter_ptr =
         (mclagd_dbg_counter_info_t *)(counter_buf + MCLAGD_REPLY_INFO_HDR);
+    for (i = 0; i < MEM_POOL_MAX; ++i)
+        mem_pool_get_dbg_counters(&(sys->mem_pools[i]), &(sys->dbg_counters.mem_pools[i]));
     memcpy(&counter_ptr->system_dbg, &sys->dbg_counters, sizeof(sys->dbg_counters));
     counter_ptr->num_iccp_counter_blocks = num_csm;
     temp_ptr = counter_ptr->iccp_dbg_counters;
@@ -812,3 +928,47 @@ int iccp_unique_ip_if_dump(char **buf, int *num, int mclag_id)
 
     return EXEC_TYPE_SUCCESS;
 }
+
+/* Copy the logger trace ring, oldest record first
+ * The allocated buffer should include MCLAGD_REPLY_INFO_HDR byte header
+ */
+int iccp_trace_dump(char **buf, int *num)
+{
+    struct LoggerTraceRecord *records = NULL;
+    struct mclagd_trace_msg *trace_msg = NULL;
+    char *trace_buf = NULL;
+    int trace_num = 0;
+    int i;
+
+    records = (struct LoggerTraceRecord*)malloc(LOGGER_TRACE_RING_SIZE * sizeof(struct LoggerTraceRecord));
+    if (!records)
+        return EXEC_TYPE_FAILED;
+
+    trace_num = logger_trace_dump(records, LOGGER_TRACE_RING_SIZE);
+
+    trace_buf = (char*)malloc(MCLAGD_REPLY_INFO_HDR + trace_num * sizeof(struct mclagd_trace_msg));
+    if (!trace_buf)
+    {
+        free(records);
+        return EXEC_TYPE_FAILED;
+    }
+
+    trace_msg = (struct mclagd_trace_msg*)(trace_buf + MCLAGD_REPLY_INFO_HDR);
+    for (i = 0; i < trace_num; i++, trace_msg++)
+    {
+        memset(trace_msg, 0, sizeof(struct mclagd_trace_msg));
+        trace_msg->seq = records[i].seq;
+        trace_msg->sec = records[i].ts.tv_sec;
+        trace_msg->nsec = records[i].ts.tv_nsec;
+        trace_msg->level = records[i].level;
+        memcpy(trace_msg->tag, records[i].tag, MCLAGDCTL_TRACE_TAG_LEN - 1);
+        memcpy(trace_msg->msg, records[i].msg, MCLAGDCTL_TRACE_MSG_LEN - 1);
+    }
+
+    free(records);
+
+    *buf = trace_buf;
+    *num = trace_num;
+
+    return EXEC_TYPE_SUCCESS;
+}
@@ -41,8 +41,7 @@
         while (!TAILQ_EMPTY(&(list))) { \
             msg = TAILQ_FIRST(&(list)); \
             TAILQ_REMOVE(&(list), msg, tail); \
-            free(msg->buf); \
-            free(msg); \
+            iccp_csm_free_msg(msg); \
         } \
         TAILQ_INIT(&(list)); \
     }
@@ -138,6 +137,7 @@ void iccp_csm_status_reset(struct CSM* csm, int all)
     }
 
     csm->sock_fd = -1;
+    csm->recv_len = 0;
     pthread_mutex_init(&csm->conn_mutex, NULL);
     csm->connTimePrev = 0;
     csm->heartbeat_send_time = 0;
@@ -237,7 +237,7 @@ void iccp_csm_msg_list_finalize(struct CSM* csm)
     {
         msg = TAILQ_FIRST(&(csm->msg_list));
         TAILQ_REMOVE(&(csm->msg_list), msg, tail);
-        free(msg);
+        iccp_csm_free_msg(msg);
     }
 }
 
@@ -660,8 +660,7 @@ void iccp_csm_correspond_from_msg(struct CSM* csm, struct Msg* msg)
         ++csm->u_msg_in_count;
     }
 
-    free(msg->buf);
-    free(msg);
+    iccp_csm_free_msg(msg);
 }
 
 /* Receive capability message correspond function */
@@ -728,7 +727,7 @@ void iccp_csm_enqueue_msg(struct CSM* csm, struct Msg* msg)
     if (csm == NULL)
     {
         if (msg != NULL)
-            free(msg);
+            iccp_csm_free_msg(msg);
         return;
     }
 
@@ -785,6 +784,7 @@ struct Msg* iccp_csm_dequeue_msg(struct CSM* csm)
 /* Message initialization */
 int iccp_csm_init_msg(struct Msg** msg, char* data, int len)
 {
+    struct System* sys = NULL;
     struct Msg* iccp_msg = NULL;
 
     if (msg == NULL)
@@ -793,43 +793,74 @@ int iccp_csm_init_msg(struct Msg** msg, char* data, int len)
     if (data == NULL || len <= 0)
         return MCLAG_ERROR;
 
-    iccp_msg = (struct Msg*)malloc(sizeof(struct Msg));
+    if ((sys = system_get_instance()) == NULL)
+        return MCLAG_ERROR;
+
+    iccp_msg = (struct Msg*)mem_pool_alloc(&(sys->mem_pools[MEM_POOL_MSG]));
     if (iccp_msg == NULL)
-        goto err_ret;
+        return MCLAG_ERROR;
+
+    /* Small messages are kept inline, TLVs up to MEM_POOL_MSG_BUF_SIZE come from
+     * the buffer pool, and only larger ones from the heap */
+    if (len <= MSG_INLINE_BUF_SIZE)
+    {
+        iccp_msg->buf = iccp_msg->inline_buf;
+        iccp_msg->buf_type = MSG_BUF_INLINE;
+    }
+    else if (len <= MEM_POOL_MSG_BUF_SIZE)
+    {
+        iccp_msg->buf = (char*)mem_pool_alloc(&(sys->mem_pools[MEM_POOL_MSG_BUF]));
+        iccp_msg->buf_type = MSG_BUF_POOL;
+    }
+    else
+    {
+        iccp_msg->buf = (char*)malloc(len);
+        iccp_msg->buf_type = MSG_BUF_HEAP;
+    }
 
-    iccp_msg->buf = (char*)malloc(len);
     if (iccp_msg->buf == NULL)
-        goto err_ret;
+    {
+        mem_pool_free(iccp_msg);
+        return MCLAG_ERROR;
+    }
 
     memcpy(iccp_msg->buf, data, len);
     iccp_msg->len = len;
     *msg = iccp_msg;
 
     return 0;
+}
 
- err_ret:
-    if (iccp_msg)
-    {
-        if (iccp_msg->buf)
-            free(iccp_msg->buf);
-        free(iccp_msg);
-    }
+/* Release a message from iccp_csm_init_msg, with its buffer */
+void iccp_csm_free_msg(struct Msg* msg)
+{
+    if (msg == NULL)
+        return;
+
+    if (msg->buf_type == MSG_BUF_POOL)
+        mem_pool_free(msg->buf);
+    else if (msg->buf_type == MSG_BUF_HEAP)
+        free(msg->buf);
 
-    return MCLAG_ERROR;
+    mem_pool_free(msg);
 }
 
 /* MAC Message initialization */
 int iccp_csm_init_mac_msg(struct MACMsg **mac_msg, char* data, int len)
 {
+    struct System* sys = NULL;
     struct MACMsg* iccp_mac_msg = NULL;
 
     if (mac_msg == NULL)
         return -2;
 
-    if (data == NULL || len <= 0)
+    if (data == NULL || len <= 0 || len > (int)sizeof(struct MACMsg))
+        return MCLAG_ERROR;
+
+    if ((sys = system_get_instance()) == NULL)
         return MCLAG_ERROR;
 
-    iccp_mac_msg = (struct MACMsg*)malloc(sizeof(struct MACMsg));
+    iccp_mac_msg = (struct MACMsg*)mem_pool_alloc(&(sys->mem_pools[MEM_POOL_MAC_MSG]));
     if (iccp_mac_msg == NULL)
        return -3;
 
@@ -837,10 +868,24 @@ int iccp_csm_init_mac_msg(struct MACMsg **mac_msg, char* data, int len)
     memcpy(iccp_mac_msg, data, len);
 
     *mac_msg = iccp_mac_msg;
+    SYSTEM_INCR_MAC_ENTRY_ALLOC_COUNTER(sys);
 
     return 0;
 }
 
+/* Release a MAC entry from iccp_csm_init_mac_msg */
+void iccp_csm_free_mac_msg(struct MACMsg *mac_msg)
+{
+    struct System* sys = NULL;
+
+    if (mac_msg == NULL)
+        return;
+
+    mem_pool_free(mac_msg);
+
+    sys = system_get_instance();
+    SYSTEM_INCR_MAC_ENTRY_FREE_COUNTER(sys);
+}
 
 void iccp_csm_stp_role_count(struct CSM *csm)
 {
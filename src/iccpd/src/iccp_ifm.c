@@ -277,19 +277,17 @@ static void do_arp_learn_from_kernel(struct ndmsg *ndm, struct rtattr *tb[], int
     }
 
     /* update lif ARP*/
-    TAILQ_FOREACH(msg, &MLACP(csm).arp_list, tail)
+    msg = mlacp_find_arp(csm, arp_msg->ipv4_addr);
+    if (msg)
     {
         arp_info = (struct ARPMsg *)msg->buf;
-        if (arp_info->ipv4_addr != arp_msg->ipv4_addr)
-            continue;
 
         entry_exists = 1;
         if (msgtype == RTM_DELNEIGH)
         {
             /* delete ARP*/
-            TAILQ_REMOVE(&MLACP(csm).arp_list, msg, tail);
-            free(msg->buf);
-            free(msg);
+            mlacp_dequeue_arp(csm, msg);
+            iccp_csm_free_msg(msg);
             msg = NULL;
             ICCPD_LOG_DEBUG(__FUNCTION__, "Delete ARP %s", show_ip_str(arp_msg->ipv4_addr));
         }
@@ -307,7 +305,6 @@ static void do_arp_learn_from_kernel(struct ndmsg *ndm, struct rtattr *tb[], int
                 ICCPD_LOG_DEBUG(__FUNCTION__, "Update ARP for %s", show_ip_str(arp_msg->ipv4_addr));
             }
         }
-        break;
     }
 
     if (msg && !arp_update)
@@ -551,20 +548,17 @@ static void do_ndisc_learn_from_kernel(struct ndmsg *ndm, struct rtattr *tb[], i
     }
 
     /* update lif ND */
-    TAILQ_FOREACH(msg, &MLACP(csm).ndisc_list, tail)
+    msg = mlacp_find_ndisc(csm, ndisc_msg->ipv6_addr);
+    if (msg)
     {
         ndisc_info = (struct NDISCMsg *)msg->buf;
 
-        if (memcmp(&ndisc_info->ipv6_addr, &ndisc_msg->ipv6_addr, 16) != 0)
-            continue;
-
         entry_exists = 1;
         if (msgtype == RTM_DELNEIGH)
         {
             /* delete ND */
-            TAILQ_REMOVE(&MLACP(csm).ndisc_list, msg, tail);
-            free(msg->buf);
-            free(msg);
+            mlacp_dequeue_ndisc(csm, msg);
+            iccp_csm_free_msg(msg);
             msg = NULL;
             ICCPD_LOG_DEBUG(__FUNCTION__, "Delete neighbor %s", show_ipv6_str((char *)ndisc_msg->ipv6_addr));
         }
@@ -581,7 +575,6 @@ static void do_ndisc_learn_from_kernel(struct ndmsg *ndm, struct rtattr *tb[], i
                 ICCPD_LOG_DEBUG(__FUNCTION__, "Update neighbor for %s", show_ipv6_str((char *)ndisc_msg->ipv6_addr));
             }
         }
-        break;
     }
 
     if (msg && !neigh_update)
@@ -960,11 +953,10 @@ void do_arp_update_from_reply_packet(unsigned int ifindex, unsigned int addr, ui
     }
 
     /* update lif ARP*/
-    TAILQ_FOREACH(msg, &MLACP(csm).arp_list, tail)
+    msg = mlacp_find_arp(csm, arp_msg->ipv4_addr);
+    if (msg)
     {
         arp_info = (struct ARPMsg*)msg->buf;
-        if (arp_info->ipv4_addr != arp_msg->ipv4_addr)
-            continue;
 
         /* update ARP*/
         if (arp_info->op_type != arp_msg->op_type
@@ -977,7 +969,6 @@ void do_arp_update_from_reply_packet(unsigned int ifindex, unsigned int addr, ui
             ICCPD_LOG_DEBUG(__FUNCTION__, "Update ARP for %s",
                             show_ip_str(arp_msg->ipv4_addr));
         }
-        break;
     }
 
     /* enquene lif_msg (add)*/
@@ -1182,13 +1173,11 @@ void do_ndisc_update_from_reply_packet(unsigned int ifindex, char *ipv6_addr, ui
     }
 
     /* update lif ND */
-    TAILQ_FOREACH(msg, &MLACP(csm).ndisc_list, tail)
+    msg = mlacp_find_ndisc(csm, ndisc_msg->ipv6_addr);
+    if (msg)
     {
         ndisc_info = (struct NDISCMsg *)msg->buf;
 
-        if (memcmp((char *)ndisc_info->ipv6_addr, (char *)ndisc_msg->ipv6_addr, 16) != 0)
-            continue;
-
         /* If MAC addr is NULL, use the old one */
         if (memcmp(mac_addr, null_mac, ETHER_ADDR_LEN) == 0)
         {
@@ -1206,7 +1195,6 @@ void do_ndisc_update_from_reply_packet(unsigned int ifindex, char *ipv6_addr, ui
             memcpy(ndisc_info->mac_addr, ndisc_msg->mac_addr, ETHER_ADDR_LEN);
              ICCPD_LOG_DEBUG(__FUNCTION__, "Update ND for %s", show_ipv6_str((char *)ndisc_msg->ipv6_addr));
         }
-        break;
     }
 
     /* enquene lif_msg (add) */
@@ -0,0 +1,215 @@
+/*
+ * iccp_mem_pool.c
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * The full GNU General Public License is included in this distribution in
+ * the file called "COPYING".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/logger.h"
+#include "../include/iccp_mem_pool.h"
+
+#define MEM_POOL_ALIGN          sizeof(void*)
+#define MEM_POOL_ROUNDUP(x)     (((x) + MEM_POOL_ALIGN - 1) & ~(MEM_POOL_ALIGN - 1))
+
+#define MEM_POOL_OBJ_TO_SLAB(obj) \
+    ((struct MemPoolSlab*)((uintptr_t)(obj) & ~((uintptr_t)MEM_POOL_SLAB_SIZE - 1)))
+
+#define MEM_POOL_SLAB_OBJ(pool, slab, index) \
+    ((char*)(slab) + (pool)->first_obj_offset + (size_t)(index) * (pool)->obj_size)
+
+/*****************************************
+* Pool setup
+*
+* ***************************************/
+void mem_pool_init(struct MemPool* pool, const char* name, size_t obj_size)
+{
+    if (pool == NULL)
+        return;
+
+    memset(pool, 0, sizeof(struct MemPool));
+    snprintf(pool->name, sizeof(pool->name), "%s", name);
+
+    /* Free objects hold the free list link */
+    if (obj_size < sizeof(void*))
+        obj_size = sizeof(void*);
+    pool->obj_size = MEM_POOL_ROUNDUP(obj_size);
+    pool->first_obj_offset = MEM_POOL_ROUNDUP(sizeof(struct MemPoolSlab));
+    pool->objs_per_slab = (MEM_POOL_SLAB_SIZE - pool->first_obj_offset) / pool->obj_size;
+
+    LIST_INIT(&(pool->partial_list));
+    LIST_INIT(&(pool->full_list));
+}
+
+void mem_pool_finalize(struct MemPool* pool)
+{
+    struct MemPoolSlab* slab = NULL;
+
+    if (pool == NULL)
+        return;
+
+    if (pool->in_use)
+        ICCPD_LOG_NOTICE(__FUNCTION__, "Pool %s released with %u objects in use",
+            pool->name, pool->in_use);
+
+    while (!LIST_EMPTY(&(pool->partial_list)))
+    {
+        slab = LIST_FIRST(&(pool->partial_list));
+        LIST_REMOVE(slab, next);
+        free(slab);
+    }
+
+    while (!LIST_EMPTY(&(pool->full_list)))
+    {
+        slab = LIST_FIRST(&(pool->full_list));
+        LIST_REMOVE(slab, next);
+        free(slab);
+    }
+
+    if (pool->spare_slab)
+        free(pool->spare_slab);
+
+    pool->spare_slab = NULL;
+    pool->in_use = 0;
+    pool->slab_count = 0;
+}
+
+static struct MemPoolSlab* mem_pool_slab_create(struct MemPool* pool)
+{
+    struct MemPoolSlab* slab = NULL;
+
+    if (posix_memalign((void**)&slab, MEM_POOL_SLAB_SIZE, MEM_POOL_SLAB_SIZE) != 0)
+        return NULL;
+
+    /* Objects are carved off on demand, so pages of a new slab are only
+     * touched as they get used */
+    slab->pool = pool;
+    slab->free_list = NULL;
+    slab->carved = 0;
+    slab->in_use = 0;
+    ++pool->slab_count;
+
+    return slab;
+}
+
+/*****************************************
+* Allocate one object, NULL if out of memory
+*
+* ***************************************/
+void* mem_pool_alloc(struct MemPool* pool)
+{
+    struct MemPoolSlab* slab = NULL;
+    void* obj = NULL;
+
+    if (pool == NULL || pool->objs_per_slab == 0)
+        return NULL;
+
+    slab = LIST_FIRST(&(pool->partial_list));
+    if (slab == NULL)
+    {
+        if (pool->spare_slab)
+        {
+            slab = pool->spare_slab;
+            pool->spare_slab = NULL;
+        }
+        else if ((slab = mem_pool_slab_create(pool)) == NULL)
+        {
+            ++pool->alloc_fail;
+            return NULL;
+        }
+        LIST_INSERT_HEAD(&(pool->partial_list), slab, next);
+    }
+
+    if (slab->free_list)
+    {
+        obj = slab->free_list;
+        slab->free_list = *(void**)obj;
+    }
+    else
+    {
+        obj = MEM_POOL_SLAB_OBJ(pool, slab, slab->carved);
+        ++slab->carved;
+    }
+
+    if (++slab->in_use == pool->objs_per_slab)
+    {
+        LIST_REMOVE(slab, next);
+        LIST_INSERT_HEAD(&(pool->full_list), slab, next);
+    }
+
+    if (++pool->in_use > pool->high_water)
+        pool->high_water = pool->in_use;
+
+    return obj;
+}
+
+/*****************************************
+* Return an object to the slab it came from
+*
+* ***************************************/
+void mem_pool_free(void* obj)
+{
+    struct MemPoolSlab* slab = NULL;
+    struct MemPool* pool = NULL;
+
+    if (obj == NULL)
+        return;
+
+    slab = MEM_POOL_OBJ_TO_SLAB(obj);
+    pool = slab->pool;
+
+    *(void**)obj = slab->free_list;
+    slab->free_list = obj;
+    --pool->in_use;
+
+    if (slab->in_use-- == pool->objs_per_slab)
+    {
+        LIST_REMOVE(slab, next);
+        LIST_INSERT_HEAD(&(pool->partial_list), slab, next);
+    }
+
+    if (slab->in_use == 0)
+    {
+        LIST_REMOVE(slab, next);
+        if (pool->spare_slab == NULL)
+        {
+            slab->free_list = NULL;
+            slab->carved = 0;
+            pool->spare_slab = slab;
+        }
+        else
+        {
+            free(slab);
+            --pool->slab_count;
+        }
+    }
+}
+
+void mem_pool_get_dbg_counters(struct MemPool* pool, mem_pool_dbg_counter_info_t* counters)
+{
+    if (pool == NULL || counters == NULL)
+        return;
+
+    memcpy(counters->name, pool->name, sizeof(counters->name));
+    counters->obj_size = pool->obj_size;
+    counters->in_use = pool->in_use;
+    counters->high_water = pool->high_water;
+    counters->slab_count = pool->slab_count;
+    counters->capacity = pool->slab_count * pool->objs_per_slab;
+    counters->alloc_fail = pool->alloc_fail;
+}
@@ -0,0 +1,83 @@
+/*
+ * iccp_mpsc_queue.c
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * The full GNU General Public License is included in this distribution in
+ * the file called "COPYING".
+ */
+
+#include "../include/iccp_mpsc_queue.h"
+
+void mpsc_queue_init(struct MpscQueue* queue)
+{
+    queue->stub.next = NULL;
+    queue->head = &queue->stub;
+    queue->tail = &queue->stub;
+}
+
+void mpsc_queue_push(struct MpscQueue* queue, struct MpscNode* node)
+{
+    struct MpscNode* prev;
+
+    __atomic_store_n(&node->next, NULL, __ATOMIC_RELAXED);
+    prev = __atomic_exchange_n(&queue->head, node, __ATOMIC_ACQ_REL);
+    /* Between the exchange and this store the node is not reachable yet,
+     * mpsc_queue_pop() sees an empty queue for that short window */
+    __atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+}
+
+/* Return the oldest node, or NULL if the queue is empty */
+struct MpscNode* mpsc_queue_pop(struct MpscQueue* queue)
+{
+    struct MpscNode* tail = queue->tail;
+    struct MpscNode* next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+
+    if (tail == &queue->stub)
+    {
+        if (next == NULL)
+            return NULL;
+        queue->tail = next;
+        tail = next;
+        next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    }
+
+    if (next != NULL)
+    {
+        queue->tail = next;
+        return tail;
+    }
+
+    /* tail is the last node, a producer may be linking a new one after it */
+    if (tail != __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE))
+        return NULL;
+
+    /* Put the stub back behind the last node so it can be handed out */
+    mpsc_queue_push(queue, &queue->stub);
+    next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    if (next != NULL)
+    {
+        queue->tail = next;
+        return tail;
+    }
+
+    return NULL;
+}
+
+/* Consumer side only */
+int mpsc_queue_empty(struct MpscQueue* queue)
+{
+    struct MpscNode* tail = queue->tail;
+
+    return tail == &queue->stub && __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE) == NULL;
+}
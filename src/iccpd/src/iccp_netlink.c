@@ -27,6 +27,11 @@
 #include <stdlib.h>
 
 #include <sys/epoll.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <pthread.h>
+#include <signal.h>
+#include <errno.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 
@@ -501,18 +506,7 @@ void iccp_set_interface_ipadd_mac(struct LocalInterface *lif, char * mac_addr )
 
     /*send msg*/
     if (sys->sync_fd)
-    {
-        if (write(sys->sync_fd,msg_buf, msg_hdr->len) == -1)
-        {
-            SYSTEM_SET_SYNCD_TX_DBG_COUNTER(
-                sys, msg_hdr->type, ICCP_DBG_CNTR_STS_ERR);
-        }
-        else
-        {
-            SYSTEM_SET_SYNCD_TX_DBG_COUNTER(
-                sys, msg_hdr->type, ICCP_DBG_CNTR_STS_OK);
-        }
-    }
+        iccp_send_to_mclagsyncd(msg_hdr->type, msg_buf, msg_hdr->len);
     return;
 }
 
@@ -957,7 +951,7 @@ void iccp_event_handler_obj_input_newlink(struct nl_object *obj, void *arg)
 
     if (lif && (lif->ifindex == -1) && (lif->type == IF_T_VLAN))
     {
-        lif->ifindex = ifindex;
+        local_if_set_ifindex(lif, ifindex);
         lif->state = (op_state == IF_OPER_UP) ? PORT_STATE_UP : PORT_STATE_DOWN;
 
         if (addr_type == AF_LLC)
@@ -1226,8 +1220,8 @@ int iccp_del_self_ip_from_neigh_table (struct LocalInterface *lif, int addr_fami
     struct System *sys = NULL;
     struct CSM *csm = NULL;
     struct Msg *msg = NULL;
-    struct ARPMsg *arp_msg = NULL, *arp_info = NULL;
-    struct NDISCMsg *ndisc_msg = NULL, *ndisc_info = NULL;
+    struct ARPMsg *arp_msg = NULL;
+    struct NDISCMsg *ndisc_msg = NULL;
     int err = 0;
 
     if (!(sys = system_get_instance()))
@@ -1239,20 +1233,13 @@ int iccp_del_self_ip_from_neigh_table (struct LocalInterface *lif, int addr_fami
 
         LIST_FOREACH(csm, &(sys->csm_list), next)
         {
-            TAILQ_FOREACH(msg, &MLACP(csm).arp_list, tail)
-            {
-                arp_info = (struct ARPMsg *)msg->buf;
-                if (arp_info->ipv4_addr == lif->ipv4_addr) {
-                    ICCPD_LOG_NOTICE(__FUNCTION__, " Delete ARP %s", show_ip_str(lif->ipv4_addr));
-                    break;
-                }
-            }
+            msg = mlacp_find_arp(csm, lif->ipv4_addr);
 
             if (msg)
             {
-                TAILQ_REMOVE(&(MLACP(csm).arp_list), msg, tail);
-                free(msg->buf);
-                free(msg);
+                ICCPD_LOG_NOTICE(__FUNCTION__, " Delete ARP %s", show_ip_str(lif->ipv4_addr));
+                mlacp_dequeue_arp(csm, msg);
+                iccp_csm_free_msg(msg);
                 msg = NULL;
                 break;
             }
@@ -1261,21 +1248,13 @@ int iccp_del_self_ip_from_neigh_table (struct LocalInterface *lif, int addr_fami
 
         LIST_FOREACH(csm, &(sys->csm_list), next)
         {
-            TAILQ_FOREACH(msg, &MLACP(csm).ndisc_list, tail)
-            {
-                ndisc_info = (struct NDISCMsg *)msg->buf;
-
-                if (memcmp(&ndisc_info->ipv6_addr, &lif->ipv6_addr, 16) == 0) {
-                    ICCPD_LOG_DEBUG(__FUNCTION__, " Delete neighbor %s", show_ipv6_str((char *)lif->ipv6_addr));
-                    break;
-                }
-            }
+            msg = mlacp_find_ndisc(csm, lif->ipv6_addr);
 
             if (msg)
             {
-                TAILQ_REMOVE(&MLACP(csm).ndisc_list, msg, tail);
-                free(msg->buf);
-                free(msg);
+                ICCPD_LOG_DEBUG(__FUNCTION__, " Delete neighbor %s", show_ipv6_str((char *)lif->ipv6_addr));
+                mlacp_dequeue_ndisc(csm, msg);
+                iccp_csm_free_msg(msg);
                 msg = NULL;
                 break;
             }
@@ -1870,6 +1849,16 @@ static int iccp_netlink_genic_sock_event_handler(struct System *sys)
     return ret;
 }
 
+/* Max fds the kernel worker waits on: route netlink, ARP, ND and its stop eventfd */
+#define KERNEL_WORKER_MAX_EVENTS    4
+/* Max kernel events the scheduler thread handles per round */
+#define KERNEL_EVENT_BUDGET         256
+/* Kernel events queued before the worker stops reading, the kernel socket
+ * buffers take the backlog then, and a route netlink overrun is resynced */
+#define KERNEL_EVENT_QUEUE_MAX      1024
+/* Queued kernel events below which a throttled worker is resumed */
+#define KERNEL_EVENT_QUEUE_LOW      (KERNEL_EVENT_QUEUE_MAX / 2)
+
 static int iccp_get_netlink_route_sock_event_fd(struct System *sys)
 {
     return nl_socket_get_fd(sys->route_event_sock);
@@ -1885,25 +1874,19 @@ static int iccp_get_receive_ndisc_packet_sock_fd(struct System *sys)
     return sys->ndisc_receive_fd;
 }
 
-static int iccp_receive_arp_packet_handler(struct System *sys)
+/* Kernel worker thread: parse an ARP reply into kev, return 1 if it is one */
+static int iccp_kernel_worker_recv_arp(struct System *sys, struct KernelEvent *kev)
 {
     unsigned char buf[1024];
     struct sockaddr_ll sll;
     socklen_t sll_len = sizeof(sll);
     struct arphdr *a = (struct arphdr*)buf;
     int n;
-    unsigned int ifindex;
-    unsigned int addr;
-    uint8_t mac_addr[ETHER_ADDR_LEN];
-    struct CSM* csm = NULL;
 
     n = recvfrom(sys->arp_receive_fd, buf, sizeof(buf), MSG_DONTWAIT,
                  (struct sockaddr*)&sll, &sll_len);
     if (n < 0)
-    {
-        ICCPD_LOG_WARN(__FUNCTION__, "ARP recvfrom error: %s", buf);
-        return MCLAG_ERROR;
-    }
+        return 0;
 
     /* Sanity checks */
     /*Only process ARPOP_REPLY*/
@@ -1915,21 +1898,16 @@ static int iccp_receive_arp_packet_handler(struct System *sys)
         sizeof(*a) + 2 * 4 + 2 * a->ar_hln > n)
         return 0;
 
-    /*Check if mclag configured*/
-    csm = system_get_first_csm();
-    if (!csm)
-        return 0;
-
-    ifindex = sll.sll_ifindex;
-    memcpy(mac_addr,  (char*)(a + 1), ETHER_ADDR_LEN);
-    memcpy(&addr, (char*)(a + 1) + a->ar_hln, 4);
+    kev->type = ICCP_KERNEL_EVENT_ARP;
+    kev->ifindex = sll.sll_ifindex;
+    memcpy(kev->mac_addr,  (char*)(a + 1), ETHER_ADDR_LEN);
+    memcpy(kev->addr, (char*)(a + 1) + a->ar_hln, 4);
 
-    do_arp_update_from_reply_packet(ifindex, addr, mac_addr);
-
-    return 0;
+    return 1;
 }
 
-int iccp_receive_ndisc_packet_handler(struct System *sys)
+/* Kernel worker thread: parse a neighbor advertisement into kev, return 1 if it is one */
+static int iccp_kernel_worker_recv_ndisc(struct System *sys, struct KernelEvent *kev)
 {
     uint8_t buf[4096];
     uint8_t adata[1024];
@@ -1940,12 +1918,9 @@ int iccp_receive_ndisc_packet_handler(struct System *sys)
     struct cmsghdr *cmsgptr;
     struct nd_msg *ndmsg = NULL;
     struct nd_opt_hdr *nd_opt = NULL;
-    struct in6_addr target;
-    uint8_t mac_addr[ETHER_ADDR_LEN] = { 0 };
     int8_t *opt = NULL;
     int opt_len = 0, l = 0;
     int len;
-    struct CSM* csm = NULL;
 
     /* Fill in message and iovec. */
     msg.msg_name = (void *)(&from);
@@ -1957,13 +1932,10 @@ int iccp_receive_ndisc_packet_handler(struct System *sys)
     iov.iov_base = buf;
     iov.iov_len = 4096;
 
-    len = recvmsg(sys->ndisc_receive_fd, &msg, 0);
+    len = recvmsg(sys->ndisc_receive_fd, &msg, MSG_DONTWAIT);
 
-    if (len < 0)
-    {
-        ICCPD_LOG_DEBUG(__FUNCTION__, "ndisc recvmsg error!");
-        return MCLAG_ERROR;
-    }
+    if (len < (int)sizeof(struct nd_msg))
+        return 0;
 
     if (msg.msg_controllen >= sizeof(struct cmsghdr))
         for (cmsgptr = CMSG_FIRSTHDR(&msg); cmsgptr != NULL; cmsgptr = CMSG_NXTHDR(&msg, cmsgptr))
@@ -1980,15 +1952,12 @@ int iccp_receive_ndisc_packet_handler(struct System *sys)
 
     ndmsg = (struct nd_msg *)buf;
 
-    /*Check if mclag configured*/
-    csm = system_get_first_csm();
-    if (!csm)
-        return 0;
-
     if (ndmsg->icmph.icmp6_type != NDISC_NEIGHBOUR_ADVERTISEMENT)
         return 0;
 
-    memcpy((char *)(&target), (char *)(&ndmsg->target), sizeof(struct in6_addr));
+    kev->type = ICCP_KERNEL_EVENT_NDISC;
+    kev->ifindex = ifindex;
+    memcpy(kev->addr, (char *)(&ndmsg->target), sizeof(struct in6_addr));
 
     opt = (char *)ndmsg->opt;
 
@@ -2010,7 +1979,7 @@ int iccp_receive_ndisc_packet_handler(struct System *sys)
 
             if (nd_opt->nd_opt_type == ND_OPT_TARGET_LL_ADDR)
             {
-                memcpy(mac_addr, (char *)((char *)nd_opt + sizeof(struct nd_opt_hdr)), ETHER_ADDR_LEN);
+                memcpy(kev->mac_addr, (char *)((char *)nd_opt + sizeof(struct nd_opt_hdr)), ETHER_ADDR_LEN);
                 break;
             }
 
@@ -2019,9 +1988,7 @@ int iccp_receive_ndisc_packet_handler(struct System *sys)
         }
     }
 
-    do_ndisc_update_from_reply_packet(ifindex, (char *)&target, mac_addr);
-
-    return 0;
+    return 1;
 }
 
 void iccp_netlink_sync_again()
@@ -2056,22 +2023,341 @@ void iccp_netlink_sync_again()
     return;
 }
 
-static int iccp_netlink_route_sock_event_handler(struct System *sys)
+/* Kernel worker thread: read one route netlink datagram, the buffer is handed over in kev */
+static int iccp_kernel_worker_recv_netlink(struct System *sys, struct KernelEvent *kev)
+{
+    struct sockaddr_nl nla;
+    unsigned char *buf = NULL;
+    int n;
+
+    n = nl_recv(sys->route_event_sock, &nla, &buf, NULL);
+    if (n == 0)
+    {
+        free(buf);
+        return 0;
+    }
+
+    if (n < 0)
+    {
+        free(buf);
+        kev->type = ICCP_KERNEL_EVENT_NETLINK_ERR;
+        kev->err = n;
+        kev->sys_errno = errno;
+        return 1;
+    }
+
+    kev->type = ICCP_KERNEL_EVENT_NETLINK;
+    kev->nl_buf = buf;
+    kev->nl_len = n;
+    return 1;
+}
+
+/* Run the route event handler on each message of a datagram, as nl_recvmsgs() would */
+static void iccp_kernel_event_netlink_input(struct System *sys, struct KernelEvent *kev)
+{
+    struct nlmsghdr *hdr = (struct nlmsghdr *)kev->nl_buf;
+    struct nl_msg *msg;
+    int len = kev->nl_len;
+    int ret;
+
+    while (nlmsg_ok(hdr, len))
+    {
+        if (hdr->nlmsg_type == NLMSG_DONE || hdr->nlmsg_type == NLMSG_ERROR ||
+            hdr->nlmsg_type == NLMSG_NOOP || hdr->nlmsg_type == NLMSG_OVERRUN)
+            break;
+
+        msg = nlmsg_convert(hdr);
+        if (msg == NULL)
+            break;
+
+        nlmsg_set_proto(msg, NETLINK_ROUTE);
+        ret = iccp_route_event_handler(msg, sys);
+        nlmsg_free(msg);
+        if (ret == NL_STOP)
+            break;
+
+        hdr = nlmsg_next(hdr, &len);
+    }
+}
+
+/* Kernel worker thread: wait while the queue is full, until the scheduler
+ * thread drained it below KERNEL_EVENT_QUEUE_LOW or the worker is stopped */
+static void iccp_kernel_worker_throttle(struct System *sys)
+{
+    struct pollfd pfds[2];
+    uint64_t count;
+
+    if (__atomic_load_n(&sys->kernel_event_depth, __ATOMIC_SEQ_CST) < KERNEL_EVENT_QUEUE_MAX)
+        return;
+
+    SYSTEM_INCR_KERNEL_EVENT_THROTTLE_COUNTER(sys);
+
+    pfds[0].fd = sys->kernel_worker_resume_fd;
+    pfds[0].events = POLLIN;
+    pfds[1].fd = sys->kernel_worker_stop_fd;
+    pfds[1].events = POLLIN;
+
+    /* Set before the depth is checked again, so a drain after the check sees it */
+    __atomic_store_n(&sys->kernel_worker_throttled, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&sys->kernel_event_depth, __ATOMIC_SEQ_CST) >= KERNEL_EVENT_QUEUE_LOW &&
+           __atomic_load_n(&sys->kernel_worker_running, __ATOMIC_ACQUIRE))
+    {
+        if (poll(pfds, 2, -1) < 0 && errno != EINTR)
+            break;
+        if (read(sys->kernel_worker_resume_fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+            break;
+    }
+    __atomic_store_n(&sys->kernel_worker_throttled, 0, __ATOMIC_SEQ_CST);
+}
+
+static void *iccp_kernel_worker_loop(void *arg)
+{
+    struct System *sys = (struct System *)arg;
+    struct epoll_event events[KERNEL_WORKER_MAX_EVENTS];
+    struct KernelEvent *kev;
+    int nfds;
+    int fd;
+    int i;
+    int ret;
+    uint64_t queued;
+
+    while (__atomic_load_n(&sys->kernel_worker_running, __ATOMIC_ACQUIRE))
+    {
+        /* A round queues at most one event per fd over the limit */
+        iccp_kernel_worker_throttle(sys);
+
+        nfds = epoll_wait(sys->kernel_worker_epoll_fd, events, KERNEL_WORKER_MAX_EVENTS, -1);
+        queued = 0;
+
+        for (i = 0; i < nfds; i++)
+        {
+            fd = events[i].data.fd;
+            if (fd == sys->kernel_worker_stop_fd)
+                continue;
+
+            kev = (struct KernelEvent *)calloc(1, sizeof(struct KernelEvent));
+            if (kev == NULL)
+                continue;
+
+            if (fd == iccp_get_netlink_route_sock_event_fd(sys))
+                ret = iccp_kernel_worker_recv_netlink(sys, kev);
+            else if (fd == iccp_get_receive_arp_packet_sock_fd(sys))
+                ret = iccp_kernel_worker_recv_arp(sys, kev);
+            else if (fd == iccp_get_receive_ndisc_packet_sock_fd(sys))
+                ret = iccp_kernel_worker_recv_ndisc(sys, kev);
+            else
+                ret = 0;
+
+            if (ret <= 0)
+            {
+                free(kev);
+                continue;
+            }
+
+            __atomic_add_fetch(&sys->kernel_event_depth, 1, __ATOMIC_SEQ_CST);
+            mpsc_queue_push(&sys->kernel_event_queue, &kev->node);
+            ++queued;
+        }
+
+        /* One wakeup of the scheduler thread for everything read in this round */
+        if (queued > 0 && write(sys->kernel_event_fd, &queued, sizeof(queued)) < 0)
+            SYSTEM_INCR_KERNEL_EVENT_SIGNAL_ERR_COUNTER(sys);
+    }
+
+    return NULL;
+}
+
+/* Create the kernel event queue, and the worker epoll on route netlink, ARP and ND sockets */
+int iccp_kernel_worker_init(struct System *sys)
+{
+    int fds[] = {
+        iccp_get_netlink_route_sock_event_fd(sys),
+        iccp_get_receive_arp_packet_sock_fd(sys),
+        iccp_get_receive_ndisc_packet_sock_fd(sys)
+    };
+    struct epoll_event event;
+    int i;
+
+    mpsc_queue_init(&sys->kernel_event_queue);
+
+    sys->kernel_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    sys->kernel_worker_stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    sys->kernel_worker_resume_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    sys->kernel_worker_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    sys->kernel_event_depth = 0;
+    sys->kernel_worker_throttled = 0;
+    if (sys->kernel_event_fd < 0 || sys->kernel_worker_stop_fd < 0 ||
+        sys->kernel_worker_resume_fd < 0 || sys->kernel_worker_epoll_fd < 0)
+    {
+        ICCPD_LOG_ERR(__FUNCTION__, "Failed to create kernel worker fds, errno %d", errno);
+        return MCLAG_ERROR;
+    }
+
+    event.data.fd = sys->kernel_worker_stop_fd;
+    event.events = EPOLLIN;
+    epoll_ctl(sys->kernel_worker_epoll_fd, EPOLL_CTL_ADD, sys->kernel_worker_stop_fd, &event);
+
+    for (i = 0; i < ARRAY_SIZE(fds); i++)
+    {
+        if (fds[i] < 0)
+            continue;
+
+        event.data.fd = fds[i];
+        event.events = EPOLLIN;
+        if (epoll_ctl(sys->kernel_worker_epoll_fd, EPOLL_CTL_ADD, fds[i], &event) != 0)
+        {
+            ICCPD_LOG_ERR(__FUNCTION__, "Failed to add fd %d to kernel worker epoll, errno %d",
+                          fds[i], errno);
+            return MCLAG_ERROR;
+        }
+    }
+
+    return 0;
+}
+
+int iccp_kernel_worker_start(struct System *sys)
+{
+    sigset_t ss;
+    sigset_t old_ss;
+    int err;
+
+    if (sys->kernel_worker_epoll_fd < 0)
+        return MCLAG_ERROR;
+
+    /* Signals are left to the scheduler thread */
+    sigfillset(&ss);
+    pthread_sigmask(SIG_BLOCK, &ss, &old_ss);
+
+    __atomic_store_n(&sys->kernel_worker_running, 1, __ATOMIC_RELEASE);
+    err = pthread_create(&sys->kernel_worker, NULL, iccp_kernel_worker_loop, sys);
+
+    pthread_sigmask(SIG_SETMASK, &old_ss, NULL);
+
+    if (err != 0)
+    {
+        __atomic_store_n(&sys->kernel_worker_running, 0, __ATOMIC_RELEASE);
+        ICCPD_LOG_ERR(__FUNCTION__, "Failed to start kernel worker thread, err %d", err);
+        return MCLAG_ERROR;
+    }
+
+    ICCPD_LOG_NOTICE(__FUNCTION__, "Kernel worker thread started");
+    return 0;
+}
+
+/* Stop the worker thread and drop what it queued but was not handled */
+void iccp_kernel_worker_stop(struct System *sys)
 {
+    struct MpscNode *node;
+    struct KernelEvent *kev;
+    uint64_t stop = 1;
+
+    if (__atomic_exchange_n(&sys->kernel_worker_running, 0, __ATOMIC_ACQ_REL))
+    {
+        if (write(sys->kernel_worker_stop_fd, &stop, sizeof(stop)) < 0)
+            ICCPD_LOG_ERR(__FUNCTION__, "Failed to signal kernel worker, errno %d", errno);
+        pthread_join(sys->kernel_worker, NULL);
+    }
+
+    while ((node = mpsc_queue_pop(&sys->kernel_event_queue)) != NULL)
+    {
+        kev = MPSC_NODE_ENTRY(node, struct KernelEvent, node);
+        free(kev->nl_buf);
+        free(kev);
+    }
+    sys->kernel_event_depth = 0;
+
+    if (sys->kernel_worker_epoll_fd >= 0)
+        close(sys->kernel_worker_epoll_fd);
+    if (sys->kernel_worker_stop_fd >= 0)
+        close(sys->kernel_worker_stop_fd);
+    if (sys->kernel_worker_resume_fd >= 0)
+        close(sys->kernel_worker_resume_fd);
+    sys->kernel_worker_epoll_fd = -1;
+    sys->kernel_worker_stop_fd = -1;
+    sys->kernel_worker_resume_fd = -1;
+}
+
+static int iccp_get_kernel_event_fd(struct System *sys)
+{
+    return sys->kernel_event_fd;
+}
+
+/* Scheduler thread: handle kernel events queued by the worker, at most
+ * KERNEL_EVENT_BUDGET per round so peer sessions are not held up by a storm */
+static int iccp_kernel_event_handler(struct System *sys)
+{
+    struct MpscNode *node;
+    struct KernelEvent *kev;
+    unsigned int addr;
+    uint64_t count;
+    int handled = 0;
     int ret = 0;
 
-    ret = nl_recvmsgs_default(sys->route_event_sock);
+    if (read(sys->kernel_event_fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+        return MCLAG_ERROR;
 
-    if (ret)
+    while (handled < KERNEL_EVENT_BUDGET &&
+           (node = mpsc_queue_pop(&sys->kernel_event_queue)) != NULL)
     {
-        sys->need_sync_netlink_again = 1;
-        ICCPD_LOG_NOTICE(__FUNCTION__, "fd %d recvmsg error ret = %d  errno = %d ", nl_socket_get_fd(sys->route_event_sock), ret, errno);
-        SYSTEM_INCR_NETLINK_RX_ERROR();
+        kev = MPSC_NODE_ENTRY(node, struct KernelEvent, node);
+        __atomic_sub_fetch(&sys->kernel_event_depth, 1, __ATOMIC_SEQ_CST);
+        ++handled;
+
+        switch (kev->type)
+        {
+            case ICCP_KERNEL_EVENT_NETLINK:
+                iccp_kernel_event_netlink_input(sys, kev);
+                /*get netlink info again when error happens */
+                if (sys->need_sync_netlink_again == 1)
+                    iccp_netlink_sync_again();
+                break;
+
+            case ICCP_KERNEL_EVENT_NETLINK_ERR:
+                sys->need_sync_netlink_again = 1;
+                ICCPD_LOG_NOTICE(__FUNCTION__, "fd %d recvmsg error ret = %d  errno = %d ",
+                                 nl_socket_get_fd(sys->route_event_sock), kev->err, kev->sys_errno);
+                SYSTEM_INCR_NETLINK_RX_ERROR();
+                ret = kev->err;
+                break;
+
+            case ICCP_KERNEL_EVENT_ARP:
+                /*Check if mclag configured*/
+                if (system_get_first_csm())
+                {
+                    memcpy(&addr, kev->addr, 4);
+                    do_arp_update_from_reply_packet(kev->ifindex, addr, kev->mac_addr);
+                }
+                break;
+
+            case ICCP_KERNEL_EVENT_NDISC:
+                /*Check if mclag configured*/
+                if (system_get_first_csm())
+                    do_ndisc_update_from_reply_packet(kev->ifindex, (char *)kev->addr, kev->mac_addr);
+                break;
+
+            default:
+                break;
+        }
+
+        free(kev->nl_buf);
+        free(kev);
+    }
+
+    /* Resume the worker once the queue drained enough */
+    if (__atomic_load_n(&sys->kernel_event_depth, __ATOMIC_SEQ_CST) < KERNEL_EVENT_QUEUE_LOW &&
+        __atomic_load_n(&sys->kernel_worker_throttled, __ATOMIC_SEQ_CST))
+    {
+        count = 1;
+        if (write(sys->kernel_worker_resume_fd, &count, sizeof(count)) < 0)
+            SYSTEM_INCR_KERNEL_EVENT_SIGNAL_ERR_COUNTER(sys);
     }
-    /*get netlink info again when error happens */
-    if (ret == 0 && sys->need_sync_netlink_again == 1)
+
+    /* Wake up again for the events left over */
+    if (!mpsc_queue_empty(&sys->kernel_event_queue))
     {
-        iccp_netlink_sync_again();
+        count = 1;
+        if (write(sys->kernel_event_fd, &count, sizeof(count)) < 0)
+            SYSTEM_INCR_KERNEL_EVENT_SIGNAL_ERR_COUNTER(sys);
     }
 
     return ret;
@@ -2097,16 +2383,8 @@ static const struct iccp_eventfd iccp_eventfds[] = {
         .event_handler = iccp_netlink_genic_sock_event_handler,
     },
     {
-        .get_fd = iccp_get_netlink_route_sock_event_fd,
-        .event_handler = iccp_netlink_route_sock_event_handler,
-    },
-    {
-        .get_fd = iccp_get_receive_arp_packet_sock_fd,
-        .event_handler = iccp_receive_arp_packet_handler,
-     },
-    {
-     .get_fd = iccp_get_receive_ndisc_packet_sock_fd,
-     .event_handler = iccp_receive_ndisc_packet_handler,
+        .get_fd = iccp_get_kernel_event_fd,
+        .event_handler = iccp_kernel_event_handler,
     }
 };
 
@@ -2203,15 +2481,18 @@ int iccp_handle_events(struct System * sys)
             int client_fd = mclagd_ctl_sock_accept(sys->sync_ctrl_fd);
             if (client_fd > 0)
             {
-                mclagd_ctl_interactive_process(client_fd);
-                close(client_fd);
+                if (mclagd_ctl_interactive_process(client_fd) != MCLAGD_CTL_STREAMING)
+                    close(client_fd);
             }
             continue;
         }
 
         if (events[i].data.fd == sys->sync_fd)
         {
-            iccp_mclagsyncd_msg_handler(sys);
+            if (events[i].events & EPOLLOUT)
+                iccp_syncd_tx_flush(sys);
+            if (events[i].events & ~EPOLLOUT)
+                iccp_mclagsyncd_msg_handler(sys);
             continue;
         }
 
@@ -2222,6 +2503,9 @@ int iccp_handle_events(struct System * sys)
             continue;
         }
 
+        if (mclagd_ctl_stream_handler(sys, events[i].data.fd, events[i].events))
+            continue;
+
         if (FD_ISSET(events[i].data.fd, &sys->readfd))
         {
             LIST_FOREACH(csm, &(sys->csm_list), next)
@@ -23,7 +23,9 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <pthread.h>
 
 #include "../include/cmd_option.h"
 #include "../include/logger.h"
@@ -64,18 +66,33 @@ char* log_level_to_string(int level)
     return "INFO";
 }
 
-struct LoggerConfig* logger_get_configuration()
+struct LoggerConfig g_logger_config =
 {
-    static struct LoggerConfig config;
+    .console_log_enabled = 0,
+    .log_level = NOTICE_LOG_LEVEL,
+    .init = 1,
+    .trace_level = NOTICE_LOG_LEVEL,
+    .active_level = NOTICE_LOG_LEVEL,
+};
 
-    if (config.init == 0)
-    {
-        config.console_log_enabled = 0;
-        config.log_level = NOTICE_LOG_LEVEL;
-        config.init = 1;
-    }
+/* Written by any thread without lock, a record is valid once its seq is set */
+static struct LoggerTraceRecord g_logger_trace_ring[LOGGER_TRACE_RING_SIZE];
+static uint64_t g_logger_trace_head = 0;
+
+/* The tag table is changed by mclagdctl on the main thread and read by
+ * every thread that logs
+ */
+static pthread_rwlock_t g_logger_tag_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+struct LoggerConfig* logger_get_configuration()
+{
+    return &g_logger_config;
+}
 
-    return &config;
+static void logger_update_active_level(struct LoggerConfig* config)
+{
+    config->active_level = (config->log_level > config->trace_level) ?
+        config->log_level : config->trace_level;
 }
 
 void logger_set_configuration(int log_level)
@@ -84,10 +101,136 @@ void logger_set_configuration(int log_level)
 
     config->log_level = log_level;
     config->init = 1;
+    logger_update_active_level(config);
+
+    return;
+}
+
+void logger_set_trace_level(int level)
+{
+    struct LoggerConfig* config = logger_get_configuration();
+
+    config->trace_level = level;
+    logger_update_active_level(config);
 
     return;
 }
 
+/* Set the log level of one tag, a level not above the global one removes it */
+int logger_set_tag_level(const char* tag, int level)
+{
+    struct LoggerConfig* config = logger_get_configuration();
+    int ret = 0;
+    int i;
+
+    pthread_rwlock_wrlock(&g_logger_tag_lock);
+
+    for (i = 0; i < config->tag_num; i++)
+    {
+        if (strncmp(config->tags[i].name, tag, LOGGER_TAG_NAME_LEN) == 0)
+            break;
+    }
+
+    if (level <= config->log_level)
+    {
+        if (i < config->tag_num)
+        {
+            config->tags[i] = config->tags[config->tag_num - 1];
+            __atomic_store_n(&config->tag_num, config->tag_num - 1, __ATOMIC_RELAXED);
+        }
+        goto out;
+    }
+
+    if (i == config->tag_num)
+    {
+        if (config->tag_num >= LOGGER_TAG_MAX_NUM)
+        {
+            ret = -1;
+            goto out;
+        }
+
+        snprintf(config->tags[i].name, LOGGER_TAG_NAME_LEN, "%s", tag);
+        __atomic_store_n(&config->tag_num, config->tag_num + 1, __ATOMIC_RELAXED);
+    }
+
+    config->tags[i].log_level = level;
+
+out:
+    pthread_rwlock_unlock(&g_logger_tag_lock);
+    return ret;
+}
+
+int logger_tag_enabled(int level, const char* tag)
+{
+    struct LoggerConfig* config = logger_get_configuration();
+    int enabled = 0;
+    int i;
+
+    pthread_rwlock_rdlock(&g_logger_tag_lock);
+
+    for (i = 0; i < config->tag_num; i++)
+    {
+        if (strncmp(config->tags[i].name, tag, LOGGER_TAG_NAME_LEN) == 0)
+        {
+            enabled = (level <= config->tags[i].log_level);
+            break;
+        }
+    }
+
+    pthread_rwlock_unlock(&g_logger_tag_lock);
+    return enabled;
+}
+
+static void logger_trace(int level, const char* tag, const char* msg)
+{
+    struct LoggerTraceRecord* record;
+    uint64_t seq;
+
+    seq = __atomic_fetch_add(&g_logger_trace_head, 1, __ATOMIC_RELAXED);
+    record = &g_logger_trace_ring[seq & (LOGGER_TRACE_RING_SIZE - 1)];
+
+    __atomic_store_n(&record->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    clock_gettime(CLOCK_REALTIME, &record->ts);
+    record->level = level;
+    snprintf(record->tag, LOGGER_TRACE_TAG_LEN, "%s", tag);
+    snprintf(record->msg, LOGGER_TRACE_MSG_LEN, "%s", msg);
+
+    __atomic_store_n(&record->seq, seq + 1, __ATOMIC_RELEASE);
+}
+
+/* Copy the most recent trace records, oldest first */
+int logger_trace_dump(struct LoggerTraceRecord* records, int max_num)
+{
+    struct LoggerTraceRecord* record;
+    uint64_t head, seq;
+    int num = 0;
+
+    head = __atomic_load_n(&g_logger_trace_head, __ATOMIC_ACQUIRE);
+    seq = (head > LOGGER_TRACE_RING_SIZE) ? head - LOGGER_TRACE_RING_SIZE : 0;
+    if (head - seq > (uint64_t)max_num)
+        seq = head - max_num;
+
+    for (; seq < head; seq++)
+    {
+        record = &g_logger_trace_ring[seq & (LOGGER_TRACE_RING_SIZE - 1)];
+        if (__atomic_load_n(&record->seq, __ATOMIC_ACQUIRE) != seq + 1)
+            continue;
+
+        memcpy(&records[num], record, sizeof(struct LoggerTraceRecord));
+
+        /* Drop the record if a writer reused the slot while copying */
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&record->seq, __ATOMIC_RELAXED) != seq + 1)
+            continue;
+
+        num++;
+    }
+
+    return num;
+}
+
 void log_init(struct CmdOptionParser* parser)
 {
     struct LoggerConfig* config = logger_get_configuration();
@@ -114,7 +257,7 @@ void write_log(int level, const char* tag, const char* format, ...)
         return;
 #endif
 
-    if (level > config->log_level)
+    if (level > config->active_level && !logger_tag_enabled(level, tag))
         return;
 
     prefix_len = snprintf(buf, LOGBUF_SIZE, "[%s.%s] ", tag, log_level_to_string(level));
@@ -133,7 +276,13 @@ void write_log(int level, const char* tag, const char* format, ...)
     }
 
     buf[prefix_len + print_len] = '\0';
-    ICCPD_UTILS_SYSLOG(_iccpd_log_level_map[level], "%s", buf);
+
+    if (level <= config->trace_level)
+        logger_trace(level, tag, buf + prefix_len);
+
+    /* Logs enabled only for the trace ring skip syslog */
+    if (level <= config->log_level || logger_tag_enabled(level, tag))
+        ICCPD_UTILS_SYSLOG(_iccpd_log_level_map[level], "%s", buf);
 
     return;
 }
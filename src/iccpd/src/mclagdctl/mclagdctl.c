@@ -27,6 +27,7 @@
 #include <stdbool.h>
 #include <getopt.h>
 #include <errno.h>
+#include <time.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <netinet/in.h>
@@ -38,6 +39,15 @@
 static int mclagdctl_sock_fd = -1;
 char *mclagdctl_sock_path = "/var/run/iccpd/mclagdctl.sock";
 
+/* Filter of mac, arp and nd dumps, applied by iccpd */
+static char mclagdctl_filter_vlan[MCLAGDCTL_PARA2_LEN];
+static char mclagdctl_filter_port[MCLAGDCTL_PARA2_LEN];
+static char mclagdctl_filter_mac[MCLAGDCTL_PARA2_LEN];
+
+/* Replies parsed so far and entries printed so far, for streamed dumps */
+static int mclagdctl_reply_chunk = 0;
+static int mclagdctl_reply_entry = 0;
+
 /*
    Already implemented command:
    mclagdctl -i dump state
@@ -47,6 +57,10 @@ char *mclagdctl_sock_path = "/var/run/iccpd/mclagdctl.sock";
    mclagdctl -i dump unique_ip
    mclagdctl -i dump portlist local
    mclagdctl -i dump portlist peer
+   mclagdctl -i -v vlan -p port -m mac_prefix dump mac
+   mclagdctl dump debug trace
+   mclagdctl -l debug config tracelevel
+   mclagdctl -l debug config logtag <tag>
  */
 
 #define ETHER_ADDR_LEN 6
@@ -143,6 +157,14 @@ static struct command_type command_types[] =
         .enca_msg = mclagdctl_enca_dump_dbg_counters,
         .parse_msg = mclagdctl_parse_dump_dbg_counters,
     },
+    {
+        .id = ID_CMDTYPE_D_D_T,
+        .parent_id = ID_CMDTYPE_D_D,
+        .info_type = INFO_TYPE_DUMP_TRACE,
+        .name = "trace",
+        .enca_msg = mclagdctl_enca_dump_trace,
+        .parse_msg = mclagdctl_parse_dump_trace,
+    },
     {
         .id = ID_CMDTYPE_C,
         .name = "config",
@@ -157,6 +179,23 @@ static struct command_type command_types[] =
         .enca_msg = mclagdctl_enca_config_loglevel,
         .parse_msg = mclagdctl_parse_config_loglevel,
     },
+    {
+        .id = ID_CMDTYPE_C_T,
+        .parent_id = ID_CMDTYPE_C,
+        .info_type = INFO_TYPE_CONFIG_TRACELEVEL,
+        .name = "tracelevel",
+        .enca_msg = mclagdctl_enca_config_tracelevel,
+        .parse_msg = mclagdctl_parse_config_tracelevel,
+    },
+    {
+        .id = ID_CMDTYPE_C_G,
+        .parent_id = ID_CMDTYPE_C,
+        .info_type = INFO_TYPE_CONFIG_LOGTAG,
+        .name = "logtag",
+        .params = { "<tag>" },
+        .enca_msg = mclagdctl_enca_config_logtag,
+        .parse_msg = mclagdctl_parse_config_logtag,
+    },
 };
 
 #define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
@@ -333,6 +372,13 @@ int mclagdctl_parse_dump_state(char *msg, int data_len)
     return 0;
 }
 
+static void mclagdctl_enca_dump_filter(struct mclagdctl_req_hdr *req)
+{
+    memcpy(req->para1, mclagdctl_filter_vlan, MCLAGDCTL_PARA2_LEN);
+    memcpy(req->para2, mclagdctl_filter_port, MCLAGDCTL_PARA2_LEN);
+    memcpy(req->para3, mclagdctl_filter_mac, MCLAGDCTL_PARA2_LEN);
+}
+
 int mclagdctl_enca_dump_arp(char *msg, int mclag_id, int argc, char **argv)
 {
     struct mclagdctl_req_hdr req;
@@ -346,6 +392,7 @@ int mclagdctl_enca_dump_arp(char *msg, int mclag_id, int argc, char **argv)
     memset(&req, 0, sizeof(struct mclagdctl_req_hdr));
     req.info_type = INFO_TYPE_DUMP_ARP;
     req.mclag_id = mclag_id;
+    mclagdctl_enca_dump_filter(&req);
     memcpy((struct mclagdctl_req_hdr *)msg, &req, sizeof(struct mclagdctl_req_hdr));
 
     return 1;
@@ -364,6 +411,7 @@ int mclagdctl_enca_dump_ndisc(char *msg, int mclag_id, int argc, char **argv)
     memset(&req, 0, sizeof(struct mclagdctl_req_hdr));
     req.info_type = INFO_TYPE_DUMP_NDISC;
     req.mclag_id = mclag_id;
+    mclagdctl_enca_dump_filter(&req);
     memcpy((struct mclagdctl_req_hdr *)msg, &req, sizeof(struct mclagdctl_req_hdr));
 
     return 1;
@@ -375,12 +423,15 @@ int mclagdctl_parse_dump_arp(char *msg, int data_len)
     int len = 0;
     int count = 0;
 
-    fprintf(stdout, "%-6s", "No.");
-    fprintf(stdout, "%-20s", "IP");
-    fprintf(stdout, "%-20s", "MAC");
-    fprintf(stdout, "%-20s", "DEV");
-    fprintf(stdout, "%s", "Flag");
-    fprintf(stdout, "\n");
+    if (mclagdctl_reply_chunk == 0)
+    {
+        fprintf(stdout, "%-6s", "No.");
+        fprintf(stdout, "%-20s", "IP");
+        fprintf(stdout, "%-20s", "MAC");
+        fprintf(stdout, "%-20s", "DEV");
+        fprintf(stdout, "%s", "Flag");
+        fprintf(stdout, "\n");
+    }
 
     len = sizeof(struct mclagd_arp_msg);
 
@@ -388,7 +439,7 @@ int mclagdctl_parse_dump_arp(char *msg, int data_len)
     {
         arp_info = (struct mclagd_arp_msg*)(msg + len * count);
 
-        fprintf(stdout, "%-6d", count + 1);
+        fprintf(stdout, "%-6d", mclagdctl_reply_entry + count + 1);
         fprintf(stdout, "%-20s", arp_info->ipv4_addr);
         fprintf(stdout, "%02x:%02x:%02x:%02x:%02x:%02x",
                 arp_info->mac_addr[0], arp_info->mac_addr[1],
@@ -406,6 +457,8 @@ int mclagdctl_parse_dump_arp(char *msg, int data_len)
         fprintf(stdout, "\n");
     }
 
+    mclagdctl_reply_entry += count;
+
     return 0;
 }
 
@@ -415,12 +468,15 @@ int mclagdctl_parse_dump_ndisc(char *msg, int data_len)
     int len = 0;
     int count = 0;
 
-    fprintf(stdout, "%-6s", "No.");
-    fprintf(stdout, "%-52s", "IPv6");
-    fprintf(stdout, "%-20s", "MAC");
-    fprintf(stdout, "%-20s", "DEV");
-    fprintf(stdout, "%s", "Flag");
-    fprintf(stdout, "\n");
+    if (mclagdctl_reply_chunk == 0)
+    {
+        fprintf(stdout, "%-6s", "No.");
+        fprintf(stdout, "%-52s", "IPv6");
+        fprintf(stdout, "%-20s", "MAC");
+        fprintf(stdout, "%-20s", "DEV");
+        fprintf(stdout, "%s", "Flag");
+        fprintf(stdout, "\n");
+    }
 
     len = sizeof(struct mclagd_ndisc_msg);
 
@@ -428,7 +484,7 @@ int mclagdctl_parse_dump_ndisc(char *msg, int data_len)
     {
         ndisc_info = (struct mclagd_ndisc_msg *)(msg + len * count);
 
-        fprintf(stdout, "%-6d", count + 1);
+        fprintf(stdout, "%-6d", mclagdctl_reply_entry + count + 1);
         fprintf(stdout, "%-52s", ndisc_info->ipv6_addr);
         fprintf(stdout, "%02x:%02x:%02x:%02x:%02x:%02x",
                 ndisc_info->mac_addr[0], ndisc_info->mac_addr[1],
@@ -445,6 +501,8 @@ int mclagdctl_parse_dump_ndisc(char *msg, int data_len)
         fprintf(stdout, "\n");
     }
 
+    mclagdctl_reply_entry += count;
+
     return 0;
 }
 
@@ -461,6 +519,7 @@ int mclagdctl_enca_dump_mac(char *msg, int mclag_id, int argc, char **argv)
     memset(&req, 0, sizeof(struct mclagdctl_req_hdr));
     req.info_type = INFO_TYPE_DUMP_MAC;
     req.mclag_id = mclag_id;
+    mclagdctl_enca_dump_filter(&req);
     memcpy((struct mclagdctl_req_hdr *)msg, &req, sizeof(struct mclagdctl_req_hdr));
 
     return 1;
@@ -472,16 +531,19 @@ int mclagdctl_parse_dump_mac(char *msg, int data_len)
     int len = 0;
     int count = 0;
 
-    fprintf(stdout, "%-60s\n", "TYPE: S-STATIC, D-DYNAMIC; AGE: L-Local age, P-Peer age");
-
-    fprintf(stdout, "%-6s", "No.");
-    fprintf(stdout, "%-5s", "TYPE");
-    fprintf(stdout, "%-20s", "MAC");
-    fprintf(stdout, "%-5s", "VID");
-    fprintf(stdout, "%-20s", "DEV");
-    fprintf(stdout, "%-20s", "ORIGIN-DEV");
-    fprintf(stdout, "%-5s", "AGE");
-    fprintf(stdout, "\n");
+    if (mclagdctl_reply_chunk == 0)
+    {
+        fprintf(stdout, "%-60s\n", "TYPE: S-STATIC, D-DYNAMIC; AGE: L-Local age, P-Peer age");
+
+        fprintf(stdout, "%-6s", "No.");
+        fprintf(stdout, "%-5s", "TYPE");
+        fprintf(stdout, "%-20s", "MAC");
+        fprintf(stdout, "%-5s", "VID");
+        fprintf(stdout, "%-20s", "DEV");
+        fprintf(stdout, "%-20s", "ORIGIN-DEV");
+        fprintf(stdout, "%-5s", "AGE");
+        fprintf(stdout, "\n");
+    }
 
     len = sizeof(struct mclagd_mac_msg);
 
@@ -489,7 +551,7 @@ int mclagdctl_parse_dump_mac(char *msg, int data_len)
     {
         mac_info = (struct mclagd_mac_msg*)(msg + len * count);
 
-        fprintf(stdout, "%-6d", count + 1);
+        fprintf(stdout, "%-6d", mclagdctl_reply_entry + count + 1);
 
         if (mac_info->fdb_type == MAC_TYPE_STATIC_CTL)
             fprintf(stdout, "%-5s", "S");
@@ -513,6 +575,8 @@ int mclagdctl_parse_dump_mac(char *msg, int data_len)
         fprintf(stdout, "\n");
     }
 
+    mclagdctl_reply_entry += count;
+
     return 0;
 }
 
@@ -723,6 +787,71 @@ int mclagdctl_enca_dump_dbg_counters(char *msg, int mclag_id, int argc, char **a
     return 1;
 }
 
+int mclagdctl_enca_dump_trace(char *msg, int mclag_id, int argc, char **argv)
+{
+    struct mclagdctl_req_hdr req;
+
+    memset(&req, 0, sizeof(struct mclagdctl_req_hdr));
+    req.info_type = INFO_TYPE_DUMP_TRACE;
+    req.mclag_id = mclag_id;
+    memcpy((struct mclagdctl_req_hdr *)msg, &req, sizeof(struct mclagdctl_req_hdr));
+
+    return 1;
+}
+
+static char *mclagdctl_log_level2str(int level)
+{
+    switch (level)
+    {
+        case CRITICAL:
+            return "CRITICAL";
+        case ERR:
+            return "ERR";
+        case WARN:
+            return "WARN";
+        case NOTICE:
+            return "NOTICE";
+        case INFO:
+            return "INFO";
+        case DEBUG:
+            return "DEBUG";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+int mclagdctl_parse_dump_trace(char *msg, int data_len)
+{
+    struct mclagd_trace_msg *trace_info = NULL;
+    struct tm tm;
+    time_t sec;
+    char time_str[32];
+    int len = 0;
+    int count = 0;
+
+    len = sizeof(struct mclagd_trace_msg);
+
+    for (; data_len >= len; data_len -= len, count++)
+    {
+        trace_info = (struct mclagd_trace_msg*)(msg + len * count);
+
+        sec = trace_info->sec;
+        localtime_r(&sec, &tm);
+        strftime(time_str, sizeof(time_str), "%b %d %H:%M:%S", &tm);
+
+        fprintf(stdout, "%-8lu%s.%06d %-9s%-*.*s %.*s\n",
+            (unsigned long)trace_info->seq, time_str, trace_info->nsec / 1000,
+            mclagdctl_log_level2str(trace_info->level),
+            MCLAGDCTL_TRACE_TAG_LEN, MCLAGDCTL_TRACE_TAG_LEN, trace_info->tag,
+            MCLAGDCTL_TRACE_MSG_LEN, trace_info->msg);
+    }
+
+    if (count == 0)
+        fprintf(stdout, "No trace records\n");
+
+    return 0;
+}
+
 static char *mclagdctl_dbg_counter_iccpid2str(ICCP_DBG_CNTR_MSG_e iccp_cntr_id)
 {
     /* Keep the string to 15 characters.
@@ -756,6 +885,8 @@ static char *mclagdctl_dbg_counter_iccpid2str(ICCP_DBG_CNTR_MSG_e iccp_cntr_id)
             return "Warmboot";
         case ICCP_DBG_CNTR_MSG_IF_UP_ACK:
             return "IfUpAck";
+        case ICCP_DBG_CNTR_MSG_SYNC_DIGEST:
+            return "SyncDigest";
         default:
             return "Unknown";
     }
@@ -920,7 +1051,28 @@ int mclagdctl_parse_dump_dbg_counters(char *msg, int data_len)
     fprintf(stdout, "Address add/del: %u/%u\n",
         sys_counter_p->newaddr_count, sys_counter_p->deladdr_count);
     fprintf(stdout, "Unexpected message type: %u\n", sys_counter_p->unknown_type_count);
-    fprintf(stdout, "Receive error: %u\n\n", sys_counter_p->rx_error_count);
+    fprintf(stdout, "Receive error: %u\n", sys_counter_p->rx_error_count);
+    fprintf(stdout, "Kernel event signal error: %u\n", sys_counter_p->kernel_event_signal_err_count);
+    fprintf(stdout, "Kernel event throttle: %u\n\n", sys_counter_p->kernel_event_throttle_count);
+
+    /* Memory pool counters */
+    fprintf(stdout, "%-20s%-12s%-12s%-12s%-12s%-12s%-12s\n",
+        "Memory Pool", "OBJ_SIZE", "IN_USE", "HIGH_WATER", "CAPACITY", "SLABS", "ALLOC_FAIL");
+    fprintf(stdout, "%-20s%-12s%-12s%-12s%-12s%-12s%-12s\n",
+        "-----------", "--------", "------", "----------", "--------", "-----", "----------");
+    for (i = 0; i < MEM_POOL_MAX; ++i)
+    {
+        fprintf(stdout, "%-20.*s%-12u%-12u%-12u%-12u%-12u%-12u\n",
+            MEM_POOL_NAME_LEN, sys_counter_p->mem_pools[i].name,
+            sys_counter_p->mem_pools[i].obj_size,
+            sys_counter_p->mem_pools[i].in_use,
+            sys_counter_p->mem_pools[i].high_water,
+            sys_counter_p->mem_pools[i].capacity,
+            sys_counter_p->mem_pools[i].slab_count,
+            sys_counter_p->mem_pools[i].alloc_fail);
+    }
+    fprintf(stdout, "MAC entry alloc/free: %u/%u\n\n",
+        sys_counter_p->mac_entry_alloc_counter, sys_counter_p->mac_entry_free_counter);
     return 0;
 }
 
@@ -949,6 +1101,45 @@ int mclagdctl_parse_config_loglevel(char *msg, int data_len)
     return 0;
 }
 
+int mclagdctl_enca_config_tracelevel(char *msg, int log_level,  int argc, char **argv)
+{
+    struct mclagdctl_req_hdr req;
+
+    memset(&req, 0, sizeof(struct mclagdctl_req_hdr));
+    req.info_type = INFO_TYPE_CONFIG_TRACELEVEL;
+    req.mclag_id = log_level;
+    memcpy((struct mclagdctl_req_hdr *)msg, &req, sizeof(struct mclagdctl_req_hdr));
+
+    return 1;
+}
+
+int mclagdctl_parse_config_tracelevel(char *msg, int data_len)
+{
+    fprintf(stdout, "%s\n", "Config tracelevel success!");
+
+    return 0;
+}
+
+int mclagdctl_enca_config_logtag(char *msg, int log_level,  int argc, char **argv)
+{
+    struct mclagdctl_req_hdr req;
+
+    memset(&req, 0, sizeof(struct mclagdctl_req_hdr));
+    req.info_type = INFO_TYPE_CONFIG_LOGTAG;
+    req.mclag_id = log_level;
+    snprintf(req.para1, sizeof(req.para1), "%s", argv[0]);
+    memcpy((struct mclagdctl_req_hdr *)msg, &req, sizeof(struct mclagdctl_req_hdr));
+
+    return 1;
+}
+
+int mclagdctl_parse_config_logtag(char *msg, int data_len)
+{
+    fprintf(stdout, "%s\n", "Config logtag success!");
+
+    return 0;
+}
+
 static bool __mclagdctl_cmd_executable(struct command_type *cmd_type)
 {
     if (!cmd_type->enca_msg || !cmd_type->parse_msg)
@@ -1066,7 +1257,10 @@ static void mclagdctl_print_help(const char *argv0)
     fprintf(stdout, "%s [options] command [command args]\n"
             "    -h --help                Show this help\n"
             "    -i --mclag-id            Specify one mclag id\n"
-            "    -l --level               Specify log level     critical,err,warn,notice,info,debug\n",
+            "    -l --level               Specify log level     critical,err,warn,notice,info,debug\n"
+            "    -v --vlan                Only dump mac, arp and nd entries of one vlan\n"
+            "    -p --port                Only dump mac, arp and nd entries of one port\n"
+            "    -m --mac                 Only dump mac, arp and nd entries with a MAC prefix, like 00:11:22\n",
             argv0);
     fprintf(stdout, "Commands:\n");
 
@@ -1095,6 +1289,9 @@ int main(int argc, char **argv)
         { "help",      no_argument,             NULL,        'h' },
         { "mclag id",  required_argument,       NULL,        'i' },
         { "log level", required_argument,       NULL,        'l' },
+        { "vlan",      required_argument,       NULL,        'v' },
+        { "port",      required_argument,       NULL,        'p' },
+        { "mac",       required_argument,       NULL,        'm' },
         { NULL,        0,                       NULL,        0   }
     };
     int opt;
@@ -1104,10 +1301,11 @@ int main(int argc, char **argv)
     unsigned para_int = 0;
 
     int len = 0;
+    int more_data = 0;
     char *data;
     struct mclagd_reply_hdr *reply;
 
-    while ((opt = getopt_long(argc, argv, "hi:l:", long_options, NULL)) >= 0)
+    while ((opt = getopt_long(argc, argv, "hi:l:v:p:m:", long_options, NULL)) >= 0)
     {
         switch (opt)
         {
@@ -1153,6 +1351,18 @@ int main(int argc, char **argv)
             }
             break;
 
+        case 'v':
+            snprintf(mclagdctl_filter_vlan, sizeof(mclagdctl_filter_vlan), "%s", optarg);
+            break;
+
+        case 'p':
+            snprintf(mclagdctl_filter_port, sizeof(mclagdctl_filter_port), "%s", optarg);
+            break;
+
+        case 'm':
+            snprintf(mclagdctl_filter_mac, sizeof(mclagdctl_filter_mac), "%s", optarg);
+            break;
+
             case '?':
                 fprintf(stderr, "unknown option.\n");
                 mclagdctl_print_help(argv0);
@@ -1204,71 +1414,80 @@ int main(int argc, char **argv)
         goto mclagdctl_disconnect;
     }
 
-    /*read data length*/
-    memset(buf, 0, MCLAGDCTL_CMD_SIZE);
-    ret = mclagdctl_sock_read(mclagdctl_sock_fd, buf, sizeof(int));
-    if (ret <= 0)
+    /*large dumps are streamed in several replies*/
+    do
     {
-        fprintf(stderr, "Failed to read data length from mclagd\n");
-        ret = EXIT_FAILURE;
-        goto mclagdctl_disconnect;
-    }
+        /*read data length*/
+        memset(buf, 0, MCLAGDCTL_CMD_SIZE);
+        ret = mclagdctl_sock_read(mclagdctl_sock_fd, buf, sizeof(int));
+        if (ret <= 0)
+        {
+            fprintf(stderr, "Failed to read data length from mclagd\n");
+            ret = EXIT_FAILURE;
+            goto mclagdctl_disconnect;
+        }
 
-    /*cont length*/
-    len = *((int*)buf);
-    if (len <= 0)
-    {
-        ret = EXIT_FAILURE;
-        fprintf(stderr, "pkt len = %d, error\n", len);
-        goto mclagdctl_disconnect;
-    }
+        /*cont length*/
+        len = *((int*)buf);
+        if (len <= 0)
+        {
+            ret = EXIT_FAILURE;
+            fprintf(stderr, "pkt len = %d, error\n", len);
+            goto mclagdctl_disconnect;
+        }
 
-    rcv_buf = (char *)malloc(len);
-    if (!rcv_buf)
-    {
-        fprintf(stderr, "Failed to malloc rcv_buf for mclagdctl\n");
-        goto mclagdctl_disconnect;
-    }
+        rcv_buf = (char *)malloc(len);
+        if (!rcv_buf)
+        {
+            fprintf(stderr, "Failed to malloc rcv_buf for mclagdctl\n");
+            goto mclagdctl_disconnect;
+        }
 
-    /*read data*/
-    ret = mclagdctl_sock_read(mclagdctl_sock_fd, rcv_buf, len);
-    if (ret <= 0)
-    {
-        fprintf(stderr, "Failed to read data from mclagd\n");
-        ret = EXIT_FAILURE;
-        goto mclagdctl_disconnect;
-    }
+        /*read data*/
+        ret = mclagdctl_sock_read(mclagdctl_sock_fd, rcv_buf, len);
+        if (ret <= 0)
+        {
+            fprintf(stderr, "Failed to read data from mclagd\n");
+            ret = EXIT_FAILURE;
+            goto mclagdctl_disconnect;
+        }
 
-    reply = (struct mclagd_reply_hdr *)rcv_buf;
-    if (reply->info_type != cmd_type->info_type)
-    {
-        fprintf(stderr, "Reply info type from mclagd error\n");
-        ret = EXIT_FAILURE;
-        goto mclagdctl_disconnect;
-    }
+        reply = (struct mclagd_reply_hdr *)rcv_buf;
+        if (reply->info_type != cmd_type->info_type)
+        {
+            fprintf(stderr, "Reply info type from mclagd error\n");
+            ret = EXIT_FAILURE;
+            goto mclagdctl_disconnect;
+        }
 
-    if (reply->exec_result == EXEC_TYPE_NO_EXIST_SYS)
-    {
-        fprintf(stderr, "No exist sys in iccpd!\n");
-        ret = EXIT_FAILURE;
-        goto mclagdctl_disconnect;
-    }
+        if (reply->exec_result == EXEC_TYPE_NO_EXIST_SYS)
+        {
+            fprintf(stderr, "No exist sys in iccpd!\n");
+            ret = EXIT_FAILURE;
+            goto mclagdctl_disconnect;
+        }
 
-    if (reply->exec_result == EXEC_TYPE_NO_EXIST_MCLAGID)
-    {
-        fprintf(stderr, "Mclag-id %d hasn't been configured in iccpd!\n", para_int);
-        ret = EXIT_FAILURE;
-        goto mclagdctl_disconnect;
-    }
+        if (reply->exec_result == EXEC_TYPE_NO_EXIST_MCLAGID)
+        {
+            fprintf(stderr, "Mclag-id %d hasn't been configured in iccpd!\n", para_int);
+            ret = EXIT_FAILURE;
+            goto mclagdctl_disconnect;
+        }
 
-    if (reply->exec_result == EXEC_TYPE_FAILED)
-    {
-        fprintf(stderr, "exec error in iccpd!\n");
-        ret = EXIT_FAILURE;
-        goto mclagdctl_disconnect;
-    }
+        if (reply->exec_result == EXEC_TYPE_FAILED)
+        {
+            fprintf(stderr, "exec error in iccpd!\n");
+            ret = EXIT_FAILURE;
+            goto mclagdctl_disconnect;
+        }
 
-    cmd_type->parse_msg((char *)(rcv_buf + sizeof(struct mclagd_reply_hdr)), len - sizeof(struct mclagd_reply_hdr));
+        cmd_type->parse_msg((char *)(rcv_buf + sizeof(struct mclagd_reply_hdr)), len - sizeof(struct mclagd_reply_hdr));
+        mclagdctl_reply_chunk++;
+        more_data = (reply->exec_result == EXEC_TYPE_MORE_DATA);
+
+        free(rcv_buf);
+        rcv_buf = NULL;
+    } while (more_data);
 
     ret = EXIT_SUCCESS;
 
@@ -60,9 +60,12 @@ enum id_command_type
     ID_CMDTYPE_D_P_P,
     ID_CMDTYPE_D_D,
     ID_CMDTYPE_D_D_C,
+    ID_CMDTYPE_D_D_T,
     ID_CMDTYPE_C,
     ID_CMDTYPE_C_L,
     ID_CMDTYPE_C_D,
+    ID_CMDTYPE_C_T,
+    ID_CMDTYPE_C_G,
 };
 
 enum mclagdctl_notify_peer_type
@@ -78,6 +81,9 @@ enum mclagdctl_notify_peer_type
     INFO_TYPE_DUMP_DBG_COUNTERS,
     INFO_TYPE_CONFIG_LOGLEVEL,
     INFO_TYPE_CONFIG_DOWN,
+    INFO_TYPE_DUMP_TRACE,
+    INFO_TYPE_CONFIG_TRACELEVEL,
+    INFO_TYPE_CONFIG_LOGTAG,
     INFO_TYPE_FINISH,
 };
 
@@ -111,6 +117,7 @@ struct mclagd_reply_hdr
 #define EXEC_TYPE_NO_EXIST_SYS  -2
 #define EXEC_TYPE_NO_EXIST_MCLAGID  -3
 #define EXEC_TYPE_FAILED -4
+#define EXEC_TYPE_MORE_DATA -5  /* streamed reply, more chunks follow */
 
 #define MCLAG_ERROR -1
 
@@ -226,6 +233,19 @@ struct mclagd_unique_ip_if
     char name[MCLAGDCTL_MAX_L_PORT_NANE];
 };
 
+#define MCLAGDCTL_TRACE_TAG_LEN 24
+#define MCLAGDCTL_TRACE_MSG_LEN 200
+
+struct mclagd_trace_msg
+{
+    uint64_t seq;
+    int64_t sec;
+    int32_t nsec;
+    uint8_t level;
+    char tag[MCLAGDCTL_TRACE_TAG_LEN];
+    char msg[MCLAGDCTL_TRACE_MSG_LEN];
+};
+
 extern int mclagdctl_enca_dump_state(char *msg, int mclag_id,  int argc, char **argv);
 extern int mclagdctl_parse_dump_state(char *msg, int data_len);
 extern int mclagdctl_enca_dump_arp(char *msg, int mclag_id, int argc, char **argv);
@@ -240,8 +260,14 @@ extern int mclagdctl_enca_dump_peer_portlist(char *msg, int mclag_id,  int argc,
 extern int mclagdctl_parse_dump_peer_portlist(char *msg, int data_len);
 int mclagdctl_enca_config_loglevel(char *msg, int log_level,  int argc, char **argv);
 int mclagdctl_parse_config_loglevel(char *msg, int data_len);
+int mclagdctl_enca_config_tracelevel(char *msg, int log_level,  int argc, char **argv);
+int mclagdctl_parse_config_tracelevel(char *msg, int data_len);
+int mclagdctl_enca_config_logtag(char *msg, int log_level,  int argc, char **argv);
+int mclagdctl_parse_config_logtag(char *msg, int data_len);
 
 extern int mclagdctl_enca_dump_dbg_counters(char *msg, int mclag_id, int argc, char **argv);
 extern int mclagdctl_parse_dump_dbg_counters(char *msg, int data_len);
+extern int mclagdctl_enca_dump_trace(char *msg, int mclag_id, int argc, char **argv);
+extern int mclagdctl_parse_dump_trace(char *msg, int data_len);
 extern int mclagdctl_enca_dump_unique_ip(char *msg, int mclag_id, int argc, char **argv);
 extern int mclagdctl_parse_dump_unique_ip(char *msg, int data_len);
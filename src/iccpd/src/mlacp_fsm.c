@@ -25,6 +25,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <endian.h>
 
 #include <sys/queue.h>
 
@@ -55,8 +56,7 @@
         while (!TAILQ_EMPTY(&(list))) { \
             msg = TAILQ_FIRST(&(list)); \
             TAILQ_REMOVE(&(list), msg, tail); \
-            free(msg->buf); \
-            free(msg); \
+            iccp_csm_free_msg(msg); \
         } \
         TAILQ_INIT(&(list)); \
     }
@@ -68,7 +68,7 @@
             mac_msg = TAILQ_FIRST(&(list)); \
             TAILQ_REMOVE(&(list), mac_msg, tail); \
             if (mac_msg->op_type == MAC_SYNC_DEL) \
-                free(mac_msg); \
+                iccp_csm_free_mac_msg(mac_msg); \
         } \
         TAILQ_INIT(&(list)); \
     }
@@ -136,14 +136,22 @@ RB_GENERATE(mac_rb_tree, MACMsg, mac_entry_rb, MACMsg_compare);
 
 #define WARM_REBOOT_TIMEOUT 90
 #define PEER_REBOOT_TIMEOUT 300
+#define MLACP_DIGEST_WAIT_TIMEOUT 3
+
+#define MLACP_DIGEST_HASH_INIT  0xcbf29ce484222325ULL
+#define MLACP_DIGEST_MAP_TEST(map, bucket)  ((map)[(bucket) >> 3] & (1 << ((bucket) & 7)))
+#define MLACP_DIGEST_MAP_SET(map, bucket)   ((map)[(bucket) >> 3] |= (1 << ((bucket) & 7)))
 
 /*****************************************
 * Static Function
 *
 * ***************************************/
 char *mlacp_state(struct CSM* csm);
-static void mlacp_resync_arp(struct CSM* csm);
-static void mlacp_resync_ndisc(struct CSM *csm);
+static void mlacp_sync_mac(struct CSM* csm, const uint8_t* bucket_map);
+static void mlacp_resync_arp(struct CSM* csm, const uint8_t* bucket_map);
+static void mlacp_resync_ndisc(struct CSM *csm, const uint8_t* bucket_map);
+static void mlacp_sync_digest_start(struct CSM* csm);
+static void mlacp_sync_digest_timeout_handler(struct CSM* csm);
 /* Sync Sender APIs*/
 static void mlacp_sync_send_sysConf(struct CSM* csm);
 static void mlacp_sync_send_aggConf(struct CSM* csm);
@@ -165,6 +173,9 @@ static void mlacp_sync_recv_portChanInfo(struct CSM* csm, struct Msg* msg);
 static void mlacp_sync_recv_peerLlinkInfo(struct CSM* csm, struct Msg* msg);
 static void mlacp_sync_recv_arpInfo(struct CSM* csm, struct Msg* msg);
 static void mlacp_sync_recv_stpInfo(struct CSM* csm, struct Msg* msg);
+static void mlacp_sync_recv_digest(struct CSM* csm, struct Msg* msg);
+static void mlacp_sync_recv_digest_support(struct CSM* csm, struct Msg* msg);
+static void mlacp_sync_recv_digest_ack(struct CSM* csm, struct Msg* msg);
 
 /* Sync Handler*/
 static void mlacp_sync_send_nak_handler(struct CSM* csm,  struct Msg* msg);
@@ -285,7 +296,7 @@ static void mlacp_sync_send_syncMacInfo(struct CSM* csm)
                 mac_find.vid = mac_msg->vid ;
                 memcpy(mac_find.mac_addr, mac_msg->mac_addr, ETHER_ADDR_LEN);
                 if (!RB_FIND(mac_rb_tree, &MLACP(csm).mac_rb ,&mac_find))
-                    free(mac_msg);
+                    iccp_csm_free_mac_msg(mac_msg);
             }
         }
 
@@ -319,8 +330,7 @@ static void mlacp_sync_send_syncArpInfo(struct CSM* csm)
 
         msg_len = mlacp_prepare_for_arp_info(csm, g_csm_buf, CSM_BUFFER_SIZE, (struct ARPMsg*)msg->buf, count, NEIGH_SYNC_CLIENT_IP);
         count++;
-        free(msg->buf);
-        free(msg);
+        iccp_csm_free_msg(msg);
         if (count >= MAX_NEIGH_ENTRY_NUM)
         {
             iccp_csm_send(csm, g_csm_buf, msg_len);
@@ -351,8 +361,7 @@ static void mlacp_sync_send_syncNdiscInfo(struct CSM *csm)
 
         msg_len = mlacp_prepare_for_ndisc_info(csm, g_csm_buf, CSM_BUFFER_SIZE, (struct NDISCMsg *)msg->buf, count, NEIGH_SYNC_CLIENT_IP);
         count++;
-        free(msg->buf);
-        free(msg);
+        iccp_csm_free_msg(msg);
         if (count >= MAX_NEIGH_ENTRY_NUM)
         {
             iccp_csm_send(csm, g_csm_buf, msg_len);
@@ -773,6 +782,8 @@ void mlacp_init(struct CSM* csm, int all)
 
     MLACP(csm).current_state = MLACP_STATE_INIT;
     memset(MLACP(csm).remote_system.system_id, 0, ETHER_ADDR_LEN);
+    MLACP(csm).digest_wait = 0;
+    MLACP(csm).peer_digest_support = 0;
 
     MLACP_MSG_QUEUE_REINIT(MLACP(csm).mlacp_msg_list);
     MLACP_MSG_QUEUE_REINIT(MLACP(csm).arp_msg_list);
@@ -780,6 +791,7 @@ void mlacp_init(struct CSM* csm, int all)
     mlacp_mac_msg_queue_reinit(csm);
 
     PIF_QUEUE_REINIT(MLACP(csm).pif_list);
+    peer_if_hash_init(csm);
     LIF_PURGE_QUEUE_REINIT(MLACP(csm).lif_purge_list);
 
     if (all != 0)
@@ -787,9 +799,15 @@ void mlacp_init(struct CSM* csm, int all)
         /* if no clean all, keep the arp info & local interface info for next connection*/
         MLACP_MSG_QUEUE_REINIT(MLACP(csm).arp_list);
         MLACP_MSG_QUEUE_REINIT(MLACP(csm).ndisc_list);
+        RB_INIT(arp_rb_tree, &MLACP(csm).arp_rb);
+        RB_INIT(ndisc_rb_tree, &MLACP(csm).ndisc_rb);
         RB_INIT(mac_rb_tree, &MLACP(csm).mac_rb );
         LIF_QUEUE_REINIT(MLACP(csm).lif_list);
 
+        free(MLACP(csm).mac_snapshot);
+        MLACP(csm).mac_snapshot = NULL;
+        MLACP(csm).mac_snapshot_num = 0;
+
         MLACP(csm).node_id = MLACP_SYSCONF_NODEID_MSB_MASK;
         MLACP(csm).node_id |= (((inet_addr(csm->sender_ip) >> 24) << 4) & MLACP_SYSCONF_NODEID_NODEID_MASK);
         MLACP(csm).node_id |= rand() % MLACP_SYSCONF_NODEID_FREE_MASK;
@@ -814,14 +832,21 @@ void mlacp_finalize(struct CSM* csm)
     mlacp_mac_msg_queue_reinit(csm);
     MLACP_MSG_QUEUE_REINIT(MLACP(csm).arp_list);
     MLACP_MSG_QUEUE_REINIT(MLACP(csm).ndisc_list);
+    RB_INIT(arp_rb_tree, &MLACP(csm).arp_rb);
+    RB_INIT(ndisc_rb_tree, &MLACP(csm).ndisc_rb);
 
     RB_INIT(mac_rb_tree, &MLACP(csm).mac_rb );
 
+    free(MLACP(csm).mac_snapshot);
+    MLACP(csm).mac_snapshot = NULL;
+    MLACP(csm).mac_snapshot_num = 0;
+
     /* remove lif & lif-purge queue */
     LIF_QUEUE_REINIT(MLACP(csm).lif_list);
     LIF_PURGE_QUEUE_REINIT(MLACP(csm).lif_purge_list);
     /* remove & destroy pif queue */
     PIF_QUEUE_REINIT(MLACP(csm).pif_list);
+    peer_if_hash_init(csm);
 
     return;
 }
@@ -899,8 +924,7 @@ void mlacp_fsm_transit(struct CSM* csm)
                 if (icc_hdr->ldp_hdr.msg_type == MSG_T_NOTIFICATION && icc_param->type == TLV_T_NAK)
                 {
                     mlacp_sync_recv_nak_handler(csm, msg);
-                    free(msg->buf);
-                    free(msg);
+                    iccp_csm_free_msg(msg);
                     continue;
                 }
             }
@@ -913,7 +937,10 @@ void mlacp_fsm_transit(struct CSM* csm)
         if (prev_state != MLACP(csm).current_state)
         {
             if (MLACP(csm).current_state == MLACP_STATE_EXCHANGE)
+            {
                 mlacp_peer_conn_handler(csm);
+                mlacp_sync_digest_start(csm);
+            }
             prev_state = MLACP(csm).current_state;
         }
 
@@ -922,8 +949,6 @@ void mlacp_fsm_transit(struct CSM* csm)
         {
             MLACP(csm).wait_for_sync_data = 0;
             MLACP(csm).current_state = MLACP_STATE_STAGE1;
-            mlacp_resync_arp(csm);
-            mlacp_resync_ndisc(csm);
         }
 
         switch (MLACP(csm).current_state)
@@ -946,8 +971,7 @@ void mlacp_fsm_transit(struct CSM* csm)
         /*ICCPD_LOG_DEBUG("mlacp_fsm", "  Next State = %s", mlacp_state(csm));*/
         if (msg)
         {
-            free(msg->buf);
-            free(msg);
+            iccp_csm_free_msg(msg);
         }
     }
 }
@@ -985,7 +1009,7 @@ void mlacp_enqueue_msg(struct CSM* csm, struct Msg* msg)
     if (csm == NULL )
     {
         if (msg != NULL )
-            free(msg);
+            iccp_csm_free_msg(msg);
         return;
     }
 
@@ -1011,11 +1035,90 @@ struct Msg* mlacp_dequeue_msg(struct CSM* csm)
     return msg;
 }
 
-void mlacp_sync_mac(struct CSM* csm)
+/*****************************************
+* Table digest: hash an entry into a bucket
+*
+* ***************************************/
+static uint64_t mlacp_digest_hash(const void* data, size_t len, uint64_t hash)
+{
+    const uint8_t* p = data;
+    size_t i;
+
+    /* FNV-1a */
+    for (i = 0; i < len; i++)
+    {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+static uint64_t mlacp_digest_mix(uint64_t hash)
+{
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+
+    return hash;
+}
+
+/* The key selects the bucket, key and value give the entry hash */
+static uint64_t mlacp_digest_entry(const void* key, size_t key_len,
+    const uint8_t* mac_addr, const char* ifname, int* bucket)
+{
+    uint64_t hash;
+
+    hash = mlacp_digest_hash(key, key_len, MLACP_DIGEST_HASH_INIT);
+    *bucket = mlacp_digest_mix(hash) % MLACP_DIGEST_BUCKET_NUM;
+
+    if (mac_addr)
+        hash = mlacp_digest_hash(mac_addr, ETHER_ADDR_LEN, hash);
+    hash = mlacp_digest_hash(ifname, strnlen(ifname, MAX_L_PORT_NAME), hash);
+
+    return mlacp_digest_mix(hash);
+}
+
+static uint64_t mlacp_digest_mac(uint16_t vid, const uint8_t* mac_addr, const char* ifname, int* bucket)
+{
+    uint8_t key[sizeof(uint16_t) + ETHER_ADDR_LEN];
+    uint16_t net_vid = htons(vid);
+
+    memcpy(key, &net_vid, sizeof(uint16_t));
+    memcpy(key + sizeof(uint16_t), mac_addr, ETHER_ADDR_LEN);
+
+    return mlacp_digest_entry(key, sizeof(key), NULL, ifname, bucket);
+}
+
+static uint64_t mlacp_digest_arp(struct ARPMsg* arp_msg, int* bucket)
+{
+    return mlacp_digest_entry(&arp_msg->ipv4_addr, sizeof(arp_msg->ipv4_addr),
+        arp_msg->mac_addr, arp_msg->ifname, bucket);
+}
+
+static uint64_t mlacp_digest_ndisc(struct NDISCMsg* ndisc_msg, int* bucket)
+{
+    return mlacp_digest_entry(ndisc_msg->ipv6_addr, sizeof(ndisc_msg->ipv6_addr),
+        ndisc_msg->mac_addr, ndisc_msg->ifname, bucket);
+}
+
+/* Sync local MACs to peer, only the ones in bucket_map if it is given */
+static void mlacp_sync_mac(struct CSM* csm, const uint8_t* bucket_map)
 {
     struct MACMsg* mac_msg = NULL;
+    int bucket;
+
     RB_FOREACH (mac_msg, mac_rb_tree, &MLACP(csm).mac_rb)
     {
+        if (bucket_map)
+        {
+            mlacp_digest_mac(mac_msg->vid, mac_msg->mac_addr, mac_msg->origin_ifname, &bucket);
+            if (!MLACP_DIGEST_MAP_TEST(bucket_map, bucket))
+                continue;
+        }
+
         /*If MAC with local age flag, dont sync to peer. Such MAC only exist when peer is warm-reboot.
           If peer is warm-reboot, peer age flag is not set when connection is lost.
           When MAC is aged in local switch, this MAC is not deleted for no peer age flag.
@@ -1074,7 +1177,7 @@ void mlacp_local_lif_clear_pending_mac(struct CSM* csm, struct LocalInterface *l
                 mac_msg->op_type = MAC_SYNC_DEL;
                 if (!MAC_IN_MSG_LIST(&(MLACP(csm).mac_msg_list), mac_msg, tail))
                 {
-                    free(mac_msg);
+                    iccp_csm_free_mac_msg(mac_msg);
                 }
             }
             else
@@ -1088,11 +1191,12 @@ void mlacp_local_lif_clear_pending_mac(struct CSM* csm, struct LocalInterface *l
 * When peerlink ready, prepare the ARPMsg
 *
 ******************************************/
-static void mlacp_resync_arp(struct CSM* csm)
+static void mlacp_resync_arp(struct CSM* csm, const uint8_t* bucket_map)
 {
     struct Msg* msg = NULL;
     struct ARPMsg* arp_msg = NULL;
     struct Msg *msg_send = NULL;
+    int bucket;
 
     /* recover ARP info sync from peer*/
     if (!TAILQ_EMPTY(&(MLACP(csm).arp_list)))
@@ -1100,6 +1204,12 @@ static void mlacp_resync_arp(struct CSM* csm)
         TAILQ_FOREACH(msg, &MLACP(csm).arp_list, tail)
         {
             arp_msg = (struct ARPMsg*)msg->buf;
+            if (bucket_map)
+            {
+                mlacp_digest_arp(arp_msg, &bucket);
+                if (!MLACP_DIGEST_MAP_TEST(bucket_map, bucket))
+                    continue;
+            }
             arp_msg->op_type = NEIGH_SYNC_ADD;
             arp_msg->flag = 0;
             if (iccp_csm_init_msg(&msg_send, (char*)arp_msg, sizeof(struct ARPMsg)) == 0)
@@ -1114,11 +1224,12 @@ static void mlacp_resync_arp(struct CSM* csm)
 * When peerlink ready, prepare the NDISCMsg
 *
 ******************************************/
-static void mlacp_resync_ndisc(struct CSM *csm)
+static void mlacp_resync_ndisc(struct CSM *csm, const uint8_t* bucket_map)
 {
     struct Msg *msg = NULL;
     struct NDISCMsg *ndisc_msg = NULL;
     struct Msg *msg_send = NULL;
+    int bucket;
 
     /* recover ndisc info sync from peer */
     if (!TAILQ_EMPTY(&(MLACP(csm).ndisc_list)))
@@ -1126,6 +1237,12 @@ static void mlacp_resync_ndisc(struct CSM *csm)
         TAILQ_FOREACH(msg, &MLACP(csm).ndisc_list, tail)
         {
             ndisc_msg = (struct NDISCMsg *)msg->buf;
+            if (bucket_map)
+            {
+                mlacp_digest_ndisc(ndisc_msg, &bucket);
+                if (!MLACP_DIGEST_MAP_TEST(bucket_map, bucket))
+                    continue;
+            }
             ndisc_msg->op_type = NEIGH_SYNC_ADD;
             ndisc_msg->flag = 0;
             if (iccp_csm_init_msg(&msg_send, (char *)ndisc_msg, sizeof(struct NDISCMsg)) == 0)
@@ -1136,6 +1253,402 @@ static void mlacp_resync_ndisc(struct CSM *csm)
     }
 }
 
+/*****************************************
+* Reconnect resync by table digest
+*
+* ***************************************/
+
+/* MACs the peer is expected to sync back on reconnect */
+static int mlacp_sync_mac_is_from_peer(struct CSM* csm, struct MACMsg* mac_msg)
+{
+    struct LocalInterface* local_if = NULL;
+
+    /* Peer has the MAC */
+    if (!(mac_msg->age_flag & MAC_AGE_PEER))
+        return 1;
+
+    /* Learnt on a MCLAG interface only here, the peer converts it to its
+       own when the session goes down */
+    if (mac_msg->age_flag == MAC_AGE_PEER && mac_msg->fdb_type != MAC_TYPE_STATIC)
+    {
+        LIST_FOREACH(local_if, &(MLACP(csm).lif_list), mlacp_next)
+        {
+            if (local_if->type == IF_T_PORT_CHANNEL && strcmp(local_if->name, mac_msg->ifname) == 0)
+                return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* Keep what the peer has synced before the session goes down */
+void mlacp_sync_mac_snapshot(struct CSM* csm)
+{
+    struct MACMsg* mac_msg = NULL;
+    struct mLACPMACData* mac_data = NULL;
+    int num = 0;
+
+    free(MLACP(csm).mac_snapshot);
+    MLACP(csm).mac_snapshot = NULL;
+    MLACP(csm).mac_snapshot_num = 0;
+
+    RB_FOREACH (mac_msg, mac_rb_tree, &MLACP(csm).mac_rb)
+    {
+        num++;
+    }
+
+    if (num == 0)
+        return;
+
+    MLACP(csm).mac_snapshot = (struct mLACPMACData*)malloc(num * sizeof(struct mLACPMACData));
+    if (MLACP(csm).mac_snapshot == NULL)
+    {
+        ICCPD_LOG_WARN(__FUNCTION__, "Failed to allocate MAC snapshot of %d entries", num);
+        return;
+    }
+
+    RB_FOREACH (mac_msg, mac_rb_tree, &MLACP(csm).mac_rb)
+    {
+        if (!mlacp_sync_mac_is_from_peer(csm, mac_msg))
+            continue;
+
+        mac_data = &MLACP(csm).mac_snapshot[MLACP(csm).mac_snapshot_num++];
+        memset(mac_data, 0, sizeof(struct mLACPMACData));
+        mac_data->type = MAC_SYNC_ADD;
+        mac_data->mac_type = mac_msg->fdb_type;
+        memcpy(mac_data->mac_addr, mac_msg->mac_addr, ETHER_ADDR_LEN);
+        mac_data->vid = htons(mac_msg->vid);
+        memcpy(mac_data->ifname, mac_msg->origin_ifname, MAX_L_PORT_NAME);
+    }
+
+    ICCPD_LOG_DEBUG("ICCP_FDB", "Snapshot %d MACs from peer", MLACP(csm).mac_snapshot_num);
+    return;
+}
+
+/* Replay the snapshot entries of the buckets the peer did not resend */
+static void mlacp_sync_mac_replay(struct CSM* csm, const uint8_t* mismatch)
+{
+    struct mLACPMACData* mac_data = NULL;
+    int bucket;
+    int i, count = 0;
+
+    for (i = 0; i < MLACP(csm).mac_snapshot_num; i++)
+    {
+        mac_data = &MLACP(csm).mac_snapshot[i];
+        mlacp_digest_mac(ntohs(mac_data->vid), mac_data->mac_addr, mac_data->ifname, &bucket);
+        if (MLACP_DIGEST_MAP_TEST(mismatch, bucket))
+            continue;
+
+        mlacp_fsm_update_mac_entry_from_peer(csm, mac_data);
+        count++;
+    }
+
+    ICCPD_LOG_NOTICE("ICCP_FDB", "Restore %d of %d MACs from snapshot",
+        count, MLACP(csm).mac_snapshot_num);
+
+    free(MLACP(csm).mac_snapshot);
+    MLACP(csm).mac_snapshot = NULL;
+    MLACP(csm).mac_snapshot_num = 0;
+    return;
+}
+
+/* Digest of the entries this node syncs to peer */
+static void mlacp_digest_table(struct CSM* csm, uint8_t table, uint64_t* digest)
+{
+    struct MACMsg* mac_msg = NULL;
+    struct Msg* msg = NULL;
+    uint64_t hash;
+    int bucket;
+
+    memset(digest, 0, sizeof(uint64_t) * MLACP_DIGEST_BUCKET_NUM);
+
+    switch (table)
+    {
+        case MLACP_DIGEST_TABLE_MAC:
+            RB_FOREACH (mac_msg, mac_rb_tree, &MLACP(csm).mac_rb)
+            {
+                /* Same as mlacp_sync_mac */
+                if (mac_msg->age_flag & MAC_AGE_LOCAL)
+                    continue;
+                hash = mlacp_digest_mac(mac_msg->vid, mac_msg->mac_addr, mac_msg->origin_ifname, &bucket);
+                digest[bucket] += hash;
+            }
+            break;
+
+        case MLACP_DIGEST_TABLE_ARP:
+            TAILQ_FOREACH(msg, &MLACP(csm).arp_list, tail)
+            {
+                hash = mlacp_digest_arp((struct ARPMsg*)msg->buf, &bucket);
+                digest[bucket] += hash;
+            }
+            break;
+
+        case MLACP_DIGEST_TABLE_NDISC:
+            TAILQ_FOREACH(msg, &MLACP(csm).ndisc_list, tail)
+            {
+                hash = mlacp_digest_ndisc((struct NDISCMsg*)msg->buf, &bucket);
+                digest[bucket] += hash;
+            }
+            break;
+    }
+
+    return;
+}
+
+/* Digest of the MACs this node holds from peer */
+static void mlacp_digest_mac_snapshot(struct CSM* csm, uint64_t* digest)
+{
+    struct mLACPMACData* mac_data = NULL;
+    uint64_t hash;
+    int bucket;
+    int i;
+
+    memset(digest, 0, sizeof(uint64_t) * MLACP_DIGEST_BUCKET_NUM);
+
+    for (i = 0; i < MLACP(csm).mac_snapshot_num; i++)
+    {
+        mac_data = &MLACP(csm).mac_snapshot[i];
+        hash = mlacp_digest_mac(ntohs(mac_data->vid), mac_data->mac_addr, mac_data->ifname, &bucket);
+        digest[bucket] += hash;
+    }
+
+    return;
+}
+
+static void mlacp_sync_send_digest(struct CSM* csm, uint8_t table, uint64_t* digest)
+{
+    int msg_len;
+
+    msg_len = mlacp_prepare_for_sync_digest(csm, g_csm_buf, CSM_BUFFER_SIZE, table, digest);
+    if (msg_len > 0)
+        iccp_csm_send(csm, g_csm_buf, msg_len);
+
+    return;
+}
+
+/* Enqueue and send the local entries of the given buckets */
+static void mlacp_sync_digest_resync(struct CSM* csm, uint8_t table, const uint8_t* bucket_map)
+{
+    switch (table)
+    {
+        case MLACP_DIGEST_TABLE_MAC:
+            mlacp_sync_mac(csm, bucket_map);
+            mlacp_sync_send_syncMacInfo(csm);
+            break;
+
+        case MLACP_DIGEST_TABLE_ARP:
+            mlacp_resync_arp(csm, bucket_map);
+            mlacp_sync_send_syncArpInfo(csm);
+            break;
+
+        case MLACP_DIGEST_TABLE_NDISC:
+            mlacp_resync_ndisc(csm, bucket_map);
+            mlacp_sync_send_syncNdiscInfo(csm);
+            break;
+    }
+
+    return;
+}
+
+/*
+ * On entering exchange state, instead of replaying the whole tables:
+ * - MAC: both nodes send the digest of the MACs they hold from peer, the
+ *   peer resends the differing buckets and acks; the matching buckets are
+ *   restored from the snapshot taken when the session went down.
+ * - ARP/ND: the lists are shared, the standby sends the digest of its lists,
+ *   the active resends the differing buckets first and acks, then the
+ *   standby resends its entries of those buckets, as in the stage sync.
+ * A peer which did not advertise digest support in stage sync gets all
+ * tables resynced in full right away, as before digest support. A table
+ * that got no digest or ack in time is resynced in full as well.
+ */
+static void mlacp_sync_digest_start(struct CSM* csm)
+{
+    uint64_t digest[MLACP_DIGEST_BUCKET_NUM];
+    uint8_t table;
+
+    if (!MLACP(csm).peer_digest_support)
+    {
+        ICCPD_LOG_NOTICE("ICCP_FSM", "Peer without sync digest support, full resync of tables");
+
+        /* The peer syncs all its MACs back */
+        free(MLACP(csm).mac_snapshot);
+        MLACP(csm).mac_snapshot = NULL;
+        MLACP(csm).mac_snapshot_num = 0;
+
+        MLACP(csm).digest_wait = 0;
+        for (table = 0; table < MLACP_DIGEST_TABLE_MAX; table++)
+            mlacp_sync_digest_resync(csm, table, NULL);
+        return;
+    }
+
+    MLACP(csm).digest_wait = (1 << MLACP_DIGEST_TABLE_MAC) | (1 << MLACP_DIGEST_TABLE_ARP)
+        | (1 << MLACP_DIGEST_TABLE_NDISC);
+    MLACP(csm).digest_wait_time = time(NULL);
+
+    mlacp_digest_mac_snapshot(csm, digest);
+    mlacp_sync_send_digest(csm, MLACP_DIGEST_TABLE_MAC, digest);
+
+    if (csm->role_type != STP_ROLE_ACTIVE)
+    {
+        mlacp_digest_table(csm, MLACP_DIGEST_TABLE_ARP, digest);
+        mlacp_sync_send_digest(csm, MLACP_DIGEST_TABLE_ARP, digest);
+
+        mlacp_digest_table(csm, MLACP_DIGEST_TABLE_NDISC, digest);
+        mlacp_sync_send_digest(csm, MLACP_DIGEST_TABLE_NDISC, digest);
+    }
+
+    return;
+}
+
+static void mlacp_sync_digest_timeout_handler(struct CSM* csm)
+{
+    uint8_t table;
+
+    if (MLACP(csm).digest_wait == 0)
+        return;
+
+    if ((time(NULL) - MLACP(csm).digest_wait_time) < MLACP_DIGEST_WAIT_TIMEOUT)
+        return;
+
+    ICCPD_LOG_NOTICE("ICCP_FSM", "No sync digest from peer, full resync of tables 0x%x",
+        MLACP(csm).digest_wait);
+
+    for (table = 0; table < MLACP_DIGEST_TABLE_MAX; table++)
+    {
+        if (!(MLACP(csm).digest_wait & (1 << table)))
+            continue;
+
+        MLACP(csm).digest_wait &= ~(1 << table);
+        mlacp_sync_digest_resync(csm, table, NULL);
+    }
+
+    return;
+}
+
+static void mlacp_sync_recv_digest_support(struct CSM* csm, struct Msg* msg)
+{
+    struct mLACPSyncDigestSupportTLV* tlv = NULL;
+
+    tlv = (struct mLACPSyncDigestSupportTLV*)&msg->buf[sizeof(ICCHdr)];
+
+    /* Digests of a different bucket count can not be compared */
+    if (ntohs(tlv->icc_parameter.len) >= sizeof(struct mLACPSyncDigestSupportTLV) - sizeof(ICCParameter)
+        && ntohs(tlv->bucket_num) == MLACP_DIGEST_BUCKET_NUM)
+        MLACP(csm).peer_digest_support = 1;
+
+    ICCPD_LOG_DEBUG("ICCP_FSM", "RX sync digest support: %d buckets, supported %d",
+        ntohs(tlv->bucket_num), MLACP(csm).peer_digest_support);
+
+    MLACP_SET_ICCP_RX_DBG_COUNTER(csm,
+        tlv->icc_parameter.type, ICCP_DBG_CNTR_STS_OK);
+
+    return;
+}
+
+static void mlacp_sync_recv_digest(struct CSM* csm, struct Msg* msg)
+{
+    struct mLACPSyncDigestTLV* tlv = NULL;
+    uint64_t digest[MLACP_DIGEST_BUCKET_NUM];
+    uint8_t mismatch[MLACP_DIGEST_MAP_SIZE];
+    size_t tlv_len = sizeof(uint64_t) * MLACP_DIGEST_BUCKET_NUM
+        + sizeof(struct mLACPSyncDigestTLV) - sizeof(ICCParameter);
+    int diff = MLACP_DIGEST_BUCKET_NUM;
+    int msg_len;
+    int i;
+
+    tlv = (struct mLACPSyncDigestTLV*)&msg->buf[sizeof(ICCHdr)];
+
+    if (tlv->table >= MLACP_DIGEST_TABLE_MAX)
+    {
+        ICCPD_LOG_ERR("ICCP_FSM", "RX sync digest: invalid table %d", tlv->table);
+        MLACP_SET_ICCP_RX_DBG_COUNTER(csm,
+            tlv->icc_parameter.type, ICCP_DBG_CNTR_STS_ERR);
+        return;
+    }
+
+    /* Every bucket differs if the table is already resynced in full or
+       the digest can not be compared */
+    memset(mismatch, 0xff, sizeof(mismatch));
+
+    if ((MLACP(csm).digest_wait & (1 << tlv->table))
+        && ntohs(tlv->bucket_num) == MLACP_DIGEST_BUCKET_NUM
+        && ntohs(tlv->icc_parameter.len) >= tlv_len)
+    {
+        mlacp_digest_table(csm, tlv->table, digest);
+        memset(mismatch, 0, sizeof(mismatch));
+        diff = 0;
+
+        for (i = 0; i < MLACP_DIGEST_BUCKET_NUM; i++)
+        {
+            if (digest[i] != be64toh(tlv->digest[i]))
+            {
+                MLACP_DIGEST_MAP_SET(mismatch, i);
+                diff++;
+            }
+        }
+    }
+
+    ICCPD_LOG_NOTICE("ICCP_FSM", "RX sync digest: table %d, %d of %d buckets differ",
+        tlv->table, diff, MLACP_DIGEST_BUCKET_NUM);
+
+    /* Resend the differing buckets before the ack */
+    if (MLACP(csm).digest_wait & (1 << tlv->table))
+    {
+        MLACP(csm).digest_wait &= ~(1 << tlv->table);
+        mlacp_sync_digest_resync(csm, tlv->table, mismatch);
+    }
+
+    msg_len = mlacp_prepare_for_sync_digest_ack(csm, g_csm_buf, CSM_BUFFER_SIZE, tlv->table, mismatch);
+    if (msg_len > 0)
+        iccp_csm_send(csm, g_csm_buf, msg_len);
+
+    MLACP_SET_ICCP_RX_DBG_COUNTER(csm,
+        tlv->icc_parameter.type, ICCP_DBG_CNTR_STS_OK);
+
+    return;
+}
+
+static void mlacp_sync_recv_digest_ack(struct CSM* csm, struct Msg* msg)
+{
+    struct mLACPSyncDigestAckTLV* tlv = NULL;
+    uint8_t mismatch[MLACP_DIGEST_MAP_SIZE];
+    size_t tlv_len = MLACP_DIGEST_MAP_SIZE
+        + sizeof(struct mLACPSyncDigestAckTLV) - sizeof(ICCParameter);
+
+    tlv = (struct mLACPSyncDigestAckTLV*)&msg->buf[sizeof(ICCHdr)];
+
+    if (tlv->table >= MLACP_DIGEST_TABLE_MAX)
+    {
+        ICCPD_LOG_ERR("ICCP_FSM", "RX sync digest ack: invalid table %d", tlv->table);
+        MLACP_SET_ICCP_RX_DBG_COUNTER(csm,
+            tlv->icc_parameter.type, ICCP_DBG_CNTR_STS_ERR);
+        return;
+    }
+
+    memset(mismatch, 0xff, sizeof(mismatch));
+    if (ntohs(tlv->bucket_num) == MLACP_DIGEST_BUCKET_NUM
+        && ntohs(tlv->icc_parameter.len) >= tlv_len)
+        memcpy(mismatch, tlv->mismatch, MLACP_DIGEST_MAP_SIZE);
+
+    ICCPD_LOG_DEBUG("ICCP_FSM", "RX sync digest ack: table %d", tlv->table);
+
+    if (tlv->table == MLACP_DIGEST_TABLE_MAC)
+    {
+        mlacp_sync_mac_replay(csm, mismatch);
+    }
+    else if (MLACP(csm).digest_wait & (1 << tlv->table))
+    {
+        MLACP(csm).digest_wait &= ~(1 << tlv->table);
+        mlacp_sync_digest_resync(csm, tlv->table, mismatch);
+    }
+
+    MLACP_SET_ICCP_RX_DBG_COUNTER(csm,
+        tlv->icc_parameter.type, ICCP_DBG_CNTR_STS_OK);
+
+    return;
+}
+
 /*****************************************
 * NAK handler
 *
@@ -1287,6 +1800,18 @@ static void mlacp_sync_receiver_handler(struct CSM* csm, struct Msg* msg)
             mlacp_fsm_recv_if_up_ack(csm, msg);
             break;
 
+        case TLV_T_MLACP_SYNC_DIGEST:
+            mlacp_sync_recv_digest(csm, msg);
+            break;
+
+        case TLV_T_MLACP_SYNC_DIGEST_ACK:
+            mlacp_sync_recv_digest_ack(csm, msg);
+            break;
+
+        case TLV_T_MLACP_SYNC_DIGEST_SUPPORT:
+            mlacp_sync_recv_digest_support(csm, msg);
+            break;
+
         default:
             ICCPD_LOG_ERR("ICCP_FSM", "Receive unsupported msg 0x%x from peer",
                 icc_param->type);
@@ -1356,6 +1881,11 @@ static void mlacp_sync_send_all_info_handler(struct CSM* csm)
     len = mlacp_prepare_for_sync_data_tlv(csm, g_csm_buf, CSM_BUFFER_SIZE, 0);
     iccp_csm_send(csm, g_csm_buf, len);
 
+    /* Let the peer resync by digest on reconnect */
+    len = mlacp_prepare_for_sync_digest_support(csm, g_csm_buf, CSM_BUFFER_SIZE);
+    if (len > 0)
+        iccp_csm_send(csm, g_csm_buf, len);
+
     MLACP(csm).sync_state = MLACP_SYNC_SYSCONF;
 
     while (1)
@@ -1558,6 +2088,9 @@ static void mlacp_exchange_handler(struct CSM* csm, struct Msg* msg)
         }
     }
 
+    /* Resync in full the tables the peer sent no digest for */
+    mlacp_sync_digest_timeout_handler(csm);
+
     /* Send MAC info if any*/
     mlacp_sync_send_syncMacInfo(csm);
 
@@ -1661,6 +2194,11 @@ ICCP_DBG_CNTR_MSG_e mlacp_fsm_iccp_to_dbg_msg_type(uint32_t tlv_type)
         case TLV_T_MLACP_IF_UP_ACK:
             return ICCP_DBG_CNTR_MSG_IF_UP_ACK;
 
+        case TLV_T_MLACP_SYNC_DIGEST:
+        case TLV_T_MLACP_SYNC_DIGEST_ACK:
+        case TLV_T_MLACP_SYNC_DIGEST_SUPPORT:
+            return ICCP_DBG_CNTR_MSG_SYNC_DIGEST;
+
         default:
             ICCPD_LOG_DEBUG(__FUNCTION__, "No debug counter for TLV type %u",
                 tlv_type);
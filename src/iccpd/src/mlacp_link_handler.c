@@ -69,10 +69,6 @@ char g_iccp_mlagsyncd_recv_buf[ICCP_MLAGSYNCD_RECV_MSG_BUFFER_SIZE] = { 0 };
 char g_iccp_mlagsyncd_send_buf[ICCP_MLAGSYNCD_SEND_MSG_BUFFER_SIZE] = { 0 };
 
 
-extern void mlacp_sync_mac(struct CSM* csm);
-
-#define SYNCD_SEND_RETRY_INTERVAL_USEC    50000 //50 mseconds
-#define SYNCD_SEND_RETRY_MAX              5
 
 #define SYNCD_RECV_RETRY_INTERVAL_USEC    50000 //50 mseconds
 #define SYNCD_RECV_RETRY_MAX              5
@@ -396,14 +392,206 @@ static int peer_po_is_alive(struct CSM *csm, int po_ifindex)
     return pif_active;
 }
 
+/*****************************************
+* TX queue to mclagsyncd
+*
+* Messages are appended at tail and written out from head with
+* non-blocking sends. FDB entries are packed into one SET_FDB message
+* until it reaches MCLAG_MAX_MSG_LEN. When the socket is full, EPOLLOUT
+* is armed on sync_fd and the rest goes out once it is writable.
+* ***************************************/
+#define SYNCD_TX_QUEUE_SIZE         (ICCP_MLAGSYNCD_RECV_MSG_BUFFER_SIZE * 4)
+#define SYNCD_TX_FLUSH_THRESHOLD    (ICCP_MLAGSYNCD_RECV_MSG_BUFFER_SIZE / 4)
+
+static struct
+{
+    size_t head;        /* next byte to send */
+    size_t msg_head;    /* start of oldest message not fully sent */
+    size_t tail;
+    ssize_t fdb_batch;  /* SET_FDB message still open for entries, -1 if none */
+    int wait_writable;
+    char buf[SYNCD_TX_QUEUE_SIZE];
+} g_syncd_tx = { .fdb_batch = -1 };
+
+/* Number of entries a message accounts for in the tx counters */
+static uint32_t iccp_syncd_tx_msg_count(struct IccpSyncdHDr *msg_hdr)
+{
+    if (msg_hdr->type == MCLAG_MSG_TYPE_SET_FDB)
+        return (msg_hdr->len - sizeof(struct IccpSyncdHDr)) / sizeof(struct mclag_fdb_info);
+
+    return 1;
+}
+
+static void iccp_syncd_tx_set_writable_wait(struct System *sys, int enable)
+{
+    struct epoll_event event;
+
+    if (g_syncd_tx.wait_writable == enable || sys->sync_fd < 0)
+        return;
+
+    event.data.fd = sys->sync_fd;
+    event.events = enable ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    if (epoll_ctl(sys->epoll_fd, EPOLL_CTL_MOD, sys->sync_fd, &event) != 0)
+    {
+        ICCPD_LOG_ERR(__FUNCTION__, "Failed to update epoll for fd %d, errno %d",
+            sys->sync_fd, errno);
+        return;
+    }
+    g_syncd_tx.wait_writable = enable;
+}
+
+/* Drop everything not sent yet, counting it as tx errors */
+void iccp_syncd_tx_reset(struct System *sys)
+{
+    struct IccpSyncdHDr msg_hdr;
+
+    while (g_syncd_tx.msg_head < g_syncd_tx.tail)
+    {
+        memcpy(&msg_hdr, &g_syncd_tx.buf[g_syncd_tx.msg_head], sizeof(msg_hdr));
+        SYSTEM_ADD_SYNCD_TX_DBG_COUNTER(sys, msg_hdr.type, ICCP_DBG_CNTR_STS_ERR,
+            iccp_syncd_tx_msg_count(&msg_hdr));
+        g_syncd_tx.msg_head += msg_hdr.len;
+    }
+
+    iccp_syncd_tx_set_writable_wait(sys, 0);
+    g_syncd_tx.head = 0;
+    g_syncd_tx.msg_head = 0;
+    g_syncd_tx.tail = 0;
+    g_syncd_tx.fdb_batch = -1;
+}
+
+/* Make room for len more bytes at tail, by moving pending data to the front */
+static int iccp_syncd_tx_reserve(size_t len)
+{
+    size_t offset = g_syncd_tx.msg_head;
+
+    if (g_syncd_tx.tail + len <= SYNCD_TX_QUEUE_SIZE)
+        return 0;
+
+    if (g_syncd_tx.tail - offset + len > SYNCD_TX_QUEUE_SIZE)
+        return MCLAG_ERROR;
+
+    memmove(g_syncd_tx.buf, &g_syncd_tx.buf[offset], g_syncd_tx.tail - offset);
+    g_syncd_tx.head -= offset;
+    g_syncd_tx.msg_head = 0;
+    g_syncd_tx.tail -= offset;
+    if (g_syncd_tx.fdb_batch >= 0)
+        g_syncd_tx.fdb_batch -= offset;
+
+    return 0;
+}
+
+/* Send as much of the queue as the socket takes, return -1 if the socket failed */
+int iccp_syncd_tx_flush(struct System *sys)
+{
+    struct IccpSyncdHDr msg_hdr;
+    ssize_t send_len;
+
+    g_syncd_tx.fdb_batch = -1;
+
+    if (g_syncd_tx.head == g_syncd_tx.tail)
+        return 0;
+
+    if (sys->sync_fd < 0)
+    {
+        iccp_syncd_tx_reset(sys);
+        return MCLAG_ERROR;
+    }
+
+    while (g_syncd_tx.head < g_syncd_tx.tail)
+    {
+        send_len = send(sys->sync_fd, &g_syncd_tx.buf[g_syncd_tx.head],
+            g_syncd_tx.tail - g_syncd_tx.head, MSG_DONTWAIT);
+
+        if (send_len < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+            {
+                iccp_syncd_tx_set_writable_wait(sys, 1);
+                break;
+            }
+
+            ICCPD_LOG_ERR("ICCP_FSM", "Send to mclagsyncd Non-blocking send() failed, errno %d, %zu bytes dropped",
+                errno, g_syncd_tx.tail - g_syncd_tx.msg_head);
+            iccp_syncd_tx_reset(sys);
+            return MCLAG_ERROR;
+        }
+
+        g_syncd_tx.head += send_len;
+
+        /* Count messages once they are completely written */
+        while (g_syncd_tx.msg_head < g_syncd_tx.head)
+        {
+            memcpy(&msg_hdr, &g_syncd_tx.buf[g_syncd_tx.msg_head], sizeof(msg_hdr));
+            if (g_syncd_tx.msg_head + msg_hdr.len > g_syncd_tx.head)
+                break;
+            SYSTEM_ADD_SYNCD_TX_DBG_COUNTER(sys, msg_hdr.type, ICCP_DBG_CNTR_STS_OK,
+                iccp_syncd_tx_msg_count(&msg_hdr));
+            g_syncd_tx.msg_head += msg_hdr.len;
+        }
+    }
+
+    if (g_syncd_tx.head == g_syncd_tx.tail)
+    {
+        g_syncd_tx.head = 0;
+        g_syncd_tx.msg_head = 0;
+        g_syncd_tx.tail = 0;
+        iccp_syncd_tx_set_writable_wait(sys, 0);
+    }
+
+    return 0;
+}
+
+/* Queue one FDB entry, packing it into the open SET_FDB message if it has room */
+static int iccp_syncd_tx_queue_fdb(struct System *sys, struct mclag_fdb_info *mac_info)
+{
+    struct IccpSyncdHDr msg_hdr;
+
+    if (g_syncd_tx.fdb_batch >= 0)
+    {
+        memcpy(&msg_hdr, &g_syncd_tx.buf[g_syncd_tx.fdb_batch], sizeof(msg_hdr));
+        if (msg_hdr.len + sizeof(struct mclag_fdb_info) > MCLAG_MAX_MSG_LEN)
+            g_syncd_tx.fdb_batch = -1;
+    }
+
+    if (g_syncd_tx.fdb_batch < 0)
+    {
+        if (iccp_syncd_tx_reserve(sizeof(msg_hdr) + sizeof(struct mclag_fdb_info)) != 0)
+        {
+            SYSTEM_SET_SYNCD_TX_DBG_COUNTER(sys, MCLAG_MSG_TYPE_SET_FDB, ICCP_DBG_CNTR_STS_ERR);
+            return MCLAG_ERROR;
+        }
+
+        msg_hdr.ver = ICCPD_TO_MCLAGSYNCD_HDR_VERSION;
+        msg_hdr.type = MCLAG_MSG_TYPE_SET_FDB;
+        msg_hdr.len = sizeof(msg_hdr);
+        g_syncd_tx.fdb_batch = g_syncd_tx.tail;
+        g_syncd_tx.tail += sizeof(msg_hdr);
+    }
+    else if (iccp_syncd_tx_reserve(sizeof(struct mclag_fdb_info)) != 0)
+    {
+        SYSTEM_SET_SYNCD_TX_DBG_COUNTER(sys, MCLAG_MSG_TYPE_SET_FDB, ICCP_DBG_CNTR_STS_ERR);
+        return MCLAG_ERROR;
+    }
+
+    memcpy(&g_syncd_tx.buf[g_syncd_tx.tail], mac_info, sizeof(struct mclag_fdb_info));
+    g_syncd_tx.tail += sizeof(struct mclag_fdb_info);
+    msg_hdr.len += sizeof(struct mclag_fdb_info);
+    memcpy(&g_syncd_tx.buf[g_syncd_tx.fdb_batch], &msg_hdr, sizeof(msg_hdr));
+
+    if (g_syncd_tx.tail - g_syncd_tx.head >= SYNCD_TX_FLUSH_THRESHOLD && !g_syncd_tx.wait_writable)
+        iccp_syncd_tx_flush(sys);
+
+    return 0;
+}
+
 // return -1 if failed
 ssize_t iccp_send_to_mclagsyncd(uint8_t msg_type, char *send_buff, uint16_t msg_len)
 {
     struct System *sys;
-    ssize_t write = 0;
-    int num_retry = 0;
-    size_t pos = 0;
-    int send_len = 0;
 
     sys = system_get_instance();
     if (sys == NULL)
@@ -412,55 +600,29 @@ ssize_t iccp_send_to_mclagsyncd(uint8_t msg_type, char *send_buff, uint16_t msg_
         return MCLAG_ERROR;
     }
 
-    if (sys->sync_fd)
+    if (sys->sync_fd < 0)
     {
-        while (msg_len > 0)
-        {
-            send_len = send(sys->sync_fd, &send_buff[pos], msg_len, MSG_DONTWAIT);
+        SYSTEM_SET_SYNCD_TX_DBG_COUNTER(sys, msg_type, ICCP_DBG_CNTR_STS_ERR);
+        return MCLAG_ERROR;
+    }
 
-            if (send_len == -1)
-            {
-                if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
-                {
-                    ++num_retry;
-                    if (num_retry > SYNCD_SEND_RETRY_MAX)
-                    {
-                        ICCPD_LOG_ERR("ICCP_FSM", "Send to mclagsyncd Non-blocking send() retry failed,msg_type: %d msg_len/send_len %d/%d",
-                                msg_type, msg_len, send_len);
-                        SYSTEM_SET_SYNCD_TX_DBG_COUNTER(
-                                            sys, msg_type, ICCP_DBG_CNTR_STS_ERR);
-                        return MCLAG_ERROR;
-                    }
-                    else
-                    {
-                        usleep(SYNCD_SEND_RETRY_INTERVAL_USEC);
-                        send_len = 0;
-                    }
-                }
-                else
-                {
-                    ICCPD_LOG_ERR("ICCP_FSM", "Send to mclagsyncd Non-blocking send() failed, msg_type: %d errno %d",
-                            msg_type, errno);
-                    SYSTEM_SET_SYNCD_TX_DBG_COUNTER(sys, msg_type, ICCP_DBG_CNTR_STS_ERR);
-                    return MCLAG_ERROR;
-                }
-            }
-            else if (send_len == 0)
-            {
-                ICCPD_LOG_ERR("ICCP_FSM", "Send to mclagsyncd Non-blocking send() failed socket closed msg_type: %d errno %d",
-                        msg_type, errno);
-                SYSTEM_SET_SYNCD_TX_DBG_COUNTER(
-                                    sys, msg_type, ICCP_DBG_CNTR_STS_ERR);
-                return MCLAG_ERROR;
-            }
-            msg_len -= send_len;
-            pos += send_len;
-        }
-        SYSTEM_SET_SYNCD_TX_DBG_COUNTER(sys, msg_type, ICCP_DBG_CNTR_STS_OK);
+    /* Entries queued so far go out first */
+    g_syncd_tx.fdb_batch = -1;
+    if (iccp_syncd_tx_reserve(msg_len) != 0)
+    {
+        ICCPD_LOG_ERR("ICCP_FSM", "Send to mclagsyncd queue full, msg_type: %d msg_len %d dropped",
+            msg_type, msg_len);
+        SYSTEM_SET_SYNCD_TX_DBG_COUNTER(sys, msg_type, ICCP_DBG_CNTR_STS_ERR);
+        return MCLAG_ERROR;
     }
 
-    return pos;
+    memcpy(&g_syncd_tx.buf[g_syncd_tx.tail], send_buff, msg_len);
+    g_syncd_tx.tail += msg_len;
+
+    if (!g_syncd_tx.wait_writable && iccp_syncd_tx_flush(sys) != 0)
+        return MCLAG_ERROR;
 
+    return msg_len;
 }
 
 #if 0
@@ -542,19 +704,12 @@ void set_peerlink_mlag_port_learn(struct LocalInterface *lif, int enable)
     /*send msg*/
     if (sys->sync_fd)
     {
-        rc = write(sys->sync_fd,msg_buf, msg_hdr->len);
+        rc = iccp_send_to_mclagsyncd(msg_hdr->type, msg_buf, msg_hdr->len);
         if ((rc <= 0) || (rc != msg_hdr->len))
         {
-            SYSTEM_SET_SYNCD_TX_DBG_COUNTER(
-                sys, msg_hdr->type, ICCP_DBG_CNTR_STS_ERR);
             ICCPD_LOG_ERR(__FUNCTION__, "Failed to write for %s, rc %d",
                 lif->name, rc);
         }
-        else
-        {
-            SYSTEM_SET_SYNCD_TX_DBG_COUNTER(
-                sys, msg_hdr->type, ICCP_DBG_CNTR_STS_OK);
-        }
     }
     return;
 }
@@ -843,7 +998,7 @@ int mlacp_link_del_iccp_info(
     msg_hdr->len += (sizeof(mclag_sub_option_hdr_t) + sub_msg->op_len);
 
     if (sys->sync_fd)
-        rc = send(sys->sync_fd,msg_buf, msg_hdr->len, MSG_DONTWAIT);
+        rc = iccp_send_to_mclagsyncd(msg_hdr->type, msg_buf, msg_hdr->len);
 
     if ((rc <= 0) || (rc != msg_hdr->len))
     {
@@ -853,7 +1008,6 @@ int mlacp_link_del_iccp_info(
     }
     else
     {
-        SYSTEM_SET_SYNCD_TX_DBG_COUNTER(sys, msg_hdr->type, ICCP_DBG_CNTR_STS_OK);
         ICCPD_LOG_DEBUG("ICCP_FSM", "Delete mlag %d", mlag_id);
         return 0;
     }
@@ -920,7 +1074,6 @@ int mlacp_link_set_remote_if_state(
     }
     else
     {
-        SYSTEM_SET_SYNCD_TX_DBG_COUNTER(sys, msg_hdr->type, ICCP_DBG_CNTR_STS_OK);
         ICCPD_LOG_DEBUG("ICCP_FSM", "Set mlag %d, remote if %s status %s",
             mlag_id, po_name, is_oper_up ? "up" : "down");
         return 0;
@@ -980,7 +1133,6 @@ int mlacp_link_del_remote_if_info(
     }
     else
     {
-        SYSTEM_SET_SYNCD_TX_DBG_COUNTER(sys, msg_hdr->type, ICCP_DBG_CNTR_STS_OK);
         ICCPD_LOG_DEBUG("ICCP_FSM", "Delete mlag %d, remote if %s",
             mlag_id, po_name);
         return 0;
@@ -1046,7 +1198,6 @@ int mlacp_link_set_peerlink_port_isolation(
     }
     else
     {
-        SYSTEM_SET_SYNCD_TX_DBG_COUNTER(sys, msg_hdr->type, ICCP_DBG_CNTR_STS_OK);
         ICCPD_LOG_NOTICE("ICCP_FSM", "Set mlag %d, %s port isolation %s",
             mlag_id, po_name, is_isolation_enable ? "enable" : "disable");
         return 0;
@@ -1191,18 +1342,11 @@ void update_peerlink_isolate_from_all_csm_lif(
     /*send msg*/
     if (sys->sync_fd)
     {
-        rc = write(sys->sync_fd,msg_buf, msg_hdr->len);
+        rc = iccp_send_to_mclagsyncd(msg_hdr->type, msg_buf, msg_hdr->len);
         if ((rc <= 0) || (rc != msg_hdr->len))
         {
-            SYSTEM_SET_SYNCD_TX_DBG_COUNTER(
-                sys, msg_hdr->type, ICCP_DBG_CNTR_STS_ERR);
             ICCPD_LOG_ERR(__FUNCTION__, "Failed to write, rc %d", rc);
         }
-        else
-        {
-            SYSTEM_SET_SYNCD_TX_DBG_COUNTER(
-                sys, msg_hdr->type, ICCP_DBG_CNTR_STS_OK);
-        }
     }
 
     return;
@@ -1624,11 +1768,8 @@ void update_stp_peer_link(struct CSM *csm,
 
 void iccp_send_fdb_entry_to_syncd( struct MACMsg* mac_msg, uint8_t mac_type, uint8_t oper)
 {
-    struct IccpSyncdHDr * msg_hdr;
-    char *msg_buf = g_iccp_mlagsyncd_send_buf;
     struct System *sys;
-    struct mclag_fdb_info * mac_info;
-    ssize_t rc;
+    struct mclag_fdb_info mac_info;
     uint8_t null_mac[] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
 
     sys = system_get_instance();
@@ -1644,37 +1785,29 @@ void iccp_send_fdb_entry_to_syncd( struct MACMsg* mac_msg, uint8_t mac_type, uin
         return;
     }
 
-    memset(msg_buf, 0, ICCP_MLAGSYNCD_SEND_MSG_BUFFER_SIZE);
-
-    msg_hdr = (struct IccpSyncdHDr *)msg_buf;
-    msg_hdr->ver = ICCPD_TO_MCLAGSYNCD_HDR_VERSION;
-    msg_hdr->type = MCLAG_MSG_TYPE_SET_FDB;
-
     /*mac msg */
-    mac_info = (struct mclag_fdb_info *)&msg_buf[sizeof(struct IccpSyncdHDr)];
-    mac_info->vid = mac_msg->vid;
-    memcpy(mac_info->port_name, mac_msg->ifname, MAX_L_PORT_NAME);
-    memcpy(mac_info->mac, mac_msg->mac_addr, ETHER_ADDR_LEN);
-    mac_info->type = mac_type;
-    mac_info->op_type = oper;
-    msg_hdr->len = sizeof(struct IccpSyncdHDr) + sizeof(struct mclag_fdb_info);
+    memset(&mac_info, 0, sizeof(mac_info));
+    mac_info.vid = mac_msg->vid;
+    memcpy(mac_info.port_name, mac_msg->ifname, MAX_L_PORT_NAME);
+    memcpy(mac_info.mac, mac_msg->mac_addr, ETHER_ADDR_LEN);
+    mac_info.type = mac_type;
+    mac_info.op_type = oper;
 
     ICCPD_LOG_DEBUG("ICCP_FDB", "Send fdb to syncd: write mac msg vid : %d ; ifname %s ; mac %s fdb type %d ; op type %s",
-        mac_info->vid, mac_info->port_name, mac_addr_to_str(mac_info->mac), mac_info->type,
+        mac_info.vid, mac_info.port_name, mac_addr_to_str(mac_info.mac), mac_info.type,
         oper == MAC_SYNC_ADD ? "add" : "del");
 
-    /*send msg*/
+    /*queue msg, it is sent once the scheduler loop flushes the tx queue*/
     if (sys->sync_fd > 0 )
     {
-        rc = iccp_send_to_mclagsyncd(msg_hdr->type, msg_buf, msg_hdr->len);
-        if (rc <= 0)
+        if (iccp_syncd_tx_queue_fdb(sys, &mac_info) != 0)
         {
-            ICCPD_LOG_WARN(__FUNCTION__, "Send to Mclagsyncd failed rc: %d",rc);
+            ICCPD_LOG_WARN(__FUNCTION__, "Send to Mclagsyncd failed, tx queue full");
         }
     }
     else
     {
-        SYSTEM_SET_SYNCD_TX_DBG_COUNTER(sys, msg_hdr->type, ICCP_DBG_CNTR_STS_ERR);
+        SYSTEM_SET_SYNCD_TX_DBG_COUNTER(sys, MCLAG_MSG_TYPE_SET_FDB, ICCP_DBG_CNTR_STS_ERR);
         ICCPD_LOG_ERR(__FUNCTION__, "Invalid sync_fd Failed to write, fd %d", sys->sync_fd);
     }
 
@@ -1842,7 +1975,7 @@ static void update_l2_mac_state(struct CSM *csm,
                 // else free is taken care after sending the update to peer
                 if (!MAC_IN_MSG_LIST(&(MLACP(csm).mac_msg_list), mac_msg, tail))
                 {
-                    free(mac_msg);
+                    iccp_csm_free_mac_msg(mac_msg);
                 }
             }
             else
@@ -1931,7 +2064,7 @@ static void update_l2_mac_state(struct CSM *csm,
                         mac_msg->op_type = MAC_SYNC_DEL;
                         if (!MAC_IN_MSG_LIST(&(MLACP(csm).mac_msg_list), mac_msg, tail))
                         {
-                            free(mac_msg);
+                            iccp_csm_free_mac_msg(mac_msg);
                         }
                     }
                     else
@@ -2189,16 +2322,6 @@ void mlacp_peer_mlag_intf_delete_handler(struct CSM* csm, char *mlag_if_name)
     return;
 }
 
-
-static void mlacp_conn_handler_fdb(struct CSM* csm)
-{
-    if (!csm)
-        return;
-    ICCPD_LOG_DEBUG(__FUNCTION__, " Sync MAC addresses to peer ");
-    mlacp_sync_mac(csm);
-    return;
-}
-
 void mlacp_fix_bridge_mac(struct CSM* csm)
 {
     char syscmd[128];
@@ -2272,7 +2395,6 @@ void mlacp_peer_conn_handler(struct CSM* csm)
     }
 
     sys->csm_trans_time = time(NULL);
-    mlacp_conn_handler_fdb(csm);
 
     LIST_FOREACH(lif, &(MLACP(csm).lif_list), mlacp_next)
     {
@@ -2341,7 +2463,7 @@ void mlacp_peer_disconn_fdb_handler(struct CSM* csm)
                 // else free is taken care after sending the update to peer
                 if (!MAC_IN_MSG_LIST(&(MLACP(csm).mac_msg_list), mac_msg, tail))
                 {
-                    free(mac_msg);
+                    iccp_csm_free_mac_msg(mac_msg);
                 }
             }
         }
@@ -2400,6 +2522,10 @@ void mlacp_peer_disconn_handler(struct CSM* csm)
     if (sys->warmboot_exit == WARM_REBOOT)
         return;
 
+    /*Keep the MACs from peer, the reconnect only resyncs what changed*/
+    if (MLACP(csm).current_state == MLACP_STATE_EXCHANGE)
+        mlacp_sync_mac_snapshot(csm);
+
     if (csm->peer_warm_reboot_time != 0)
     {
         /*If peer disconnected, recover peer to normal reboot for next time*/
@@ -2528,7 +2654,7 @@ void mlacp_peerlink_down_handler(struct CSM* csm)
             // else free is taken care after sending the update to peer
             if (!MAC_IN_MSG_LIST(&(MLACP(csm).mac_msg_list), mac_msg, tail))
             {
-                free(mac_msg);
+                iccp_csm_free_mac_msg(mac_msg);
             }
         }
     }
@@ -2659,6 +2785,8 @@ void syncd_info_close()
         return;
     }
 
+    iccp_syncd_tx_reset(sys);
+
     if (sys->sync_fd > 0)
     {
         close(sys->sync_fd);
@@ -2999,7 +3127,7 @@ void do_mac_update_from_syncd(uint8_t mac_addr[ETHER_ADDR_LEN], uint16_t vid, ch
                     // else free is taken care after sending the update to peer
                     if (!MAC_IN_MSG_LIST(&(MLACP(csm).mac_msg_list), mac_info, tail))
                     {
-                        free(mac_info);
+                        iccp_csm_free_mac_msg(mac_info);
                     }
                 }
                 else if (csm->peer_link_if && csm->peer_link_if->state != PORT_STATE_DOWN)
@@ -3036,7 +3164,7 @@ void do_mac_update_from_syncd(uint8_t mac_addr[ETHER_ADDR_LEN], uint16_t vid, ch
                 // else free is taken care after sending the update to peer
                 if (!MAC_IN_MSG_LIST(&(MLACP(csm).mac_msg_list), mac_info, tail))
                 {
-                    free(mac_info);
+                    iccp_csm_free_mac_msg(mac_info);
                 }
             }
             else
@@ -3691,6 +3819,15 @@ char * mclagd_ctl_cmd_str(int req_type)
         case INFO_TYPE_CONFIG_LOGLEVEL:
             return "config loglevel";
 
+        case INFO_TYPE_DUMP_TRACE:
+            return "dump debug trace";
+
+        case INFO_TYPE_CONFIG_TRACELEVEL:
+            return "config tracelevel";
+
+        case INFO_TYPE_CONFIG_LOGTAG:
+            return "config logtag";
+
         default:
             break;
     }
@@ -3864,126 +4001,279 @@ void mclagd_ctl_handle_dump_state(int client_fd, int mclag_id)
     return;
 }
 
-void mclagd_ctl_handle_dump_arp(int client_fd, int mclag_id)
+/*****************************************
+* Streamed mclagdctl dumps
+*
+* MAC, ARP and ND tables and the trace ring can be large, so their dumps
+* are not built in one reply. The client fd is kept open and gets one chunk of at most
+* MCLAGD_CTL_STREAM_BUF_SIZE bytes per scheduler round while it is
+* writable. Every chunk is a complete reply, all but the last one carry
+* EXEC_TYPE_MORE_DATA. The walk resumes from the key of the last entry
+* sent, so the tables may change between chunks. The trace ring is copied
+* when the dump starts and the copy is sent in chunks.
+* ***************************************/
+#define MCLAGD_CTL_STREAM_MAX       4
+#define MCLAGD_CTL_STREAM_BUF_SIZE  65536
+#define MCLAGD_CTL_STREAM_TIMEOUT   30
+
+struct MclagdCtlStream
 {
-    char * Pbuf = NULL;
-    char buf[512] = { 0 };
-    int arp_num = 0;
-    int ret = 0;
+    int fd;
+    int info_type;
+    int mclag_id;
+    struct IccpDumpFilter filter;
+    struct IccpDumpCursor cursor;
+    char *snapshot;         /* trace records, after MCLAGD_REPLY_INFO_HDR */
+    int snapshot_num;
+    int snapshot_pos;
+    time_t last_time;
+    int head;               /* next byte to send */
+    int tail;
+    char buf[MCLAGD_CTL_STREAM_BUF_SIZE];
+    LIST_ENTRY(MclagdCtlStream) next;
+};
+
+static LIST_HEAD(mclagd_ctl_stream_list, MclagdCtlStream) g_ctl_stream_list =
+    LIST_HEAD_INITIALIZER(g_ctl_stream_list);
+static int g_ctl_stream_num = 0;
+
+static void mclagd_ctl_reply_result(int client_fd, int info_type, int exec_result)
+{
+    char buf[sizeof(struct mclagd_reply_hdr)+sizeof(int)];
     struct mclagd_reply_hdr *hd = NULL;
     int len_tmp = 0;
 
-    ret = iccp_arp_dump(&Pbuf, &arp_num, mclag_id);
-    if (ret != EXEC_TYPE_SUCCESS)
+    len_tmp = sizeof(struct mclagd_reply_hdr);
+    memcpy(buf, &len_tmp, sizeof(int));
+    hd = (struct mclagd_reply_hdr *)(buf + sizeof(int));
+    hd->exec_result = exec_result;
+    hd->info_type = info_type;
+    hd->data_len = 0;
+    mclagd_ctl_sock_write(client_fd, buf, MCLAGD_REPLY_INFO_HDR);
+}
+
+static void mclagd_ctl_stream_close(struct System *sys, struct MclagdCtlStream *stream)
+{
+    epoll_ctl(sys->epoll_fd, EPOLL_CTL_DEL, stream->fd, NULL);
+    sys->readfd_count--;
+    close(stream->fd);
+    LIST_REMOVE(stream, next);
+    g_ctl_stream_num--;
+    if (stream->snapshot)
+        free(stream->snapshot);
+    free(stream);
+}
+
+/* Put the next chunk of the dump into the stream buffer */
+static void mclagd_ctl_stream_fill(struct MclagdCtlStream *stream)
+{
+    struct mclagd_reply_hdr *hd = NULL;
+    char *data = stream->buf + MCLAGD_REPLY_INFO_HDR;
+    int max_len = MCLAGD_CTL_STREAM_BUF_SIZE - MCLAGD_REPLY_INFO_HDR;
+    int data_len = 0;
+    int len_tmp = 0;
+    int num = 0;
+
+    switch (stream->info_type)
     {
-        len_tmp = sizeof(struct mclagd_reply_hdr);
-        memcpy(buf, &len_tmp, sizeof(int));
-        hd = (struct mclagd_reply_hdr *)(buf + sizeof(int));
-        hd->exec_result = ret;
-        hd->info_type = INFO_TYPE_DUMP_ARP;
-        hd->data_len = 0;
-        mclagd_ctl_sock_write(client_fd, buf, MCLAGD_REPLY_INFO_HDR);
+        case INFO_TYPE_DUMP_ARP:
+            num = iccp_arp_dump_next(&stream->cursor, &stream->filter, stream->mclag_id,
+                data, max_len / sizeof(struct mclagd_arp_msg));
+            data_len = num * sizeof(struct mclagd_arp_msg);
+            break;
 
-        if (Pbuf)
-            free(Pbuf);
+        case INFO_TYPE_DUMP_NDISC:
+            num = iccp_ndisc_dump_next(&stream->cursor, &stream->filter, stream->mclag_id,
+                data, max_len / sizeof(struct mclagd_ndisc_msg));
+            data_len = num * sizeof(struct mclagd_ndisc_msg);
+            break;
 
-        return;
+        case INFO_TYPE_DUMP_MAC:
+            num = iccp_mac_dump_next(&stream->cursor, &stream->filter, stream->mclag_id,
+                data, max_len / sizeof(struct mclagd_mac_msg));
+            data_len = num * sizeof(struct mclagd_mac_msg);
+            break;
+
+        case INFO_TYPE_DUMP_TRACE:
+            num = stream->snapshot_num - stream->snapshot_pos;
+            if (num > max_len / (int)sizeof(struct mclagd_trace_msg))
+                num = max_len / sizeof(struct mclagd_trace_msg);
+            data_len = num * sizeof(struct mclagd_trace_msg);
+            memcpy(data, stream->snapshot + MCLAGD_REPLY_INFO_HDR
+                + stream->snapshot_pos * sizeof(struct mclagd_trace_msg), data_len);
+            stream->snapshot_pos += num;
+            if (stream->snapshot_pos == stream->snapshot_num)
+                stream->cursor.done = 1;
+            break;
+
+        default:
+            stream->cursor.done = 1;
+            break;
     }
 
-    hd = (struct mclagd_reply_hdr *)(Pbuf + sizeof(int));
-    hd->exec_result = EXEC_TYPE_SUCCESS;
-    hd->info_type = INFO_TYPE_DUMP_ARP;
-    hd->data_len = arp_num * sizeof(struct mclagd_arp_msg);
+    hd = (struct mclagd_reply_hdr *)(stream->buf + sizeof(int));
+    hd->exec_result = stream->cursor.done ? EXEC_TYPE_SUCCESS : EXEC_TYPE_MORE_DATA;
+    hd->info_type = stream->info_type;
+    hd->data_len = data_len;
     len_tmp = (hd->data_len + sizeof(struct mclagd_reply_hdr));
-    memcpy(Pbuf, &len_tmp, sizeof(int));
-    mclagd_ctl_sock_write(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
-
-    if (Pbuf)
-        free(Pbuf);
+    memcpy(stream->buf, &len_tmp, sizeof(int));
 
-    return;
+    stream->head = 0;
+    stream->tail = MCLAGD_REPLY_INFO_HDR + data_len;
 }
 
-void mclagd_ctl_handle_dump_ndisc(int client_fd, int mclag_id)
+/* Start a streamed dump, return 1 if the stream owns client_fd from now on */
+static int mclagd_ctl_stream_start(int client_fd, struct mclagdctl_req_hdr *req)
 {
-    char *Pbuf = NULL;
-    char buf[512] = { 0 };
-    int ndisc_num = 0;
-    int ret = 0;
-    struct mclagd_reply_hdr *hd = NULL;
-    int len_tmp = 0;
+    struct System *sys = NULL;
+    struct CSM *csm = NULL;
+    struct MclagdCtlStream *stream = NULL;
+    struct MclagdCtlStream *next_stream = NULL;
+    struct epoll_event event;
+    time_t now = time(NULL);
+    int id_exist = 0;
 
-    ret = iccp_ndisc_dump(&Pbuf, &ndisc_num, mclag_id);
-    if (ret != EXEC_TYPE_SUCCESS)
+    if (!(sys = system_get_instance()))
     {
-        len_tmp = sizeof(struct mclagd_reply_hdr);
-        memcpy(buf, &len_tmp, sizeof(int));
-        hd = (struct mclagd_reply_hdr *)(buf + sizeof(int));
-        hd->exec_result = ret;
-        hd->info_type = INFO_TYPE_DUMP_NDISC;
-        hd->data_len = 0;
-        mclagd_ctl_sock_write(client_fd, buf, MCLAGD_REPLY_INFO_HDR);
+        mclagd_ctl_reply_result(client_fd, req->info_type, EXEC_TYPE_NO_EXIST_SYS);
+        return 0;
+    }
 
-        if (Pbuf)
-            free(Pbuf);
+    if (req->mclag_id > 0 && req->info_type != INFO_TYPE_DUMP_TRACE)
+    {
+        LIST_FOREACH(csm, &(sys->csm_list), next)
+        {
+            if (csm->mlag_id == req->mclag_id)
+                id_exist = 1;
+        }
 
-        return;
+        if (!id_exist)
+        {
+            mclagd_ctl_reply_result(client_fd, req->info_type, EXEC_TYPE_NO_EXIST_MCLAGID);
+            return 0;
+        }
     }
 
-    hd = (struct mclagd_reply_hdr *)(Pbuf + sizeof(int));
-    hd->exec_result = EXEC_TYPE_SUCCESS;
-    hd->info_type = INFO_TYPE_DUMP_NDISC;
-    hd->data_len = ndisc_num * sizeof(struct mclagd_ndisc_msg);
-    len_tmp = (hd->data_len + sizeof(struct mclagd_reply_hdr));
-    memcpy(Pbuf, &len_tmp, sizeof(int));
-    mclagd_ctl_sock_write(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
+    /* Drop streams whose client stopped reading */
+    for (stream = LIST_FIRST(&g_ctl_stream_list); stream; stream = next_stream)
+    {
+        next_stream = LIST_NEXT(stream, next);
+        if (now - stream->last_time > MCLAGD_CTL_STREAM_TIMEOUT)
+        {
+            ICCPD_LOG_NOTICE(__FUNCTION__, "Close idle mclagdctl %s dump on fd %d",
+                mclagd_ctl_cmd_str(stream->info_type), stream->fd);
+            mclagd_ctl_stream_close(sys, stream);
+        }
+    }
 
-    if (Pbuf)
-        free(Pbuf);
+    if (g_ctl_stream_num >= MCLAGD_CTL_STREAM_MAX)
+    {
+        ICCPD_LOG_WARN(__FUNCTION__, "Too many mclagdctl dumps in progress");
+        mclagd_ctl_reply_result(client_fd, req->info_type, EXEC_TYPE_FAILED);
+        return 0;
+    }
 
-    return;
+    stream = (struct MclagdCtlStream *)calloc(1, sizeof(struct MclagdCtlStream));
+    if (!stream)
+    {
+        mclagd_ctl_reply_result(client_fd, req->info_type, EXEC_TYPE_FAILED);
+        return 0;
+    }
+
+    req->para1[MCLAGDCTL_PARA2_LEN - 1] = '\0';
+    req->para2[MCLAGDCTL_PARA2_LEN - 1] = '\0';
+    req->para3[MCLAGDCTL_PARA2_LEN - 1] = '\0';
+    if (iccp_dump_filter_parse(&stream->filter, req->para1, req->para2, req->para3) < 0)
+    {
+        ICCPD_LOG_NOTICE(__FUNCTION__, "Invalid mclagdctl dump filter vlan %s port %s mac %s",
+            req->para1, req->para2, req->para3);
+        mclagd_ctl_reply_result(client_fd, req->info_type, EXEC_TYPE_FAILED);
+        free(stream);
+        return 0;
+    }
+
+    if (req->info_type == INFO_TYPE_DUMP_TRACE
+        && iccp_trace_dump(&stream->snapshot, &stream->snapshot_num) != EXEC_TYPE_SUCCESS)
+    {
+        mclagd_ctl_reply_result(client_fd, req->info_type, EXEC_TYPE_FAILED);
+        free(stream);
+        return 0;
+    }
+
+    stream->fd = client_fd;
+    stream->info_type = req->info_type;
+    stream->mclag_id = req->mclag_id;
+    stream->last_time = now;
+
+    event.data.fd = client_fd;
+    event.events = EPOLLOUT;
+    if (epoll_ctl(sys->epoll_fd, EPOLL_CTL_ADD, client_fd, &event) != 0)
+    {
+        ICCPD_LOG_ERR(__FUNCTION__, "Failed to add mclagdctl fd %d to epoll, errno %d",
+            client_fd, errno);
+        mclagd_ctl_reply_result(client_fd, req->info_type, EXEC_TYPE_FAILED);
+        if (stream->snapshot)
+            free(stream->snapshot);
+        free(stream);
+        return 0;
+    }
+    sys->readfd_count++;
+
+    LIST_INSERT_HEAD(&g_ctl_stream_list, stream, next);
+    g_ctl_stream_num++;
+
+    return 1;
 }
 
-void mclagd_ctl_handle_dump_mac(int client_fd, int mclag_id)
+/* Serve fd if it belongs to a streamed dump, return 0 if it does not */
+int mclagd_ctl_stream_handler(struct System *sys, int fd, uint32_t events)
 {
-    char * Pbuf = NULL;
-    char buf[512] = { 0 };
-    int mac_num = 0;
-    int ret = 0;
-    struct mclagd_reply_hdr *hd = NULL;
-    int len_tmp = 0;
+    struct MclagdCtlStream *stream = NULL;
+    ssize_t ret = 0;
 
-    ret = iccp_mac_dump(&Pbuf, &mac_num, mclag_id);
-    if (ret != EXEC_TYPE_SUCCESS)
+    LIST_FOREACH(stream, &g_ctl_stream_list, next)
     {
-        len_tmp = sizeof(struct mclagd_reply_hdr);
-        memcpy(buf, &len_tmp, sizeof(int));
-        hd = (struct mclagd_reply_hdr *)(buf + sizeof(int));
-        hd->exec_result = ret;
-        hd->info_type = INFO_TYPE_DUMP_MAC;
-        hd->data_len = 0;
-        mclagd_ctl_sock_write(client_fd, buf, MCLAGD_REPLY_INFO_HDR);
+        if (stream->fd == fd)
+            break;
+    }
 
-        if (Pbuf)
-            free(Pbuf);
+    if (!stream)
+        return 0;
 
-        return;
+    if (events & (EPOLLERR | EPOLLHUP))
+    {
+        mclagd_ctl_stream_close(sys, stream);
+        return 1;
     }
 
-    hd = (struct mclagd_reply_hdr *)(Pbuf + sizeof(int));
-    hd->exec_result = EXEC_TYPE_SUCCESS;
-    hd->info_type = INFO_TYPE_DUMP_MAC;
-    hd->data_len = mac_num * sizeof(struct mclagd_mac_msg);
+    if (stream->head == stream->tail && !stream->cursor.done)
+        mclagd_ctl_stream_fill(stream);
 
-    len_tmp = (hd->data_len + sizeof(struct mclagd_reply_hdr));
-    memcpy(Pbuf, &len_tmp, sizeof(int));
+    while (stream->head < stream->tail)
+    {
+        ret = send(fd, stream->buf + stream->head, stream->tail - stream->head,
+            MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+                continue;
 
-    mclagd_ctl_sock_write(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+                break;
 
-    if (Pbuf)
-        free(Pbuf);
+            mclagd_ctl_stream_close(sys, stream);
+            return 1;
+        }
 
-    return;
+        stream->head += ret;
+    }
+
+    stream->last_time = time(NULL);
+
+    if (stream->head == stream->tail && stream->cursor.done)
+        mclagd_ctl_stream_close(sys, stream);
+
+    return 1;
 }
 
 void mclagd_ctl_handle_dump_local_portlist(int client_fd, int mclag_id)
@@ -4162,6 +4452,47 @@ void mclagd_ctl_handle_config_loglevel(int client_fd, int log_level)
     return;
 }
 
+void mclagd_ctl_handle_config_tracelevel(int client_fd, int log_level)
+{
+    char buf[sizeof(struct mclagd_reply_hdr)+sizeof(int)];
+    struct mclagd_reply_hdr *hd = NULL;
+    int len_tmp = 0;
+
+    logger_set_trace_level(log_level);
+
+    len_tmp = sizeof(struct mclagd_reply_hdr);
+    memcpy(buf, &len_tmp, sizeof(int));
+    hd = (struct mclagd_reply_hdr *)(buf + sizeof(int));
+    hd->exec_result = EXEC_TYPE_SUCCESS;
+    hd->info_type = INFO_TYPE_CONFIG_TRACELEVEL;
+    hd->data_len = 0;
+    mclagd_ctl_sock_write(client_fd, buf, MCLAGD_REPLY_INFO_HDR);
+
+    return;
+}
+
+void mclagd_ctl_handle_config_logtag(int client_fd, char *tag, int log_level)
+{
+    char buf[sizeof(struct mclagd_reply_hdr)+sizeof(int)];
+    struct mclagd_reply_hdr *hd = NULL;
+    int len_tmp = 0;
+
+    tag[MCLAGDCTL_PARA2_LEN - 1] = '\0';
+
+    len_tmp = sizeof(struct mclagd_reply_hdr);
+    memcpy(buf, &len_tmp, sizeof(int));
+    hd = (struct mclagd_reply_hdr *)(buf + sizeof(int));
+    if (logger_set_tag_level(tag, log_level) == 0)
+        hd->exec_result = EXEC_TYPE_SUCCESS;
+    else
+        hd->exec_result = EXEC_TYPE_FAILED;
+    hd->info_type = INFO_TYPE_CONFIG_LOGTAG;
+    hd->data_len = 0;
+    mclagd_ctl_sock_write(client_fd, buf, MCLAGD_REPLY_INFO_HDR);
+
+    return;
+}
+
 int mclagd_ctl_interactive_process(int client_fd)
 {
     char buf[512] = { 0 };
@@ -4188,15 +4519,11 @@ int mclagd_ctl_interactive_process(int client_fd)
             break;
 
         case INFO_TYPE_DUMP_ARP:
-            mclagd_ctl_handle_dump_arp(client_fd, req->mclag_id);
-            break;
-
         case INFO_TYPE_DUMP_NDISC:
-            mclagd_ctl_handle_dump_ndisc(client_fd, req->mclag_id);
-            break;
-
         case INFO_TYPE_DUMP_MAC:
-            mclagd_ctl_handle_dump_mac(client_fd, req->mclag_id);
+        case INFO_TYPE_DUMP_TRACE:
+            if (mclagd_ctl_stream_start(client_fd, req))
+                return MCLAGD_CTL_STREAMING;
             break;
 
         case INFO_TYPE_DUMP_LOCAL_PORTLIST:
@@ -4219,6 +4546,14 @@ int mclagd_ctl_interactive_process(int client_fd)
             mclagd_ctl_handle_config_loglevel(client_fd, req->mclag_id);
             break;
 
+        case INFO_TYPE_CONFIG_TRACELEVEL:
+            mclagd_ctl_handle_config_tracelevel(client_fd, req->mclag_id);
+            break;
+
+        case INFO_TYPE_CONFIG_LOGTAG:
+            mclagd_ctl_handle_config_logtag(client_fd, req->para1, req->mclag_id);
+            break;
+
         default:
             return MCLAG_ERROR;
     }
@@ -25,6 +25,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <endian.h>
 
 #include <sys/queue.h>
 
@@ -723,6 +724,120 @@ int mlacp_prepare_for_if_up_ack(
     return msg_len;
 }
 
+/*****************************************
+* Prepare table digest
+*
+* ***************************************/
+int mlacp_prepare_for_sync_digest(struct CSM* csm, char* buf, size_t max_buf_size, uint8_t table, uint64_t* digest)
+{
+    ICCHdr* icc_hdr = NULL;
+    struct mLACPSyncDigestTLV* tlv = NULL;
+    size_t tlv_len = sizeof(struct mLACPSyncDigestTLV) + sizeof(uint64_t) * MLACP_DIGEST_BUCKET_NUM;
+    size_t msg_len = sizeof(ICCHdr) + tlv_len;
+    int i;
+
+    if (csm == NULL || buf == NULL || digest == NULL)
+        return MCLAG_ERROR;
+
+    if (msg_len > max_buf_size)
+        return MCLAG_ERROR;
+
+    memset(buf, 0, max_buf_size);
+
+    icc_hdr = (ICCHdr*)buf;
+    tlv = (struct mLACPSyncDigestTLV*)&buf[sizeof(ICCHdr)];
+
+    /* ICC header */
+    mlacp_fill_icc_header(csm, icc_hdr, msg_len);
+
+    /* Digest TLV */
+    tlv->icc_parameter.u_bit = 0;
+    tlv->icc_parameter.f_bit = 0;
+    tlv->icc_parameter.type = htons(TLV_T_MLACP_SYNC_DIGEST);
+    tlv->icc_parameter.len = htons(tlv_len - sizeof(ICCParameter));
+    tlv->table = table;
+    tlv->bucket_num = htons(MLACP_DIGEST_BUCKET_NUM);
+
+    for (i = 0; i < MLACP_DIGEST_BUCKET_NUM; i++)
+        tlv->digest[i] = htobe64(digest[i]);
+
+    ICCPD_LOG_DEBUG("ICCP_FSM", "TX sync digest: table %d", table);
+    return msg_len;
+}
+
+/*****************************************
+* Prepare table digest support
+*
+* ***************************************/
+int mlacp_prepare_for_sync_digest_support(struct CSM* csm, char* buf, size_t max_buf_size)
+{
+    ICCHdr* icc_hdr = NULL;
+    struct mLACPSyncDigestSupportTLV* tlv = NULL;
+    size_t msg_len = sizeof(ICCHdr) + sizeof(struct mLACPSyncDigestSupportTLV);
+
+    if (csm == NULL || buf == NULL)
+        return MCLAG_ERROR;
+
+    if (msg_len > max_buf_size)
+        return MCLAG_ERROR;
+
+    memset(buf, 0, max_buf_size);
+
+    icc_hdr = (ICCHdr*)buf;
+    tlv = (struct mLACPSyncDigestSupportTLV*)&buf[sizeof(ICCHdr)];
+
+    /* ICC header */
+    mlacp_fill_icc_header(csm, icc_hdr, msg_len);
+
+    /* Digest support TLV */
+    tlv->icc_parameter.u_bit = 0;
+    tlv->icc_parameter.f_bit = 0;
+    tlv->icc_parameter.type = htons(TLV_T_MLACP_SYNC_DIGEST_SUPPORT);
+    tlv->icc_parameter.len = htons(sizeof(struct mLACPSyncDigestSupportTLV) - sizeof(ICCParameter));
+    tlv->bucket_num = htons(MLACP_DIGEST_BUCKET_NUM);
+
+    ICCPD_LOG_DEBUG("ICCP_FSM", "TX sync digest support");
+    return msg_len;
+}
+
+/*****************************************
+* Prepare table digest ACK
+*
+* ***************************************/
+int mlacp_prepare_for_sync_digest_ack(struct CSM* csm, char* buf, size_t max_buf_size, uint8_t table, uint8_t* mismatch)
+{
+    ICCHdr* icc_hdr = NULL;
+    struct mLACPSyncDigestAckTLV* tlv = NULL;
+    size_t tlv_len = sizeof(struct mLACPSyncDigestAckTLV) + MLACP_DIGEST_MAP_SIZE;
+    size_t msg_len = sizeof(ICCHdr) + tlv_len;
+
+    if (csm == NULL || buf == NULL || mismatch == NULL)
+        return MCLAG_ERROR;
+
+    if (msg_len > max_buf_size)
+        return MCLAG_ERROR;
+
+    memset(buf, 0, max_buf_size);
+
+    icc_hdr = (ICCHdr*)buf;
+    tlv = (struct mLACPSyncDigestAckTLV*)&buf[sizeof(ICCHdr)];
+
+    /* ICC header */
+    mlacp_fill_icc_header(csm, icc_hdr, msg_len);
+
+    /* Digest ACK TLV */
+    tlv->icc_parameter.u_bit = 0;
+    tlv->icc_parameter.f_bit = 0;
+    tlv->icc_parameter.type = htons(TLV_T_MLACP_SYNC_DIGEST_ACK);
+    tlv->icc_parameter.len = htons(tlv_len - sizeof(ICCParameter));
+    tlv->table = table;
+    tlv->bucket_num = htons(MLACP_DIGEST_BUCKET_NUM);
+    memcpy(tlv->mismatch, mismatch, MLACP_DIGEST_MAP_SIZE);
+
+    ICCPD_LOG_DEBUG("ICCP_FSM", "TX sync digest ack: table %d", table);
+    return msg_len;
+}
+
 /*****************************************
 * Tool : Prepare ICC Header
 *
@@ -132,7 +132,7 @@ int mlacp_fsm_update_Agg_conf(struct CSM* csm, mLACPAggConfigTLV* portconf)
     }
 
     pif->po_id = ntohs(portconf->agg_id);
-    memcpy(pif->name, portconf->agg_name, portconf->agg_name_len);
+    peer_if_set_name(csm, pif, portconf->agg_name, portconf->agg_name_len);
     memcpy(pif->mac_addr, portconf->mac_addr, ETHER_ADDR_LEN);
 
     po_active = (pif->state == PORT_STATE_UP);
@@ -361,7 +361,7 @@ int mlacp_fsm_update_mac_entry_from_peer( struct CSM* csm, struct mLACPMACData *
                             // else free is taken care after sending the update to peer
                             if (!MAC_IN_MSG_LIST(&(MLACP(csm).mac_msg_list), mac_msg, tail))
                             {
-                                free(mac_msg);
+                                iccp_csm_free_mac_msg(mac_msg);
                             }
 
                             ICCPD_LOG_ERR(__FUNCTION__, "Ignore Recv MAC ADD "
@@ -467,7 +467,7 @@ int mlacp_fsm_update_mac_entry_from_peer( struct CSM* csm, struct mLACPMACData *
             // else free is taken care after sending the update to peer
             if (!MAC_IN_MSG_LIST(&(MLACP(csm).mac_msg_list), mac_msg, tail))
             {
-                free(mac_msg);
+                iccp_csm_free_mac_msg(mac_msg);
             }
         }
         else
@@ -568,6 +568,83 @@ int mlacp_fsm_update_mac_info_from_peer(struct CSM* csm, struct mLACPMACInfoTLV*
     }
 }
 
+static int mlacp_arp_compare(const struct Msg *msg1, const struct Msg *msg2)
+{
+    uint32_t addr1 = ((struct ARPMsg *)msg1->buf)->ipv4_addr;
+    uint32_t addr2 = ((struct ARPMsg *)msg2->buf)->ipv4_addr;
+
+    if (addr1 < addr2)
+        return -1;
+
+    if (addr1 > addr2)
+        return 1;
+
+    return 0;
+}
+RB_GENERATE(arp_rb_tree, Msg, neigh_entry_rb, mlacp_arp_compare);
+
+static int mlacp_ndisc_compare(const struct Msg *msg1, const struct Msg *msg2)
+{
+    return memcmp(((struct NDISCMsg *)msg1->buf)->ipv6_addr, ((struct NDISCMsg *)msg2->buf)->ipv6_addr, 16);
+}
+RB_GENERATE(ndisc_rb_tree, Msg, neigh_entry_rb, mlacp_ndisc_compare);
+
+/*****************************************
+ * Tool : Find ARP Info in ARP list by IP
+ *
+ ****************************************/
+struct Msg* mlacp_find_arp(struct CSM* csm, uint32_t ipv4_addr)
+{
+    struct ARPMsg arp_key;
+    struct Msg msg_key;
+
+    memset(&arp_key, 0, sizeof(struct ARPMsg));
+    arp_key.ipv4_addr = ipv4_addr;
+    msg_key.buf = (char *)&arp_key;
+
+    return RB_FIND(arp_rb_tree, &MLACP(csm).arp_rb, &msg_key);
+}
+
+/*****************************************
+ * Tool : Find Ndisc Info in ndisc list by IP
+ *
+ ****************************************/
+struct Msg* mlacp_find_ndisc(struct CSM *csm, uint32_t *ipv6_addr)
+{
+    struct NDISCMsg ndisc_key;
+    struct Msg msg_key;
+
+    memset(&ndisc_key, 0, sizeof(struct NDISCMsg));
+    memcpy(ndisc_key.ipv6_addr, ipv6_addr, 16);
+    msg_key.buf = (char *)&ndisc_key;
+
+    return RB_FIND(ndisc_rb_tree, &MLACP(csm).ndisc_rb, &msg_key);
+}
+
+/*****************************************
+ * Tool : Remove ARP Info from ARP list, caller frees msg
+ *
+ ****************************************/
+void mlacp_dequeue_arp(struct CSM* csm, struct Msg* msg)
+{
+    TAILQ_REMOVE(&(MLACP(csm).arp_list), msg, tail);
+    RB_REMOVE(arp_rb_tree, &MLACP(csm).arp_rb, msg);
+
+    return;
+}
+
+/*****************************************
+ * Tool : Remove Ndisc Info from ndisc list, caller frees msg
+ *
+ ****************************************/
+void mlacp_dequeue_ndisc(struct CSM *csm, struct Msg *msg)
+{
+    TAILQ_REMOVE(&(MLACP(csm).ndisc_list), msg, tail);
+    RB_REMOVE(ndisc_rb_tree, &MLACP(csm).ndisc_rb, msg);
+
+    return;
+}
+
 /*****************************************
  * Tool : Add ARP Info into ARP list
  *
@@ -579,7 +656,7 @@ void mlacp_enqueue_arp(struct CSM* csm, struct Msg* msg)
     if (!csm)
     {
         if (msg)
-            free(msg);
+            iccp_csm_free_msg(msg);
         return;
     }
     if (!msg)
@@ -588,6 +665,13 @@ void mlacp_enqueue_arp(struct CSM* csm, struct Msg* msg)
     arp_msg = (struct ARPMsg*)msg->buf;
     if (arp_msg->op_type != NEIGH_SYNC_DEL)
     {
+        /* list keeps insertion order for sync and dump, tree is the lookup index */
+        if (RB_INSERT(arp_rb_tree, &MLACP(csm).arp_rb, msg) != NULL)
+        {
+            ICCPD_LOG_DEBUG(__FUNCTION__, "ARP %s is already in ARP list", show_ip_str(arp_msg->ipv4_addr));
+            iccp_csm_free_msg(msg);
+            return;
+        }
         TAILQ_INSERT_TAIL(&(MLACP(csm).arp_list), msg, tail);
     }
 
@@ -605,7 +689,7 @@ void mlacp_enqueue_ndisc(struct CSM *csm, struct Msg *msg)
     if (!csm)
     {
         if (msg)
-            free(msg);
+            iccp_csm_free_msg(msg);
         return;
     }
     if (!msg)
@@ -614,6 +698,12 @@ void mlacp_enqueue_ndisc(struct CSM *csm, struct Msg *msg)
     ndisc_msg = (struct NDISCMsg *)msg->buf;
     if (ndisc_msg->op_type != NEIGH_SYNC_DEL)
     {
+        if (RB_INSERT(ndisc_rb_tree, &MLACP(csm).ndisc_rb, msg) != NULL)
+        {
+            ICCPD_LOG_DEBUG(__FUNCTION__, "ND %s is already in ndisc list", show_ipv6_str((char *)ndisc_msg->ipv6_addr));
+            iccp_csm_free_msg(msg);
+            return;
+        }
         TAILQ_INSERT_TAIL(&(MLACP(csm).ndisc_list), msg, tail);
     }
 
@@ -841,24 +931,20 @@ int mlacp_fsm_update_arp_entry(struct CSM* csm, struct ARPMsg *arp_entry)
     }
 
     /* update ARP list*/
-    TAILQ_FOREACH(msg, &(MLACP(csm).arp_list), tail)
+    msg = mlacp_find_arp(csm, arp_entry->ipv4_addr);
+    if (msg)
     {
         arp_msg = (struct ARPMsg*)msg->buf;
-        if (arp_msg->ipv4_addr == arp_entry->ipv4_addr)
-        {
-            /*arp_msg->op_type = tlv->type;*/
-            sprintf(arp_msg->ifname, "%s", arp_entry->ifname);
-            memcpy(arp_msg->mac_addr, arp_entry->mac_addr, ETHER_ADDR_LEN);
-            break;
-        }
+        /*arp_msg->op_type = tlv->type;*/
+        sprintf(arp_msg->ifname, "%s", arp_entry->ifname);
+        memcpy(arp_msg->mac_addr, arp_entry->mac_addr, ETHER_ADDR_LEN);
     }
 
     /* delete/add ARP list*/
     if (msg && arp_entry->op_type == NEIGH_SYNC_DEL)
     {
-        TAILQ_REMOVE(&(MLACP(csm).arp_list), msg, tail);
-        free(msg->buf);
-        free(msg);
+        mlacp_dequeue_arp(csm, msg);
+        iccp_csm_free_msg(msg);
         /*ICCPD_LOG_INFO(__FUNCTION__, "Del arp queue successfully");*/
     }
     else if (!msg && arp_entry->op_type == NEIGH_SYNC_ADD)
@@ -889,8 +975,7 @@ int mlacp_fsm_update_arp_entry(struct CSM* csm, struct ARPMsg *arp_entry)
     {
         arp_msg = (struct ARPMsg*)msg->buf;
         TAILQ_REMOVE(&(MLACP(csm).arp_msg_list), msg, tail);
-        free(msg->buf);
-        free(msg);
+        iccp_csm_free_msg(msg);
         TAILQ_FOREACH(msg, &(MLACP(csm).arp_msg_list), tail)
         {
             arp_msg = (struct ARPMsg*)msg->buf;
@@ -1163,24 +1248,20 @@ int mlacp_fsm_update_ndisc_entry(struct CSM *csm, struct NDISCMsg *ndisc_entry)
     }
 
     /* update NDISC list */
-    TAILQ_FOREACH(msg, &(MLACP(csm).ndisc_list), tail)
+    msg = mlacp_find_ndisc(csm, ndisc_entry->ipv6_addr);
+    if (msg)
     {
         ndisc_msg = (struct NDISCMsg *)msg->buf;
-        if (memcmp((char *)ndisc_msg->ipv6_addr, (char *)ndisc_entry->ipv6_addr, 16) == 0)
-        {
-            /* ndisc_msg->op_type = tlv->type; */
-            sprintf(ndisc_msg->ifname, "%s", ndisc_entry->ifname);
-            memcpy(ndisc_msg->mac_addr, ndisc_entry->mac_addr, ETHER_ADDR_LEN);
-            break;
-        }
+        /* ndisc_msg->op_type = tlv->type; */
+        sprintf(ndisc_msg->ifname, "%s", ndisc_entry->ifname);
+        memcpy(ndisc_msg->mac_addr, ndisc_entry->mac_addr, ETHER_ADDR_LEN);
     }
 
     /* delete/add NDISC list */
     if (msg && ndisc_entry->op_type == NEIGH_SYNC_DEL)
     {
-        TAILQ_REMOVE(&(MLACP(csm).ndisc_list), msg, tail);
-        free(msg->buf);
-        free(msg);
+        mlacp_dequeue_ndisc(csm, msg);
+        iccp_csm_free_msg(msg);
         /* ICCPD_LOG_INFO(__FUNCTION__, "Del ndisc queue successfully"); */
     }
     else if (!msg && ndisc_entry->op_type == NEIGH_SYNC_ADD)
@@ -1211,8 +1292,7 @@ int mlacp_fsm_update_ndisc_entry(struct CSM *csm, struct NDISCMsg *ndisc_entry)
     {
         ndisc_msg = (struct NDISCMsg *)msg->buf;
         TAILQ_REMOVE(&(MLACP(csm).ndisc_msg_list), msg, tail);
-        free(msg->buf);
-        free(msg);
+        iccp_csm_free_msg(msg);
         TAILQ_FOREACH(msg, &(MLACP(csm).ndisc_msg_list), tail)
         {
             ndisc_msg = (struct NDISCMsg *)msg->buf;
@@ -46,6 +46,108 @@ static int vlan_node_compare(const struct VLAN_ID *p_vlan_node1, const struct VL
 }
 RB_GENERATE(vlan_rb_tree, VLAN_ID, vlan_entry, vlan_node_compare);
 
+/* FNV-1a hash of an interface name */
+static uint32_t if_name_hash(const char* name)
+{
+    uint32_t hash = 2166136261u;
+
+    while (*name)
+    {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+#define LIF_NAME_BUCKET(sys, name) (&(sys)->lif_name_hash[if_name_hash(name) & (LIF_HASH_SIZE - 1)])
+#define LIF_IFINDEX_BUCKET(sys, ifindex) (&(sys)->lif_ifindex_hash[(uint32_t)(ifindex) & (LIF_HASH_SIZE - 1)])
+#define LIF_PO_BUCKET(sys, po_id) (&(sys)->lif_po_hash[(uint32_t)(po_id) & (LIF_HASH_SIZE - 1)])
+#define PIF_NAME_BUCKET(csm, name) (&MLACP(csm).pif_name_hash[if_name_hash(name) & (PIF_HASH_SIZE - 1)])
+
+void local_if_hash_init(struct System* sys)
+{
+    int i;
+
+    for (i = 0; i < LIF_HASH_SIZE; i++)
+    {
+        LIST_INIT(&(sys->lif_name_hash[i]));
+        LIST_INIT(&(sys->lif_ifindex_hash[i]));
+        LIST_INIT(&(sys->lif_po_hash[i]));
+    }
+
+    return;
+}
+
+/* Index a local interface, when it is added to sys->lif_list */
+static void local_if_hash_add(struct System* sys, struct LocalInterface* lif)
+{
+    LIST_INSERT_HEAD(LIF_NAME_BUCKET(sys, lif->name), lif, name_hash_next);
+    LIST_INSERT_HEAD(LIF_IFINDEX_BUCKET(sys, lif->ifindex), lif, ifindex_hash_next);
+    /* po_id of a port channel never changes, unlike that of a member port */
+    if (lif->type == IF_T_PORT_CHANNEL)
+        LIST_INSERT_HEAD(LIF_PO_BUCKET(sys, lif->po_id), lif, po_hash_next);
+
+    return;
+}
+
+/* Unindex a local interface, when it is removed from sys->lif_list */
+static void local_if_hash_del(struct LocalInterface* lif)
+{
+    LIST_REMOVE(lif, name_hash_next);
+    LIST_REMOVE(lif, ifindex_hash_next);
+    if (lif->type == IF_T_PORT_CHANNEL)
+        LIST_REMOVE(lif, po_hash_next);
+
+    return;
+}
+
+void local_if_set_ifindex(struct LocalInterface* local_if, int ifindex)
+{
+    struct System* sys = NULL;
+
+    if (local_if == NULL || local_if->ifindex == ifindex)
+        return;
+
+    if ((sys = system_get_instance()) == NULL)
+        return;
+
+    LIST_REMOVE(local_if, ifindex_hash_next);
+    local_if->ifindex = ifindex;
+    LIST_INSERT_HEAD(LIF_IFINDEX_BUCKET(sys, ifindex), local_if, ifindex_hash_next);
+
+    return;
+}
+
+void peer_if_hash_init(struct CSM* csm)
+{
+    int i;
+
+    for (i = 0; i < PIF_HASH_SIZE; i++)
+        LIST_INIT(&(MLACP(csm).pif_name_hash[i]));
+
+    return;
+}
+
+void peer_if_set_name(struct CSM* csm, struct PeerInterface* peer_if, const char* name, int len)
+{
+    if (csm == NULL || peer_if == NULL)
+        return;
+
+    if (peer_if->name_hashed)
+        LIST_REMOVE(peer_if, name_hash_next);
+
+    if (len >= MAX_L_PORT_NAME)
+        len = MAX_L_PORT_NAME - 1;
+    memcpy(peer_if->name, name, len);
+    peer_if->name[len] = '\0';
+
+    LIST_INSERT_HEAD(PIF_NAME_BUCKET(csm, peer_if->name), peer_if, name_hash_next);
+    peer_if->name_hashed = 1;
+
+    return;
+}
+
 void local_if_init(struct LocalInterface* local_if)
 {
     if (local_if == NULL)
@@ -165,6 +267,7 @@ struct LocalInterface* local_if_create(int ifindex, char* ifname, int type, uint
                    local_if->mac_addr[3], local_if->mac_addr[4], local_if->mac_addr[5], local_if->state ? "down" : "up");
 
     LIST_INSERT_HEAD(&(sys->lif_list), local_if, system_next);
+    local_if_hash_add(sys, local_if);
 
     //if there is pending vlan membership for this interface move to system lif
     move_pending_vlan_mbr_to_lif(sys, local_if);
@@ -202,7 +305,7 @@ struct LocalInterface* local_if_find_by_name(const char* ifname)
     if (!(sys = system_get_instance()))
         return NULL;
 
-    LIST_FOREACH(local_if, &(sys->lif_list), system_next)
+    LIST_FOREACH(local_if, LIF_NAME_BUCKET(sys, ifname), name_hash_next)
     {
         if (strcmp(local_if->name, ifname) == 0)
             return local_if;
@@ -219,7 +322,7 @@ struct LocalInterface* local_if_find_by_ifindex(int ifindex)
     if ((sys = system_get_instance()) == NULL)
         return NULL;
 
-    LIST_FOREACH(local_if, &(sys->lif_list), system_next)
+    LIST_FOREACH(local_if, LIF_IFINDEX_BUCKET(sys, ifindex), ifindex_hash_next)
     {
         if (local_if->ifindex == ifindex)
             return local_if;
@@ -236,9 +339,9 @@ struct LocalInterface* local_if_find_by_po_id(int po_id)
     if ((sys = system_get_instance()) == NULL)
         return NULL;
 
-    LIST_FOREACH(local_if, &(sys->lif_list), system_next)
+    LIST_FOREACH(local_if, LIF_PO_BUCKET(sys, po_id), po_hash_next)
     {
-        if (local_if->type == IF_T_PORT_CHANNEL && local_if->po_id == po_id)
+        if (local_if->po_id == po_id)
             return local_if;
     }
 
@@ -365,6 +468,7 @@ void local_if_destroy(char *ifname)
 to_sys_purge:
     /* sys purge */
     LIST_REMOVE(lif, system_next);
+    local_if_hash_del(lif);
     if (lif->csm)
         LIST_REMOVE(lif, mlacp_next);
     LIST_INSERT_HEAD(&(sys->lif_purge_list), lif, system_purge_next);
@@ -373,6 +477,7 @@ to_sys_purge:
 to_mlacp_purge:
     /* sys & mlacp purge */
     LIST_REMOVE(lif, system_next);
+    local_if_hash_del(lif);
     LIST_REMOVE(lif, mlacp_next);
     LIST_INSERT_HEAD(&(sys->lif_purge_list), lif, system_purge_next);
     LIST_INSERT_HEAD(&(MLACP(csm).lif_purge_list), lif, mlacp_purge_next);
@@ -531,7 +636,7 @@ struct PeerInterface* peer_if_find_by_name(struct CSM* csm, char* name)
     if (csm == NULL)
         return NULL;
 
-    LIST_FOREACH(peer_if, &(csm->app_csm.mlacp.pif_list), mlacp_next)
+    LIST_FOREACH(peer_if, PIF_NAME_BUCKET(csm, name), name_hash_next)
     {
         if (strcmp(peer_if->name, name) == 0)
             return peer_if;
@@ -561,6 +666,8 @@ void peer_if_destroy(struct PeerInterface* pif)
 
     /* destroy if*/
     LIST_REMOVE(pif, mlacp_next);
+    if (pif->name_hashed)
+        LIST_REMOVE(pif, name_hash_next);
     peer_if_del_all_vlan(pif);
 
     free(pif);
@@ -51,8 +51,8 @@
 //this needs to be fine tuned
 #define PEER_SOCK_SND_BUF_LEN  (6 * 1024 * 1024)
 #define PEER_SOCK_RCV_BUF_LEN  (6 * 1024 * 1024)
-#define RECV_RETRY_INTERVAL_USEC    100000
-#define RECV_RETRY_MAX              10
+/* Max recv() calls for one readiness event, the rest is read on the next one */
+#define RECV_BATCH_MAX              64
 
 extern int mlacp_prepare_for_warm_reboot(struct CSM* csm, char* buf, size_t max_buf_size);
 
@@ -126,129 +126,105 @@ static int scheduler_transit_fsm()
     return 1;
 }
 
-/* Receive packets call back function */
-int scheduler_csm_read_callback(struct CSM* csm)
+/* Queue the complete messages at the front of the receive buffer */
+static int scheduler_csm_parse_recv_buf(struct CSM* csm)
 {
     struct Msg* msg = NULL;
-    /*peer message*/
-    char *peer_msg = g_csm_buf;
-    LDPHdr* ldp_hdr = (LDPHdr*)peer_msg;
-    char* data = &peer_msg[sizeof(LDPHdr)];
-    size_t data_len = 0;
+    LDPHdr* ldp_hdr;
     size_t pos = 0;
-    int recv_len = 0, len = 0, retval;
-    int num_retry = 0;
-    int total_retry_time = 0;
-    int total_data_len = 0;
-
-    if (csm->sock_fd <= 0)
-        return MCLAG_ERROR;
+    size_t msg_len;
 
-    memset(peer_msg, 0, CSM_BUFFER_SIZE);
-
-    recv_len = 0;
-    errno = 0;
-
-    while (recv_len != sizeof(LDPHdr))
+    while (csm->recv_len - pos >= sizeof(LDPHdr))
     {
-        len = recv(csm->sock_fd, peer_msg + recv_len, sizeof(LDPHdr) - recv_len, 0);
-        if (len == -1)
+        ldp_hdr = (LDPHdr*)&csm->recv_buf[pos];
+        if (ntohs(ldp_hdr->msg_len) < MSG_L_INCLUD_U_BIT_MSG_T_L_FIELDS)
         {
-            perror("recv(). Error");
-            ICCPD_LOG_WARN("ICCP_FSM", "Peer disconnect for header read error[%s] len = -1 till now received len  = %d ", strerror(errno), recv_len);
-            SYSTEM_INCR_HDR_READ_SOCK_ERR_COUNTER(system_get_instance());
-            goto recv_err;
+            ICCPD_LOG_ERR("ICCP_FSM", "Peer disconnect for invalid data error; length[%d] msg_type[0x%x] ", ntohs(ldp_hdr->msg_len),  ntohs(ldp_hdr->msg_type));
+            SYSTEM_INCR_INVALID_PEER_MSG_COUNTER(system_get_instance());
+            return MCLAG_ERROR;
         }
-        else if (len == 0)
+
+        msg_len = ntohs(ldp_hdr->msg_len) + MSG_L_INCLUD_U_BIT_MSG_T_L_FIELDS;
+        if (csm->recv_len - pos < msg_len)
+            break;
+
+        if (iccp_csm_init_msg(&msg, &csm->recv_buf[pos], msg_len) == 0)
         {
-            ICCPD_LOG_WARN("ICCP_FSM", "Peer disconnect for header read error[%s] len = 0, till now received len = %d ",strerror(errno), recv_len);
-            SYSTEM_INCR_HDR_READ_SOCK_ZERO_LEN_COUNTER(system_get_instance());
-            goto recv_err;
+            iccp_csm_enqueue_msg(csm, msg);
+            ++csm->icc_msg_in_count;
         }
-        recv_len += len;
-        /*usleep(100);*/
-    }
+        else
+            ++csm->i_msg_in_count;
 
-    if (ntohs(ldp_hdr->msg_len) >= MSG_L_INCLUD_U_BIT_MSG_T_L_FIELDS)
-    {
-        data_len = ntohs(ldp_hdr->msg_len) - MSG_L_INCLUD_U_BIT_MSG_T_L_FIELDS;
+        pos += msg_len;
     }
-    else
+
+    /* Move the partial message to the front for the next read */
+    if (pos > 0)
     {
-        ICCPD_LOG_ERR("ICCP_FSM", "Peer disconnect for invalid data error; length[%d] msg_type[0x%x] ", ntohs(ldp_hdr->msg_len),  ntohs(ldp_hdr->msg_type));
-        SYSTEM_INCR_INVALID_PEER_MSG_COUNTER(system_get_instance());
-        goto recv_err;
+        csm->recv_len -= pos;
+        memmove(csm->recv_buf, &csm->recv_buf[pos], csm->recv_len);
     }
-    total_data_len = data_len;
-    pos = 0;
 
-    while (data_len > 0)
+    return 0;
+}
+
+/* Receive packets call back function
+ * Reads whatever the socket has without blocking and queues every complete
+ * message; a partial message is kept in csm->recv_buf until the next EPOLLIN.
+ */
+int scheduler_csm_read_callback(struct CSM* csm)
+{
+    ssize_t len;
+    int num_recv = 0;
+
+    if (csm->sock_fd <= 0)
+        return MCLAG_ERROR;
+
+    while (num_recv < RECV_BATCH_MAX)
     {
-        /* When consecutive CCP session flaps happen, recv() call got stuck.
-         * Change recv() to non-blocking with retry mechanism. If max
-         * retry reaches, attempt one more retry after waiting for one KA
-         * interval before bringing down the session.
-         */
-        recv_len = recv(csm->sock_fd, &data[pos], data_len, MSG_DONTWAIT);
-        if (recv_len == -1)
+        len = recv(csm->sock_fd, &csm->recv_buf[csm->recv_len],
+                   CSM_RECV_BUFFER_SIZE - csm->recv_len, MSG_DONTWAIT);
+        if (len == -1)
         {
+            if (errno == EINTR)
+                continue;
+
             if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+                break;
+
+            ICCPD_LOG_WARN("ICCP_FSM", "Peer disconnect for read error[%s], pending len %zu",
+                           strerror(errno), csm->recv_len);
+            if (csm->recv_len < sizeof(LDPHdr))
             {
-                ICCPD_LOG_NOTICE(
-                    "ICCP_FSM", "Non-blocking recv total/pending len %d/%d, errno %d, num_retry %d",
-                    total_data_len, data_len, errno, num_retry);
-                ++num_retry;
-                if (num_retry > RECV_RETRY_MAX)
-                {
-                    ICCPD_LOG_ERR(
-                        "ICCP_FSM", "Non-blocking recv() retry failed, total/pending len %d/%d",
-                        total_data_len, data_len);
-                    SYSTEM_INCR_RX_RETRY_FAIL_COUNTER(system_get_instance());
-                    goto recv_err;
-                }
-                else
-                {
-                    if (num_retry == RECV_RETRY_MAX)
-                        usleep((csm->session_timeout * 1000000) - total_retry_time);
-                    else
-                    {
-                        total_retry_time += (num_retry * RECV_RETRY_INTERVAL_USEC);
-                        usleep(num_retry * RECV_RETRY_INTERVAL_USEC);
-                    }
-                    recv_len = 0;
-                }
+                SYSTEM_INCR_HDR_READ_SOCK_ERR_COUNTER(system_get_instance());
             }
             else
             {
-                perror("continue recv() Error");
-                ICCPD_LOG_WARN("ICCP_FSM", "Peer data read error; recv_len:%d data_len:%d, errno %d",
-                               recv_len, data_len, errno);
                 SYSTEM_INCR_TLV_READ_SOCK_ERR_COUNTER(system_get_instance());
-                goto recv_err;
             }
+            goto recv_err;
         }
-        else if (recv_len == 0)
+        else if (len == 0)
         {
-            ICCPD_LOG_WARN("ICCP_FSM", "Peer disconnect for data read error; recv_len:%d data_len:%d ", recv_len, data_len);
-            SYSTEM_INCR_TLV_READ_SOCK_ZERO_LEN_COUNTER(system_get_instance());
+            ICCPD_LOG_WARN("ICCP_FSM", "Peer disconnect for read len = 0, pending len %zu",
+                           csm->recv_len);
+            if (csm->recv_len < sizeof(LDPHdr))
+            {
+                SYSTEM_INCR_HDR_READ_SOCK_ZERO_LEN_COUNTER(system_get_instance());
+            }
+            else
+            {
+                SYSTEM_INCR_TLV_READ_SOCK_ZERO_LEN_COUNTER(system_get_instance());
+            }
             goto recv_err;
         }
-        data_len -= recv_len;
-        pos += recv_len;
-        /*usleep(100);*/
-    }
-    if (num_retry > 0)
-    {
-        SYSTEM_SET_RETRY_COUNTER(system_get_instance(), num_retry);
-    }
-    retval = iccp_csm_init_msg(&msg, peer_msg, ntohs(ldp_hdr->msg_len) + MSG_L_INCLUD_U_BIT_MSG_T_L_FIELDS);
-    if (retval == 0)
-    {
-        iccp_csm_enqueue_msg(csm, msg);
-        ++csm->icc_msg_in_count;
+
+        ++num_recv;
+        csm->recv_len += len;
+        if (scheduler_csm_parse_recv_buf(csm) != 0)
+            goto recv_err;
     }
-    else
-        ++csm->i_msg_in_count;
 
     return 1;
 
@@ -477,6 +453,8 @@ void scheduler_loop()
         iccp_handle_events(sys);
         /*csm, app state machine transit */
         scheduler_transit_fsm();
+        /*send out FDB entries batched in this round*/
+        iccp_syncd_tx_flush(sys);
 
         if (sys->warmboot_exit == WARM_REBOOT)
         {
@@ -529,8 +507,16 @@ int mlacp_sync_with_kernel_callback()
 /* Scheduler start while loop */
 void scheduler_start()
 {
+    struct System* sys = NULL;
+
+    if ((sys = system_get_instance()) == NULL)
+        return;
+
     /*mlacp_sync_with_kernel_callback();*/
 
+    /*kernel netlink, ARP and ND sockets are read on their own thread*/
+    iccp_kernel_worker_start(sys);
+
     scheduler_loop();
 
     return;
@@ -892,5 +878,6 @@ void scheduler_csm_socket_cleanup(struct CSM* csm, int location)
                          csm->sock_fd, location);
     }
     csm->sock_fd = -1;
+    csm->recv_len = 0;
 }
 
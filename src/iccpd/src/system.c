@@ -66,6 +66,10 @@ void system_init(struct System* sys)
     sys->arp_receive_fd = -1;
     sys->ndisc_receive_fd = -1;
     sys->epoll_fd = -1;
+    sys->kernel_worker_epoll_fd = -1;
+    sys->kernel_worker_stop_fd = -1;
+    sys->kernel_worker_resume_fd = -1;
+    sys->kernel_event_fd = -1;
     sys->family = -1;
     sys->warmboot_start = 0;
     sys->warmboot_exit = 0;
@@ -74,6 +78,11 @@ void system_init(struct System* sys)
     LIST_INIT(&(sys->lif_purge_list));
     LIST_INIT(&(sys->unq_ip_if_list));
     LIST_INIT(&(sys->pending_vlan_mbr_if_list));
+    local_if_hash_init(sys);
+
+    mem_pool_init(&(sys->mem_pools[MEM_POOL_MSG]), "Msg", sizeof(struct Msg));
+    mem_pool_init(&(sys->mem_pools[MEM_POOL_MSG_BUF]), "MsgBuf", MEM_POOL_MSG_BUF_SIZE);
+    mem_pool_init(&(sys->mem_pools[MEM_POOL_MAC_MSG]), "MACMsg", sizeof(struct MACMsg));
 
     sys->log_file_path = strdup("/var/log/iccpd.log");
     sys->cmd_file_path = strdup("/var/run/iccpd/iccpd.vty");
@@ -88,6 +97,7 @@ void system_init(struct System* sys)
     sys->need_sync_netlink_again = 0;
     scheduler_server_sock_init();
     iccp_system_init_netlink_socket();
+    iccp_kernel_worker_init(sys);
     iccp_init_netlink_event_fd(sys);
 }
 
@@ -98,6 +108,7 @@ void system_finalize()
     struct CSM* csm = NULL;
     struct LocalInterface* local_if = NULL;
     struct Unq_ip_If_info* unq_ip_if = NULL;
+    int i;
 
     if ((sys = system_get_instance()) == NULL )
         return;
@@ -122,6 +133,7 @@ void system_finalize()
         LIST_REMOVE(local_if, system_next);
         local_if_finalize(local_if);
     }
+    local_if_hash_init(sys);
 
     while (!LIST_EMPTY(&(sys->lif_purge_list)))
     {
@@ -140,6 +152,10 @@ void system_finalize()
         free(unq_ip_if);
     }
 
+    for (i = 0; i < MEM_POOL_MAX; ++i)
+        mem_pool_finalize(&(sys->mem_pools[i]));
+
+    iccp_kernel_worker_stop(sys);
     iccp_system_dinit_netlink_socket();
 
     if (sys->log_file_path != NULL )
@@ -164,6 +180,8 @@ void system_finalize()
         close(sys->sig_pipe_r);
     if (sys->sig_pipe_w > 0)
         close(sys->sig_pipe_w);
+    if (sys->kernel_event_fd >= 0)
+        close(sys->kernel_event_fd);
 
     if (sys->epoll_fd)
         close(sys->epoll_fd);
@@ -0,0 +1,282 @@
+/*
+ * iccp_stubs.c
+ *
+ * Stand-ins for the iccpd functions the unit checks do not link in.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * The full GNU General Public License is included in this distribution in
+ * the file called "COPYING".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/system.h"
+#include "../include/port.h"
+#include "../include/iccp_csm.h"
+#include "../include/iccp_consistency_check.h"
+#include "../include/iccp_ifm.h"
+#include "../include/iccp_netlink.h"
+#include "../include/mlacp_fsm.h"
+#include "../include/mlacp_link_handler.h"
+#include "../include/scheduler.h"
+#include "iccp_stubs.h"
+
+static struct System stub_sys;
+
+/*****************************************
+* Test system
+*
+* ***************************************/
+struct System* stub_system_init(void)
+{
+    memset(&stub_sys, 0, sizeof(stub_sys));
+    LIST_INIT(&(stub_sys.csm_list));
+    LIST_INIT(&(stub_sys.lif_list));
+    LIST_INIT(&(stub_sys.lif_purge_list));
+    LIST_INIT(&(stub_sys.unq_ip_if_list));
+    LIST_INIT(&(stub_sys.pending_vlan_mbr_if_list));
+    local_if_hash_init(&stub_sys);
+
+    return &stub_sys;
+}
+
+void stub_system_finalize(void)
+{
+    struct LocalInterface* local_if = NULL;
+
+    while (!LIST_EMPTY(&(stub_sys.lif_list)))
+    {
+        local_if = LIST_FIRST(&(stub_sys.lif_list));
+        LIST_REMOVE(local_if, system_next);
+        local_if_finalize(local_if);
+    }
+    local_if_hash_init(&stub_sys);
+
+    while (!LIST_EMPTY(&(stub_sys.lif_purge_list)))
+    {
+        local_if = LIST_FIRST(&(stub_sys.lif_purge_list));
+        LIST_REMOVE(local_if, system_purge_next);
+        local_if_finalize(local_if);
+    }
+
+    return;
+}
+
+struct System* system_get_instance()
+{
+    return &stub_sys;
+}
+
+struct CSM* system_get_csm_by_peer_ifname(char *ifname)
+{
+    return NULL;
+}
+
+/*****************************************
+* Peers of port.c
+*
+* ***************************************/
+int is_unique_ip_configured(char *ifname)
+{
+    return 0;
+}
+
+void set_peerlink_learn_kernel(struct CSM* csm, int enable, int dir)
+{
+    return;
+}
+
+int mlacp_bind_port_channel_to_csm(struct CSM* csm, const char *ifname)
+{
+    return 0;
+}
+
+int mlacp_unbind_local_if(struct LocalInterface* local_if)
+{
+    return 0;
+}
+
+void move_pending_vlan_mbr_to_lif(struct System *sys, struct LocalInterface* lif)
+{
+    return;
+}
+
+void scheduler_session_disconnect_handler(struct CSM* csm)
+{
+    return;
+}
+
+void update_vlan_if_mac_on_standby(struct LocalInterface* lif_vlan, int dir)
+{
+    return;
+}
+
+/*****************************************
+* Peers of mlacp_sync_update.c
+*
+* ***************************************/
+static int MACMsg_compare(const struct MACMsg *mac1, const struct MACMsg *mac2)
+{
+    if (mac1->vid != mac2->vid)
+        return (mac1->vid < mac2->vid) ? -1 : 1;
+
+    return memcmp(mac1->mac_addr, mac2->mac_addr, ETHER_ADDR_LEN);
+}
+
+RB_GENERATE(mac_rb_tree, MACMsg, mac_entry_rb, MACMsg_compare);
+
+/* Plain heap messages, the pools are checked on their own */
+int iccp_csm_init_msg(struct Msg** msg, char* data, int len)
+{
+    struct Msg* iccp_msg = NULL;
+
+    if (msg == NULL || data == NULL || len <= 0)
+        return MCLAG_ERROR;
+
+    if (!(iccp_msg = (struct Msg*)calloc(1, sizeof(struct Msg))))
+        return MCLAG_ERROR;
+
+    if (len <= MSG_INLINE_BUF_SIZE)
+    {
+        iccp_msg->buf = iccp_msg->inline_buf;
+        iccp_msg->buf_type = MSG_BUF_INLINE;
+    }
+    else if (!(iccp_msg->buf = (char*)malloc(len)))
+    {
+        free(iccp_msg);
+        return MCLAG_ERROR;
+    }
+    else
+    {
+        iccp_msg->buf_type = MSG_BUF_HEAP;
+    }
+
+    memcpy(iccp_msg->buf, data, len);
+    iccp_msg->len = len;
+    *msg = iccp_msg;
+
+    return 0;
+}
+
+void iccp_csm_free_msg(struct Msg* msg)
+{
+    if (msg == NULL)
+        return;
+
+    if (msg->buf_type == MSG_BUF_HEAP)
+        free(msg->buf);
+    free(msg);
+}
+
+int iccp_csm_init_mac_msg(struct MACMsg **mac_msg, char* data, int len)
+{
+    return MCLAG_ERROR;
+}
+
+void iccp_csm_free_mac_msg(struct MACMsg *mac_msg)
+{
+    free(mac_msg);
+}
+
+void add_mac_to_chip(struct MACMsg* mac_msg, uint8_t mac_type)
+{
+    return;
+}
+
+void del_mac_from_chip(struct MACMsg* mac_msg)
+{
+    return;
+}
+
+uint8_t set_mac_local_age_flag(struct CSM *csm, struct MACMsg* mac_msg, uint8_t set, uint8_t update_peer)
+{
+    return 0;
+}
+
+void mlacp_convert_remote_mac_to_local(struct CSM *csm, char *po_name)
+{
+    return;
+}
+
+enum Reason_ID iccp_consistency_check(char* ifname)
+{
+    return REASON_NONE;
+}
+
+int iccp_netlink_neighbor_request(int family, uint8_t *addr, int add, uint8_t *mac, char *portname, int permanent, int dir)
+{
+    return 0;
+}
+
+int mlacp_link_set_iccp_system_id(int mlag_id, uint8_t *system_id)
+{
+    return 0;
+}
+
+int mlacp_link_set_remote_if_state(int mlag_id, char *po_name, bool is_oper_up)
+{
+    return 0;
+}
+
+int mlacp_link_del_remote_if_info(int mlag_id, char *po_name)
+{
+    return 0;
+}
+
+void mlacp_peer_mlag_intf_delete_handler(struct CSM* csm, char *mlag_if_name)
+{
+    return;
+}
+
+char* mlacp_state(struct CSM* csm)
+{
+    return "STUB";
+}
+
+int syn_ack_local_neigh_mac_info_to_peer(char *ifname, int is_ipv6_ll)
+{
+    return 0;
+}
+
+void update_peerlink_isolate_from_pif(struct CSM *csm, struct PeerInterface *pif, int po_state, int new_create)
+{
+    return;
+}
+
+void update_stp_peer_link(struct CSM *csm, struct PeerInterface *peer_if, int po_state, int new_create)
+{
+    return;
+}
+
+void update_if_ipmac_on_standby(struct LocalInterface* lif_po, int dir)
+{
+    return;
+}
+
+char *show_ip_str(uint32_t ipv4_addr)
+{
+    return "";
+}
+
+char *show_ipv6_str(char *ipv6_addr)
+{
+    return "";
+}
+
+char *mac_addr_to_str(uint8_t mac_addr[ETHER_ADDR_LEN])
+{
+    return "";
+}
@@ -0,0 +1,110 @@
+/*
+ * mem_pool_check.c
+ *
+ * Checks the slab pools of iccp_mem_pool.c: objects are distinct and
+ * reused, the counters follow alloc and free, and slabs are released
+ * down to one spare once the pool drains.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * The full GNU General Public License is included in this distribution in
+ * the file called "COPYING".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/logger.h"
+#include "../include/iccp_mem_pool.h"
+#include "iccp_stubs.h"
+
+#define POOL_OBJ_NUM        100000
+#define POOL_ROUND_NUM      3
+#define POOL_OBJ_SIZE       72
+
+static void* objs[POOL_OBJ_NUM];
+
+static int pool_round(struct MemPool* pool, int round)
+{
+    mem_pool_dbg_counter_info_t counters;
+    struct timespec start;
+    uint32_t slab_count;
+    int i;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < POOL_OBJ_NUM; i++)
+    {
+        CHECK((objs[i] = mem_pool_alloc(pool)) != NULL);
+        memset(objs[i], i & 0xff, POOL_OBJ_SIZE);
+    }
+    printf("round %d: %d allocs %.2f ms", round, POOL_OBJ_NUM, elapsed_ms(&start));
+
+    /* Objects must not overlap */
+    for (i = 0; i < POOL_OBJ_NUM; i++)
+        CHECK(((unsigned char*)objs[i])[0] == (i & 0xff)
+              && ((unsigned char*)objs[i])[POOL_OBJ_SIZE - 1] == (i & 0xff));
+
+    mem_pool_get_dbg_counters(pool, &counters);
+    CHECK(counters.in_use == POOL_OBJ_NUM);
+    CHECK(counters.high_water == POOL_OBJ_NUM);
+    CHECK(counters.capacity >= POOL_OBJ_NUM);
+    CHECK(counters.alloc_fail == 0);
+    slab_count = counters.slab_count;
+
+    /* Freed holes are refilled without new slabs */
+    for (i = 0; i < POOL_OBJ_NUM; i += 2)
+        mem_pool_free(objs[i]);
+    for (i = 0; i < POOL_OBJ_NUM; i += 2)
+        CHECK((objs[i] = mem_pool_alloc(pool)) != NULL);
+    mem_pool_get_dbg_counters(pool, &counters);
+    CHECK(counters.slab_count == slab_count);
+    CHECK(counters.in_use == POOL_OBJ_NUM);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < POOL_OBJ_NUM; i++)
+        mem_pool_free(objs[(i * 7919) % POOL_OBJ_NUM]);
+    printf(", frees %.2f ms\n", elapsed_ms(&start));
+
+    mem_pool_get_dbg_counters(pool, &counters);
+    CHECK(counters.in_use == 0);
+    CHECK(counters.slab_count == 1);
+
+    return 0;
+}
+
+int main(void)
+{
+    struct MemPool pool;
+    void* obj = NULL;
+    int round;
+
+    logger_set_configuration(ERR_LOG_LEVEL);
+    mem_pool_init(&pool, "check", POOL_OBJ_SIZE);
+
+    for (round = 0; round < POOL_ROUND_NUM; round++)
+    {
+        if (pool_round(&pool, round) != 0)
+            return 1;
+    }
+
+    /* The spare slab serves the next allocation */
+    CHECK((obj = mem_pool_alloc(&pool)) != NULL);
+    CHECK(pool.slab_count == 1);
+    mem_pool_free(obj);
+
+    mem_pool_finalize(&pool);
+    CHECK(pool.slab_count == 0);
+
+    return 0;
+}
@@ -0,0 +1,225 @@
+/*
+ * neigh_index_check.c
+ *
+ * Checks that the RB tree indexes of the ARP and ND lists of mlacp_sync_update.c
+ * stay in step with the lists, and that the lists keep insertion order.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * The full GNU General Public License is included in this distribution in
+ * the file called "COPYING".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "../include/logger.h"
+#include "../include/iccp_csm.h"
+#include "../include/mlacp_tlv.h"
+#include "../include/mlacp_sync_update.h"
+#include "iccp_stubs.h"
+
+#define NEIGH_ARP_NUM       50000
+#define NEIGH_ND_NUM        10000
+#define NEIGH_LOOKUP_NUM    100000
+
+/* Distinct and unordered, 2654435761 is odd so i -> addr is a bijection */
+#define NEIGH_ARP_ADDR(i)   ((uint32_t)((i) * 2654435761u))
+
+static void neigh_nd_addr(int i, uint32_t* addr)
+{
+    addr[0] = htonl(0xfc000000);
+    addr[1] = 0;
+    addr[2] = NEIGH_ARP_ADDR(i);
+    addr[3] = (uint32_t)i;
+}
+
+static int arp_enqueue(struct CSM* csm, int i, uint8_t op_type)
+{
+    struct ARPMsg arp;
+    struct Msg* msg = NULL;
+
+    memset(&arp, 0, sizeof(arp));
+    arp.op_type = op_type;
+    arp.ipv4_addr = NEIGH_ARP_ADDR(i);
+    snprintf(arp.ifname, MAX_L_PORT_NAME, "Vlan%d", i % 4094 + 1);
+    CHECK(iccp_csm_init_msg(&msg, (char*)&arp, sizeof(arp)) == 0);
+    mlacp_enqueue_arp(csm, msg);
+
+    return 0;
+}
+
+static int check_arp(struct CSM* csm)
+{
+    struct Msg* msg = NULL;
+    struct Msg* next = NULL;
+    struct timespec start;
+    int i, count;
+
+    for (i = 0; i < NEIGH_ARP_NUM; i++)
+        CHECK(arp_enqueue(csm, i, NEIGH_SYNC_ADD) == 0);
+    /* A second entry for an address and a delete are never queued */
+    CHECK(arp_enqueue(csm, 7, NEIGH_SYNC_ADD) == 0);
+    CHECK(arp_enqueue(csm, NEIGH_ARP_NUM, NEIGH_SYNC_DEL) == 0);
+    CHECK(mlacp_find_arp(csm, NEIGH_ARP_ADDR(NEIGH_ARP_NUM)) == NULL);
+
+    i = 0;
+    TAILQ_FOREACH(msg, &(MLACP(csm).arp_list), tail)
+    {
+        CHECK(((struct ARPMsg*)msg->buf)->ipv4_addr == NEIGH_ARP_ADDR(i));
+        i++;
+    }
+    CHECK(i == NEIGH_ARP_NUM);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < NEIGH_LOOKUP_NUM; i++)
+    {
+        msg = mlacp_find_arp(csm, NEIGH_ARP_ADDR(i % NEIGH_ARP_NUM));
+        CHECK(msg != NULL && ((struct ARPMsg*)msg->buf)->ipv4_addr == NEIGH_ARP_ADDR(i % NEIGH_ARP_NUM));
+    }
+    printf("%d ARP lookups against %d entries: %.2f ms\n",
+           NEIGH_LOOKUP_NUM, NEIGH_ARP_NUM, elapsed_ms(&start));
+
+    /* Delete every other entry */
+    i = 0;
+    for (msg = TAILQ_FIRST(&(MLACP(csm).arp_list)); msg != NULL; msg = next)
+    {
+        next = TAILQ_NEXT(msg, tail);
+        if (i++ % 2 == 0)
+        {
+            mlacp_dequeue_arp(csm, msg);
+            iccp_csm_free_msg(msg);
+        }
+    }
+
+    for (i = 0; i < NEIGH_ARP_NUM; i++)
+    {
+        msg = mlacp_find_arp(csm, NEIGH_ARP_ADDR(i));
+        CHECK((i % 2 == 0) == (msg == NULL));
+    }
+
+    i = 1;
+    count = 0;
+    TAILQ_FOREACH(msg, &(MLACP(csm).arp_list), tail)
+    {
+        CHECK(((struct ARPMsg*)msg->buf)->ipv4_addr == NEIGH_ARP_ADDR(i));
+        i += 2;
+        count++;
+    }
+    CHECK(count == NEIGH_ARP_NUM / 2);
+
+    count = 0;
+    RB_FOREACH(msg, arp_rb_tree, &MLACP(csm).arp_rb)
+        count++;
+    CHECK(count == NEIGH_ARP_NUM / 2);
+
+    return 0;
+}
+
+static int check_ndisc(struct CSM* csm)
+{
+    struct NDISCMsg ndisc;
+    struct Msg* msg = NULL;
+    struct Msg* next = NULL;
+    uint32_t addr[4];
+    int i, count;
+
+    for (i = 0; i < NEIGH_ND_NUM; i++)
+    {
+        memset(&ndisc, 0, sizeof(ndisc));
+        ndisc.op_type = NEIGH_SYNC_ADD;
+        neigh_nd_addr(i, ndisc.ipv6_addr);
+        CHECK(iccp_csm_init_msg(&msg, (char*)&ndisc, sizeof(ndisc)) == 0);
+        mlacp_enqueue_ndisc(csm, msg);
+    }
+
+    i = 0;
+    TAILQ_FOREACH(msg, &(MLACP(csm).ndisc_list), tail)
+    {
+        neigh_nd_addr(i++, addr);
+        CHECK(memcmp(((struct NDISCMsg*)msg->buf)->ipv6_addr, addr, sizeof(addr)) == 0);
+        CHECK(mlacp_find_ndisc(csm, addr) == msg);
+    }
+    CHECK(i == NEIGH_ND_NUM);
+
+    i = 0;
+    for (msg = TAILQ_FIRST(&(MLACP(csm).ndisc_list)); msg != NULL; msg = next)
+    {
+        next = TAILQ_NEXT(msg, tail);
+        if (i++ % 2 == 0)
+        {
+            mlacp_dequeue_ndisc(csm, msg);
+            iccp_csm_free_msg(msg);
+        }
+    }
+
+    count = 0;
+    for (i = 0; i < NEIGH_ND_NUM; i++)
+    {
+        neigh_nd_addr(i, addr);
+        msg = mlacp_find_ndisc(csm, addr);
+        CHECK((i % 2 == 0) == (msg == NULL));
+        if (msg)
+            count++;
+    }
+    CHECK(count == NEIGH_ND_NUM / 2);
+
+    return 0;
+}
+
+static void neigh_list_free(struct CSM* csm)
+{
+    struct Msg* msg = NULL;
+
+    while (!TAILQ_EMPTY(&(MLACP(csm).arp_list)))
+    {
+        msg = TAILQ_FIRST(&(MLACP(csm).arp_list));
+        mlacp_dequeue_arp(csm, msg);
+        iccp_csm_free_msg(msg);
+    }
+
+    while (!TAILQ_EMPTY(&(MLACP(csm).ndisc_list)))
+    {
+        msg = TAILQ_FIRST(&(MLACP(csm).ndisc_list));
+        mlacp_dequeue_ndisc(csm, msg);
+        iccp_csm_free_msg(msg);
+    }
+
+    return;
+}
+
+int main(void)
+{
+    struct CSM* csm = NULL;
+    int rc;
+
+    logger_set_configuration(ERR_LOG_LEVEL);
+    stub_system_init();
+
+    CHECK((csm = (struct CSM*)calloc(1, sizeof(struct CSM))) != NULL);
+    TAILQ_INIT(&(MLACP(csm).arp_list));
+    TAILQ_INIT(&(MLACP(csm).ndisc_list));
+    RB_INIT(arp_rb_tree, &MLACP(csm).arp_rb);
+    RB_INIT(ndisc_rb_tree, &MLACP(csm).ndisc_rb);
+
+    rc = check_arp(csm) || check_ndisc(csm);
+
+    neigh_list_free(csm);
+    CHECK(RB_EMPTY(arp_rb_tree, &MLACP(csm).arp_rb));
+    CHECK(RB_EMPTY(ndisc_rb_tree, &MLACP(csm).ndisc_rb));
+    free(csm);
+
+    return rc;
+}
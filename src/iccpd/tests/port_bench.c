@@ -0,0 +1,169 @@
+/*
+ * port_bench.c
+ *
+ * Times the local interface lookups of port.c against a linear scan of
+ * lif_list, and checks that the hash indexes follow create, ifindex
+ * change and destroy.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * The full GNU General Public License is included in this distribution in
+ * the file called "COPYING".
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../include/logger.h"
+#include "../include/system.h"
+#include "../include/port.h"
+#include "iccp_stubs.h"
+
+#define BENCH_IF_NUM        4096
+#define BENCH_LOOKUP_NUM    100000
+#define BENCH_IFINDEX_BASE  1000
+
+static char if_names[BENCH_IF_NUM][MAX_L_PORT_NAME];
+
+/* Even slots are ports, odd slots are port channels with po_id = slot */
+static int bench_create(void)
+{
+    struct LocalInterface* lif = NULL;
+    int i;
+
+    for (i = 0; i < BENCH_IF_NUM; i++)
+    {
+        if (i % 2 == 0)
+        {
+            snprintf(if_names[i], MAX_L_PORT_NAME, "Ethernet%d", i);
+            lif = local_if_create(BENCH_IFINDEX_BASE + i, if_names[i], IF_T_PORT, PORT_STATE_UP);
+        }
+        else
+        {
+            snprintf(if_names[i], MAX_L_PORT_NAME, "PortChannel%d", i);
+            lif = local_if_create(BENCH_IFINDEX_BASE + i, if_names[i], IF_T_PORT_CHANNEL, PORT_STATE_UP);
+        }
+        CHECK(lif != NULL);
+    }
+
+    return 0;
+}
+
+static struct LocalInterface* linear_find_by_name(struct System* sys, const char* ifname)
+{
+    struct LocalInterface* lif = NULL;
+
+    LIST_FOREACH(lif, &(sys->lif_list), system_next)
+    {
+        if (strcmp(lif->name, ifname) == 0)
+            return lif;
+    }
+
+    return NULL;
+}
+
+static int bench_lookup(struct System* sys)
+{
+    struct LocalInterface* lif = NULL;
+    struct timespec start;
+    int i, slot;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < BENCH_LOOKUP_NUM; i++)
+    {
+        slot = (i * 7919) % BENCH_IF_NUM;
+        lif = local_if_find_by_name(if_names[slot]);
+        CHECK(lif != NULL && lif->ifindex == BENCH_IFINDEX_BASE + slot);
+    }
+    printf("by name:     %8.2f ms\n", elapsed_ms(&start));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < BENCH_LOOKUP_NUM; i++)
+    {
+        slot = (i * 7919) % BENCH_IF_NUM;
+        lif = local_if_find_by_ifindex(BENCH_IFINDEX_BASE + slot);
+        CHECK(lif != NULL && strcmp(lif->name, if_names[slot]) == 0);
+    }
+    printf("by ifindex:  %8.2f ms\n", elapsed_ms(&start));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < BENCH_LOOKUP_NUM; i++)
+    {
+        slot = ((i * 7919) % BENCH_IF_NUM) | 1;
+        lif = local_if_find_by_po_id(slot);
+        CHECK(lif != NULL && lif->type == IF_T_PORT_CHANNEL && lif->po_id == slot);
+    }
+    printf("by po_id:    %8.2f ms\n", elapsed_ms(&start));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < BENCH_LOOKUP_NUM; i++)
+    {
+        slot = (i * 7919) % BENCH_IF_NUM;
+        lif = linear_find_by_name(sys, if_names[slot]);
+        CHECK(lif != NULL && lif->ifindex == BENCH_IFINDEX_BASE + slot);
+    }
+    printf("linear scan: %8.2f ms\n", elapsed_ms(&start));
+
+    return 0;
+}
+
+/* The indexes must follow an ifindex change and a destroy */
+static int check_update(void)
+{
+    struct LocalInterface* lif = NULL;
+    int i;
+
+    lif = local_if_find_by_name(if_names[0]);
+    CHECK(lif != NULL);
+    local_if_set_ifindex(lif, BENCH_IFINDEX_BASE + BENCH_IF_NUM);
+    CHECK(local_if_find_by_ifindex(BENCH_IFINDEX_BASE) == NULL);
+    CHECK(local_if_find_by_ifindex(BENCH_IFINDEX_BASE + BENCH_IF_NUM) == lif);
+
+    for (i = 0; i < BENCH_IF_NUM; i += 4)
+        local_if_destroy(if_names[i]);
+    for (i = 1; i < BENCH_IF_NUM; i += 4)
+        local_if_destroy(if_names[i]);
+
+    for (i = 0; i < BENCH_IF_NUM; i++)
+    {
+        lif = local_if_find_by_name(if_names[i]);
+        if (i % 4 < 2)
+        {
+            CHECK(lif == NULL);
+            CHECK(i % 2 == 0 || local_if_find_by_po_id(i) == NULL);
+        }
+        else
+        {
+            CHECK(lif != NULL && local_if_find_by_ifindex(lif->ifindex) == lif);
+            CHECK(i % 2 == 0 || local_if_find_by_po_id(i) == lif);
+        }
+    }
+
+    return 0;
+}
+
+int main(void)
+{
+    struct System* sys = NULL;
+
+    logger_set_configuration(ERR_LOG_LEVEL);
+    sys = stub_system_init();
+
+    printf("%d lookups against %d interfaces\n", BENCH_LOOKUP_NUM, BENCH_IF_NUM);
+    if (bench_create() != 0 || bench_lookup(sys) != 0 || check_update() != 0)
+        return 1;
+
+    stub_system_finalize();
+
+    return 0;
+}
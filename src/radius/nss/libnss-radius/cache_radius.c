@@ -159,6 +159,15 @@ int main(int ac, char * av[]) {
 
     }
 
+    /* Rebuild the shared cache readers map, for the updated MPL or config.
+     */
+
+    if (refresh_user || !radius_mpl_cache_current(conf->prog)) {
+
+        radius_write_mpl_cache(conf->prog);
+
+    }
+
     if (conf->many_to_one) {
 
         rnm = &((conf->rnm)[mpl-1]);
@@ -31,7 +31,11 @@ enum nss_status _nss_radius_getpwnam_r( const char * nam, struct passwd * pwd,
     if (!nam || !strcmp(nam, "*") || !pwd || !buf || (buflen == 0))
         return NSS_STATUS_NOTFOUND;
 
-    parse_nss_config(conf, prog, file_buf, sizeof(file_buf), errnop, &ncfd);
+      /* The config parsed by cache_radius, or the config file if absent.
+       */
+    if (radius_cached_nss_config(conf, prog, file_buf, sizeof(file_buf)) != 0)
+        parse_nss_config(conf, prog, file_buf, sizeof(file_buf), errnop,
+            &ncfd);
 
     if (radius_lookup_cache(prog, nam, &mpl) == 0) {
 
@@ -45,12 +49,13 @@ enum nss_status _nss_radius_getpwnam_r( const char * nam, struct passwd * pwd,
         if (conf->many_to_one) {
             radius_getpwnam_r(prog, rnm->gecos, &pw, buffer, sizeof(buffer),
                 &res);
-        } else if (conf->allow_anonymous) {
+        } else if (radius_lock_nss_config(conf, &ncfd) == 0) {
             radius_create_user(conf, nam, mpl, RADIUS_CONFIRMED);
             radius_getpwnam_r(prog, nam, &pw, buffer, sizeof(buffer), &res);
         }
 
-    } else if (conf->allow_anonymous && is_sshd_lookup(conf, nam)) {
+    } else if (conf->allow_anonymous && is_sshd_lookup(conf, nam)
+        && (radius_lock_nss_config(conf, &ncfd) == 0)) {
 
         /* Could be an sshd doing a getpwnam() before pam_authenticate().
          */
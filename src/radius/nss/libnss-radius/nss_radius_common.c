@@ -26,6 +26,10 @@ The term "Broadcom" refers to Broadcom Inc. and/or its subsidiaries.
 #include <regex.h>
 #include <time.h>
 #include <sys/wait.h>
+#include <sys/mman.h>
+#include <stddef.h>
+#include <dirent.h>
+#include <sched.h>
 
 #include "nss_radius_common.h"
 
@@ -286,17 +290,13 @@ static int user_mod(const char* name, char* sec_grp) {
     return status;
 }
 
-int parse_nss_config(RADIUS_NSS_CONF_B * conf, char * prog,
-    char * file_buf, int file_buf_sz, int * errnop, int * plockfd) {
+/* Parses the NSS config from file_buf, which is modified in place.
+ * Unset settings get their defaults.
+ */
+static void parse_nss_config_buf(RADIUS_NSS_CONF_B * conf, char * prog,
+    char * file_buf, int file_sz) {
 
-      /* Slurp the whole file.
-       */
-    int ncfd = -1;
-    int ret = 0;
     int i = 0, remain;
-    struct stat sb;
-    char errbuf[128];
-    int flags;
     char * scanpos, * line;
     int use_default_rnm = 1, bad_rnm = 0;
     int unconfirmed_disallow = 0;
@@ -307,42 +307,11 @@ int parse_nss_config(RADIUS_NSS_CONF_B * conf, char * prog,
     conf->unconfirmed_ageout = UNCONFIRMED_AGEOUT_DEFAULT;
     conf->unconfirmed_clear_limit = UNCONFIRMED_CLEAR_LIMIT_DEFAULT;
 
-      /* Read the file.
-       */
-    if (((ncfd = open(RADIUS_NSS_CONF, O_RDONLY)) == -1)
-        || (fstat(ncfd, &sb) == -1)
-        || (((flags = fcntl(ncfd, F_GETFL, 0)) == -1) && ((flags = 0) != 0))
-        || (fcntl(ncfd, F_SETFL, flags | O_NONBLOCK) == -1)) {
-
-        if (errnop)
-            *errnop = errno;
-        ret = 1;
-        errbuf[0] = 0; strerror_r(errno, errbuf, sizeof(errbuf));
-        syslog( LOG_WARNING, "%s: %s", prog, errbuf);
-        goto parse_nss_config_exit;
-    }
-
-      /* The maximum file size is 1 less than the buffer, to allow space for
-       * a NULL byte in the case where the last line has no \n, \r, \l char.
-       * (which could have been substituted with a NULL).
-       */
-    if (sb.st_size >= file_buf_sz) {
-        syslog( LOG_WARNING, "%s: size greater than %d. Ignoring",
-            prog, file_buf_sz - 1);
-        goto parse_nss_config_exit;
-    }
-
-    if ((i = read(ncfd, file_buf, file_buf_sz)) != sb.st_size) {
-        syslog( LOG_WARNING, "%s: read %d of %ld. Ignoring", prog,
-            i, sb.st_size);
-        goto parse_nss_config_exit;
-    }
-
       /* Parse each line from file.
        */
 
     scanpos = file_buf;
-    remain = sb.st_size;
+    remain = file_sz;
     while((line = parse_line(conf, file_buf, &scanpos, &remain)) != NULL) {
 
         if (strncmp(line, "debug=", 6) == 0) {
@@ -436,21 +405,89 @@ int parse_nss_config(RADIUS_NSS_CONF_B * conf, char * prog,
 
      }
 
+      /* Fix up rnm.
+       */
+
+    if (use_default_rnm || bad_rnm)
+        init_rnm(conf);
+
+    for ( i = 1; i < RADIUS_MAX_MPL; i++) {
+        if ((conf->rnm)[i].gecos == NULL) {
+            (conf->rnm)[i] = (conf->rnm)[i-1];
+        }
+    }
+}
+
+/* Takes the Unconfirmed lock on ncfd. Only the lock holder may create
+ * unconfirmed users.
+ */
+static void lock_nss_config(RADIUS_NSS_CONF_B * conf, int ncfd) {
+
+    if (flock(ncfd, LOCK_EX|LOCK_NB) == 0) {
+        if (conf->debug)
+            syslog( LOG_DEBUG, "%s: %d: Unconfirmed: lock success",
+                conf->prog, (int) getpid());
+    } else {
+        conf->allow_anonymous = 0;
+        if (conf->debug)
+            syslog( LOG_DEBUG, "%s: %d: Unconfirmed: locked out",
+                conf->prog, (int) getpid());
+    }
+}
+
+int parse_nss_config(RADIUS_NSS_CONF_B * conf, char * prog,
+    char * file_buf, int file_buf_sz, int * errnop, int * plockfd) {
+
+      /* Slurp the whole file.
+       */
+    int ncfd = -1;
+    int ret = 0;
+    int i = 0;
+    struct stat sb;
+    char errbuf[128];
+    int flags;
+    int file_sz = 0;
+
+      /* Read the file.
+       */
+    if (((ncfd = open(RADIUS_NSS_CONF, O_RDONLY)) == -1)
+        || (fstat(ncfd, &sb) == -1)
+        || (((flags = fcntl(ncfd, F_GETFL, 0)) == -1) && ((flags = 0) != 0))
+        || (fcntl(ncfd, F_SETFL, flags | O_NONBLOCK) == -1)) {
+
+        if (errnop)
+            *errnop = errno;
+        ret = 1;
+        errbuf[0] = 0; strerror_r(errno, errbuf, sizeof(errbuf));
+        syslog( LOG_WARNING, "%s: %s", prog, errbuf);
+        goto parse_nss_config_exit;
+    }
+
+      /* The maximum file size is 1 less than the buffer, to allow space for
+       * a NULL byte in the case where the last line has no \n, \r, \l char.
+       * (which could have been substituted with a NULL).
+       */
+    if (sb.st_size >= file_buf_sz) {
+        syslog( LOG_WARNING, "%s: size greater than %d. Ignoring",
+            prog, file_buf_sz - 1);
+        goto parse_nss_config_exit;
+    }
+
+    if ((i = read(ncfd, file_buf, file_buf_sz)) != sb.st_size) {
+        syslog( LOG_WARNING, "%s: read %d of %ld. Ignoring", prog,
+            i, sb.st_size);
+        goto parse_nss_config_exit;
+    }
+
+    file_sz = sb.st_size;
 
 parse_nss_config_exit:
 
+    parse_nss_config_buf(conf, prog, file_buf, file_sz);
+
     if (ncfd != -1) {
 
-        if (flock(ncfd, LOCK_EX|LOCK_NB) == 0) {
-            if (conf->debug)
-                syslog( LOG_DEBUG, "%s: %d: Unconfirmed: lock success",
-                    prog, (int) getpid());
-        } else {
-            conf->allow_anonymous = 0;
-            if (conf->debug)
-                syslog( LOG_DEBUG, "%s: %d: Unconfirmed: locked out",
-                    prog, (int) getpid());
-        }
+        lock_nss_config(conf, ncfd);
 
         if (plockfd) {
             *plockfd = ncfd;
@@ -459,20 +496,31 @@ parse_nss_config_exit:
         }
     }
 
+    return ret;
+}
 
-      /* Fix up rnm.
-       */
+/* Takes the Unconfirmed lock for a conf from radius_cached_nss_config(),
+ * which is parsed without it.
+ * Returns 0 if unconfirmed users may be created.
+ */
+int radius_lock_nss_config(RADIUS_NSS_CONF_B * conf, int * plockfd) {
 
-    if (use_default_rnm || bad_rnm)
-        init_rnm(conf);
+    if (!conf->allow_anonymous)
+        return 1;
 
-    for ( i = 1; i < RADIUS_MAX_MPL; i++) {
-        if ((conf->rnm)[i].gecos == NULL) {
-            (conf->rnm)[i] = (conf->rnm)[i-1];
-        }
+    if (*plockfd != -1)
+        return 0;
+
+    if ((*plockfd = open(RADIUS_NSS_CONF, O_RDONLY)) == -1) {
+        conf->allow_anonymous = 0;
+        syslog( LOG_WARNING, "%s: open(%s) failed: errno %d",
+            conf->prog, RADIUS_NSS_CONF, errno);
+        return 1;
     }
 
-    return ret;
+    lock_nss_config(conf, *plockfd);
+
+    return conf->allow_anonymous ? 0 : 1;
 }
 
 /* Releases any memory.
@@ -659,7 +707,8 @@ int radius_lookup_cache_cleanup( int status, int rafd) {
     return status;
 }
 
-int radius_lookup_cache( char * prog, const char * nam, int * pmpl) {
+static int radius_lookup_cache_file( char * prog, const char * nam,
+    int * pmpl) {
     int rafd = -1;
     int i;
     char cache_filename[PATH_MAX];
@@ -712,6 +761,380 @@ int radius_lookup_cache( char * prog, const char * nam, int * pmpl) {
     return radius_lookup_cache_cleanup(0, rafd);
 }
 
+/* Shared MPL cache mapping of this process.
+ */
+static RADIUS_MPL_CACHE * mpl_cache = NULL;
+static RADIUS_NSS_CONF_B mpl_cache_conf;
+static char mpl_cache_conf_buf[RADIUS_MAX_NSS_CONF_SZ];
+static int mpl_cache_conf_current = 0;
+static time_t mpl_cache_conf_checked = 0;
+static volatile int mpl_cache_lock = 0;
+
+static void radius_mpl_cache_lock(void) {
+    while (__sync_lock_test_and_set(&mpl_cache_lock, 1))
+        sched_yield();
+}
+
+static void radius_mpl_cache_unlock(void) {
+    __sync_lock_release(&mpl_cache_lock);
+}
+
+static uint32_t radius_mpl_cache_hash(const char * nam) {
+    uint32_t hash = 2166136261u;
+
+    for ( ; *nam; nam++) {
+        hash ^= (unsigned char) *nam;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static RADIUS_MPL_CACHE_ENTRY * radius_mpl_cache_slot(RADIUS_MPL_CACHE * cache,
+    const char * nam) {
+    uint32_t i, slot = radius_mpl_cache_hash(nam);
+
+    for (i = 0; i < RADIUS_MPL_CACHE_SLOTS; i++, slot++) {
+        RADIUS_MPL_CACHE_ENTRY * entry =
+            &(cache->entries[slot & (RADIUS_MPL_CACHE_SLOTS - 1)]);
+        if ((entry->mpl == 0) || (strcmp(entry->user, nam) == 0))
+            return entry;
+    }
+
+    return NULL;
+}
+
+/* Returns the mapped cache, mapping it again once cache_radius has replaced
+ * it. Must be called with mpl_cache_lock held.
+ */
+static RADIUS_MPL_CACHE * radius_map_mpl_cache(char * prog) {
+    RADIUS_MPL_CACHE * cache;
+    struct stat sb;
+    int fd;
+
+    if (mpl_cache && !mpl_cache->stale)
+        return mpl_cache;
+
+    if (mpl_cache) {
+        munmap(mpl_cache, sizeof(*mpl_cache));
+        mpl_cache = NULL;
+    }
+
+    if ((fd = open(RADIUS_MPL_CACHE_FILE, O_RDONLY | O_CLOEXEC)) == -1)
+        return NULL;
+
+    if ((fstat(fd, &sb) == -1)
+        || (sb.st_size != sizeof(*cache))
+#if !defined(TEST_RADIUS_NSS)
+        || (sb.st_uid != 0)
+#endif
+        || (sb.st_mode & (S_IWGRP | S_IWOTH))) {
+        syslog( LOG_WARNING, "%s: \"%s\": bad size or mode. Ignoring",
+            prog, RADIUS_MPL_CACHE_FILE);
+        close(fd);
+        return NULL;
+    }
+
+    cache = mmap(NULL, sizeof(*cache), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (cache == MAP_FAILED)
+        return NULL;
+
+    if (cache->stale) {
+        munmap(cache, sizeof(*cache));
+        return NULL;
+    }
+
+    if ((cache->magic != RADIUS_MPL_CACHE_MAGIC)
+        || (cache->version != RADIUS_MPL_CACHE_VERSION)
+        || (cache->conf_size < 0)
+        || (cache->conf_size >= RADIUS_MAX_NSS_CONF_SZ)) {
+        syslog( LOG_WARNING, "%s: \"%s\": bad version. Ignoring",
+            prog, RADIUS_MPL_CACHE_FILE);
+        munmap(cache, sizeof(*cache));
+        return NULL;
+    }
+
+      /* Parse the config copy once per mapping.
+       */
+    if (cache->conf_valid) {
+        memcpy(mpl_cache_conf_buf, cache->conf, cache->conf_size);
+        mpl_cache_conf_buf[cache->conf_size] = 0;
+        parse_nss_config_buf(&mpl_cache_conf, prog, mpl_cache_conf_buf,
+            cache->conf_size);
+    }
+    mpl_cache_conf_checked = 0;
+
+    mpl_cache = cache;
+    return mpl_cache;
+}
+
+/* Checks, at most every RADIUS_MPL_CACHE_REVALIDATE seconds, that the
+ * config copy in the cache still matches RADIUS_NSS_CONF.
+ * Must be called with mpl_cache_lock held.
+ */
+static int radius_mpl_cache_conf_is_current(RADIUS_MPL_CACHE * cache) {
+    struct stat sb;
+    time_t now = time(NULL);
+
+    if (!cache->conf_valid)
+        return 0;
+
+    if ((now - mpl_cache_conf_checked) < RADIUS_MPL_CACHE_REVALIDATE)
+        return mpl_cache_conf_current;
+
+    mpl_cache_conf_checked = now;
+    mpl_cache_conf_current = (stat(RADIUS_NSS_CONF, &sb) == 0)
+        && (sb.st_mtim.tv_sec == cache->conf_mtime_sec)
+        && (sb.st_mtim.tv_nsec == cache->conf_mtime_nsec)
+        && (sb.st_size == cache->conf_size);
+
+    return mpl_cache_conf_current;
+}
+
+static char * relocate_conf_ptr(char * p, char * to) {
+    if ((p >= mpl_cache_conf_buf)
+        && (p < (mpl_cache_conf_buf + sizeof(mpl_cache_conf_buf))))
+        return to + (p - mpl_cache_conf_buf);
+    return p;
+}
+
+/* Copies the NSS config parsed from the shared MPL cache into conf and
+ * file_buf, without reading RADIUS_NSS_CONF. The Unconfirmed lock is not
+ * taken, see radius_lock_nss_config().
+ * Returns 0 on success, or 1 if the caller must use parse_nss_config().
+ */
+int radius_cached_nss_config(RADIUS_NSS_CONF_B * conf, char * prog,
+    char * file_buf, int file_buf_sz) {
+
+    RADIUS_MPL_CACHE * cache;
+    int i;
+
+    if (file_buf_sz < sizeof(mpl_cache_conf_buf))
+        return 1;
+
+    radius_mpl_cache_lock();
+
+    if (((cache = radius_map_mpl_cache(prog)) == NULL)
+        || !radius_mpl_cache_conf_is_current(cache)) {
+        radius_mpl_cache_unlock();
+        return 1;
+    }
+
+    memcpy(file_buf, mpl_cache_conf_buf, sizeof(mpl_cache_conf_buf));
+    *conf = mpl_cache_conf;
+    conf->prog = prog;
+    conf->unconfirmed_regexp = relocate_conf_ptr(conf->unconfirmed_regexp,
+        file_buf);
+    for (i = 0; i < RADIUS_MAX_MPL; i++) {
+        (conf->rnm)[i].groups = relocate_conf_ptr((conf->rnm)[i].groups,
+            file_buf);
+        (conf->rnm)[i].gecos = relocate_conf_ptr((conf->rnm)[i].gecos,
+            file_buf);
+        (conf->rnm)[i].shell = relocate_conf_ptr((conf->rnm)[i].shell,
+            file_buf);
+    }
+
+    radius_mpl_cache_unlock();
+
+    return 0;
+}
+
+/* Returns 1 if the shared MPL cache exists and matches RADIUS_NSS_CONF.
+ */
+int radius_mpl_cache_current( char * prog) {
+    RADIUS_MPL_CACHE * cache;
+    int current;
+
+    radius_mpl_cache_lock();
+    mpl_cache_conf_checked = 0;
+    current = ((cache = radius_map_mpl_cache(prog)) != NULL)
+        && radius_mpl_cache_conf_is_current(cache);
+    radius_mpl_cache_unlock();
+
+    return current;
+}
+
+int radius_lookup_cache( char * prog, const char * nam, int * pmpl) {
+    RADIUS_MPL_CACHE * cache;
+    RADIUS_MPL_CACHE_ENTRY * entry = NULL;
+    int status = STATUS_ESRCH;
+
+    *pmpl = RADIUS_MIN_MPL;
+
+      /* A hash probe in the shared MPL cache, falling back to the user's
+       * cache file when the shared cache is absent or incomplete.
+       */
+    radius_mpl_cache_lock();
+
+    if ((cache = radius_map_mpl_cache(prog)) != NULL) {
+        if (strlen(nam) <= RADIUS_MAX_USER_LEN)
+            entry = radius_mpl_cache_slot(cache, nam);
+
+        if (entry && entry->mpl) {
+            *pmpl = entry->mpl;
+            status = 0;
+        } else if (cache->complete && (strlen(nam) <= RADIUS_MAX_USER_LEN)) {
+            status = STATUS_ENOENT;
+        }
+    }
+
+    radius_mpl_cache_unlock();
+
+    if (status != STATUS_ESRCH)
+        return status;
+
+    return radius_lookup_cache_file(prog, nam, pmpl);
+}
+
+/* Marks the current shared MPL cache stale, so readers stop using it.
+ */
+static void radius_mark_mpl_cache_stale( char * prog, int oldfd) {
+    uint32_t stale = 1;
+
+    if (pwrite(oldfd, &stale, sizeof(stale),
+            offsetof(RADIUS_MPL_CACHE, stale)) != sizeof(stale))
+        syslog( LOG_WARNING, "%s: \"%s\": stale mark fails. errno %d",
+            prog, RADIUS_MPL_CACHE_FILE, errno);
+    close(oldfd);
+}
+
+static int radius_write_mpl_cache_cleanup( int status, char * prog,
+    RADIUS_MPL_CACHE * cache, int lockfd, int fd, const char * tmp_filename) {
+    int oldfd;
+
+    if (fd != -1) {
+        close(fd);
+        unlink(tmp_filename);
+    }
+
+      /* A cache without the latest users must not be used.
+       */
+    if (status && ((oldfd = open(RADIUS_MPL_CACHE_FILE, O_WRONLY)) != -1)) {
+        unlink(RADIUS_MPL_CACHE_FILE);
+        radius_mark_mpl_cache_stale(prog, oldfd);
+    }
+
+    if (lockfd != -1)
+        close(lockfd); /* Releases the writer lock */
+    free(cache);
+    return status;
+}
+
+/* Rebuilds the shared MPL cache from RADIUS_NSS_CONF and the per-user
+ * cache files. The new cache replaces the old one atomically, and the old
+ * one is then marked stale so readers map the new one.
+ */
+int radius_write_mpl_cache( char * prog) {
+    RADIUS_MPL_CACHE * cache;
+    RADIUS_MPL_CACHE_ENTRY * entry;
+    char tmp_filename[PATH_MAX];
+    struct dirent * de;
+    struct stat sb;
+    DIR * dir;
+    int lockfd = -1, fd = -1, ncfd, oldfd;
+    int mpl;
+
+    snprintf(tmp_filename, sizeof(tmp_filename), "%s.%d",
+        RADIUS_MPL_CACHE_FILE, (int) getpid());
+
+    if ((cache = calloc(1, sizeof(*cache))) == NULL) {
+        syslog( LOG_ERR, "%s: \"%s\": calloc() fails.", prog,
+            RADIUS_MPL_CACHE_FILE);
+        return radius_write_mpl_cache_cleanup(STATUS_ENOENT, prog, cache,
+            lockfd, fd, tmp_filename);
+    }
+
+    cache->magic = RADIUS_MPL_CACHE_MAGIC;
+    cache->version = RADIUS_MPL_CACHE_VERSION;
+    cache->complete = 1;
+
+      /* Copy the config file.
+       */
+    if ((ncfd = open(RADIUS_NSS_CONF, O_RDONLY)) != -1) {
+        if ((fstat(ncfd, &sb) == 0)
+            && (sb.st_size < sizeof(cache->conf))
+            && (read(ncfd, cache->conf, sizeof(cache->conf)) == sb.st_size)) {
+            cache->conf_valid = 1;
+            cache->conf_mtime_sec = sb.st_mtim.tv_sec;
+            cache->conf_mtime_nsec = sb.st_mtim.tv_nsec;
+            cache->conf_size = sb.st_size;
+        }
+        close(ncfd);
+    }
+
+      /* Serialize writers, so the last cache written is never left stale.
+       */
+    if (((lockfd = open(RADIUS_ATTRIBUTE_CACHE_DIR, O_RDONLY)) == -1)
+        || (flock(lockfd, LOCK_EX) == -1)
+        || ((dir = opendir(RADIUS_ATTRIBUTE_CACHE_DIR)) == NULL)) {
+        syslog( LOG_ERR, "%s: \"%s\": open fails. errno %d", prog,
+            RADIUS_ATTRIBUTE_CACHE_DIR, errno);
+        return radius_write_mpl_cache_cleanup(STATUS_ENOENT, prog, cache,
+            lockfd, fd, tmp_filename);
+    }
+
+    while ((de = readdir(dir)) != NULL) {
+        if ((de->d_name[0] == '.')
+            || (radius_lookup_cache_file(prog, de->d_name, &mpl) != 0))
+            continue;
+
+        if ((strlen(de->d_name) > RADIUS_MAX_USER_LEN)
+            || (cache->num_users >= RADIUS_MPL_CACHE_MAX_USERS)
+            || ((entry = radius_mpl_cache_slot(cache, de->d_name)) == NULL)) {
+            cache->complete = 0;
+            continue;
+        }
+
+        if (entry->mpl == 0)
+            cache->num_users++;
+        strcpy(entry->user, de->d_name);
+        entry->mpl = mpl;
+    }
+    closedir(dir);
+
+    if (!cache->complete)
+        syslog( LOG_INFO, "%s: \"%s\": %u users cached, others looked up"
+            " from \"%s\"", prog, RADIUS_MPL_CACHE_FILE, cache->num_users,
+            RADIUS_ATTRIBUTE_CACHE_DIR);
+
+      /* Write and replace.
+       */
+    if (((fd = open(tmp_filename, O_WRONLY | O_CREAT | O_TRUNC, 0644)) == -1)
+        || (fchmod(fd, 0644) == -1)
+        || (write(fd, cache, sizeof(*cache)) != sizeof(*cache))
+        || (fsync(fd) == -1)) {
+        syslog( LOG_ERR, "%s: \"%s\": write fails. errno %d", prog,
+            tmp_filename, errno);
+        return radius_write_mpl_cache_cleanup(STATUS_EIO, prog, cache,
+            lockfd, fd, tmp_filename);
+    }
+
+    oldfd = open(RADIUS_MPL_CACHE_FILE, O_WRONLY);
+
+    if (rename(tmp_filename, RADIUS_MPL_CACHE_FILE) == -1) {
+        syslog( LOG_ERR, "%s: \"%s\": rename fails. errno %d", prog,
+            RADIUS_MPL_CACHE_FILE, errno);
+        if (oldfd != -1)
+            close(oldfd);
+        return radius_write_mpl_cache_cleanup(STATUS_EIO, prog, cache,
+            lockfd, fd, tmp_filename);
+    }
+
+    close(fd);
+    fd = -1;
+
+    if (oldfd != -1)
+        radius_mark_mpl_cache_stale(prog, oldfd);
+
+    syslog(LOG_INFO, "%s: \"%s\": %u users cached", prog,
+        RADIUS_MPL_CACHE_FILE, cache->num_users);
+
+    return radius_write_mpl_cache_cleanup(0, prog, cache, lockfd, fd,
+        tmp_filename);
+}
+
 int radius_copy_pw( RADIUS_NSS_CONF_B * conf, struct passwd * res,
     const char * nam, struct passwd * pwd,
     char * buffer, size_t buflen, int * errnop) {
@@ -11,6 +11,7 @@ The term "Broadcom" refers to Broadcom Inc. and/or its subsidiaries.
  */
 
 #include <stdio.h>
+#include <stdint.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/file.h>
@@ -36,6 +37,16 @@ The term "Broadcom" refers to Broadcom Inc. and/or its subsidiaries.
 #define RADIUS_CACHE_DIR "/var/cache/radius"
 #define RADIUS_ATTR_MPL "Management-Privilege-Level"
 
+/* Shared MPL cache, written by cache_radius and mapped by readers.
+ */
+#define RADIUS_MPL_CACHE_FILE RADIUS_CACHE_DIR "/mpl_cache"
+#define RADIUS_MPL_CACHE_MAGIC 0x4c504d52 /* "RMPL" */
+#define RADIUS_MPL_CACHE_VERSION 1
+#define RADIUS_MPL_CACHE_SLOTS 1024       /* Power of 2 */
+#define RADIUS_MPL_CACHE_MAX_USERS (RADIUS_MPL_CACHE_SLOTS / 2)
+#define RADIUS_MPL_CACHE_REVALIDATE 1     /* Seconds between config checks */
+#define RADIUS_MAX_USER_LEN 32
+
 #define ETC_PASSWD "/etc/passwd"
 
 #define USERADD "/usr/sbin/useradd"
@@ -106,11 +117,39 @@ typedef struct _radius_nss_conf {
     RADIUS_NSS_MPL rnm[RADIUS_MAX_MPL];
 } RADIUS_NSS_CONF_B;
 
+typedef struct _radius_mpl_cache_entry {
+    char        user[RADIUS_MAX_USER_LEN + 1];
+    uint8_t     mpl;        /* 0 for empty slot */
+} RADIUS_MPL_CACHE_ENTRY;
+
+typedef struct _radius_mpl_cache {
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    stale;      /* Set once the file has been replaced */
+    uint32_t    complete;   /* All cached users are in entries */
+    uint32_t    conf_valid; /* conf holds RADIUS_NSS_CONF */
+    uint32_t    num_users;
+    int64_t     conf_mtime_sec;
+    int64_t     conf_mtime_nsec;
+    int64_t     conf_size;
+    char        conf[RADIUS_MAX_NSS_CONF_SZ];
+    RADIUS_MPL_CACHE_ENTRY entries[RADIUS_MPL_CACHE_SLOTS];
+} RADIUS_MPL_CACHE;
+
 int parse_nss_config( RADIUS_NSS_CONF_B * conf, char * prog,
     char * file_buf, int file_buf_sz, int * errnop, int * plockfd);
 
 int unparse_nss_config( RADIUS_NSS_CONF_B * conf, int * errnop, int * plockfd);
 
+int radius_cached_nss_config( RADIUS_NSS_CONF_B * conf, char * prog,
+    char * file_buf, int file_buf_sz);
+
+int radius_lock_nss_config( RADIUS_NSS_CONF_B * conf, int * plockfd);
+
+int radius_mpl_cache_current( char * prog);
+
+int radius_write_mpl_cache( char * prog);
+
 int radius_lookup_cache( char * prog, const char * nam, int * pmpl);
 
 int radius_fill_pw( RADIUS_NSS_CONF_B * conf, int mpl,
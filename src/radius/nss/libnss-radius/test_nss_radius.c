@@ -21,6 +21,239 @@ The term "Broadcom" refers to Broadcom Inc. and/or its subsidiaries.
 #include <ctype.h>
 #include <netdb.h>
 #include <nss.h>
+#include <sys/mman.h>
+#include <stddef.h>
+#include <time.h>
+
+#include "nss_radius_common.h"
+
+/*
+ * Test code for the shared MPL cache (mpl_cache), run in a scratch
+ * directory since TEST_RADIUS_NSS puts all the files in the current one.
+ */
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FUNCTION__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static void write_file(const char * filename, const char * text) {
+    FILE * fp = fopen(filename, "w");
+
+    if (fp) {
+        fputs(text, fp);
+        fclose(fp);
+    }
+}
+
+static void set_user_mpl(const char * nam, int mpl) {
+    char filename[PATH_MAX];
+    char text[16];
+
+    mkdir(RADIUS_ATTRIBUTE_CACHE_DIR, 0755);
+    snprintf(filename, sizeof(filename), "%s/%s", RADIUS_ATTRIBUTE_CACHE_DIR,
+        nam);
+    mkdir(filename, 0755);
+    strcat(filename, "/" RADIUS_ATTR_MPL);
+    snprintf(text, sizeof(text), "%d\n", mpl);
+    write_file(filename, text);
+}
+
+/* Maps the current mpl_cache file, as readers do.
+ */
+static RADIUS_MPL_CACHE * map_mpl_cache(void) {
+    RADIUS_MPL_CACHE * cache;
+    int fd;
+
+    if ((fd = open(RADIUS_MPL_CACHE_FILE, O_RDONLY)) == -1)
+        return NULL;
+
+    cache = mmap(NULL, sizeof(*cache), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    return (cache == MAP_FAILED) ? NULL : cache;
+}
+
+/* Replaces mpl_cache with file the way cache_radius does: rename, then
+ * mark the replaced one stale.
+ */
+static void replace_mpl_cache(const char * filename) {
+    uint32_t stale = 1;
+    int oldfd = open(RADIUS_MPL_CACHE_FILE, O_WRONLY);
+
+    rename(filename, RADIUS_MPL_CACHE_FILE);
+    if (oldfd != -1) {
+        pwrite(oldfd, &stale, sizeof(stale),
+            offsetof(RADIUS_MPL_CACHE, stale));
+        close(oldfd);
+    }
+}
+
+/* Drops the cache and the per-user files of the previous test.
+ */
+static void reset_cache_dir(void) {
+    write_file("empty", "");
+    replace_mpl_cache("empty");
+    unlink(RADIUS_MPL_CACHE_FILE);
+    system("rm -rf " RADIUS_ATTRIBUTE_CACHE_DIR);
+    write_file(RADIUS_NSS_CONF, "many_to_one=y\n");
+    set_user_mpl("alice", 2);
+}
+
+/* A process that maps mpl_cache must see the one written after it.
+ */
+static void test_mpl_cache_stale_switch(void) {
+    RADIUS_MPL_CACHE * old, bad;
+    int mpl = 0;
+    int fd;
+
+    reset_cache_dir();
+    CHECK(radius_write_mpl_cache("test") == 0);
+    CHECK(radius_lookup_cache("test", "alice", &mpl) == 0);
+    CHECK(mpl == 2);
+
+    old = map_mpl_cache();
+    CHECK(old != NULL);
+    CHECK(old && !old->stale);
+
+    set_user_mpl("alice", 5);
+    set_user_mpl("bob", 3);
+    CHECK(radius_write_mpl_cache("test") == 0);
+    CHECK(old && old->stale);
+    CHECK(radius_lookup_cache("test", "alice", &mpl) == 0);
+    CHECK(mpl == 5);
+    CHECK(radius_lookup_cache("test", "bob", &mpl) == 0);
+    CHECK(mpl == 3);
+    if (old)
+        munmap(old, sizeof(*old));
+
+      /* A cache of another version is not mapped, lookups go to the
+       * per-user files.
+       */
+    memset(&bad, 0, sizeof(bad));
+    bad.magic = RADIUS_MPL_CACHE_MAGIC;
+    bad.version = RADIUS_MPL_CACHE_VERSION + 1;
+    bad.complete = 1;
+    fd = open("bad_cache", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    CHECK(write(fd, &bad, sizeof(bad)) == sizeof(bad));
+    close(fd);
+    replace_mpl_cache("bad_cache");
+
+    CHECK(!radius_mpl_cache_current("test"));
+    CHECK(radius_lookup_cache("test", "bob", &mpl) == 0);
+    CHECK(mpl == 3);
+}
+
+/* Users left out of a full table are still found in their files.
+ */
+static void test_mpl_cache_overflow(void) {
+    RADIUS_MPL_CACHE * cache;
+    char nam[RADIUS_MAX_USER_LEN + 1];
+    int mpl = 0;
+    int i;
+
+      /* A complete cache answers for users it does not hold.
+       */
+    reset_cache_dir();
+    CHECK(radius_write_mpl_cache("test") == 0);
+    set_user_mpl("carol", 4);
+    CHECK(radius_lookup_cache("test", "carol", &mpl) == STATUS_ENOENT);
+
+    for (i = 0; i <= RADIUS_MPL_CACHE_MAX_USERS; i++) {
+        snprintf(nam, sizeof(nam), "user%d", i);
+        set_user_mpl(nam, (i % RADIUS_MAX_MPL) + 1);
+    }
+    CHECK(radius_write_mpl_cache("test") == 0);
+
+    cache = map_mpl_cache();
+    CHECK(cache != NULL);
+    CHECK(cache && !cache->complete);
+    CHECK(cache && (cache->num_users == RADIUS_MPL_CACHE_MAX_USERS));
+    if (cache)
+        munmap(cache, sizeof(*cache));
+
+    for (i = 0; i <= RADIUS_MPL_CACHE_MAX_USERS; i++) {
+        snprintf(nam, sizeof(nam), "user%d", i);
+        CHECK(radius_lookup_cache("test", nam, &mpl) == 0);
+        CHECK(mpl == (i % RADIUS_MAX_MPL) + 1);
+    }
+
+    set_user_mpl("dave", 6);
+    CHECK(radius_lookup_cache("test", "dave", &mpl) == 0);
+    CHECK(mpl == 6);
+}
+
+/* The config copy is used only while it matches RADIUS_NSS_CONF.
+ */
+static void test_mpl_cache_conf_mismatch(void) {
+    RADIUS_NSS_CONF_B conf;
+    char file_buf[RADIUS_MAX_NSS_CONF_SZ];
+    struct timespec times[2];
+    int err = 0, lockfd = -1;
+
+    reset_cache_dir();
+    CHECK(radius_write_mpl_cache("test") == 0);
+    CHECK(radius_cached_nss_config(&conf, "test", file_buf,
+        sizeof(file_buf)) == 0);
+    CHECK(conf.many_to_one);
+
+      /* Same size, other mtime. Noticed once the last check is
+       * RADIUS_MPL_CACHE_REVALIDATE seconds old.
+       */
+    write_file(RADIUS_NSS_CONF, "many_to_one=n\n");
+    clock_gettime(CLOCK_REALTIME, &times[0]);
+    times[0].tv_sec += 10;
+    times[1] = times[0];
+    utimensat(AT_FDCWD, RADIUS_NSS_CONF, times, 0);
+    sleep(RADIUS_MPL_CACHE_REVALIDATE);
+
+    CHECK(radius_cached_nss_config(&conf, "test", file_buf,
+        sizeof(file_buf)) == 1);
+    parse_nss_config(&conf, "test", file_buf, sizeof(file_buf), &err,
+        &lockfd);
+    CHECK(!conf.many_to_one);
+    unparse_nss_config(&conf, &err, &lockfd);
+
+    CHECK(radius_write_mpl_cache("test") == 0);
+    CHECK(radius_cached_nss_config(&conf, "test", file_buf,
+        sizeof(file_buf)) == 0);
+    CHECK(!conf.many_to_one);
+
+      /* A group writable cache is not mapped. The owner is not checked
+       * with TEST_RADIUS_NSS.
+       */
+    CHECK(radius_write_mpl_cache("test") == 0);
+    chmod(RADIUS_MPL_CACHE_FILE, 0664);
+    CHECK(!radius_mpl_cache_current("test"));
+    CHECK(radius_cached_nss_config(&conf, "test", file_buf,
+        sizeof(file_buf)) == 1);
+}
+
+static int test_mpl_cache(void) {
+    char tmpdir[] = "/tmp/test_nss_radius.XXXXXX";
+    char cwd[PATH_MAX];
+    char cmd[PATH_MAX + 16];
+
+    if (!getcwd(cwd, sizeof(cwd)) || !mkdtemp(tmpdir) || chdir(tmpdir)) {
+        printf("FAIL: no scratch directory\n");
+        return 1;
+    }
+
+    test_mpl_cache_stale_switch();
+    test_mpl_cache_overflow();
+    test_mpl_cache_conf_mismatch();
+
+    chdir(cwd);
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", tmpdir);
+    system(cmd);
+
+    printf("mpl_cache: %d failures\n", failures);
+    return failures;
+}
 
 int main(int ac, char * av[]) {
 
@@ -33,6 +266,9 @@ int main(int ac, char * av[]) {
     char * users[] = { "admin", "user", "netops", "operator", "unknown", 0 };
     char ** u;
 
+    if (test_mpl_cache())
+        return 1;
+
     printf("buf: %p, len: %lx\n", buf, sizeof(buf));
 
     for ( u = users ; *u ; u++) {
@@ -0,0 +1,140 @@
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include "line_reader.h"
+
+static uint64_t countLines(const char* data, size_t length) {
+    uint64_t count = 0;
+    const char* end = data + length;
+    while((data = static_cast<const char*>(memchr(data, '\n', end - data))) != NULL) {
+        count++;
+        data++;
+    }
+    return count;
+}
+
+LineReader::LineReader(int fd) : m_fd(fd), m_partialLength(0), m_skipLine(false), m_eof(false), m_droppedLines(0) {
+    for(auto& block : m_blocks) {
+        block.data.reset(new char[LINE_BLOCK_SIZE]);
+        block.length = 0;
+        m_free.push(&block);
+    }
+    m_scratch.data.reset(new char[LINE_BLOCK_SIZE]);
+    m_scratch.length = 0;
+    m_partial.reset(new char[LINE_BLOCK_SIZE]);
+}
+
+ssize_t LineReader::readInput(char* buffer, size_t size) {
+    ssize_t readLength;
+    do {
+        readLength = read(m_fd, buffer, size);
+    } while(readLength < 0 && errno == EINTR);
+    return readLength;
+}
+
+void LineReader::publishBlock(LineBlock* block) {
+    if(block == &m_scratch) {
+        m_droppedLines.fetch_add(countLines(block->data.get(), block->length), memory_order_relaxed);
+        return;
+    }
+    m_filled.push(block); // never full, as there are only as many blocks
+    lock_guard<mutex> lock(m_mutex);
+    m_cv.notify_one();
+}
+
+/**
+ * Reads input until EOF or read error.
+ *
+ * A block is handed over as soon as it has complete lines, if consumer is waiting.
+ * While consumer is busy with earlier blocks, reads keep filling the same block.
+ */
+
+void LineReader::run() {
+    LineBlock* block = NULL;
+    while(true) {
+        if(block == NULL) {
+            if(!m_free.pop(block)) {
+                // Give consumer a while to catch up, before dropping
+                unique_lock<mutex> lock(m_mutex);
+                m_freeCv.wait_for(lock, chrono::milliseconds(LINE_BLOCK_WAIT_MS), [this] { return !m_free.empty(); });
+                if(!m_free.pop(block)) {
+                    block = &m_scratch;
+                }
+            }
+            memcpy(block->data.get(), m_partial.get(), m_partialLength);
+            block->length = m_partialLength;
+            m_partialLength = 0;
+        }
+
+        char* data = block->data.get();
+        size_t start = block->length;
+        ssize_t readLength = readInput(data + start, LINE_BLOCK_SIZE - start);
+        if(readLength <= 0) { // last line may not end with newline
+            if(block == &m_scratch && block->length != 0) {
+                m_droppedLines.fetch_add(countLines(data, block->length) + 1, memory_order_relaxed);
+            } else {
+                publishBlock(block);
+            }
+            break;
+        }
+        block->length += readLength;
+
+        if(m_skipLine) { // rest of a long line, which is already counted as dropped
+            char* newline = static_cast<char*>(memchr(data + start, '\n', block->length - start));
+            if(newline == NULL) {
+                block->length = start;
+                continue;
+            }
+            m_skipLine = false;
+            memmove(data + start, newline + 1, data + block->length - (newline + 1));
+            block->length -= (newline + 1 - (data + start));
+        }
+
+        char* lastNewline = static_cast<char*>(memrchr(data, '\n', block->length));
+        if(lastNewline == NULL) {
+            if(block->length == LINE_BLOCK_SIZE) { // line longer than a block
+                m_droppedLines.fetch_add(1, memory_order_relaxed);
+                m_skipLine = true;
+                block->length = 0;
+            }
+            continue;
+        }
+
+        if(block != &m_scratch && block->length < LINE_BLOCK_SIZE && !m_filled.empty()) {
+            continue;
+        }
+
+        size_t complete = lastNewline + 1 - data;
+        m_partialLength = block->length - complete;
+        memcpy(m_partial.get(), lastNewline + 1, m_partialLength);
+        block->length = complete;
+        publishBlock(block);
+        block = NULL;
+    }
+
+    m_eof = true;
+    lock_guard<mutex> lock(m_mutex);
+    m_cv.notify_one();
+}
+
+/**
+ * Waits for next block of lines. Returns false upon EOF, once all blocks are consumed.
+ */
+
+bool LineReader::nextBlock(LineBlock*& block) {
+    while(!m_filled.pop(block)) {
+        if(m_eof && m_filled.empty()) {
+            return false;
+        }
+        unique_lock<mutex> lock(m_mutex);
+        m_cv.wait(lock, [this] { return !m_filled.empty() || m_eof; });
+    }
+    return true;
+}
+
+void LineReader::releaseBlock(LineBlock* block) {
+    block->length = 0;
+    m_free.push(block);
+    lock_guard<mutex> lock(m_mutex);
+    m_freeCv.notify_one();
+}
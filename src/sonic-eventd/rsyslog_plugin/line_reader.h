@@ -0,0 +1,119 @@
+#ifndef LINE_READER_H
+#define LINE_READER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+using namespace std;
+
+#define LINE_BLOCK_SIZE (64 * 1024)
+#define LINE_BLOCK_COUNT 16
+#define LINE_BLOCK_WAIT_MS 100
+
+/**
+ * Bounded lock free ring for a single producer thread and a single consumer thread
+ *
+ */
+
+template<typename T, size_t N>
+class SpscRing {
+public:
+    SpscRing() : m_head(0), m_tail(0) {}
+    bool push(const T& item) {
+        size_t tail = m_tail.load(memory_order_relaxed);
+        if(tail - m_head.load(memory_order_acquire) == N) {
+            return false;
+        }
+        m_items[tail % N] = item;
+        m_tail.store(tail + 1, memory_order_release);
+        return true;
+    }
+    bool pop(T& item) {
+        size_t head = m_head.load(memory_order_relaxed);
+        if(head == m_tail.load(memory_order_acquire)) {
+            return false;
+        }
+        item = m_items[head % N];
+        m_head.store(head + 1, memory_order_release);
+        return true;
+    }
+    bool empty() const {
+        return m_head.load(memory_order_acquire) == m_tail.load(memory_order_acquire);
+    }
+private:
+    T m_items[N];
+    alignas(64) atomic<size_t> m_head;
+    alignas(64) atomic<size_t> m_tail;
+};
+
+/**
+ * Block of complete lines read from input
+ */
+
+struct LineBlock {
+    unique_ptr<char[]> data;
+    size_t length;
+};
+
+/**
+ * LineReader reads input in large blocks on its own thread and hands blocks holding only
+ * complete lines to a consumer thread through a bounded ring. Lines are consumed in place
+ * from the blocks; only a line split across reads is moved to the start of the next block.
+ *
+ * When the consumer falls behind and no block is freed within LINE_BLOCK_WAIT_MS, the
+ * reader keeps draining input and drops the lines read, so the writer on the other end
+ * is never blocked for long.
+ * A line longer than a block is dropped as well.
+ *
+ */
+
+class LineReader {
+public:
+    LineReader(int fd);
+    void run();
+    bool nextBlock(LineBlock*& block);
+    void releaseBlock(LineBlock* block);
+    uint64_t droppedLines() const { return m_droppedLines.load(memory_order_relaxed); }
+private:
+    ssize_t readInput(char* buffer, size_t size);
+    void publishBlock(LineBlock* block);
+    int m_fd;
+    LineBlock m_blocks[LINE_BLOCK_COUNT];
+    LineBlock m_scratch; // absorbs input to drop, when out of free blocks
+    unique_ptr<char[]> m_partial; // incomplete line carried to next block
+    size_t m_partialLength;
+    bool m_skipLine; // dropping rest of a line longer than a block
+    SpscRing<LineBlock*, LINE_BLOCK_COUNT> m_filled;
+    SpscRing<LineBlock*, LINE_BLOCK_COUNT> m_free;
+    atomic<bool> m_eof;
+    atomic<uint64_t> m_droppedLines;
+    mutex m_mutex;
+    condition_variable m_cv;
+    condition_variable m_freeCv;
+};
+
+/**
+ * Calls func for each non empty line in block, as a view into the block
+ */
+
+template<typename Func>
+void forEachLine(const LineBlock* block, Func func) {
+    const char* begin = block->data.get();
+    const char* end = begin + block->length;
+    while(begin < end) {
+        const char* newline = static_cast<const char*>(memchr(begin, '\n', end - begin));
+        const char* lineEnd = newline != NULL ? newline : end;
+        if(lineEnd != begin) {
+            func(string_view(begin, lineEnd - begin));
+        }
+        begin = lineEnd + 1;
+    }
+}
+
+#endif
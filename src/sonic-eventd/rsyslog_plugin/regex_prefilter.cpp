@@ -0,0 +1,313 @@
+#include <cstring>
+#include <queue>
+#include "regex_prefilter.h"
+
+static const int32_t NO_STATE = -1;
+
+static bool isMeta(char c) {
+    return strchr(".^$|()[]{}*+?\\", c) != NULL;
+}
+
+/**
+ * Length of the escape sequence starting at pos, including the backslash.
+ * \xhh, \uhhhh and \cX carry operands which are not literal text.
+ */
+static size_t escapeLength(const string& regex, size_t pos) {
+    size_t len = 2;
+    switch(regex[pos + 1]) {
+        case 'x':
+            len = 4;
+            break;
+        case 'u':
+            len = 6;
+            break;
+        case 'c':
+            len = 3;
+            break;
+        default:
+            break;
+    }
+    return min(len, regex.size() - pos);
+}
+
+/**
+ * Returns index past the character class starting at pos, or npos if unterminated
+ */
+static size_t skipClass(const string& regex, size_t pos) {
+    size_t i = pos + 1;
+    if(i < regex.size() && regex[i] == '^') {
+        i++;
+    }
+    if(i < regex.size() && regex[i] == ']') { // ] as first char is literal
+        i++;
+    }
+    for(; i < regex.size(); i++) {
+        if(regex[i] == '\\') {
+            i++;
+        } else if(regex[i] == ']') {
+            return i + 1;
+        }
+    }
+    return string::npos;
+}
+
+/**
+ * Returns index of the parenthesis closing the group starting at pos, or npos if unbalanced
+ */
+static size_t findGroupEnd(const string& regex, size_t pos) {
+    int depth = 0;
+    for(size_t i = pos; i < regex.size(); i++) {
+        if(regex[i] == '\\') {
+            i++;
+        } else if(regex[i] == '[') {
+            i = skipClass(regex, i);
+            if(i == string::npos) {
+                return i;
+            }
+            i--;
+        } else if(regex[i] == '(') {
+            depth++;
+        } else if(regex[i] == ')' && --depth == 0) {
+            return i;
+        }
+    }
+    return string::npos;
+}
+
+/**
+ * Literal alternatives of a group such as (?:to|from), empty if any alternative is not a plain literal
+ */
+static vector<string> groupLiterals(string group) {
+    vector<string> literals;
+    string literal;
+    if(group.compare(0, 2, "?:") == 0) {
+        group = group.substr(2);
+    } else if(!group.empty() && group[0] == '?') { // lookaround
+        return {};
+    }
+    for(size_t i = 0; i <= group.size(); i++) {
+        if(i == group.size() || group[i] == '|') {
+            if(literal.empty()) {
+                return {};
+            }
+            literals.push_back(literal);
+            literal.clear();
+        } else if(group[i] == '\\' && i + 1 < group.size() && !isalnum((unsigned char)group[i + 1])) {
+            literal += group[++i];
+        } else if(isMeta(group[i])) {
+            return {};
+        } else {
+            literal += group[i];
+        }
+    }
+    return literals;
+}
+
+/**
+ * Returns literals one of which must be part of any match of regex.
+ * Returns empty, if no such literal could be found.
+ *
+ * The scan is conservative: anything not understood ends the current literal run.
+ */
+vector<string> RegexPrefilter::requiredLiterals(const string& regex) {
+    vector<vector<string>> sets;
+    string run;
+    size_t i = 0;
+
+    auto endRun = [&]() {
+        if(!run.empty()) {
+            sets.push_back({ run });
+            run.clear();
+        }
+    };
+
+    while(i < regex.size()) {
+        char c = regex[i];
+        bool isLiteral = false;
+        char literal = 0;
+        vector<string> group;
+
+        if(c == '\\') {
+            if(i + 1 >= regex.size()) {
+                return {};
+            }
+            if(isalnum((unsigned char)regex[i + 1])) { // \d, \s, \b, \x41, back reference etc.
+                endRun();
+                i += escapeLength(regex, i);
+            } else {
+                isLiteral = true;
+                literal = regex[i + 1];
+                i += 2;
+            }
+        } else if(c == '[') {
+            endRun();
+            i = skipClass(regex, i);
+            if(i == string::npos) {
+                return {};
+            }
+        } else if(c == '(') {
+            size_t end = findGroupEnd(regex, i);
+            if(end == string::npos) {
+                return {};
+            }
+            endRun();
+            group = groupLiterals(regex.substr(i + 1, end - i - 1));
+            i = end + 1;
+        } else if(c == '|') { // top level alternation; nothing is required
+            return {};
+        } else if(isMeta(c) && c != '*' && c != '+' && c != '?' && c != '{') {
+            endRun();
+            i++;
+        } else if(!isMeta(c)) {
+            isLiteral = true;
+            literal = c;
+            i++;
+        }
+
+        // quantifier applies to the atom just scanned
+        char quantifier = i < regex.size() ? regex[i] : 0;
+        bool optional = (quantifier == '*' || quantifier == '?' || quantifier == '{');
+        if(isLiteral) {
+            if(optional) {
+                endRun();
+            } else {
+                run += literal;
+                if(quantifier == '+') {
+                    endRun();
+                }
+            }
+        } else if(!group.empty() && !optional) {
+            sets.push_back(group);
+        }
+
+        if(optional || quantifier == '+') {
+            if(quantifier == '{') {
+                i = regex.find('}', i);
+                if(i == string::npos) {
+                    return {};
+                }
+            }
+            i++;
+            if(i < regex.size() && regex[i] == '?') { // lazy
+                i++;
+            }
+            endRun();
+        }
+    }
+    endRun();
+
+    // prefer the set whose shortest literal is longest, as it filters best
+    vector<string> best;
+    size_t bestLength = 0;
+    for(const auto& set : sets) {
+        size_t shortest = string::npos;
+        for(const auto& literal : set) {
+            shortest = min(shortest, literal.size());
+        }
+        if(shortest > bestLength) {
+            bestLength = shortest;
+            best = set;
+        }
+    }
+    return best;
+}
+
+RegexPrefilter::RegexPrefilter() : m_classCount(1), m_ruleCount(0) {
+    memset(m_byteClass, 0, sizeof(m_byteClass));
+}
+
+void RegexPrefilter::addLiteral(const string& literal, int ruleId) {
+    int32_t state = 0;
+    for(unsigned char c : literal) {
+        int32_t& next = m_transitions[state * m_classCount + m_byteClass[c]];
+        if(next == NO_STATE) {
+            next = (int32_t)m_outputs.size();
+            m_outputs.emplace_back();
+            m_transitions.resize(m_transitions.size() + m_classCount, NO_STATE);
+        }
+        state = m_transitions[state * m_classCount + m_byteClass[c]];
+    }
+    m_outputs[state].push_back(ruleId);
+}
+
+/**
+ * Builds the automaton for given regexes. Rule ids are the indexes in regexes.
+ */
+void RegexPrefilter::build(const vector<string>& regexes) {
+    vector<vector<string>> literals;
+
+    memset(m_byteClass, 0, sizeof(m_byteClass));
+    m_classCount = 1; // class 0 is for bytes in none of the literals
+    m_alwaysCandidates.clear();
+    m_ruleCount = regexes.size();
+
+    for(size_t i = 0; i < regexes.size(); i++) {
+        literals.push_back(requiredLiterals(regexes[i]));
+        if(literals.back().empty()) {
+            m_alwaysCandidates.push_back((int)i);
+        }
+        for(const auto& literal : literals.back()) {
+            for(unsigned char c : literal) {
+                if(m_byteClass[c] == 0) {
+                    m_byteClass[c] = (uint8_t)m_classCount++;
+                }
+            }
+        }
+    }
+
+    m_outputs.assign(1, {});
+    m_transitions.assign(m_classCount, NO_STATE);
+    for(size_t i = 0; i < literals.size(); i++) {
+        for(const auto& literal : literals[i]) {
+            addLiteral(literal, (int)i);
+        }
+    }
+
+    // Breadth first, fill in failure transitions to make it a DFA
+    vector<int32_t> fail(m_outputs.size(), 0);
+    queue<int32_t> pending;
+    for(int c = 0; c < m_classCount; c++) {
+        int32_t& next = m_transitions[c];
+        if(next == NO_STATE) {
+            next = 0;
+        } else {
+            pending.push(next);
+        }
+    }
+    while(!pending.empty()) {
+        int32_t state = pending.front();
+        pending.pop();
+        const vector<int>& failOutputs = m_outputs[fail[state]];
+        m_outputs[state].insert(m_outputs[state].end(), failOutputs.begin(), failOutputs.end());
+        for(int c = 0; c < m_classCount; c++) {
+            int32_t& next = m_transitions[state * m_classCount + c];
+            int32_t failNext = m_transitions[fail[state] * m_classCount + c];
+            if(next == NO_STATE) {
+                next = failNext;
+            } else {
+                fail[next] = failNext;
+                pending.push(next);
+            }
+        }
+    }
+}
+
+/**
+ * Sets candidates[i] to 1 for every rule i that could match message, 0 otherwise
+ */
+void RegexPrefilter::match(string_view message, vector<uint8_t>& candidates) const {
+    candidates.assign(m_ruleCount, 0);
+    for(int ruleId : m_alwaysCandidates) {
+        candidates[ruleId] = 1;
+    }
+    if(m_transitions.empty()) {
+        return;
+    }
+    int32_t state = 0;
+    for(unsigned char c : message) {
+        state = m_transitions[state * m_classCount + m_byteClass[c]];
+        for(int ruleId : m_outputs[state]) {
+            candidates[ruleId] = 1;
+        }
+    }
+}
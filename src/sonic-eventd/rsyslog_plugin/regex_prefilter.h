@@ -0,0 +1,39 @@
+#ifndef REGEX_PREFILTER_H
+#define REGEX_PREFILTER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+/**
+ * RegexPrefilter narrows down the regexes to run against a syslog message.
+ *
+ * For each regex, a set of literals is extracted such that any match of the
+ * regex must contain one of them. All literals are compiled into a single
+ * Aho-Corasick automaton, so one pass over the message finds every regex
+ * that could possibly match. Regexes with no usable literal are always
+ * candidates.
+ *
+ */
+
+class RegexPrefilter {
+public:
+    RegexPrefilter();
+    void build(const vector<string>& regexes);
+    void match(string_view message, vector<uint8_t>& candidates) const;
+    size_t size() const { return m_ruleCount; }
+    static vector<string> requiredLiterals(const string& regex);
+private:
+    void addLiteral(const string& literal, int ruleId);
+    uint8_t m_byteClass[256];
+    int m_classCount;
+    vector<int32_t> m_transitions;
+    vector<vector<int>> m_outputs;
+    vector<int> m_alwaysCandidates;
+    size_t m_ruleCount;
+};
+
+#endif
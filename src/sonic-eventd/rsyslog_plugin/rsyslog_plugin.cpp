@@ -3,17 +3,19 @@
 #include <fstream>
 #include <regex>
 #include <ctime>
+#include <chrono>
+#include <thread>
 #include <unordered_map>
 #include "rsyslog_plugin.h"
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
 
-bool RsyslogPlugin::onMessage(string msg, lua_State* luaState) {
+bool RsyslogPlugin::onMessage(string_view msg, lua_State* luaState) {
     string tag;
     event_params_t paramDict;
     if(!m_parser->parseMessage(msg, tag, paramDict, luaState)) {
-        SWSS_LOG_DEBUG("%s was not able to be parsed into a structured event\n", msg.c_str());
+        SWSS_LOG_DEBUG("%.*s was not able to be parsed into a structured event\n", (int)msg.size(), msg.data());
         return false;
     } else {
         int returnCode = event_publish(m_eventHandle, tag, &paramDict);
@@ -82,6 +84,7 @@ bool RsyslogPlugin::createRegexList() {
             rs.params = eventParams;
             rs.tag = tag;
             rs.regexExpression = expression;
+            rs.eventRegex = eventRegex;
             regexList.push_back(rs);
 	} catch (nlohmann::detail::type_error& deException) {
             SWSS_LOG_ERROR("Missing required key, throws exception: %s\n", deException.what());
@@ -97,24 +100,63 @@ bool RsyslogPlugin::createRegexList() {
         return false;
     }
 
-    m_parser->m_regexList = regexList;
+    m_parser->setRegexList(regexList);
+    if(!m_parser->compileLuaCode(m_luaState)) {
+        // only params with invalid lua code are affected; their captured values are published as is
+        SWSS_LOG_ERROR("Invalid lua code in regex file: %s\n", m_regexPath.c_str());
+    }
 
     regexFile.close();
     return true;
 }
 
-void RsyslogPlugin::run() {
-    lua_State* luaState = luaL_newstate();
-    luaL_openlibs(luaState);
-    while(true) {
-        string line;
-        getline(cin, line);
-        if(line.empty()) {
-            continue;
+void RsyslogPlugin::publishStats() {
+    SWSS_LOG_NOTICE("rsyslog_plugin %s lines: dropped=%lu parsed=%lu matched=%lu", m_moduleName.c_str(),
+            (unsigned long)m_droppedLines, (unsigned long)m_parsedLines, (unsigned long)m_matchedLines);
+
+    try {
+        if(m_statsTable == NULL) {
+            m_countersDb = make_shared<swss::DBConnector>("COUNTERS_DB", 0, true);
+            m_statsTable = make_shared<swss::Table>(m_countersDb.get(), PLUGIN_STATS_TABLE);
         }
-        onMessage(line, luaState);
+        vector<FieldValueTuple> fv;
+        fv.emplace_back(PLUGIN_STATS_FIELD_DROPPED, to_string(m_droppedLines));
+        fv.emplace_back(PLUGIN_STATS_FIELD_PARSED, to_string(m_parsedLines));
+        fv.emplace_back(PLUGIN_STATS_FIELD_MATCHED, to_string(m_matchedLines));
+        m_statsTable->set(m_moduleName, fv);
+    } catch (exception& e) {
+        // retried at next interval; counters are still logged above
+        SWSS_LOG_ERROR("rsyslog_plugin %s unable to write stats to COUNTERS_DB, e=(%s)\n", m_moduleName.c_str(), e.what());
+        m_statsTable.reset();
+        m_countersDb.reset();
     }
-    lua_close(luaState);
+}
+
+void RsyslogPlugin::run(int fd) {
+    LineReader reader(fd);
+    thread readerThread(&LineReader::run, &reader);
+    auto lastStats = chrono::steady_clock::now();
+    LineBlock* block;
+
+    while(reader.nextBlock(block)) {
+        forEachLine(block, [this](string_view line) {
+            m_parsedLines++;
+            if(onMessage(line, m_luaState)) {
+                m_matchedLines++;
+            }
+        });
+        reader.releaseBlock(block);
+        m_droppedLines = reader.droppedLines();
+
+        auto now = chrono::steady_clock::now();
+        if(now - lastStats >= chrono::seconds(PLUGIN_STATS_INTERVAL_SECS)) {
+            publishStats();
+            lastStats = now;
+        }
+    }
+    readerThread.join();
+    m_droppedLines = reader.droppedLines();
+    publishStats();
 }
 
 int RsyslogPlugin::onInit() {
@@ -132,4 +174,13 @@ RsyslogPlugin::RsyslogPlugin(string moduleName, string regexPath) {
     m_parser = unique_ptr<SyslogParser>(new SyslogParser());
     m_moduleName = moduleName;
     m_regexPath = regexPath;
+    m_droppedLines = 0;
+    m_parsedLines = 0;
+    m_matchedLines = 0;
+    m_luaState = luaL_newstate(); // lua code of params is compiled into this state at init
+    luaL_openlibs(m_luaState);
+}
+
+RsyslogPlugin::~RsyslogPlugin() {
+    lua_close(m_luaState);
 }
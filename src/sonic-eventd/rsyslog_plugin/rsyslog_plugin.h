@@ -8,32 +8,60 @@ extern "C"
     #include <lua5.1/lauxlib.h>
 }
 #include <string>
+#include <string_view>
 #include <memory>
+#include <unistd.h>
+#include "dbconnector.h"
+#include "table.h"
 #include "syslog_parser.h"
+#include "line_reader.h"
 #include "events.h"
 #include "logger.h"
 
 using namespace std;
 using namespace swss;
 
+#define PLUGIN_STATS_INTERVAL_SECS 60
+
+/* Line counters are published in COUNTERS_DB as PLUGIN_STATS_TABLE|<module name> */
+#define PLUGIN_STATS_TABLE "COUNTERS_RSYSLOG_PLUGIN"
+#define PLUGIN_STATS_FIELD_DROPPED "dropped"
+#define PLUGIN_STATS_FIELD_PARSED "parsed"
+#define PLUGIN_STATS_FIELD_MATCHED "matched"
+
 /**
  * Rsyslog Plugin will utilize an instance of a syslog parser to read syslog messages from rsyslog.d and will continuously read from stdin
  * A plugin instance is created for each container/host.
  *
+ * Input is read by a LineReader on its own thread, while lines are parsed and published on the thread calling run,
+ * until EOF. Counts of dropped, parsed and matched lines are logged and written to COUNTERS_DB every
+ * PLUGIN_STATS_INTERVAL_SECS, and once more at EOF.
+ *
  */
 
 class RsyslogPlugin {
 public:
     int onInit();
-    bool onMessage(string msg, lua_State* luaState);
-    void run();
+    bool onMessage(string_view msg, lua_State* luaState);
+    void run(int fd = STDIN_FILENO);
+    uint64_t droppedLines() const { return m_droppedLines; }
+    uint64_t parsedLines() const { return m_parsedLines; }
+    uint64_t matchedLines() const { return m_matchedLines; }
     RsyslogPlugin(string moduleName, string regexPath);
+    ~RsyslogPlugin();
 private:
     unique_ptr<SyslogParser> m_parser;
+    lua_State* m_luaState;
     event_handle_t m_eventHandle;
     string m_regexPath;
     string m_moduleName;
+    uint64_t m_droppedLines;
+    uint64_t m_parsedLines;
+    uint64_t m_matchedLines;
+    shared_ptr<swss::DBConnector> m_countersDb;
+    shared_ptr<swss::Table> m_statsTable;
     bool createRegexList();
+    void publishStats();
 };
 
 #endif
@@ -11,18 +11,93 @@
  *
 */
 
-bool SyslogParser::parseMessage(string message, string& eventTag, event_params_t& paramMap, lua_State* luaState) {
+void SyslogParser::setRegexList(const vector<RegexStruct>& regexList) {
+    vector<string> eventRegexes;
+    m_regexList = regexList;
+    for(const auto& rs : m_regexList) {
+        eventRegexes.push_back(rs.eventRegex);
+    }
+    m_prefilter.build(eventRegexes);
+    m_luaState = NULL; // new params are not compiled yet
+}
+
+/**
+ * Compiles lua code of all params into functions referenced from registry of luaState.
+ * The code reads the captured value as global arg and returns result as global ret.
+ * It is wrapped to get arg as function argument and return ret, to avoid globals per call.
+ *
+ * A param whose lua code fails to compile is left without a function, so its captured
+ * value is used as is, while all other params and regexes keep working.
+ *
+ * @return false if any lua code fails to compile
+ *
+ */
+
+bool SyslogParser::compileLuaCode(lua_State* luaState) {
+    bool success = true;
+    for(auto& rs : m_regexList) {
+        for(auto& param : rs.params) {
+            param.luaRef = LUA_NOREF;
+            if(param.luaCode.empty()) {
+                continue;
+            }
+            string chunk = "local arg = ...\n" + param.luaCode + "\nreturn ret";
+            if(luaL_loadbuffer(luaState, chunk.c_str(), chunk.size(), param.paramName.c_str()) != 0) {
+                SWSS_LOG_ERROR("Invalid lua code for param %s of tag %s: %s\n", param.paramName.c_str(),
+                        rs.tag.c_str(), lua_tostring(luaState, -1));
+                lua_pop(luaState, 1);
+                success = false;
+                continue;
+            }
+            param.luaRef = luaL_ref(luaState, LUA_REGISTRYINDEX);
+        }
+    }
+    m_luaState = luaState;
+    return success;
+}
+
+bool SyslogParser::runLuaCode(lua_State* luaState, const EventParam& param, const char* value, size_t length, string& result) {
+    lua_rawgeti(luaState, LUA_REGISTRYINDEX, param.luaRef);
+    lua_pushlstring(luaState, value, length);
+    if(lua_pcall(luaState, 1, 1, 0) != 0) {
+        SWSS_LOG_ERROR("Lua code for param %s failed: %s\n", param.paramName.c_str(), lua_tostring(luaState, -1));
+        lua_pop(luaState, 1);
+        return false;
+    }
+    size_t resultLength = 0;
+    const char* resultValue = lua_isstring(luaState, -1) ? lua_tolstring(luaState, -1, &resultLength) : NULL;
+    if(resultValue != NULL) {
+        result.assign(resultValue, resultLength);
+    }
+    lua_pop(luaState, 1);
+    return resultValue != NULL;
+}
+
+bool SyslogParser::parseMessage(string_view message, string& eventTag, event_params_t& paramMap, lua_State* luaState) {
+    bool prefiltered = (m_prefilter.size() == m_regexList.size());
+    if(luaState != m_luaState) {
+        compileLuaCode(luaState);
+    }
+    if(prefiltered) {
+        m_prefilter.match(message, m_candidates);
+    }
     for(long unsigned int i = 0; i < m_regexList.size(); i++) {
-        smatch matchResults;
-        if(!regex_search(message, matchResults, m_regexList[i].regexExpression) || m_regexList[i].params.size() != matchResults.size() - 1 || matchResults.size() < 4) {
+        cmatch matchResults;
+        if(prefiltered && !m_candidates[i]) {
             continue;
         }
-        string formattedTimestamp;
-        if(!matchResults[1].str().empty() && !matchResults[2].str().empty() && !matchResults[3].str().empty()) { // found timestamp components
-            formattedTimestamp = m_timestampFormatter->changeTimestampFormat({ matchResults[1].str(), matchResults[2].str(), matchResults[3].str() });
+        if(!regex_search(message.data(), message.data() + message.size(), matchResults, m_regexList[i].regexExpression) || m_regexList[i].params.size() != matchResults.size() - 1 || matchResults.size() < 4) {
+            continue;
+        }
+        char formattedTimestamp[TIMESTAMP_BUFFER_SIZE];
+        size_t timestampLength = 0;
+        if(matchResults.length(1) != 0 && matchResults.length(2) != 0 && matchResults.length(3) != 0) { // found timestamp components
+            auto component = [&](int k) { return string_view(message.data() + matchResults.position(k), matchResults.length(k)); };
+            timestampLength = m_timestampFormatter->formatTimestamp(component(1), component(2), component(3),
+                    formattedTimestamp, sizeof(formattedTimestamp));
 	}
-        if(!formattedTimestamp.empty()) {
-            paramMap["timestamp"] = formattedTimestamp;
+        if(timestampLength != 0) {
+            paramMap["timestamp"].assign(formattedTimestamp, timestampLength);
 	} else {
             SWSS_LOG_INFO("Timestamp is invalid and is not able to be formatted");
 	}
@@ -31,35 +106,27 @@ bool SyslogParser::parseMessage(string message, string& eventTag, event_params_t
         eventTag = m_regexList[i].tag;
 	// check params for lua code
         for(long unsigned int j = 3; j < m_regexList[i].params.size(); j++) {
-	    string resultValue = matchResults[j + 1].str();
-	    string paramName = m_regexList[i].params[j].paramName;
-	    const char* luaCode = m_regexList[i].params[j].luaCode.c_str();
+            const EventParam& param = m_regexList[i].params[j];
+            string& paramValue = paramMap[param.paramName];
 
-            if(luaCode == NULL || *luaCode == 0) {
+            if(param.luaCode.empty()) {
                 SWSS_LOG_INFO("Invalid lua code, empty or missing");
-                paramMap[paramName] = resultValue;
+                paramValue = matchResults[j + 1].str();
 		continue;
 	    }
 
-	    // execute lua code
-            lua_pushstring(luaState, resultValue.c_str());
-            lua_setglobal(luaState, "arg");
-            if(luaL_dostring(luaState, luaCode) == 0) {
-                lua_pop(luaState, lua_gettop(luaState));
-	    } else { // error in lua code
+	    // execute precompiled lua code on captured value, in place in message
+            if(param.luaRef == LUA_NOREF || !runLuaCode(luaState, param, message.data() + matchResults.position(j + 1),
+                        matchResults.length(j + 1), paramValue)) { // error in lua code
 		SWSS_LOG_ERROR("Invalid lua code, unable to do operation.\n");
-		paramMap[paramName] = resultValue;
-		continue;
+                paramValue = matchResults[j + 1].str();
             }
-            lua_getglobal(luaState, "ret");
-            paramMap[paramName] = lua_tostring(luaState, -1);
-            lua_pop(luaState, 1);
 	}
         return true;
     }
     return false;
 }
 
-SyslogParser::SyslogParser() {
+SyslogParser::SyslogParser() : m_luaState(NULL) {
     m_timestampFormatter = unique_ptr<TimestampFormatter>(new TimestampFormatter());
 }
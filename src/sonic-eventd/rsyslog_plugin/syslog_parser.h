@@ -10,10 +10,12 @@ extern "C"
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <regex>
 #include <nlohmann/json.hpp>
 #include "events.h"
 #include "timestamp_formatter.h"
+#include "regex_prefilter.h"
 
 using namespace std;
 using json = nlohmann::json;
@@ -21,26 +23,42 @@ using json = nlohmann::json;
 struct EventParam {
     string paramName;
     string luaCode;
+    int luaRef = LUA_NOREF; // registry reference to compiled luaCode
 };
 
 struct RegexStruct {
     regex regexExpression;
     vector<EventParam> params;
     string tag;
+    string eventRegex; // regex from regex file, w/o timestamp prefix
 };
 
 /**
  * Syslog Parser is responsible for parsing log messages fed by rsyslog.d and returns
  * matched result to rsyslog_plugin to use with events publish API
  *
+ * Regex list set via setRegexList is prefiltered, so only regexes that could match
+ * a message are run. A list assigned directly to m_regexList runs every regex.
+ *
+ * Lua code of params is compiled once per lua state into functions held in the
+ * registry. The lua state passed to parseMessage is compiled for upon first use,
+ * unless already done via compileLuaCode.
+ *
  */
 
 class SyslogParser {
 public:
     unique_ptr<TimestampFormatter> m_timestampFormatter;
     vector<RegexStruct> m_regexList;
-    bool parseMessage(string message, string& tag, event_params_t& paramDict, lua_State* luaState);
+    void setRegexList(const vector<RegexStruct>& regexList);
+    bool compileLuaCode(lua_State* luaState);
+    bool parseMessage(string_view message, string& tag, event_params_t& paramDict, lua_State* luaState);
     SyslogParser();
+private:
+    bool runLuaCode(lua_State* luaState, const EventParam& param, const char* value, size_t length, string& result);
+    RegexPrefilter m_prefilter;
+    vector<uint8_t> m_candidates;
+    lua_State* m_luaState;
 };
 
 #endif
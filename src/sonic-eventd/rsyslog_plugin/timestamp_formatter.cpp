@@ -1,74 +1,156 @@
 #include <iostream>
+#include <cstring>
 #include "timestamp_formatter.h"
 #include "logger.h"
 #include "events.h"
 
 using namespace std;
 
+static constexpr const char* g_monthNames[] = {
+    "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+};
+
+/**
+ * Perfect hash of the three letter month names into 32 slots
+ */
+static constexpr uint8_t monthHash(char first, char second, char third) {
+    return (uint8_t)((first + second + 3 * third) & 31);
+}
+
+struct MonthTable {
+    uint8_t month[32]; // 1 based month number by hash, 0 for unused slot
+};
+
+static constexpr MonthTable buildMonthTable() {
+    MonthTable table = {};
+    for(uint8_t i = 0; i < 12; i++) {
+        const char* name = g_monthNames[i];
+        table.month[monthHash(name[0], name[1], name[2])] = i + 1;
+    }
+    return table;
+}
+
+static constexpr bool monthHashIsPerfect(const MonthTable& table) {
+    int count = 0;
+    for(uint8_t month : table.month) {
+        count += (month != 0);
+    }
+    return count == 12;
+}
+
+static constexpr MonthTable g_monthTable = buildMonthTable();
+static_assert(monthHashIsPerfect(g_monthTable), "month hash has collisions");
+
+/**
+ * Returns month number 1-12 for a three letter month name, 0 if invalid
+ */
+static int monthNumber(string_view month) {
+    if(month.size() != 3) {
+        return 0;
+    }
+    int number = g_monthTable.month[monthHash(month[0], month[1], month[2])];
+    if(number == 0 || memcmp(g_monthNames[number - 1], month.data(), 3) != 0) {
+        return 0;
+    }
+    return number;
+}
+
+TimestampFormatter::TimestampFormatter() : m_currentYear(0), m_yearValidUntil(0) {
+}
+
 /***
  *
- * Formats given string into string needed by YANG model
+ * Sets m_storedYear for given timestamp of form mmddhh:mm:ss.SSSSSS
  *
- * @param timestamp parsed from syslog message
- * @return formatted timestamp that conforms to YANG model
+ * Year is kept, unless timestamp went back in time, which is taken as a year change.
  *
  */
 
-static const unordered_map<string, string> g_monthDict {
-    { "Jan", "01" },
-    { "Feb", "02" },
-    { "Mar", "03" },
-    { "Apr", "04" },
-    { "May", "05" },
-    { "Jun", "06" },
-    { "Jul", "07" },
-    { "Aug", "08" },
-    { "Sep", "09" },
-    { "Oct", "10" },
-    { "Nov", "11" },
-    { "Dec", "12" }
-};
-
-string TimestampFormatter::getYear(string timestamp) {
-    if(!m_storedTimestamp.empty()) {
-        if(m_storedTimestamp.compare(timestamp) <= 0) {
-            m_storedTimestamp = timestamp;
-            return m_storedYear;
-        }
+void TimestampFormatter::updateYear(const char* timestamp, size_t length) {
+    if(!m_storedTimestamp.empty() && m_storedTimestamp.compare(0, string::npos, timestamp, length) <= 0) {
+        m_storedTimestamp.assign(timestamp, length);
+        return;
     }
     // no last timestamp or year change
     time_t currentTime = time(nullptr);
-    tm* const localTime = localtime(&currentTime);
-    stringstream ss;
-    auto currentYear = 1900 + localTime->tm_year;
-    ss << currentYear; // get current year
-    string year = ss.str();
-    m_storedTimestamp = timestamp;
-    m_storedYear = year;
-    return year;
+    if(currentTime >= m_yearValidUntil) {
+        tm localTime;
+        localtime_r(&currentTime, &localTime);
+        m_currentYear = 1900 + localTime.tm_year;
+        localTime.tm_sec = 0;
+        localTime.tm_min = 0;
+        localTime.tm_hour = 0;
+        localTime.tm_mday++;
+        localTime.tm_isdst = -1;
+        m_yearValidUntil = mktime(&localTime);
+    }
+    char year[16];
+    int yearLength = snprintf(year, sizeof(year), "%d", m_currentYear);
+    m_storedTimestamp.assign(timestamp, length);
+    m_storedYear.assign(year, yearLength);
 }
 
-string TimestampFormatter::changeTimestampFormat(vector<string> dateComponents) {
+/***
+ *
+ * Formats timestamp components Mmm, d or dd and hh:mm:ss.SSSSSS into YYYY-mm-ddThh:mm:ss.SSSSSSZ as needed by YANG model
+ *
+ * @param buffer to write formatted timestamp into, not null terminated
+ * @return length of formatted timestamp, 0 on invalid input
+ *
+ */
+
+size_t TimestampFormatter::formatTimestamp(string_view month, string_view day, string_view time, char* buffer, size_t size) {
+    int monthNum = monthNumber(month);
+    if(monthNum == 0) {
+        SWSS_LOG_ERROR("Timestamp month was given in wrong format.\n");
+        return 0;
+    }
+    if(day.empty() || day.size() > 2) {
+        SWSS_LOG_ERROR("Timestamp day was given in wrong format.\n");
+        return 0;
+    }
+
+    // mmdd followed by time, to detect year change
+    char key[TIMESTAMP_BUFFER_SIZE];
+    size_t keyLength = 4 + time.size();
+    if(keyLength > sizeof(key)) {
+        SWSS_LOG_ERROR("Timestamp time was given in wrong format.\n");
+        return 0;
+    }
+    key[0] = (char)('0' + monthNum / 10);
+    key[1] = (char)('0' + monthNum % 10);
+    key[2] = day.size() == 1 ? '0' : day[0]; // convert 1 -> 01
+    key[3] = day.back();
+    memcpy(key + 4, time.data(), time.size());
+    updateYear(key, keyLength);
+
+    size_t length = m_storedYear.size() + 1 + 2 + 1 + 2 + 1 + time.size() + 1;
+    if(length > size) {
+        SWSS_LOG_ERROR("Timestamp formatter buffer too small.\n");
+        return 0;
+    }
+    char* out = buffer;
+    memcpy(out, m_storedYear.data(), m_storedYear.size());
+    out += m_storedYear.size();
+    *out++ = '-';
+    *out++ = key[0];
+    *out++ = key[1];
+    *out++ = '-';
+    *out++ = key[2];
+    *out++ = key[3];
+    *out++ = 'T';
+    memcpy(out, time.data(), time.size());
+    out += time.size();
+    *out++ = 'Z';
+    return length;
+}
+
+string TimestampFormatter::changeTimestampFormat(const vector<string>& dateComponents) {
     if(dateComponents.size() < 3) {
         SWSS_LOG_ERROR("Timestamp formatter unable to format due to invalid input");
         return "";
     }
-    string formattedTimestamp; // need to change format of Mmm dd hh:mm:ss.SSSSSS to YYYY-mm-ddThh:mm:ss.SSSSSSZ
-    string month;
-    auto it = g_monthDict.find(dateComponents[0]);
-    if(it != g_monthDict.end()) {
-        month = it->second;
-    } else {
-        SWSS_LOG_ERROR("Timestamp month was given in wrong format.\n");
-        return "";
-    }
-    string day = dateComponents[1];
-    if(day.size() == 1) { // convert 1 -> 01
-       day.insert(day.begin(), '0');
-    }
-    string time = dateComponents[2];
-    string currentTimestamp = month + day + time;
-    string year = getYear(currentTimestamp);
-    formattedTimestamp = year + "-" + month + "-" + day + "T" + time + "Z";
-    return formattedTimestamp;
+    char buffer[TIMESTAMP_BUFFER_SIZE];
+    size_t length = formatTimestamp(dateComponents[0], dateComponents[1], dateComponents[2], buffer, sizeof(buffer));
+    return string(buffer, length);
 }
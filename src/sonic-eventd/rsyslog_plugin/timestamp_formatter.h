@@ -3,25 +3,35 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <regex>
 #include <ctime>
 #include <vector>
 
 using namespace std;
 
+#define TIMESTAMP_BUFFER_SIZE 32 // fits YYYY-mm-ddThh:mm:ss.SSSSSSZ with room to spare
+
 /***
  *
  * TimestampFormatter is responsible for formatting the timestamps received in syslog messages and to format them into the type needed by YANG model
  *
+ * formatTimestamp writes into a caller provided buffer and does not allocate once the stored timestamp has reached its size.
+ * The current year is looked up only when a timestamp goes back in time, and then at most once per day.
+ *
  */
 
 class TimestampFormatter {
 public:
-    string changeTimestampFormat(vector<string> dateComponents);
+    TimestampFormatter();
+    size_t formatTimestamp(string_view month, string_view day, string_view time, char* buffer, size_t size);
+    string changeTimestampFormat(const vector<string>& dateComponents);
     string m_storedTimestamp;
     string m_storedYear;
 private:
-    string getYear(string timestamp);
+    void updateYear(const char* timestamp, size_t length);
+    int m_currentYear;
+    time_t m_yearValidUntil; // start of next local day, when current year is to be looked up again
 };
 
 #endif
@@ -8,12 +8,17 @@ extern "C"
 #include <fstream>
 #include <memory>
 #include <regex>
+#include <chrono>
+#include <iomanip>
+#include <thread>
+#include <unistd.h>
 #include "gtest/gtest.h"
 #include <nlohmann/json.hpp>
 #include "events.h"
 #include "../rsyslog_plugin/rsyslog_plugin.h"
 #include "../rsyslog_plugin/syslog_parser.h"
 #include "../rsyslog_plugin/timestamp_formatter.h"
+#include "../rsyslog_plugin/regex_prefilter.h"
 
 using namespace std;
 using namespace swss;
@@ -208,6 +213,114 @@ TEST(syslog_parser, lua_code_valid_2) {
     lua_close(luaState);
 }
 
+TEST(regex_prefilter, requiredLiterals) {
+    EXPECT_EQ(vector<string>({ " %ADJCHANGE: neighbor " }),
+            RegexPrefilter::requiredLiterals(".* %ADJCHANGE: neighbor (.*) (Up|Down) .*"));
+    EXPECT_EQ(vector<string>({ "write failed", "Write protected" }),
+            RegexPrefilter::requiredLiterals("(write failed|Write protected)"));
+    EXPECT_EQ(vector<string>({ "fg" }), RegexPrefilter::requiredLiterals("ab?c*d+e{2}fg"));
+    EXPECT_EQ(vector<string>({ "a/b" }), RegexPrefilter::requiredLiterals("[0-9]+a\\/b\\d"));
+    EXPECT_EQ(vector<string>({ "bar" }), RegexPrefilter::requiredLiterals("fo\\x41bar"));
+    EXPECT_EQ(vector<string>({ "bar" }), RegexPrefilter::requiredLiterals("fo\\u0041bar"));
+    EXPECT_EQ(vector<string>({ "bar" }), RegexPrefilter::requiredLiterals("fo\\x41?bar"));
+    EXPECT_EQ(vector<string>({ "bar" }), RegexPrefilter::requiredLiterals("fo\\cJbar"));
+    EXPECT_TRUE(RegexPrefilter::requiredLiterals(".*").empty());
+    EXPECT_TRUE(RegexPrefilter::requiredLiterals("abc|def").empty());
+    EXPECT_TRUE(RegexPrefilter::requiredLiterals("(abc)?").empty());
+}
+
+TEST(regex_prefilter, match) {
+    RegexPrefilter prefilter;
+    vector<uint8_t> candidates;
+
+    prefilter.build({ "neighbor (.*) (Up|Down)", "(write failed|Write protected)", ".*", "abcd" });
+    EXPECT_EQ(4, (int)prefilter.size());
+
+    prefilter.match("Aug 17 02:39:21 bgpd: neighbor 10.0.0.1 Up", candidates);
+    EXPECT_EQ(vector<uint8_t>({ 1, 0, 1, 0 }), candidates);
+
+    prefilter.match("kernel: Write protected", candidates);
+    EXPECT_EQ(vector<uint8_t>({ 0, 1, 1, 0 }), candidates);
+
+    prefilter.match("xxabcabcdxx", candidates);
+    EXPECT_EQ(vector<uint8_t>({ 0, 0, 1, 1 }), candidates);
+}
+
+vector<RegexStruct> loadRegexList(const string& path) {
+    ifstream regexFile(path);
+    json jsonList = json::array();
+    vector<RegexStruct> regexList;
+    string timestampRegex = "^([a-zA-Z]{3})?\\s*([0-9]{1,2})?\\s*([0-9]{2}:[0-9]{2}:[0-9]{2}.[0-9]{0,6})?\\s*";
+    vector<string> timestampParams = { "month", "day", "time" };
+
+    regexFile >> jsonList;
+    for(long unsigned int i = 0; i < jsonList.size(); i++) {
+        RegexStruct rs = RegexStruct();
+        vector<string> params = jsonList[i]["params"];
+        vector<string> luaCodes;
+
+        params.insert(params.begin(), timestampParams.begin(), timestampParams.end());
+        for(auto& param : params) {
+            auto delimPos = param.find(':');
+            luaCodes.push_back(delimPos == string::npos ? "" : param.substr(delimPos + 1));
+            param = param.substr(0, delimPos);
+        }
+        rs.tag = jsonList[i]["tag"];
+        rs.eventRegex = jsonList[i]["regex"];
+        rs.regexExpression = regex(timestampRegex + rs.eventRegex);
+        rs.params = createEventParams(params, luaCodes);
+        regexList.push_back(rs);
+    }
+    return regexList;
+}
+
+TEST(syslog_parser, benchmark) {
+    const int iterations = 2000;
+    vector<RegexStruct> regexList = loadRegexList("./rsyslog_plugin_tests/test_regex_6.rc.json");
+    ifstream infile("./rsyslog_plugin_tests/test_syslogs.txt");
+    vector<string> logMessages;
+    string logMessage;
+    bool parseResult;
+
+    while(infile >> quoted(logMessage) >> boolalpha >> parseResult) {
+        logMessages.push_back(logMessage);
+    }
+    ASSERT_FALSE(logMessages.empty());
+
+    SyslogParser sequential;
+    SyslogParser prefiltered;
+    sequential.m_regexList = regexList;
+    prefiltered.setRegexList(regexList);
+
+    lua_State* luaState = luaL_newstate();
+    luaL_openlibs(luaState);
+
+    double linesPerSec[2];
+    vector<string> tags[2];
+    SyslogParser* parsers[2] = { &sequential, &prefiltered };
+    for(int p = 0; p < 2; p++) {
+        auto start = chrono::steady_clock::now();
+        for(int i = 0; i < iterations; i++) {
+            for(const auto& message : logMessages) {
+                string tag;
+                event_params_t paramDict;
+                parsers[p]->parseMessage(message, tag, paramDict, luaState);
+                if(i == 0) {
+                    tags[p].push_back(tag);
+                }
+            }
+        }
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        linesPerSec[p] = (iterations * logMessages.size()) / elapsed.count();
+    }
+    lua_close(luaState);
+
+    cout << "Parsed " << iterations * logMessages.size() << " lines against " << regexList.size()
+        << " regexes: sequential " << (long)linesPerSec[0] << " lines/sec, prefiltered "
+        << (long)linesPerSec[1] << " lines/sec" << endl;
+    EXPECT_EQ(tags[0], tags[1]);
+}
+
 TEST(rsyslog_plugin, onInit_emptyJSON) {
     unique_ptr<RsyslogPlugin> plugin(new RsyslogPlugin("test_mod_name", "./rsyslog_plugin_tests/test_regex_1.rc.json"));
     EXPECT_NE(0, plugin->onInit());
@@ -223,6 +336,67 @@ TEST(rsyslog_plugin, onInit_invalidRegex) {
     EXPECT_NE(0, plugin->onInit());
 }
 
+TEST(rsyslog_plugin, onInit_invalidLuaCode) {
+    // invalid lua code of a param is logged at load, the regex is still used
+    unique_ptr<RsyslogPlugin> plugin(new RsyslogPlugin("test_mod_name", "./rsyslog_plugin_tests/test_regex_7.rc.json"));
+    EXPECT_EQ(0, plugin->onInit());
+    lua_State* luaState = luaL_newstate();
+    luaL_openlibs(luaState);
+    EXPECT_TRUE(plugin->onMessage("Aug 17 02:39:21.286611 SN6-0101-0114-02T0 INFO bgp#bgpd[62]: %ADJCHANGE: neighbor 100.126.188.90 Down Neighbor deleted", luaState));
+    lua_close(luaState);
+}
+
+TEST(syslog_parser, lua_code_compile) {
+    vector<RegexStruct> regexList;
+    string regexString = "^([a-zA-Z]{3})?\\s*([0-9]{1,2})?\\s*([0-9]{2}:[0-9]{2}:[0-9]{2}.[0-9]{0,6})?\\s*state (.*) code (.*)";
+    vector<string> params = { "month", "day", "time", "state", "code" };
+    vector<string> luaCodes = { "", "", "", "ret=string.upper(arg)", "ret=tostring(tonumber(arg) + 1)" };
+
+    RegexStruct rs = RegexStruct();
+    rs.tag = "test_tag";
+    rs.regexExpression = regex(regexString);
+    rs.params = createEventParams(params, luaCodes);
+    regexList.push_back(rs);
+
+    unique_ptr<SyslogParser> parser(new SyslogParser());
+    parser->setRegexList(regexList);
+    lua_State* luaState = luaL_newstate();
+    luaL_openlibs(luaState);
+    EXPECT_TRUE(parser->compileLuaCode(luaState));
+
+    event_params_t expectedDict;
+    expectedDict["state"] = "UP";
+    expectedDict["code"] = "8";
+
+    for(int i = 0; i < 3; i++) { // compiled once, run repeatedly
+        string tag;
+        event_params_t paramDict;
+        EXPECT_TRUE(parser->parseMessage("state up code 7", tag, paramDict, luaState));
+        EXPECT_EQ(expectedDict, paramDict);
+    }
+    EXPECT_EQ(0, lua_gettop(luaState));
+
+    // a line is parsed in place as a view, without the rest of the block
+    string block = "state up code 7\nstate down code 9";
+    {
+        string tag;
+        event_params_t paramDict;
+        EXPECT_TRUE(parser->parseMessage(string_view(block.data(), block.find('\n')), tag, paramDict, luaState));
+        EXPECT_EQ(expectedDict, paramDict);
+    }
+
+    // invalid lua code fails compile; captured value is used as is
+    regexList[0].params[4].luaCode = "ret=(arg==";
+    parser->setRegexList(regexList);
+    EXPECT_FALSE(parser->compileLuaCode(luaState));
+    string tag;
+    event_params_t paramDict;
+    EXPECT_TRUE(parser->parseMessage("state up code 7", tag, paramDict, luaState));
+    EXPECT_EQ("7", paramDict["code"]);
+
+    lua_close(luaState);
+}
+
 TEST(rsyslog_plugin, onMessage) {
     unique_ptr<RsyslogPlugin> plugin(new RsyslogPlugin("test_mod_name", "./rsyslog_plugin_tests/test_regex_2.rc.json"));
     EXPECT_EQ(0, plugin->onInit());
@@ -253,6 +427,37 @@ TEST(rsyslog_plugin, onMessage_noParams) {
     infile.close();
 }
 
+TEST(rsyslog_plugin, run) {
+    unique_ptr<RsyslogPlugin> plugin(new RsyslogPlugin("test_mod_name", "./rsyslog_plugin_tests/test_regex_2.rc.json"));
+    EXPECT_EQ(0, plugin->onInit());
+    vector<string> lines = {
+        "Aug 17 02:39:21.286611 SN6-0101-0114-02T0 INFO bgp#bgpd[62]: %ADJCHANGE: neighbor 100.126.188.90 Down Neighbor deleted",
+        "Aug 17 02:46:42.615668 SN6-0101-0114-02T0 INFO bgp#bgpd[62]: %ADJCHANGE: neighbor 100.126.188.90 Up",
+        "Aug 17 04:46:51.290979 SN6-0101-0114-02T0 INFO bgp#bgpd[62]: %NOEVENT: no event",
+        ""
+    };
+    const int repeat = 1000;
+    int pipeFd[2];
+    ASSERT_EQ(0, pipe(pipeFd));
+
+    thread writer([&]() {
+        for(int i = 0; i < repeat; i++) {
+            for(const auto& line : lines) {
+                string data = line + "\n";
+                EXPECT_EQ((ssize_t)data.size(), write(pipeFd[1], data.data(), data.size()));
+            }
+        }
+        close(pipeFd[1]);
+    });
+    plugin->run(pipeFd[0]); // returns at EOF
+    writer.join();
+    close(pipeFd[0]);
+
+    EXPECT_EQ(0u, plugin->droppedLines());
+    EXPECT_EQ(3u * repeat, plugin->parsedLines());
+    EXPECT_EQ(2u * repeat, plugin->matchedLines());
+}
+
 TEST(timestampFormatter, changeTimestampFormat) {
     unique_ptr<TimestampFormatter> formatter(new TimestampFormatter());
 
@@ -284,6 +489,26 @@ TEST(timestampFormatter, changeTimestampFormat) {
     EXPECT_EQ("2025-12-31T23:59:59.000000Z", formattedTimestampThree);
 }
 
+TEST(timestampFormatter, formatTimestamp) {
+    unique_ptr<TimestampFormatter> formatter(new TimestampFormatter());
+    char buffer[TIMESTAMP_BUFFER_SIZE];
+    const char* months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+    for(int i = 0; i < 12; i++) {
+        formatter->m_storedTimestamp = "010100:00:00.000000";
+        formatter->m_storedYear = "2025";
+        size_t length = formatter->formatTimestamp(months[i], "5", "10:09:40.230874", buffer, sizeof(buffer));
+        char expected[TIMESTAMP_BUFFER_SIZE];
+        snprintf(expected, sizeof(expected), "2025-%02d-05T10:09:40.230874Z", i + 1);
+        EXPECT_EQ(string(expected), string(buffer, length));
+    }
+
+    EXPECT_EQ(0u, formatter->formatTimestamp("Foo", "5", "10:09:40.230874", buffer, sizeof(buffer)));
+    EXPECT_EQ(0u, formatter->formatTimestamp("jan", "5", "10:09:40.230874", buffer, sizeof(buffer)));
+    EXPECT_EQ(0u, formatter->formatTimestamp("Jan", "", "10:09:40.230874", buffer, sizeof(buffer)));
+    EXPECT_EQ(0u, formatter->formatTimestamp("Jan", "5", "10:09:40.230874", buffer, 10));
+}
+
 int main(int argc, char* argv[]) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -1,4 +1,5 @@
 #include <thread>
+#include <cstring>
 #include "eventd.h"
 #include "dbconnector.h"
 #include "zmq.h"
@@ -15,11 +16,13 @@
  *
  * (2) Main proxy service that runs XSUB/XPUB ends
  *
- * (3) Get stats for total published counter in memory. This thread also sends
- *     heartbeat message. It accomplishes by counting upon receive missed due
- *     to event receive timeout.
+ * (3) Get stats for total published counter in memory, along with published,
+ *     dropped & latency per source. This thread also sends heartbeat message.
+ *     It accomplishes by counting upon receive missed due to event receive
+ *     timeout.
  *
- * (4) Thread to update counters from memory to redis periodically.
+ * (4) Thread to update counters from memory to redis. It blocks until
+ *     an update and writes all counters in one pipelined batch.
  *
  */
 
@@ -31,9 +34,6 @@ using namespace swss;
 
 #define MAX_CACHE_SIZE (MB(100) / (EVT_SIZE_AVG))
 
-/* Count of elements returned in each read */
-#define READ_SET_SIZE 100
-
 #define VEC_SIZE(p) ((int)p.size())
 
 /* Sock read timeout in milliseconds, to enable look for control signals */
@@ -95,18 +95,135 @@ eventd_proxy::run()
 }
 
 
+/* Upper bounds of latency buckets in milliseconds */
+static const int64_t latency_bounds[LATENCY_BUCKETS_TOTAL - 1] = {
+    1, 10, 100, 1000
+};
+
+
 stats_collector::stats_collector() :
-    m_shutdown(false), m_pause_heartbeat(false), m_heartbeats_published(0),
-    m_heartbeats_interval_cnt(0)
+    m_last_source_stats(NULL), m_shutdown(false), m_pause_heartbeat(false),
+    m_heartbeats_published(0), m_heartbeats_interval_cnt(0)
 {
     set_heartbeat_interval(HEARTBEAT_INTERVAL_SECS);
-    for (int i=0; i < COUNTERS_EVENTS_TOTAL; ++i) {
-        m_lst_counters[i] = 0;
+    for (int s=0; s < STATS_SHARDS; ++s) {
+        for (int i=0; i < COUNTERS_EVENTS_TOTAL; ++i) {
+            m_lst_counters[s][i].val = 0;
+        }
     }
+    m_shards_used = 0;
     m_updated = false;
 }
 
 
+int
+stats_collector::get_shard()
+{
+    /*
+     * Assigned upon first update from a thread, per collector, as
+     * each collector spreads its own updating threads over its shards.
+     * Last collector is cached as a thread mostly updates only one.
+     */
+    static thread_local map<const stats_collector *, int> shards;
+    static thread_local const stats_collector *last = NULL;
+    static thread_local int last_shard = 0;
+
+    if (last != this) {
+        auto itc = shards.find(this);
+        if (itc == shards.end()) {
+            itc = shards.emplace(this, m_shards_used.fetch_add(1) % STATS_SHARDS).first;
+        }
+        last = this;
+        last_shard = itc->second;
+    }
+    return last_shard;
+}
+
+
+source_stats_t *
+stats_collector::get_source_stats(const string_view &source)
+{
+    source_stats_t *ret = NULL;
+
+    if ((m_last_source_stats != NULL) && (m_last_source == source)) {
+        return m_last_source_stats;
+    }
+
+    {
+        lock_guard<mutex> lock(m_mutex_sources);
+
+        auto it = m_source_stats.find(source);
+        if (it != m_source_stats.end()) {
+            ret = it->second.get();
+        }
+        else if (m_source_stats.size() < STATS_SOURCES_MAX) {
+            /* value initialized, hence all counters are zero */
+            ret = new source_stats_t();
+            m_source_stats.emplace(string(source), unique_ptr<source_stats_t>(ret));
+        }
+        else {
+            SWSS_LOG_DEBUG("Source stats at max=%d; skip %s",
+                    STATS_SOURCES_MAX, string(source).c_str());
+            return NULL;
+        }
+    }
+    m_last_source = source;
+    m_last_source_stats = ret;
+    return ret;
+}
+
+
+void
+stats_collector::update_source_stats(const string &key, counters_t missed_cnt,
+        int64_t publish_epoch_ms)
+{
+    /* key is <source>:<tag> */
+    string_view source(key);
+    source_stats_t *stats;
+    int64_t latency;
+    int i;
+
+    source = source.substr(0, source.find(':'));
+
+    stats = get_source_stats(source);
+    if (stats == NULL) {
+        return;
+    }
+
+    stats->published.fetch_add(1 + missed_cnt, memory_order_relaxed);
+    if (missed_cnt != 0) {
+        stats->dropped.fetch_add(missed_cnt, memory_order_relaxed);
+    }
+
+    latency = duration_cast<milliseconds>(
+            system_clock::now().time_since_epoch()).count() - publish_epoch_ms;
+    for (i = 0; (i < (int)ARRAY_SIZE(latency_bounds)) &&
+            (latency > latency_bounds[i]); ++i);
+    stats->latency[i].fetch_add(1, memory_order_relaxed);
+
+    _mark_updated();
+}
+
+
+bool
+stats_collector::read_source_stats(const string &source,
+        source_stats_snapshot_t &stats)
+{
+    lock_guard<mutex> lock(m_mutex_sources);
+
+    auto it = m_source_stats.find(source);
+    if (it == m_source_stats.end()) {
+        return false;
+    }
+    stats.published = it->second->published.load(memory_order_relaxed);
+    stats.dropped = it->second->dropped.load(memory_order_relaxed);
+    for (int i = 0; i < LATENCY_BUCKETS_TOTAL; ++i) {
+        stats.latency[i] = it->second->latency[i].load(memory_order_relaxed);
+    }
+    return true;
+}
+
+
 void
 stats_collector::set_heartbeat_interval(int val)
 {
@@ -153,8 +270,12 @@ stats_collector::start()
         }
         RET_ON_ERR(m_counters_db != NULL, "Failed to get COUNTERS_DB");
 
+        /* Buffered table, so all counters are written in one pipelined batch */
+        m_stats_pipeline = make_shared<swss::RedisPipeline>(m_counters_db.get());
+        RET_ON_ERR(m_stats_pipeline != NULL, "Failed to get redis pipeline");
+
         m_stats_table = make_shared<swss::Table>(
-                m_counters_db.get(), COUNTERS_EVENTS_TABLE);
+                m_stats_pipeline.get(), COUNTERS_EVENTS_TABLE, true);
         RET_ON_ERR(m_stats_table != NULL, "Failed to get events table");
 
         m_thr_writer = thread(&stats_collector::run_writer, this);
@@ -165,33 +286,93 @@ out:
     return rc;
 }
 
+void
+stats_collector::write_stats()
+{
+    for (int i = 0; i < COUNTERS_EVENTS_TOTAL; ++i) {
+        vector<FieldValueTuple> fv;
+
+        fv.emplace_back(EVENTS_STATS_FIELD_NAME,
+                to_string(read_counter((stats_counter_index_t)i)));
+
+        m_stats_table->set(counter_keys[i], fv);
+    }
+
+    {
+        lock_guard<mutex> lock(m_mutex_sources);
+
+        for (source_stats_map_t::const_iterator itc = m_source_stats.begin();
+                itc != m_source_stats.end(); ++itc) {
+            const source_stats_t *stats = itc->second.get();
+            vector<FieldValueTuple> fv;
+            int i;
+
+            fv.emplace_back(STATS_FIELD_PUBLISHED, to_string(stats->published.load()));
+            fv.emplace_back(STATS_FIELD_DROPPED, to_string(stats->dropped.load()));
+            for (i = 0; i < (int)ARRAY_SIZE(latency_bounds); ++i) {
+                fv.emplace_back(STATS_FIELD_LATENCY_PREFIX + to_string(latency_bounds[i]),
+                        to_string(stats->latency[i].load()));
+            }
+            fv.emplace_back(STATS_FIELD_LATENCY_OVER, to_string(stats->latency[i].load()));
+
+            m_stats_table->set(itc->first, fv);
+        }
+    }
+
+    /* Write all in one batch */
+    m_stats_table->flush();
+}
+
+
 void
 stats_collector::run_writer()
 {
+    int flush_ms = STATS_FLUSH_MIN_MS;
+
     while (true) {
-        if (m_updated.exchange(false)) {
-            /* Update if there had been any update */
+        bool updated;
+
+        {
+            /*
+             * Block until an update. As updaters notify w/o taking the lock,
+             * a notify could be missed; wait timeout bounds the delay.
+             */
+            unique_lock<mutex> lock(m_mutex_updated);
+            updated = m_cv_updated.wait_for(lock, chrono::milliseconds(STATS_FLUSH_MAX_MS),
+                    [this] { return m_updated || m_shutdown; });
+        }
 
-            for (int i = 0; i < COUNTERS_EVENTS_TOTAL; ++i) {
-                vector<FieldValueTuple> fv;
+        if (!updated) {
+            /* Idle; Flush the next update with least delay */
+            flush_ms = STATS_FLUSH_MIN_MS;
+            continue;
+        }
 
-                fv.emplace_back(EVENTS_STATS_FIELD_NAME, to_string(m_lst_counters[i]));
+        if (!m_shutdown) {
+            /*
+             * Coalesce updates before flush. As long as updates keep coming,
+             * back off to flush less often.
+             */
+            unique_lock<mutex> lock(m_mutex_updated);
+            m_cv_updated.wait_for(lock, chrono::milliseconds(flush_ms),
+                    [this] { return m_shutdown.load(); });
+            flush_ms = min(flush_ms * 2, STATS_FLUSH_MAX_MS);
+        }
 
-                m_stats_table->set(counter_keys[i], fv);
-            }
+        /*
+         * Always do an update if needed before checking shutdown flag,
+         * as any counters collected during wait needs to be updated.
+         */
+        if (m_updated.exchange(false)) {
+            write_stats();
         }
         if (m_shutdown) {
             break;
         }
-        this_thread::sleep_for(chrono::milliseconds(10));
-        /*
-         * After sleep always do an update if needed before checking
-         * shutdown flag, as any counters collected during sleep
-         * needs to be updated.
-         */
     }
 
     m_stats_table.reset();
+    m_stats_pipeline.reset();
     m_counters_db.reset();
 }
 
@@ -246,6 +427,7 @@ stats_collector::run_collector()
         if ((rc == 0) && (op.key != hb_key)) {
             /* TODO: Discount EVENT_STR_CTRL_DEINIT messages too */
             increment_published(1+op.missed_cnt);
+            update_source_stats(op.key, op.missed_cnt, op.publish_epoch_ms);
 
             /* reset counter on receive to restart. */
             hb_cntr = 0;
@@ -254,7 +436,7 @@ stats_collector::run_collector()
             if (rc < 0) {
                 SWSS_LOG_ERROR(
                         "event_receive failed with rc=%d; stats:published(%lu)", rc,
-                        m_lst_counters[INDEX_COUNTERS_EVENTS_PUBLISHED]);
+                        read_counter(INDEX_COUNTERS_EVENTS_PUBLISHED));
             }
             if (!m_pause_heartbeat && (m_heartbeats_interval_cnt > 0) &&
                     ++hb_cntr >= m_heartbeats_interval_cnt) {
@@ -320,6 +502,262 @@ validate_event(const internal_event_t &event, runtime_id_t &rid, sequence_t &seq
 }
 
 
+uint32_t
+event_cache::get_rid_index(const string_view &rid)
+{
+    /* Consecutive events are most likely from same publisher */
+    if (!m_index.empty()) {
+        uint32_t last = m_index.back().rid;
+        if (m_rids[last] == rid) {
+            return last;
+        }
+    }
+
+    auto it = m_rid_ids.find(rid);
+    if (it != m_rid_ids.end()) {
+        return it->second;
+    }
+    uint32_t id = (uint32_t)m_rids.size();
+    m_rids.emplace_back(rid);
+    m_rid_ids.emplace(m_rids.back(), id);
+    return id;
+}
+
+
+bool
+event_cache::add(const char *data, size_t len, const string_view &rid,
+        sequence_t seq)
+{
+    if (size() >= m_max_cnt) {
+        return false;
+    }
+
+    if (m_slabs.empty() || ((m_slab_sizes.back() - m_slab_used) < len)) {
+        /* Start a new slab; Remaining space in current one is left unused. */
+        size_t sz = len > CACHE_SLAB_SIZE ? len : CACHE_SLAB_SIZE;
+
+        if ((m_alloc_bytes + sz) > m_max_bytes) {
+            if ((m_alloc_bytes + len) > m_max_bytes) {
+                return false;
+            }
+            /* Last slab trimmed to fit within max bytes */
+            sz = m_max_bytes - m_alloc_bytes;
+        }
+        m_slabs.emplace_back(new char[sz]);
+        m_slab_sizes.push_back(sz);
+        m_alloc_bytes += sz;
+        m_slab_used = 0;
+    }
+
+    memcpy(m_slabs.back().get() + m_slab_used, data, len);
+
+    cache_index_t e = { (uint32_t)(m_slabs.size() - 1), (uint32_t)m_slab_used,
+        (uint32_t)len, get_rid_index(rid), seq };
+    m_index.push_back(e);
+    m_slab_used += len;
+    return true;
+}
+
+
+void
+event_cache::release(int cnt)
+{
+    size_t last = (cnt < size()) ? m_index[cnt].slab : m_slabs.size();
+
+    for (; m_released_slabs < last; ++m_released_slabs) {
+        m_slabs[m_released_slabs].reset();
+        m_alloc_bytes -= m_slab_sizes[m_released_slabs];
+        m_slab_sizes[m_released_slabs] = 0;
+    }
+}
+
+
+void
+event_cache::clear()
+{
+    event_cache(m_max_cnt, m_max_bytes).swap(*this);
+}
+
+
+void
+event_cache::swap(event_cache &other)
+{
+    std::swap(m_max_cnt, other.m_max_cnt);
+    std::swap(m_max_bytes, other.m_max_bytes);
+    m_slabs.swap(other.m_slabs);
+    m_slab_sizes.swap(other.m_slab_sizes);
+    std::swap(m_slab_used, other.m_slab_used);
+    std::swap(m_alloc_bytes, other.m_alloc_bytes);
+    std::swap(m_released_slabs, other.m_released_slabs);
+    m_index.swap(other.m_index);
+    m_rids.swap(other.m_rids);
+    m_rid_ids.swap(other.m_rid_ids);
+}
+
+
+/* Skip spaces & read an unsigned decimal */
+static bool
+scan_uint(const char *&p, const char *end, uint64_t &val)
+{
+    while ((p < end) && (*p == ' ')) {
+        ++p;
+    }
+    if ((p == end) || !isdigit((unsigned char)*p)) {
+        return false;
+    }
+    for (val = 0; (p < end) && isdigit((unsigned char)*p); ++p) {
+        val = (val * 10) + (*p - '0');
+    }
+    return true;
+}
+
+
+/* Read a string saved as "<len> <bytes>" */
+static bool
+scan_str(const char *&p, const char *end, string_view &str)
+{
+    uint64_t len;
+
+    if (!scan_uint(p, end, len) || (p == end) || (*p != ' ') ||
+            ((uint64_t)(end - p - 1) < len)) {
+        return false;
+    }
+    str = string_view(p + 1, len);
+    p += len + 1;
+    return true;
+}
+
+
+/*
+ * The serialized event is boost text archive of internal_event_t, as
+ *  "22 serialization::archive <lib ver> <tracking> <ver> <cnt> <item ver>
+ *   <pair tracking> <pair ver>" followed by cnt pairs of key & value.
+ *
+ * Any mismatch fails the scan, and caller could fall back to deserialize.
+ */
+bool
+scan_event(const char *data, size_t len, string_view &rid, sequence_t &seq)
+{
+    const char *p = data, *end = data + len;
+    string_view sig, key, val;
+    uint64_t lib_ver, cnt, tmp;
+    bool rid_found = false, seq_found = false, data_found = false;
+
+    if (!scan_str(p, end, sig) || (sig != "serialization::archive") ||
+            !scan_uint(p, end, lib_ver) ||
+            !scan_uint(p, end, tmp) || !scan_uint(p, end, tmp) ||
+            !scan_uint(p, end, cnt)) {
+        return false;
+    }
+    if ((lib_ver > 3) && !scan_uint(p, end, tmp)) {
+        return false;
+    }
+    if ((cnt > 0) && (!scan_uint(p, end, tmp) || !scan_uint(p, end, tmp))) {
+        return false;
+    }
+
+    for (uint64_t i = 0; i < cnt; ++i) {
+        if (!scan_str(p, end, key) || !scan_str(p, end, val)) {
+            return false;
+        }
+        if (key == EVENT_RUNTIME_ID) {
+            rid = val;
+            rid_found = true;
+        }
+        else if (key == EVENT_SEQUENCE) {
+            const char *q = val.data();
+            uint64_t s;
+
+            if (!scan_uint(q, val.data() + val.size(), s)) {
+                return false;
+            }
+            seq = (sequence_t)s;
+            seq_found = true;
+        }
+        else if (key == EVENT_STR_DATA) {
+            data_found = true;
+        }
+    }
+
+    /* Only trailing white space is expected */
+    for (; p < end; ++p) {
+        if (!isspace(*p)) {
+            return false;
+        }
+    }
+    return rid_found && seq_found && data_found;
+}
+
+
+/*
+ * Get runtime id & sequence of serialized event.
+ * Scans the bytes and falls back to deserialize only if scan fails.
+ * rid_buf holds the runtime id, when deserialized.
+ */
+static bool
+parse_event(const char *data, size_t len, string_view &rid, sequence_t &seq,
+        runtime_id_t &rid_buf)
+{
+    internal_event_t event;
+
+    if (scan_event(data, len, rid, seq)) {
+        return true;
+    }
+    if ((deserialize(string(data, len), event) != 0) ||
+            !validate_event(event, rid_buf, seq)) {
+        return false;
+    }
+    rid = rid_buf;
+    return true;
+}
+
+
+/*
+ * Read an event from capture socket as raw bytes, w/o deserializing.
+ * Each event is 2 parts. First part is the source, which is dropped.
+ * Upon success, caller owns msg with second part.
+ *
+ * Returns 0 on success, EAGAIN on timeout & ERR_MESSAGE_INVALID when
+ * message is not in 2 parts.
+ */
+static int
+read_raw_event(void *sock, zmq_msg_t &msg)
+{
+    int rc, more;
+    zmq_msg_t part;
+
+    zmq_msg_init(&part);
+    rc = zmq_msg_recv(&part, sock, 0);
+    more = zmq_msg_more(&part);
+    zmq_msg_close(&part);
+
+    if (rc == -1) {
+        return zmq_errno();
+    }
+    if (!more) {
+        /* e.g. subscription requests are captured too */
+        return ERR_MESSAGE_INVALID;
+    }
+
+    rc = zmq_msg_recv(&msg, sock, 0);
+    if (rc == -1) {
+        return zmq_errno();
+    }
+
+    if (zmq_msg_more(&msg)) {
+        /* Drain any unexpected parts */
+        do {
+            zmq_msg_init(&part);
+            rc = zmq_msg_recv(&part, sock, 0);
+            more = (rc != -1) && zmq_msg_more(&part);
+            zmq_msg_close(&part);
+        } while (more);
+        return ERR_MESSAGE_INVALID;
+    }
+    return 0;
+}
+
+
 /*
  * Initialize cache with set of events provided.
  * Events read by cache service will be appended
@@ -333,15 +771,16 @@ capture_service::init_capture_cache(const event_serialized_lst_t &lst)
      * No check for max cache size here, as most likely not needed.
      */
     for (event_serialized_lst_t::const_iterator itc = lst.begin(); itc != lst.end(); ++itc) {
-        internal_event_t event;
-
-        if (deserialize(*itc, event) == 0) {
-            runtime_id_t rid;
-            sequence_t seq;
+        string_view rid;
+        runtime_id_t rid_buf;
+        sequence_t seq;
 
-            if (validate_event(event, rid, seq)) {
-                m_pre_exist_id[rid] = seq;
-                m_events.push_back(*itc);
+        if (parse_event(itc->data(), itc->size(), rid, seq, rid_buf)) {
+            m_pre_exist_id[runtime_id_t(rid)] = seq;
+            if (!m_events.add(*itc, rid, seq)) {
+                SWSS_LOG_ERROR("Init cache exceeds limits events:size=%d bytes=%zu",
+                        m_events.size(), m_events.bytes());
+                break;
             }
         }
     }
@@ -355,6 +794,7 @@ capture_service::do_capture()
     int block_ms=CAPTURE_SOCK_TIMEOUT;
     int init_cnt;
     void *cap_sub_sock = NULL;
+    zmq_msg_t msg;
     counters_t total_overflow = 0;
     static bool init_done = false;
 
@@ -374,6 +814,8 @@ capture_service::do_capture()
 
     cap_state_t cap_state = CAP_STATE_INIT;
 
+    zmq_msg_init(&msg);
+
     /*
      * Need subscription for publishers to publish.
      * The stats collector service already has active subscriber for all.
@@ -430,30 +872,35 @@ capture_service::do_capture()
      * Hence until as many events as in initial stock or until the cached id map
      * is empty, do this check.
      */
-    init_cnt = (int)m_events.size();
+    init_cnt = m_events.size();
 
     /* Read until STOP_CAPTURE */
     while(m_ctrl == START_CAPTURE) {
-        runtime_id_t rid;
+        string_view rid;
+        runtime_id_t rid_buf;
         sequence_t seq;
-        internal_event_t event;
-        string source, evt_str;
+        const char *evt_data;
+        size_t evt_len;
 
-        if ((rc = zmq_message_read(cap_sub_sock, 0, source, event)) != 0) {
+        zmq_msg_close(&msg);
+        zmq_msg_init(&msg);
+
+        if ((rc = read_raw_event(cap_sub_sock, msg)) != 0) {
             /*
              * The capture socket captures SUBSCRIBE requests too.
              * The messge could contain subscribe filter strings and binary code.
-             * Empty string with binary code will fail to deserialize.
-             * Else would fail event validation.
+             * These are single part and hence fail as invalid.
              */
             RET_ON_ERR((rc == EAGAIN) || (rc == ERR_MESSAGE_INVALID),
                 "0:Failed to read from capture socket");
             continue;
         }
-        if (!validate_event(event, rid, seq)) {
+        evt_data = (const char *)zmq_msg_data(&msg);
+        evt_len = zmq_msg_size(&msg);
+
+        if (!parse_event(evt_data, evt_len, rid, seq, rid_buf)) {
             continue;
         }
-        serialize(event, evt_str);
 
         switch(cap_state) {
         case CAP_STATE_INIT:
@@ -467,7 +914,7 @@ capture_service::do_capture()
             {
                 bool add = true;
                 init_cnt--;
-                pre_exist_id_t::iterator it = m_pre_exist_id.find(rid);
+                pre_exist_id_t::iterator it = m_pre_exist_id.find(runtime_id_t(rid));
 
                 if (it != m_pre_exist_id.end()) {
                     if (seq <= it->second) {
@@ -480,7 +927,7 @@ capture_service::do_capture()
                     }
                 }
                 if (add) {
-                    m_events.push_back(evt_str);
+                    m_events.add(evt_data, evt_len, rid, seq);
                 }
             }
             if(m_pre_exist_id.empty() || (init_cnt <= 0)) {
@@ -494,28 +941,33 @@ capture_service::do_capture()
             /* Save until max allowed */
             try
             {
-                m_events.push_back(evt_str);
-                if (VEC_SIZE(m_events) >= m_cache_max) {
-                    cap_state = CAP_STATE_LAST;
-                    /* Clear the map, created to ensure memory space available */
-                    m_last_events.clear();
-                    m_last_events_init = true;
+                if (m_events.add(evt_data, evt_len, rid, seq)) {
+                    if (m_events.is_full()) {
+                        cap_state = CAP_STATE_LAST;
+                        /* Clear the map, created to ensure memory space available */
+                        m_last_events.clear();
+                        m_last_events_init = true;
+                    }
+                    break;
                 }
-                break;
+                SWSS_LOG_INFO("Cache full events:size=%d bytes=%zu",
+                        m_events.size(), m_events.bytes());
             }
             catch (bad_alloc& e)
             {
                 stringstream ss;
                 ss << e.what();
                 SWSS_LOG_ERROR("Cache save event failed with %s events:size=%d",
-                        ss.str().c_str(), VEC_SIZE(m_events));
-                cap_state = CAP_STATE_LAST;
-                // fall through to save this event in last set.
+                        ss.str().c_str(), m_events.size());
             }
+            cap_state = CAP_STATE_LAST;
+            m_last_events.clear();
+            m_last_events_init = true;
+            // fall through to save this event in last set.
 
         case CAP_STATE_LAST:
             total_overflow++;
-            m_last_events[rid] = evt_str;
+            m_last_events[runtime_id_t(rid)] = event_serialized_t(evt_data, evt_len);
             if (total_overflow > m_last_events.size()) {
                 m_total_missed_cache++;
                 m_stats_instance->increment_missed_cache(1);
@@ -529,6 +981,7 @@ out:
      * Capture stop will close the socket which fail the read
      * and hence bail out.
      */
+    zmq_msg_close(&msg);
     zmq_close(cap_sub_sock);
     m_cap_run = false;
     return;
@@ -598,18 +1051,144 @@ int
 capture_service::read_cache(event_serialized_lst_t &lst_fifo,
         last_events_t &lst_last, counters_t &overflow_cnt)
 {
-    lst_fifo.swap(m_events);
+    event_serialized_lst_t().swap(lst_fifo);
+    lst_fifo.reserve(m_events.size());
+    for (int i = 0; i < m_events.size(); ++i) {
+        lst_fifo.emplace_back(m_events.get(i));
+    }
     if (m_last_events_init) {
         lst_last.swap(m_last_events);
     } else {
         last_events_t().swap(lst_last);
     }
     last_events_t().swap(m_last_events);
-    event_serialized_lst_t().swap(m_events);
+    m_events.clear();
     overflow_cnt = m_total_missed_cache;
     return 0;
 }
 
+int
+capture_service::read_cache(event_cache &cache, last_events_t &lst_last,
+        counters_t &overflow_cnt)
+{
+    cache.swap(m_events);
+    if (m_last_events_init) {
+        lst_last.swap(m_last_events);
+    } else {
+        last_events_t().swap(lst_last);
+    }
+    last_events_t().swap(m_last_events);
+    m_events.clear();
+    overflow_cnt = m_total_missed_cache;
+    return 0;
+}
+
+
+void
+cache_reader::reset(event_cache &cache, last_events_t &lst_last)
+{
+    clear();
+    m_events.swap(cache);
+
+    m_last_events.reserve(lst_last.size());
+    for (last_events_t::iterator it = lst_last.begin(); it != lst_last.end(); ++it) {
+        m_last_events.push_back(move(it->second));
+    }
+    last_events_t().swap(lst_last);
+}
+
+
+void
+cache_reader::clear()
+{
+    m_events.clear();
+    event_serialized_lst_t().swap(m_last_events);
+    m_cursor = 0;
+    m_page_end = 0;
+}
+
+
+int
+cache_reader::ack(size_t cnt)
+{
+    int ret = -1;
+
+    /* Can only ack what is sent & not yet retired */
+    RET_ON_ERR((cnt >= m_cursor) && (cnt <= m_page_end),
+            "Invalid ack cnt=%zu cursor=%zu page_end=%zu", cnt, m_cursor, m_page_end);
+
+    m_cursor = cnt;
+    m_events.release((int)min(m_cursor, (size_t)m_events.size()));
+    ret = 0;
+out:
+    return ret;
+}
+
+
+int
+cache_reader::read_page(const event_serialized_lst_t &req,
+        event_serialized_lst_t &page)
+{
+    int ret = -1;
+    size_t fifo_cnt = m_events.size();
+    size_t bytes = 0;
+    size_t i;
+
+    if (req.empty()) {
+        /* Implicit ack of the last page sent */
+        RET_ON_ERR(ack(m_page_end) == 0, "Failed to ack");
+    }
+    else {
+        RET_ON_ERR(req.size() == 1, "Expect only one ack string %d",
+                (int)req.size());
+        bool valid = false;
+        size_t acked = 0;
+
+        /* Ack comes from the client; never let a bad one take eventd down */
+        try {
+            const auto &data = nlohmann::json::parse(*(req.begin()));
+            const auto it = data.find(CACHE_READ_ACK);
+            if ((it != data.end()) && it->is_number_unsigned()) {
+                acked = it->get<size_t>();
+                valid = true;
+            }
+        }
+        catch (exception &e)
+        {
+            SWSS_LOG_ERROR("Failed to parse ack string, e=(%s)\n", e.what());
+        }
+        RET_ON_ERR(valid, "Expect unsigned %s", CACHE_READ_ACK);
+        RET_ON_ERR(ack(acked) == 0, "Failed to ack");
+    }
+
+    page.clear();
+    for (i = m_cursor; (i < total()) && ((int)page.size() < READ_SET_SIZE); ++i) {
+        size_t sz = (i < fifo_cnt) ? m_events.get((int)i).size() :
+            m_last_events[i - fifo_cnt].size();
+
+        if (!page.empty() && ((bytes + sz) > READ_SET_BYTES)) {
+            break;
+        }
+        bytes += sz;
+        if (i < fifo_cnt) {
+            page.emplace_back(m_events.get((int)i));
+        }
+        else {
+            page.push_back(m_last_events[i - fifo_cnt]);
+        }
+    }
+    m_page_end = i;
+
+    if (page.empty()) {
+        /* All consumed; Release the cache */
+        clear();
+    }
+    ret = 0;
+out:
+    return ret;
+}
+
+
 static int
 process_options(stats_collector *stats, const event_serialized_lst_t &req_data,
         event_serialized_lst_t &resp_data)
@@ -643,13 +1222,13 @@ run_eventd_service()
 {
     int code = 0;
     int cache_max;
+    size_t cache_max_bytes;
     event_service service;
     stats_collector stats_instance;
     eventd_proxy *proxy = NULL;
     capture_service *capture = NULL;
 
-    event_serialized_lst_t capture_fifo_events;
-    last_events_t capture_last_events;
+    cache_reader capture_reader;
 
     SWSS_LOG_INFO("Eventd service starting\n");
 
@@ -659,6 +1238,10 @@ run_eventd_service()
     cache_max = get_config_data(string(CACHE_MAX_CNT), (int)MAX_CACHE_SIZE);
     RET_ON_ERR(cache_max > 0, "Failed to get CACHE_MAX_CNT");
 
+    cache_max_bytes = get_config_data(string(CACHE_MAX_BYTES),
+            (size_t)CACHE_MAX_BYTES_DEFAULT);
+    RET_ON_ERR(cache_max_bytes > 0, "Failed to get CACHE_MAX_BYTES");
+
     proxy = new eventd_proxy(zctx);
     RET_ON_ERR(proxy != NULL, "Failed to create proxy");
 
@@ -676,7 +1259,8 @@ run_eventd_service()
      * events until telemetry starts.
      * Telemetry will send a stop & collect cache upon startup
      */
-    capture = new capture_service(zctx, cache_max, &stats_instance);
+    capture = new capture_service(zctx, cache_max, &stats_instance,
+            cache_max_bytes);
     RET_ON_ERR(capture->set_control(INIT_CAPTURE) == 0, "Failed to init capture");
     RET_ON_ERR(capture->set_control(START_CAPTURE) == 0, "Failed to start capture");
 
@@ -696,10 +1280,10 @@ run_eventd_service()
                 if (capture != NULL) {
                     delete capture;
                 }
-                event_serialized_lst_t().swap(capture_fifo_events);
-                last_events_t().swap(capture_last_events);
+                capture_reader.clear();
 
-                capture = new capture_service(zctx, cache_max, &stats_instance);
+                capture = new capture_service(zctx, cache_max, &stats_instance,
+                        cache_max_bytes);
                 if (capture != NULL) {
                     resp = capture->set_control(INIT_CAPTURE);
                 }
@@ -727,9 +1311,12 @@ run_eventd_service()
                 }
                 resp = capture->set_control(STOP_CAPTURE);
                 if (resp == 0) {
+                    event_cache cache(0, 0);
+                    last_events_t last_events;
                     counters_t overflow;
-                    resp = capture->read_cache(capture_fifo_events, capture_last_events,
-                            overflow);
+
+                    resp = capture->read_cache(cache, last_events, overflow);
+                    capture_reader.reset(cache, last_events);
                 }
                 delete capture;
                 capture = NULL;
@@ -745,32 +1332,7 @@ run_eventd_service()
                     resp = -1;
                     break;
                 }
-                resp = 0;
-
-                if (capture_fifo_events.empty()) {
-                    for (last_events_t::iterator it = capture_last_events.begin();
-                            it != capture_last_events.end(); ++it) {
-                        capture_fifo_events.push_back(it->second);
-                    }
-                    last_events_t().swap(capture_last_events);
-                }
-
-                {
-                    int sz = VEC_SIZE(capture_fifo_events) < READ_SET_SIZE ?
-                        VEC_SIZE(capture_fifo_events) : READ_SET_SIZE;
-
-                    if (sz != 0) {
-                        auto it = std::next(capture_fifo_events.begin(), sz);
-                        move(capture_fifo_events.begin(), capture_fifo_events.end(),
-                                back_inserter(resp_data));
-
-                        if (sz == VEC_SIZE(capture_fifo_events)) {
-                            event_serialized_lst_t().swap(capture_fifo_events);
-                        } else {
-                            capture_fifo_events.erase(capture_fifo_events.begin(), it);
-                        }
-                    }
-                }
+                resp = capture_reader.read_page(req_data, resp_data);
                 break;
 
 
@@ -1,6 +1,9 @@
 /*
  * Header file for eventd daemon
  */
+#include <string_view>
+#include <mutex>
+#include <condition_variable>
 #include "table.h"
 #include "events_service.h"
 #include "events.h"
@@ -22,6 +25,73 @@ typedef enum {
 #define EVENTS_STATS_FIELD_NAME "value"
 #define STATS_HEARTBEAT_MIN 300
 
+/*
+ * Shards for counters. Each updating thread is assigned a shard, so
+ * that concurrent updates never contend on a cache line.
+ */
+#define STATS_SHARDS 4
+#define CACHE_LINE_SIZE 64
+
+/* Writer coalesces updates for a period that backs off between min & max */
+#define STATS_FLUSH_MIN_MS 10
+#define STATS_FLUSH_MAX_MS 1000
+
+/* Per source stats are tracked for upto these many sources */
+#define STATS_SOURCES_MAX 64
+
+/* Per source stats fields; Latency buckets are upper bound in millisecs */
+#define STATS_FIELD_PUBLISHED "published"
+#define STATS_FIELD_DROPPED "dropped"
+#define STATS_FIELD_LATENCY_PREFIX "latency_ms_le_"
+#define STATS_FIELD_LATENCY_OVER "latency_ms_over"
+
+typedef enum {
+    INDEX_LATENCY_1MS,
+    INDEX_LATENCY_10MS,
+    INDEX_LATENCY_100MS,
+    INDEX_LATENCY_1000MS,
+    INDEX_LATENCY_OVER,
+    LATENCY_BUCKETS_TOTAL
+} latency_bucket_index_t;
+
+typedef struct alignas(CACHE_LINE_SIZE) {
+    atomic<counters_t> val;
+} padded_counter_t;
+
+/*
+ * Stats per publisher source. Updated only by collector thread and read by
+ * writer, hence just atomic, w/o any need for padding.
+ */
+typedef struct {
+    atomic<counters_t> published;
+    atomic<counters_t> dropped;
+    atomic<counters_t> latency[LATENCY_BUCKETS_TOTAL];
+} source_stats_t;
+
+/* A point in time copy of source_stats_t */
+typedef struct {
+    counters_t published;
+    counters_t dropped;
+    counters_t latency[LATENCY_BUCKETS_TOTAL];
+} source_stats_snapshot_t;
+
+/* Config key for max bytes of event data held by capture cache */
+#ifndef CACHE_MAX_BYTES
+#define CACHE_MAX_BYTES "cache_max_bytes"
+#endif
+
+#define CACHE_MAX_BYTES_DEFAULT (100 * 1024 * 1024)
+
+/* Size of each slab allocated by event_cache */
+#define CACHE_SLAB_SIZE (1024 * 1024)
+
+/* Max count of events & bytes returned in each cache read */
+#define READ_SET_SIZE 100
+#define READ_SET_BYTES (64 * 1024)
+
+/* Optional cache read request to ack count of events consumed by client */
+#define CACHE_READ_ACK "CACHE_READ_ACK"
+
 /*
  *  Started by eventd_service.
  *  Creates XPUB & XSUB end points.
@@ -70,6 +140,7 @@ class stats_collector
         void stop() {
 
             m_shutdown = true;
+            m_cv_updated.notify_one();
 
             if (m_thr_collector.joinable()) {
                 m_thr_collector.join();
@@ -89,14 +160,23 @@ class stats_collector
         }
 
         counters_t read_counter(stats_counter_index_t index) {
+            counters_t val = 0;
+
             if (index != COUNTERS_EVENTS_TOTAL) {
-                return m_lst_counters[index];
-            }
-            else {
-                return 0;
+                for (int i = 0; i < STATS_SHARDS; ++i) {
+                    val += m_lst_counters[i][index].val.load(memory_order_relaxed);
+                }
             }
+            return val;
         }
 
+        /* Update stats of the source of received event */
+        void update_source_stats(const string &key, counters_t missed_cnt,
+                int64_t publish_epoch_ms);
+
+        /* Returns false, if source is not tracked */
+        bool read_source_stats(const string &source, source_stats_snapshot_t &stats);
+
         /* Sets heartbeat interval in milliseconds */
         void set_heartbeat_interval(int val_in_ms);
 
@@ -125,28 +205,59 @@ class stats_collector
     private:
         void _update_stats(stats_counter_index_t index, counters_t val) {
             if (index != COUNTERS_EVENTS_TOTAL) {
-                m_lst_counters[index] += val;
-                m_updated = true;
+                m_lst_counters[get_shard()][index].val.fetch_add(val,
+                        memory_order_relaxed);
+                _mark_updated();
             }
             else {
                 SWSS_LOG_ERROR("Internal code error. Invalid index=%d", index);
             }
         }
 
+        /* Wake writer, only for first update since last flush */
+        void _mark_updated() {
+            if (!m_updated.exchange(true)) {
+                m_cv_updated.notify_one();
+            }
+        }
+
+        int get_shard();
+
+        source_stats_t *get_source_stats(const string_view &source);
+
+        void write_stats();
+
         void run_collector();
 
         void run_writer();
 
         atomic<bool> m_updated;
+        mutex m_mutex_updated;
+        condition_variable m_cv_updated;
+
+        padded_counter_t m_lst_counters[STATS_SHARDS][COUNTERS_EVENTS_TOTAL];
+        atomic<int> m_shards_used;
+
+        /*
+         * Sources are added by collector thread only. Writer thread walks
+         * the map, hence insert & walk are protected by mutex. Updates
+         * to stats are lock free via atomics.
+         */
+        typedef map<string, unique_ptr<source_stats_t>, less<>> source_stats_map_t;
+        source_stats_map_t m_source_stats;
+        mutex m_mutex_sources;
 
-        counters_t m_lst_counters[COUNTERS_EVENTS_TOTAL];
+        /* Cache of last source looked up by collector */
+        string m_last_source;
+        source_stats_t *m_last_source_stats;
 
-        bool m_shutdown;
+        atomic<bool> m_shutdown;
 
         thread m_thr_collector;
         thread m_thr_writer;
 
         shared_ptr<swss::DBConnector> m_counters_db;
+        shared_ptr<swss::RedisPipeline> m_stats_pipeline;
         shared_ptr<swss::Table> m_stats_table;
 
         bool m_pause_heartbeat;
@@ -156,6 +267,101 @@ class stats_collector
         int m_heartbeats_interval_cnt;
 };
 
+/*
+ *  Store for events cached by capture service.
+ *
+ *  Events are saved as the raw serialized bytes, as received from capture
+ *  socket, packed back to back in slabs of CACHE_SLAB_SIZE. Slabs are
+ *  allocated on demand and total slab memory never exceeds max_bytes.
+ *  An event larger than a slab gets a slab of its own.
+ *
+ *  An index entry per event holds its location in slab along with runtime
+ *  id & sequence. Runtime IDs are interned, as a handful of publishers
+ *  produce all the events.
+ *
+ *  The cache is full, when either max count or max bytes is reached.
+ */
+class event_cache
+{
+    public:
+        event_cache(int max_cnt, size_t max_bytes=CACHE_MAX_BYTES_DEFAULT) :
+            m_max_cnt(max_cnt), m_max_bytes(max_bytes), m_slab_used(0),
+            m_alloc_bytes(0), m_released_slabs(0)
+        {}
+
+        /* Returns false, if event could not be added within limits */
+        bool add(const char *data, size_t len, const string_view &rid,
+                sequence_t seq);
+
+        bool add(const event_serialized_t &evt, const string_view &rid,
+                sequence_t seq) {
+            return add(evt.data(), evt.size(), rid, seq);
+        }
+
+        bool is_full() const {
+            return (size() >= m_max_cnt) || (m_alloc_bytes >= m_max_bytes);
+        }
+
+        int size() const { return (int)m_index.size(); }
+
+        bool empty() const { return m_index.empty(); }
+
+        /* Bytes allocated for event data */
+        size_t bytes() const { return m_alloc_bytes; }
+
+        string_view get(int i) const {
+            const cache_index_t &e = m_index[i];
+            return string_view(m_slabs[e.slab].get() + e.offset, e.len);
+        }
+
+        const runtime_id_t &get_runtime_id(int i) const {
+            return m_rids[m_index[i].rid];
+        }
+
+        sequence_t get_sequence(int i) const { return m_index[i].seq; }
+
+        /*
+         * Free slabs holding only events before index cnt, as those
+         * are no longer needed. Any get on them is invalid.
+         */
+        void release(int cnt);
+
+        void clear();
+
+        void swap(event_cache &other);
+
+    private:
+        typedef struct {
+            uint32_t slab;
+            uint32_t offset;
+            uint32_t len;
+            uint32_t rid;
+            sequence_t seq;
+        } cache_index_t;
+
+        uint32_t get_rid_index(const string_view &rid);
+
+        int m_max_cnt;
+        size_t m_max_bytes;
+
+        vector<unique_ptr<char[]>> m_slabs;
+        vector<size_t> m_slab_sizes;
+        size_t m_slab_used;
+        size_t m_alloc_bytes;
+        size_t m_released_slabs;
+
+        vector<cache_index_t> m_index;
+
+        vector<runtime_id_t> m_rids;
+        map<runtime_id_t, uint32_t, less<>> m_rid_ids;
+};
+
+/*
+ * Extracts runtime id & sequence from serialized event, w/o deserializing.
+ * Returns false, if not a valid event or not in expected format.
+ */
+bool scan_event(const char *data, size_t len, string_view &rid, sequence_t &seq);
+
 /*
  *  Capture/Cache service
  *
@@ -181,16 +387,15 @@ class stats_collector
  *  via thread.join().
  *
  *  Each event is 2 parts. It drops the first part, which is
- *  more for filtering events. It creates string from second part
- *  and saves it.
- *
- *  The string is the serialized version of internal_event_ref
+ *  more for filtering events. The second part, which is the serialized
+ *  version of internal_event_ref, is saved as is w/o deserializing.
+ *  Runtime id & sequence are scanned off the serialized bytes.
  *
  *  It keeps two sets of data
- *      1) List of all events received in vector in same order as received
- *      2) Map of last event from each runtime id upon list overflow max size.
+ *      1) event_cache of all events received in same order as received
+ *      2) Map of last event from each runtime id upon cache overflow.
  *
- *  We add to the vector as much as allowed by vector and max limit,
+ *  We add to the cache as much as allowed by max count and max bytes,
  *  whichever comes first.
  *
  *  The sequence number in internal event will help assess the missed count
@@ -208,9 +413,10 @@ typedef enum {
 class capture_service
 {
     public:
-        capture_service(void *ctx, int cache_max, stats_collector *stats) :
+        capture_service(void *ctx, int cache_max, stats_collector *stats,
+                size_t cache_max_bytes=CACHE_MAX_BYTES_DEFAULT) :
             m_ctx(ctx), m_stats_instance(stats), m_cap_run(false),
-            m_ctrl(NEED_INIT), m_cache_max(cache_max),
+            m_ctrl(NEED_INIT), m_events(cache_max, cache_max_bytes),
             m_last_events_init(false), m_total_missed_cache(0)
         {}
 
@@ -221,6 +427,10 @@ class capture_service
         int read_cache(event_serialized_lst_t &lst_fifo,
                 last_events_t &lst_last, counters_t &overflow_cnt);
 
+        /* Hands over the cache as is, w/o copying events */
+        int read_cache(event_cache &cache, last_events_t &lst_last,
+                counters_t &overflow_cnt);
+
     private:
         void init_capture_cache(const event_serialized_lst_t &lst);
         void do_capture();
@@ -234,9 +444,7 @@ class capture_service
         capture_control_t m_ctrl;
         thread m_thr;
 
-        int m_cache_max;
-
-        event_serialized_lst_t m_events;
+        event_cache m_events;
 
         last_events_t m_last_events;
         bool m_last_events_init;
@@ -249,6 +457,55 @@ class capture_service
 };
 
 
+/*
+ *  Serves cached events to EVENT_CACHE_READ requests, page by page.
+ *
+ *  The reader owns the cache handed over by capture service upon stop.
+ *  A server side cursor tracks the count of events consumed by client.
+ *  Each page is bounded by READ_SET_SIZE events & READ_SET_BYTES bytes,
+ *  but has at least one event.
+ *
+ *  The page sent is retired only upon ack. As REQ/REP channel is in
+ *  lock step, a read request is an implicit ack for the last page sent.
+ *  A client could also explicitly ack as {"CACHE_READ_ACK": <cnt>} with
+ *  count of events consumed so far, which enables resending the last page,
+ *  if client lost it.
+ *
+ *  Slabs that are fully acked are freed right away, so the memory held
+ *  only shrinks as client drains. Last events saved upon cache overflow
+ *  are served after all cached events.
+ *
+ *  An empty page indicates end of cache.
+ */
+class cache_reader
+{
+    public:
+        cache_reader() : m_events(0, 0), m_cursor(0), m_page_end(0) {}
+
+        /* Take over the given cache & last events */
+        void reset(event_cache &cache, last_events_t &lst_last);
+
+        void clear();
+
+        int read_page(const event_serialized_lst_t &req,
+                event_serialized_lst_t &page);
+
+        /* Count of events consumed */
+        size_t cursor() const { return m_cursor; }
+
+        size_t total() const { return m_events.size() + m_last_events.size(); }
+
+    private:
+        int ack(size_t cnt);
+
+        event_cache m_events;
+        event_serialized_lst_t m_last_events;
+
+        size_t m_cursor;
+        size_t m_page_end;
+};
+
+
 /*
  * Main server, that starts the zproxy service and honor
  * eventd service requests event_req_type_t
@@ -259,7 +516,7 @@ class capture_service
  *  capture_events thread. Upon cache stop command, close the handle
  *  which will stop the caching thread with read failure.
  *
- *  for cache read, returns the collected events in chunks.
+ *  for cache read, returns the collected events in pages via cache_reader.
  *
  */
 void run_eventd_service();
@@ -565,6 +565,209 @@ TEST(eventd, captureCacheMax)
     printf("Capture TEST with matchinhg cache-max completed\n");
 }
 
+TEST(eventd, eventCache)
+{
+    printf("Event cache TEST started\n");
+
+    event_serialized_lst_t evts;
+
+    for(int i=0; i < (int)ARRAY_SIZE(ldata); ++i) {
+        internal_event_t ev(create_ev(ldata[i]));
+        string evt_str;
+        string_view rid;
+        sequence_t seq;
+
+        serialize(ev, evt_str);
+
+        /* Scan must match deserialized values */
+        EXPECT_TRUE(scan_event(evt_str.data(), evt_str.size(), rid, seq));
+        EXPECT_EQ(ldata[i].rid, string(rid));
+        EXPECT_EQ(str_to_seq(ldata[i].seq), seq);
+
+        evts.push_back(evt_str);
+    }
+
+    {
+        /* Invalid events fail scan */
+        internal_event_t ev(create_ev(ldata[0]));
+        string evt_str, sub("\x01hello");
+        string_view rid;
+        sequence_t seq;
+
+        ev.erase(EVENT_SEQUENCE);
+        serialize(ev, evt_str);
+        EXPECT_FALSE(scan_event(evt_str.data(), evt_str.size(), rid, seq));
+        EXPECT_FALSE(scan_event(sub.data(), sub.size(), rid, seq));
+    }
+
+    {
+        /* Count limit */
+        event_cache cache(3);
+
+        for(int i=0; i < (int)evts.size(); ++i) {
+            string_view rid;
+            sequence_t seq;
+
+            EXPECT_TRUE(scan_event(evts[i].data(), evts[i].size(), rid, seq));
+            EXPECT_EQ(i < 3, cache.add(evts[i], rid, seq));
+        }
+        EXPECT_TRUE(cache.is_full());
+        EXPECT_EQ(3, cache.size());
+        for(int i=0; i < cache.size(); ++i) {
+            EXPECT_EQ(evts[i], string(cache.get(i)));
+            EXPECT_EQ(ldata[i].rid, cache.get_runtime_id(i));
+            EXPECT_EQ(str_to_seq(ldata[i].seq), cache.get_sequence(i));
+        }
+    }
+
+    {
+        /* Byte limit */
+        size_t max_bytes = evts[0].size() + evts[1].size();
+        event_cache cache((int)evts.size(), max_bytes);
+        int cnt = 0;
+
+        for(int i=0; i < (int)evts.size(); ++i) {
+            string_view rid;
+            sequence_t seq;
+
+            EXPECT_TRUE(scan_event(evts[i].data(), evts[i].size(), rid, seq));
+            if (cache.add(evts[i], rid, seq)) {
+                ++cnt;
+            }
+        }
+        EXPECT_EQ(cnt, cache.size());
+        EXPECT_LE(cache.bytes(), max_bytes);
+        EXPECT_TRUE(cache.is_full());
+        for(int i=0; i < cache.size(); ++i) {
+            EXPECT_EQ(evts[i], string(cache.get(i)));
+        }
+
+        cache.clear();
+        EXPECT_TRUE(cache.empty());
+        EXPECT_EQ(0, (int)cache.bytes());
+    }
+
+    printf("Event cache TEST completed\n");
+}
+
+TEST(eventd, cacheReader)
+{
+    printf("Cache reader TEST started\n");
+
+    event_serialized_lst_t evts, evts_read, req, page;
+    event_cache cache((int)ARRAY_SIZE(ldata));
+    last_events_t last_evts;
+    cache_reader reader;
+
+    for(int i=0; i < (int)ARRAY_SIZE(ldata); ++i) {
+        internal_event_t ev(create_ev(ldata[i]));
+        string evt_str;
+
+        serialize(ev, evt_str);
+        EXPECT_TRUE(cache.add(evt_str, ldata[i].rid, str_to_seq(ldata[i].seq)));
+        evts.push_back(evt_str);
+    }
+    last_evts["guid-9"] = evts[0];
+    evts.push_back(evts[0]);
+
+    reader.reset(cache, last_evts);
+    EXPECT_TRUE(cache.empty());
+    EXPECT_TRUE(last_evts.empty());
+    EXPECT_EQ(evts.size(), reader.total());
+
+    /* First page */
+    EXPECT_EQ(0, reader.read_page(req, page));
+    EXPECT_FALSE(page.empty());
+    evts_read.insert(evts_read.end(), page.begin(), page.end());
+
+    /* Resend of same page upon explicit ack of what is consumed so far */
+    req.push_back("{\"" CACHE_READ_ACK "\":0}");
+    EXPECT_EQ(0, reader.read_page(req, page));
+    EXPECT_EQ(evts_read, page);
+
+    /* Can't ack beyond what is sent */
+    req[0] = string("{\"" CACHE_READ_ACK "\":") + to_string(evts.size() + 1) + "}";
+    EXPECT_EQ(-1, reader.read_page(req, page));
+
+    /* Malformed or non-numeric acks are rejected, not thrown */
+    req[0] = "{\"" CACHE_READ_ACK "\":";
+    EXPECT_EQ(-1, reader.read_page(req, page));
+    req[0] = "{\"" CACHE_READ_ACK "\":\"1\"}";
+    EXPECT_EQ(-1, reader.read_page(req, page));
+    req[0] = "{\"" CACHE_READ_ACK "\":-1}";
+    EXPECT_EQ(-1, reader.read_page(req, page));
+    req[0] = "[1]";
+    EXPECT_EQ(-1, reader.read_page(req, page));
+
+    /* Drain the rest with implicit acks */
+    req.clear();
+    while (true) {
+        EXPECT_EQ(0, reader.read_page(req, page));
+        if (page.empty()) {
+            break;
+        }
+        evts_read.insert(evts_read.end(), page.begin(), page.end());
+    }
+    EXPECT_EQ(evts, evts_read);
+    EXPECT_EQ(0, (int)reader.total());
+
+    printf("Cache reader TEST completed\n");
+}
+
+
+TEST(eventd, cacheDrain)
+{
+    printf("Cache drain TEST started\n");
+
+    const int evt_cnt = 1000000;
+    event_cache cache(evt_cnt, (size_t)4 * 1024 * 1024 * 1024);
+    last_events_t last_evts;
+    cache_reader reader;
+    event_serialized_lst_t req, page;
+    vector<string> evts;
+    size_t read_cnt = 0, page_cnt = 0, max_page = 0;
+    bool in_order = true;
+
+    for(int i=0; i < (int)ARRAY_SIZE(ldata); ++i) {
+        string evt_str;
+        serialize(create_ev(ldata[i]), evt_str);
+        evts.push_back(evt_str);
+    }
+
+    for(int i=0; i < evt_cnt; ++i) {
+        const string &evt = evts[i % evts.size()];
+        EXPECT_TRUE(cache.add(evt, ldata[i % evts.size()].rid, i));
+    }
+    EXPECT_EQ(evt_cnt, cache.size());
+
+    reader.reset(cache, last_evts);
+
+    auto st = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+    while (true) {
+        EXPECT_EQ(0, reader.read_page(req, page));
+        if (page.empty()) {
+            break;
+        }
+        if (page[0] != evts[read_cnt % evts.size()]) {
+            in_order = false;
+        }
+        read_cnt += page.size();
+        max_page = max(max_page, page.size());
+        ++page_cnt;
+    }
+    auto en = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+
+    printf("Drained %zu events in %zu pages (max=%zu) in %ld ms\n",
+            read_cnt, page_cnt, max_page, (long)(en - st));
+
+    EXPECT_TRUE(in_order);
+    EXPECT_EQ(evt_cnt, (int)read_cnt);
+    EXPECT_LE((int)max_page, READ_SET_SIZE);
+
+    printf("Cache drain TEST completed\n");
+}
+
+
 TEST(eventd, service)
 {
     /*
@@ -868,6 +1071,21 @@ TEST(eventd, testDB)
     EXPECT_EQ((pub_count - cache_max - 1), stats_instance.read_counter(
                 INDEX_COUNTERS_EVENTS_MISSED_CACHE));
 
+    {
+        /* Per source stats */
+        source_stats_snapshot_t src_stats;
+        counters_t latency_cnt = 0;
+
+        EXPECT_TRUE(stats_instance.read_source_stats("test_db", src_stats));
+        EXPECT_EQ(pub_count, (int)src_stats.published);
+        EXPECT_EQ(0, (int)src_stats.dropped);
+        for (int i=0; i < LATENCY_BUCKETS_TOTAL; ++i) {
+            latency_cnt += src_stats.latency[i];
+        }
+        EXPECT_EQ(pub_count, (int)latency_cnt);
+        EXPECT_FALSE(stats_instance.read_source_stats("test_db_none", src_stats));
+    }
+
     events_deinit_publisher(pub_handle);
 
     for (int i=0; i < COUNTERS_EVENTS_TOTAL; ++i) {
@@ -911,6 +1129,16 @@ TEST(eventd, testDB)
 
     stats_instance.stop();
 
+    {
+        string key = string("COUNTERS_EVENTS:test_db");
+        unordered_map<string, string> m;
+
+        EXPECT_TRUE(db.exists(key));
+        m = db.hgetall(key);
+        EXPECT_EQ(to_string(pub_count), m[STATS_FIELD_PUBLISHED]);
+        EXPECT_EQ("0", m[STATS_FIELD_DROPPED]);
+    }
+
     delete pxy;
     delete pcap;
 
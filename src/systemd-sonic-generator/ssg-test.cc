@@ -6,6 +6,7 @@
  * Copyright (c) 2021 by Cisco Systems, Inc.
  *------------------------------------------------------------------
  */
+#include <chrono>
 #include <mutex>
 #include <string>
 #include <sys/stat.h>
@@ -413,6 +414,125 @@ SsgMainTest::common_dependency_list = {
     "Before=single_inst.service",
 };
 
+/*
+ * class SsgScaleTest
+ * Runs ssg_main on a large generated set of unit files, once unbatched
+ * as a baseline and once as shipped, and reports how long each takes.
+ */
+class SsgScaleTest : public SsgMainTest {
+  protected:
+    static const int num_scale_units = 200;
+    static const int num_scale_asics = 16;
+
+    /* Every fourth unit is a multi instance service template */
+    bool is_scale_template(int i) {
+        return (i % 4) == 0;
+    }
+
+    std::string scale_unit_name(int i) {
+        return "scale_" + std::to_string(i) +
+               (is_scale_template(i) ? "@.service" : ".service");
+    }
+
+    /* Writes the scale unit files and generated_services.conf */
+    void generate_scale_units() {
+        FILE* fp = fopen(TEST_CONFIG_FILE.c_str(), "w");
+        ASSERT_NE(fp, nullptr);
+        for (int i = 0; i < num_scale_units; ++i) {
+            std::string name = scale_unit_name(i);
+            fputs((name + "\n").c_str(), fp);
+
+            FILE* unit_fp = fopen((TEST_UNIT_FILE_PREFIX + name).c_str(), "w");
+            ASSERT_NE(unit_fp, nullptr);
+            fputs("[Unit]\n", unit_fp);
+            fprintf(unit_fp, "Description=Scale test service %d\n", i);
+            if (!is_scale_template(i)) {
+                /* Depend on the multi instance service of this group */
+                fprintf(unit_fp, "After=scale_%d.service\n", i - i % 4);
+            }
+            fputs("[Service]\n", unit_fp);
+            fputs("Type=oneshot\n", unit_fp);
+            fputs("ExecStart=/bin/true\n", unit_fp);
+            fputs("[Install]\n", unit_fp);
+            fputs("WantedBy=multi-user.target\n", unit_fp);
+            fprintf(unit_fp, "RequiredBy=scale-%d.target\n", i % 8);
+            fclose(unit_fp);
+        }
+        fclose(fp);
+    }
+
+    /* Runs ssg_main over the scale units and returns its run time */
+    std::chrono::microseconds ssg_main_scale_test(bool unbatched) {
+        FILE* fp;
+        std::vector<char*> argv_;
+        std::vector<std::string> arguments = {
+                    "ssg_main",
+                    TEST_OUTPUT_DIR.c_str()
+                };
+        std::string num_asic_str = "NUM_ASIC=" + std::to_string(num_scale_asics);
+
+        std::string unit_file_path = fs::current_path().string() + "/" +TEST_UNIT_FILE_PREFIX;
+        g_unit_file_prefix = unit_file_path.c_str();
+        g_config_file = TEST_CONFIG_FILE.c_str();
+        g_machine_config_file = TEST_MACHINE_CONF.c_str();
+        g_asic_conf_format = TEST_ASIC_CONF_FORMAT.c_str();
+
+        fp = fopen(TEST_ASIC_CONF.c_str(), "w");
+        EXPECT_NE(fp, nullptr);
+        fputs(num_asic_str.c_str(), fp);
+        fclose(fp);
+
+        for (const auto& arg : arguments) {
+            argv_.push_back((char*)arg.data());
+        }
+        argv_.push_back(nullptr);
+
+        g_ssg_unbatched = unbatched;
+        auto start = std::chrono::steady_clock::now();
+        EXPECT_EQ(ssg_main(argv_.size(), argv_.data()), 0);
+        auto end = std::chrono::steady_clock::now();
+        g_ssg_unbatched = false;
+
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    }
+
+    /* Validates the symlinks and dependencies generated for the scale units */
+    void validate_scale_units() {
+        for (int i = 0; i < num_scale_units; ++i) {
+            std::string name = scale_unit_name(i);
+            std::string required_by = "scale-" + std::to_string(i % 8) + ".target.requires";
+
+            if (is_scale_template(i)) {
+                std::string instance = "scale_" + std::to_string(i) + "@%1%.service";
+                validate_output_unit_files({instance}, "multi-user.target.wants",
+                    true, num_scale_asics);
+                validate_output_unit_files({instance}, required_by,
+                    true, num_scale_asics);
+            } else {
+                std::string dependency = "After=scale_" + std::to_string(i - i % 4) + "@%1%.service";
+                validate_output_unit_files({name}, "multi-user.target.wants",
+                    true, num_scale_asics);
+                validate_output_unit_files({name}, required_by,
+                    true, num_scale_asics);
+                validate_output_dependency_list({dependency}, name,
+                    true, num_scale_asics);
+            }
+        }
+    }
+
+    /* Starts over from freshly written unit files and an empty output dir */
+    void reset_scale_units() {
+        fs::remove_all(fs::path(TEST_OUTPUT_DIR.c_str()));
+        fs::create_directories(fs::path(TEST_OUTPUT_DIR.c_str()));
+        generate_scale_units();
+    }
+
+    virtual void SetUp() {
+        SsgMainTest::SetUp();
+        generate_scale_units();
+    }
+};
+
 /* Test get functions for global vasr*/
 TEST_F(SystemdSonicGeneratorFixture, get_global_vars) {
     EXPECT_EQ(g_unit_file_prefix, nullptr);
@@ -542,6 +662,22 @@ TEST_F(SsgMainTest, ssg_main_10_npu) {
 TEST_F(SsgMainTest, ssg_main_40_npu) {
     ssg_main_test(40);
 }
+
+/* TEST ssg_main() run time with 200 units on multi(16) asic */
+TEST_F(SsgScaleTest, ssg_main_200_units_16_npu) {
+    auto baseline = ssg_main_scale_test(true);
+    validate_scale_units();
+
+    reset_scale_units();
+    auto elapsed = ssg_main_scale_test(false);
+    validate_scale_units();
+
+    std::cout << "ssg_main installed " << num_scale_units << " units for "
+              << num_scale_asics << " asics in " << elapsed.count() << " us"
+              << " (unbatched baseline " << baseline.count() << " us)\n";
+    RecordProperty("ssg_main_baseline_usec", std::to_string(baseline.count()));
+    RecordProperty("ssg_main_usec", std::to_string(elapsed.count()));
+}
 }
 
 int main(int argc, char** argv) {
@@ -5,14 +5,18 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <linux/limits.h>
 
 #define MAX_NUM_TARGETS 48
 #define MAX_NUM_INSTALL_LINES 48
-#define MAX_NUM_UNITS 128
+#define MAX_NUM_UNITS 512
 #define MAX_BUF_SIZE 512
+#define NAME_HASH_SIZE 256
+#define MAX_INSTALL_THREADS 8
 
 const char* UNIT_FILE_PREFIX = "/usr/lib/systemd/system/";
 const char* CONFIG_FILE = "/etc/sonic/generated_services.conf";
@@ -39,9 +43,65 @@ const char* get_asic_conf_format() {
     return (g_asic_conf_format) ? g_asic_conf_format : ASIC_CONF_FORMAT;
 }
 
+/* Baseline for the scale test: read each unit file twice and create
+ * the symlinks one at a time, preparing the target directory for each
+ */
+bool g_ssg_unbatched = false;
+
+struct name_entry {
+    char* name;
+    struct name_entry* next;
+};
+
+struct unit_info {
+    /***
+    [Install] targets of a unit file, parsed once per generator run
+    ***/
+    char* unit_file;
+    int num_targets;
+    char* targets[MAX_NUM_TARGETS];
+    struct unit_info* next;
+};
+
+struct install_link {
+    char* unit;         // unit file the symlink points to
+    char* link_name;    // symlink name in the target directory
+};
+
+struct install_target {
+    /***
+    Symlinks to create in one target directory, e.g. multi-user.target.wants
+    ***/
+    char* name;
+    int num_links;
+    int max_links;
+    struct install_link* links;
+    struct install_target* next;
+};
+
 static int num_asics;
-static char** multi_instance_services;
+static struct name_entry* multi_inst_hash[NAME_HASH_SIZE];
 static int num_multi_inst;
+static struct unit_info* unit_cache[NAME_HASH_SIZE];
+static struct install_target* target_hash[NAME_HASH_SIZE];
+static struct install_target** install_targets;
+static int num_install_targets;
+static int next_install_target;
+static const char* install_root;
+
+
+static unsigned int hash_name(const char* name, size_t len) {
+    /***
+    FNV-1a hash of the first len characters of name
+    ***/
+    unsigned int hash = 2166136261u;
+
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash & (NAME_HASH_SIZE - 1);
+}
 
 void strip_trailing_newline(char* str) {
     /***
@@ -54,78 +114,53 @@ void strip_trailing_newline(char* str) {
 }
 
 
-static int get_target_lines(char* unit_file, char* target_lines[]) {
-    /***
-    Gets installation information for a given unit file
-
-    Returns lines in the [Install] section of a unit file
-    ***/
-    FILE *fp;
-    char *line = NULL;
-    size_t len = 0;
-    ssize_t nread;
-    bool found_install;
-    int num_target_lines;
-
-
-    fp = fopen(unit_file, "r");
+static bool is_multi_instance_service(const char *service_name){
+    /*
+     * The service name may contain @.service or .service. Remove these
+     * postfixes and extract service name. Compare service name for absolute
+     * match in the multi instance services.
+     * This is to prevent services like database-chassis and systemd-timesyncd marked
+     * as multi instance services as they contain strings 'database' and 'syncd' respectively
+     * which are multi instance services.
+     */
+    size_t len = strcspn(service_name, "@");
+    struct name_entry* entry;
 
-    if (fp == NULL) {
-        fprintf(stderr, "Failed to open file %s\n", unit_file);
-        return -1;
+    if (service_name[len] == '\0' && strstr(service_name, ".service") != NULL) {
+        /* service_name does not have '@' delimiter but contains '.service' */
+        len = strcspn(service_name, ".");
     }
 
-    found_install = false;
-    num_target_lines = 0;
-
-    while ((nread = getline(&line, &len, fp)) != -1 ) {
-        // Assumes that [Install] is the last section of the unit file
-        if (strstr(line, "[Install]") != NULL) {
-             found_install = true;
-        }
-        else if (found_install) {
-            if (num_target_lines >= MAX_NUM_INSTALL_LINES) {
-                fprintf(stderr, "Number of lines in [Install] section of %s exceeds MAX_NUM_INSTALL_LINES\n", unit_file);
-                fputs("Extra [Install] lines will be ignored\n", stderr);
-                break;
-            }
-            target_lines[num_target_lines] = strdup(line);
-            num_target_lines++;
+    for (entry = multi_inst_hash[hash_name(service_name, len)]; entry; entry = entry->next) {
+        if (strncmp(entry->name, service_name, len) == 0 && entry->name[len] == '\0') {
+            return true;
         }
     }
+    return false;
+}
 
-    free(line);
-
-    fclose(fp);
+static void add_multi_instance_service(const char *service_name, size_t len) {
+    struct name_entry* entry;
+    unsigned int bucket = hash_name(service_name, len);
 
-    return num_target_lines;
+    entry = malloc(sizeof(struct name_entry));
+    entry->name = strndup(service_name, len);
+    entry->next = multi_inst_hash[bucket];
+    multi_inst_hash[bucket] = entry;
+    num_multi_inst++;
 }
 
-static bool is_multi_instance_service(char *service_name){
-    int i;
-    for(i=0; i < num_multi_inst; i++){
-        /*
-         * The service name may contain @.service or .service. Remove these
-         * postfixes and extract service name. Compare service name for absolute
-         * match in multi_instance_services[].
-         * This is to prevent services like database-chassis and systemd-timesyncd marked
-         * as multi instance services as they contain strings 'database' and 'syncd' respectively
-         * which are multi instance services in multi_instance_services[].
-         */
-        char *saveptr;
-        char *token = strtok_r(service_name, "@", &saveptr);
-        if (token) {
-            if (strstr(token, ".service") != NULL) {
-                /* If we are here, service_name did not have '@' delimiter but contains '.service' */
-                token = strtok_r(service_name, ".", &saveptr);
-            }
-        }
-        if (strncmp(service_name, multi_instance_services[i], strlen(service_name)) == 0) {
-            return true;
+static void free_multi_instance_services() {
+    struct name_entry* entry;
+
+    for (int i = 0; i < NAME_HASH_SIZE; i++) {
+        while ((entry = multi_inst_hash[i])) {
+            multi_inst_hash[i] = entry->next;
+            free(entry->name);
+            free(entry);
         }
     }
-    return false;
-
+    num_multi_inst = 0;
 }
 
 static int get_install_targets_from_line(char* target_string, char* install_type, char* targets[], int existing_targets) {
@@ -174,13 +209,70 @@ static int get_install_targets_from_line(char* target_string, char* install_type
     return num_targets;
 }
 
-static void replace_multi_inst_dep(char *src) {
-    FILE *fp_src;
-    FILE *fp_tmp;
+static void parse_install_line(struct unit_info* info, const char* install_line) {
+    /***
+    Adds the targets of one line in the [Install] section of a unit file
+    ***/
+    char* line_copy;
+    char* line;
+    char* token;
+    char* target_suffix = NULL;
+    bool first = true;
+
+    line_copy = strdup(install_line);
+    line = line_copy;
+
+    while ((token = strtok_r(line, "=", &line))) {
+        if (first) {
+            first = false;
+
+            if (strstr(token, "RequiredBy") != NULL) {
+                target_suffix = ".requires";
+            }
+            else if (strstr(token, "WantedBy") != NULL) {
+                target_suffix = ".wants";
+            }
+        }
+        else if (target_suffix != NULL) {
+            info->num_targets += get_install_targets_from_line(token, target_suffix,
+                                                               info->targets, info->num_targets);
+        }
+    }
+    free(line_copy);
+}
+
+static void emit_unit_line(struct unit_info* info, FILE* fp_tmp, bool in_install,
+                           int* num_install_lines, const char* line) {
+    /***
+    Writes a line of the unit file being rewritten, and collects its
+    targets if it is in the [Install] section
+    ***/
+    if (fp_tmp)
+        fputs(line, fp_tmp);
+
+    if (!in_install)
+        return;
+
+    if (*num_install_lines >= MAX_NUM_INSTALL_LINES) {
+        if (*num_install_lines == MAX_NUM_INSTALL_LINES) {
+            fprintf(stderr, "Number of lines in [Install] section of %s exceeds MAX_NUM_INSTALL_LINES\n", info->unit_file);
+            fputs("Extra [Install] lines will be ignored\n", stderr);
+            (*num_install_lines)++;
+        }
+        return;
+    }
+    (*num_install_lines)++;
+    parse_install_line(info, line);
+}
+
+static void rewrite_multi_inst_dep_line(struct unit_info* info, FILE* fp_tmp, bool in_install,
+                                        int* num_install_lines, char* line) {
+    /***
+    Replaces a dependency on a multi instance service by a dependency
+    on each of its instances
+    ***/
     char buf[MAX_BUF_SIZE];
-    char* line = NULL;
     int i;
-    ssize_t len;
     char *token;
     char *word;
     char *line_copy;
@@ -188,9 +280,61 @@ static void replace_multi_inst_dep(char *src) {
     char *type;
     char *save_ptr1 = NULL;
     char *save_ptr2 = NULL;
+
+    line_copy = strdup(line);
+    token = strtok_r(line_copy, "=", &save_ptr1);
+    while ((word = strtok_r(NULL, " ", &save_ptr1))) {
+        if((strchr(word, '.') == NULL) ||
+           (strchr(word, '@') != NULL)) {
+            snprintf(buf, MAX_BUF_SIZE,"%s=%s\n",token, word);
+            emit_unit_line(info, fp_tmp, in_install, num_install_lines, buf);
+        } else {
+            service_name = strdup(word);
+            service_name = strtok_r(service_name, ".", &save_ptr2);
+            type = strtok_r(NULL, "\n", &save_ptr2);
+            if (is_multi_instance_service(word)) {
+                for(i = 0; i < num_asics; i++) {
+                    snprintf(buf, MAX_BUF_SIZE, "%s=%s@%d.%s\n",
+                            token, service_name, i, type);
+                    emit_unit_line(info, fp_tmp, in_install, num_install_lines, buf);
+                }
+            } else {
+                snprintf(buf, MAX_BUF_SIZE,"%s=%s.%s\n",token, service_name, type);
+                emit_unit_line(info, fp_tmp, in_install, num_install_lines, buf);
+            }
+            free(service_name);
+        }
+    }
+    free(line_copy);
+}
+
+static struct unit_info* parse_unit_file(const char* unit_file, bool rewrite) {
+    /***
+    Reads a unit file once and returns the targets of its [Install] section
+
+    On a multi ASIC platform, a unit that is not multi instance gets its
+    dependencies on multi instance services replaced in the same pass
+    if rewrite is set, and the targets are taken from the rewritten lines.
+    ***/
+    struct unit_info* info;
+    char file_path[PATH_MAX];
+    char tmp_file_path[PATH_MAX];
+    FILE *fp_src;
+    FILE *fp_tmp = NULL;
+    char *line = NULL;
+    size_t len = 0;
     ssize_t nread;
     bool section_done = false;
-    char tmp_file_path[PATH_MAX];
+    bool in_install = false;
+    int num_install_lines = 0;
+
+    snprintf(file_path, PATH_MAX, "%s%s", get_unit_file_prefix(), unit_file);
+
+    fp_src = fopen(file_path, "r");
+    if (fp_src == NULL) {
+        fprintf(stderr, "Failed to open file %s\n", file_path);
+        return NULL;
+    }
 
     /* Assumes that the service files has 3 sections,
      * in the order: Unit, Service and Install.
@@ -200,58 +344,102 @@ static void replace_multi_inst_dep(char *src) {
      * sections, replace if dependent on multi instance
      * service.
      */
-    fp_src = fopen(src, "r");
-    snprintf(tmp_file_path, PATH_MAX, "%s.tmp", src);
-    fp_tmp = fopen(tmp_file_path, "w");
+    if (rewrite && (num_asics > 1) && (!is_multi_instance_service(unit_file))) {
+        if (snprintf(tmp_file_path, PATH_MAX, "%s.tmp", file_path) >= PATH_MAX) {
+            fprintf(stderr, "Path too long for temporary file of %s\n", file_path);
+            fclose(fp_src);
+            return NULL;
+        }
+        fp_tmp = fopen(tmp_file_path, "w");
+        if (fp_tmp == NULL) {
+            fprintf(stderr, "Failed to open file %s\n", tmp_file_path);
+        }
+    }
+
+    info = calloc(1, sizeof(struct unit_info));
+    info->unit_file = strdup(unit_file);
 
     while ((nread = getline(&line, &len, fp_src)) != -1 ) {
         if ((strstr(line, "[Service]") != NULL) ||
             (strstr(line, "[Timer]") != NULL)) {
             section_done = true;
-            fputs(line,fp_tmp);
+            emit_unit_line(info, fp_tmp, in_install, &num_install_lines, line);
         } else if (strstr(line, "[Install]") != NULL) {
+            // Assumes that [Install] is the last section of the unit file
             section_done = false;
-            fputs(line,fp_tmp);
-        } else if ((strstr(line, "[Unit]") != NULL) ||
+            if (fp_tmp)
+                fputs(line, fp_tmp);
+            in_install = true;
+        } else if ((fp_tmp == NULL) ||
+           (strstr(line, "[Unit]") != NULL) ||
            (strstr(line, "Description") != NULL) ||
            (section_done == true)) {
-            fputs(line,fp_tmp);
+            emit_unit_line(info, fp_tmp, in_install, &num_install_lines, line);
         } else {
-            line_copy = strdup(line);
-            token = strtok_r(line_copy, "=", &save_ptr1);
-            while ((word = strtok_r(NULL, " ", &save_ptr1))) {
-                if((strchr(word, '.') == NULL) ||
-                   (strchr(word, '@') != NULL)) {
-                    snprintf(buf, MAX_BUF_SIZE,"%s=%s\n",token, word);
-                    fputs(buf,fp_tmp);
-                } else {
-                    service_name = strdup(word);
-                    service_name = strtok_r(service_name, ".", &save_ptr2);
-                    type = strtok_r(NULL, "\n", &save_ptr2);
-                    if (is_multi_instance_service(word)) {
-                        for(i = 0; i < num_asics; i++) {
-                            snprintf(buf, MAX_BUF_SIZE, "%s=%s@%d.%s\n",
-                                    token, service_name, i, type);
-                            fputs(buf,fp_tmp);
-                        }
-                    } else {
-                        snprintf(buf, MAX_BUF_SIZE,"%s=%s.%s\n",token, service_name, type);
-                        fputs(buf, fp_tmp);
-                    }
-                    free(service_name);
-                }
-            }
-            free(line_copy);
+            rewrite_multi_inst_dep_line(info, fp_tmp, in_install, &num_install_lines, line);
         }
     }
-    fclose(fp_src);
-    fclose(fp_tmp);
+
     free(line);
-    /* remove the .service file, rename the .service.tmp file
-     * as .service.
-     */
-    remove(src);
-    rename(tmp_file_path, src);
+    fclose(fp_src);
+
+    if (fp_tmp) {
+        fclose(fp_tmp);
+        /* remove the .service file, rename the .service.tmp file
+         * as .service.
+         */
+        remove(file_path);
+        rename(tmp_file_path, file_path);
+    }
+
+    return info;
+}
+
+static struct unit_info* get_unit_info(const char* unit_file) {
+    /***
+    Returns the cached [Install] targets of a unit file, parsing it on first use
+    ***/
+    unsigned int bucket = hash_name(unit_file, strlen(unit_file));
+    struct unit_info* info;
+
+    for (info = unit_cache[bucket]; info; info = info->next) {
+        if (strcmp(info->unit_file, unit_file) == 0)
+            return info;
+    }
+
+    info = parse_unit_file(unit_file, true);
+    if (info == NULL)
+        return NULL;
+
+    if (g_ssg_unbatched) {
+        // Rewrite pass first, then read the targets from the rewritten file
+        for (int i = 0; i < info->num_targets; i++)
+            free(info->targets[i]);
+        free(info->unit_file);
+        free(info);
+
+        info = parse_unit_file(unit_file, false);
+        if (info == NULL)
+            return NULL;
+    }
+
+    info->next = unit_cache[bucket];
+    unit_cache[bucket] = info;
+    return info;
+}
+
+static void free_unit_cache() {
+    struct unit_info* info;
+
+    for (int i = 0; i < NAME_HASH_SIZE; i++) {
+        while ((info = unit_cache[i])) {
+            unit_cache[i] = info->next;
+            for (int j = 0; j < info->num_targets; j++)
+                free(info->targets[j]);
+            free(info->unit_file);
+            free(info);
+        }
+    }
 }
 
 int get_install_targets(char* unit_file, char* targets[]) {
@@ -261,61 +449,18 @@ int get_install_targets(char* unit_file, char* targets[]) {
     Parses the information in the [Install] section of a given
     unit file to determine which directories to install the unit in
     ***/
-    char file_path[PATH_MAX];
-    char *target_lines[MAX_NUM_INSTALL_LINES];
-    int num_target_lines;
-    int num_targets;
-    int found_targets;
-    char* token;
-    char* line = NULL;
-    bool first;
-    char* target_suffix;
-    char *instance_name;
-    char *dot_ptr;
+    struct unit_info* info;
 
-    strcpy(file_path, get_unit_file_prefix());
-    strcat(file_path, unit_file);
-
-    instance_name = strdup(unit_file);
-    dot_ptr = strchr(instance_name, '.');
-    *dot_ptr = '\0';
-
-    if((num_asics > 1) && (!is_multi_instance_service(instance_name))) {
-        replace_multi_inst_dep(file_path);
-    }
-    free(instance_name);
-
-    num_target_lines = get_target_lines(file_path, target_lines);
-    if (num_target_lines < 0) {
+    info = get_unit_info(unit_file);
+    if (info == NULL) {
         fprintf(stderr, "Error parsing targets for %s\n", unit_file);
         return -1;
     }
 
-    num_targets = 0;
+    for (int i = 0; i < info->num_targets; i++)
+        targets[i] = strdup(info->targets[i]);
 
-    for (int i = 0; i < num_target_lines; i++) {
-        line = target_lines[i];
-        first = true;
-
-        while ((token = strtok_r(line, "=", &line))) {
-            if (first) {
-                first = false;
-
-                if (strstr(token, "RequiredBy") != NULL) {
-                    target_suffix = ".requires";
-                }
-                else if (strstr(token, "WantedBy") != NULL) {
-                    target_suffix = ".wants";
-                }
-            }
-            else {
-                found_targets = get_install_targets_from_line(token, target_suffix, targets, num_targets);
-                num_targets += found_targets;
-            }
-        }
-        free(target_lines[i]);
-    }
-    return num_targets;
+    return info->num_targets;
 }
 
 
@@ -338,9 +483,7 @@ int get_unit_files(char* unit_files[]) {
     }
 
     int num_unit_files = 0;
-    num_multi_inst = 0;
-
-    multi_instance_services = calloc(MAX_NUM_UNITS, sizeof(char *));
+    free_multi_instance_services();
 
     while ((read = getline(&line, &len, fp)) != -1) {
         if (num_unit_files >= MAX_NUM_UNITS) {
@@ -352,9 +495,7 @@ int get_unit_files(char* unit_files[]) {
         /* Get the multi-instance services */
         pos = strchr(line, '@');
         if (pos != NULL) {
-            multi_instance_services[num_multi_inst] = calloc(strlen(line), sizeof(char));
-            strncpy(multi_instance_services[num_multi_inst], line, pos-line);
-            num_multi_inst++;
+            add_multi_instance_service(line, pos - line);
         }
 
         /* topology service to be started only for multiasic VS platform */
@@ -405,31 +546,97 @@ char* insert_instance_number(char* unit_file, int instance) {
 }
 
 
-static int create_symlink(char* unit, char* target, char* install_dir, int instance) {
-    struct stat st;
-    char src_path[PATH_MAX];
-    char dest_path[PATH_MAX];
-    char final_install_dir[PATH_MAX];
-    char* unit_instance;
-    int r;
+static void queue_symlink(char* unit, char* target, int instance) {
+    /***
+    Records a symlink to create in a target directory
+
+    Symlinks are grouped by target directory so each directory is
+    prepared once, however many units are installed in it
+    ***/
+    struct install_target* t;
+    struct install_link* link;
+    unsigned int bucket = hash_name(target, strlen(target));
 
-    strcpy(src_path, get_unit_file_prefix());
-    strcat(src_path, unit);
+    for (t = target_hash[bucket]; t; t = t->next) {
+        if (strcmp(t->name, target) == 0)
+            break;
+    }
+
+    if (t == NULL) {
+        t = calloc(1, sizeof(struct install_target));
+        t->name = strdup(target);
+        t->next = target_hash[bucket];
+        target_hash[bucket] = t;
+
+        install_targets = realloc(install_targets, (num_install_targets + 1) * sizeof(struct install_target*));
+        install_targets[num_install_targets++] = t;
+    }
 
+    if (t->num_links == t->max_links) {
+        t->max_links = t->max_links ? 2 * t->max_links : 16;
+        t->links = realloc(t->links, t->max_links * sizeof(struct install_link));
+    }
+
+    link = &t->links[t->num_links++];
+    link->unit = strdup(unit);
     if (instance < 0) {
-        unit_instance = strdup(unit);
+        link->link_name = strdup(unit);
+    }
+    else {
+        link->link_name = insert_instance_number(unit, instance);
+    }
+}
+
+
+static int install_unit_file(char* unit_file, char* target) {
+    /***
+    Queues the symlinks for a unit file installation
+
+    For a given unit file and target directory,
+    queue the appropriate symlink in the target directory
+    to enable the unit and have it started by Systemd
+
+    If a multi ASIC platform is detected, enables multi-instance
+    services as well
+    ***/
+    char* target_instance;
+
+    assert(unit_file);
+    assert(target);
+
+
+    if ((num_asics > 1) && strstr(unit_file, "@") != NULL) {
+
+        for (int i = 0; i < num_asics; i++) {
+
+            if (strstr(target, "@") != NULL) {
+                target_instance = insert_instance_number(target, i);
+            }
+            else {
+                target_instance = strdup(target);
+            }
+
+            if (target_instance == NULL) {
+                fprintf(stderr, "Error installing %s for target %s\n", unit_file, target);
+                continue;
+            }
+
+            queue_symlink(unit_file, target_instance, i);
+            free(target_instance);
+
+        }
     }
     else {
-        unit_instance = insert_instance_number(unit, instance);
+        queue_symlink(unit_file, target, -1);
     }
 
-    strcpy(final_install_dir, install_dir);
-    strcat(final_install_dir, target);
-    strcpy(dest_path, final_install_dir);
-    strcat(dest_path, "/");
-    strcat(dest_path, unit_instance);
+    return 0;
+}
 
-    free(unit_instance);
+
+static int prepare_target_dir(const char* final_install_dir) {
+    struct stat st;
+    int r;
 
     if (stat(final_install_dir, &st) == -1) {
         // If doesn't exist, create
@@ -462,66 +669,147 @@ static int create_symlink(char* unit, char* target, char* install_dir, int insta
         }
     }
 
-    r = symlink(src_path, dest_path);
+    return 0;
+}
 
-    if (r < 0) {
-        if (errno == EEXIST)
-            return 0;
-        fprintf(stderr, "Error creating symlink %s from source %s\n", dest_path, src_path);
-        return -1;
+
+static void create_target_symlinks(struct install_target* t) {
+    /***
+    Prepares a target directory and creates all of its queued symlinks
+    ***/
+    char src_path[PATH_MAX];
+    char final_install_dir[PATH_MAX];
+    int dir_fd;
+    int r;
+
+    snprintf(final_install_dir, PATH_MAX, "%s%s", install_root, t->name);
+
+    if (prepare_target_dir(final_install_dir) < 0) {
+        for (int i = 0; i < t->num_links; i++)
+            fprintf(stderr, "Error installing %s for target %s\n", t->links[i].unit, t->name);
+        return;
     }
 
-    return 0;
+    dir_fd = open(final_install_dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) {
+        fprintf(stderr, "Unable to open target directory %s\n", final_install_dir);
+        return;
+    }
+
+    for (int i = 0; i < t->num_links; i++) {
+        if (t->links[i].link_name == NULL)
+            continue;
+
+        snprintf(src_path, PATH_MAX, "%s%s", get_unit_file_prefix(), t->links[i].unit);
 
+        r = symlinkat(src_path, dir_fd, t->links[i].link_name);
+        if (r < 0 && errno != EEXIST) {
+            fprintf(stderr, "Error creating symlink %s/%s from source %s\n",
+                    final_install_dir, t->links[i].link_name, src_path);
+            fprintf(stderr, "Error installing %s for target %s\n", t->links[i].unit, t->name);
+        }
+    }
+
+    close(dir_fd);
 }
 
 
-static int install_unit_file(char* unit_file, char* target, char* install_dir) {
-    /***
-    Creates a symlink for a unit file installation
+static void create_target_symlinks_unbatched(struct install_target* t) {
+    char src_path[PATH_MAX];
+    char final_install_dir[PATH_MAX];
+    char dest_path[PATH_MAX];
 
-    For a given unit file and target directory,
-    create the appropriate symlink in the target directory
-    to enable the unit and have it started by Systemd
+    snprintf(final_install_dir, PATH_MAX, "%s%s", install_root, t->name);
 
-    If a multi ASIC platform is detected, enables multi-instance
-    services as well
-    ***/
-    char* target_instance;
-    char* prefix;
-    char* suffix;
-    int r;
+    for (int i = 0; i < t->num_links; i++) {
+        if (t->links[i].link_name == NULL)
+            continue;
 
-    assert(unit_file);
-    assert(target);
+        if (prepare_target_dir(final_install_dir) < 0) {
+            fprintf(stderr, "Error installing %s for target %s\n", t->links[i].unit, t->name);
+            continue;
+        }
 
+        snprintf(src_path, PATH_MAX, "%s%s", get_unit_file_prefix(), t->links[i].unit);
+        snprintf(dest_path, PATH_MAX, "%s/%s", final_install_dir, t->links[i].link_name);
 
-    if ((num_asics > 1) && strstr(unit_file, "@") != NULL) {
+        if (symlink(src_path, dest_path) < 0 && errno != EEXIST) {
+            fprintf(stderr, "Error creating symlink %s from source %s\n", dest_path, src_path);
+            fprintf(stderr, "Error installing %s for target %s\n", t->links[i].unit, t->name);
+        }
+    }
+}
 
-        for (int i = 0; i < num_asics; i++) {
 
-            if (strstr(target, "@") != NULL) {
-                target_instance = insert_instance_number(target, i);
-            }
-            else {
-                target_instance = strdup(target);
-            }
+static void* install_worker(void* arg) {
+    int i;
 
-            r = create_symlink(unit_file, target_instance, install_dir, i);
-            if (r < 0)
-                fprintf(stderr, "Error installing %s for target %s\n", unit_file, target_instance);
+    (void)arg;
+    while ((i = __atomic_fetch_add(&next_install_target, 1, __ATOMIC_RELAXED)) < num_install_targets) {
+        create_target_symlinks(install_targets[i]);
+    }
+    return NULL;
+}
 
-            free(target_instance);
 
-        }
+static void install_queued_units(const char* install_dir) {
+    /***
+    Creates the queued symlinks, one target directory at a time per thread
+
+    Target directories are independent of each other, so they are
+    spread over a small pool of threads
+    ***/
+    pthread_t threads[MAX_INSTALL_THREADS];
+    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int num_threads = MAX_INSTALL_THREADS;
+    int started = 0;
+
+    install_root = install_dir;
+    next_install_target = 0;
+
+    if (g_ssg_unbatched) {
+        for (int i = 0; i < num_install_targets; i++)
+            create_target_symlinks_unbatched(install_targets[i]);
+        return;
     }
-    else {
-        r = create_symlink(unit_file, target, install_dir, -1);
-        if (r < 0)
-            fprintf(stderr, "Error installing %s for target %s\n", unit_file, target);
+
+    if (num_cpus > 0 && num_cpus < num_threads)
+        num_threads = num_cpus;
+    if (num_install_targets < num_threads)
+        num_threads = num_install_targets;
+
+    if (num_threads > 1) {
+        for (started = 0; started < num_threads; started++) {
+            if (pthread_create(&threads[started], NULL, install_worker, NULL) != 0)
+                break;
+        }
     }
 
-    return 0;
+    // Picks up whatever the threads have not, or everything if none started
+    install_worker(NULL);
+
+    for (int i = 0; i < started; i++)
+        pthread_join(threads[i], NULL);
+}
+
+
+static void free_install_targets() {
+    struct install_target* t;
+
+    for (int i = 0; i < num_install_targets; i++) {
+        t = install_targets[i];
+        for (int j = 0; j < t->num_links; j++) {
+            free(t->links[j].unit);
+            free(t->links[j].link_name);
+        }
+        free(t->links);
+        free(t->name);
+        free(t);
+    }
+    free(install_targets);
+    install_targets = NULL;
+    num_install_targets = 0;
+    memset(target_hash, 0, sizeof(target_hash));
 }
 
 
@@ -600,6 +888,8 @@ int ssg_main(int argc, char **argv) {
     }
 
     num_asics = get_num_of_asic();
+    free_unit_cache();
+    free_install_targets();
     strcpy(install_dir, argv[1]);
     strcat(install_dir, "/");
     num_unit_files = get_unit_files(unit_files);
@@ -627,7 +917,7 @@ int ssg_main(int argc, char **argv) {
         }
 
         for (int j = 0; j < num_targets; j++) {
-            if (install_unit_file(unit_instance, targets[j], install_dir) != 0)
+            if (install_unit_file(unit_instance, targets[j]) != 0)
                 fprintf(stderr, "Error installing %s to target directory %s\n", unit_instance, targets[j]);
 
             free(targets[j]);
@@ -637,10 +927,11 @@ int ssg_main(int argc, char **argv) {
         free(unit_files[i]);
     }
 
-    for (int i = 0; i < num_multi_inst; i++) {
-        free(multi_instance_services[i]);
-    }
-    free(multi_instance_services);
+    install_queued_units(install_dir);
+
+    free_install_targets();
+    free_unit_cache();
+    free_multi_instance_services();
 
     return 0;
 }
@@ -19,6 +19,7 @@ extern const char* g_unit_file_prefix;
 extern const char* g_config_file;
 extern const char* g_machine_config_file;
 extern const char* g_asic_conf_format;
+extern bool g_ssg_unbatched;
 
 /* C-functions under test */
 extern const char* get_unit_file_prefix();
@@ -0,0 +1,1123 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <pwd.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <syslog.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Remote user gecos prefix, which been assigned by nss_tacplus */
+#define REMOTE_USER_GECOS_PREFIX      "remote_user"
+
+/* Default value for getpwnam */
+#define DEFAULT_GETPWENT_SIZE_MAX     4096
+
+/* User classification cache slot count, must be power of 2 */
+#define USER_CACHE_SIZE               16
+
+/* Return value for is_local_user method */
+#define IS_LOCAL_USER              0
+#define IS_REMOTE_USER             1
+#define ERROR_CHECK_LOCAL_USER     2
+
+/* Tacacs+ lib */
+#include <libtac/libtac.h>
+
+/* Tacacs+ support lib */
+#include <libtac/support.h>
+
+/* Output syslog to mock method when build with UT */
+#if defined (BASH_PLUGIN_UT)
+#define syslog mock_syslog
+#define getpwnam_r mock_getpwnam_r
+#define connect mock_connect
+#endif
+
+/* Tacacs+ log format */
+#define  TACACS_LOG_FORMAT "TACACS+: %s"
+
+/* Tacacs+ config file timestamp string format */
+#define  CONFIG_FILE_TIME_STAMP_FORMAT "%d.%m.%Y %H:%M:%S"
+
+/* Tacacs+ config file timestamp string length */
+#define  CONFIG_FILE_TIME_STAMP_LEN  100
+
+/*
+    Convert log to a string because va args resoursive issue:
+    http://www.c-faq.com/varargs/handoff.html
+*/
+#define GENERATE_LOG_FROM_VA(logBufferName)                 \
+    char logBufferName[512];                                \
+    va_list args;                                           \
+    va_start(args, format);                                 \
+    vsnprintf(logBufferName, sizeof(logBufferName), format, args);  \
+    va_end(args);
+
+/* Authorization cache slot count, must be power of 2 */
+#define AUTHORIZATION_CACHE_SIZE      64
+
+/* Max slots probed for a cache key */
+#define AUTHORIZATION_CACHE_PROBE     8
+
+/* Max length of user, command and arguments kept as cache key */
+#define AUTHORIZATION_CACHE_KEY_LEN   512
+
+/*
+    Authorization cache setting in plugin config file, cache disabled when
+    the option is missing or not positive.
+*/
+#define AUTHORIZATION_CACHE_TTL_OPTION "authorization_cache_ttl="
+
+/* Config file path */
+const char *tacacs_config_file = "/etc/tacplus_nss.conf";
+
+/* Plugin config file path */
+const char *plugin_config_file = "/etc/bash_tacplus.conf";
+
+/* Local user database, remote users are added here by nss_tacplus */
+const char *passwd_file = "/etc/passwd";
+
+/* Unknown user name */
+const char *unknown_username = "UNKNOWN";
+
+
+/* Config file attribute */
+struct stat config_file_attr;
+
+/* Tacacs server config data */
+typedef struct {
+    struct addrinfo *address;
+    const char *key;
+} tacacs_server_t;
+
+/* Tacacs control flag */
+int tacacs_ctrl;
+
+/* Cached positive authorization result */
+typedef struct {
+    uint64_t hash;
+    time_t expire;
+    int key_len;
+    char key[AUTHORIZATION_CACHE_KEY_LEN];
+} authorization_cache_entry_t;
+
+/*
+    Positive authorization cache.
+    Commands are authorized in the child forked by bash for each command,
+    so the cache is mapped shared by the parent shell in plugin_init and
+    every child of the session sees the same entries.
+    This is a per-session latency optimization only, not a security boundary:
+    the mapping is writable by every process of the login session, so a
+    command run by the user can add entries for that session. It never
+    outlives the shell, and entries are dropped when the tacacs servers,
+    keys or vrf change.
+*/
+typedef struct {
+    pthread_mutex_t lock;
+    int ttl;
+    uint64_t server_config_hash;
+    unsigned long hits;
+    unsigned long misses;
+    authorization_cache_entry_t entries[AUTHORIZATION_CACHE_SIZE];
+} authorization_cache_t;
+
+/* Authorization cache, NULL when disabled */
+authorization_cache_t *authorization_cache;
+
+/* Cached is_local_user result */
+typedef struct {
+    char name[LOGIN_NAME_MAX];
+    int result;
+} user_cache_entry_t;
+
+/*
+    User classification cache.
+    Filled by plugin_init in the shell process, so commands forked from the
+    shell inherit the classification of the login user.
+*/
+user_cache_entry_t user_cache[USER_CACHE_SIZE];
+
+/* passwd file modify time when user cache filled */
+struct timespec user_cache_mtime;
+
+/* Authorization result from one tacacs server */
+typedef enum {
+    SERVER_PENDING = 0,
+    SERVER_CONNECT_FAILED,
+    SERVER_CONNECTED,
+    SERVER_SKIPPED,
+    SERVER_DONE
+} server_state_t;
+
+typedef struct authorization_race authorization_race_t;
+
+/* Per server worker context */
+typedef struct {
+    authorization_race_t *race;
+    int server_idx;
+} authorization_worker_t;
+
+/*
+    Connections raced against all tacacs servers for one authorization request.
+    Workers only connect, the request is sent by the calling thread in the
+    order the servers connected, because libtac keeps the key and session of
+    the request in globals. Workers which connect after the request decided
+    close their connection, and the last reference frees the race.
+*/
+struct authorization_race {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int refcount;
+    int pending;
+    int decided;
+    int connected_count;
+    int connected[TAC_PLUS_MAXSERVERS];
+    int fd[TAC_PLUS_MAXSERVERS];
+    server_state_t state[TAC_PLUS_MAXSERVERS];
+    int error[TAC_PLUS_MAXSERVERS];
+    authorization_worker_t workers[TAC_PLUS_MAXSERVERS];
+};
+
+/*
+ * Output error message.
+ */
+void output_error(const char *format, ...)
+{
+    GENERATE_LOG_FROM_VA(logBuffer);
+
+    if (tacacs_ctrl & PAM_TAC_DEBUG) {
+        fprintf(stderr, TACACS_LOG_FORMAT, logBuffer);
+    }
+
+    syslog(LOG_ERR, TACACS_LOG_FORMAT, logBuffer);
+}
+
+/*
+ * Output debug message.
+ */
+void output_debug(const char *format, ...)
+{
+    if ((tacacs_ctrl & PAM_TAC_DEBUG) == 0) {
+        return;
+    }
+
+    GENERATE_LOG_FROM_VA(logBuffer);
+    fprintf(stderr, TACACS_LOG_FORMAT, logBuffer);
+    syslog(LOG_DEBUG, TACACS_LOG_FORMAT, logBuffer);
+}
+
+
+/*
+ * Send authorization message.
+ * This method based on send_auth_msg in https://github.com/daveolson53/tacplus-auth/blob/master/tacplus-auth.c
+ */
+int send_authorization_message(
+    int tac_fd,
+    const char *user,
+    const char *tty,
+    const char *host,
+    uint16_t taskid,
+    const char *cmd,
+    char **args,
+    int argc)
+{
+    char buf[128];
+    struct tac_attrib *attr;
+    int retval;
+    struct areply re;
+    int i;
+
+    attr=(struct tac_attrib *)xcalloc(1, sizeof(struct tac_attrib));
+
+    snprintf(buf, sizeof buf, "%hu", taskid);
+    tac_add_attrib(&attr, "task_id", buf);
+    tac_add_attrib(&attr, "protocol", "ssh");
+    tac_add_attrib(&attr, "service", "shell");
+
+    tac_add_attrib(&attr, "cmd", (char*)cmd);
+
+    for(i=1; i<argc; i++) {
+        // TACACS protocol allow max 255 bytes per argument. 'cmd-arg' will take 7 bytes.
+        char tbuf[248];
+        const char *arg;
+        if(strlen(args[i]) >= sizeof(tbuf)) {
+            snprintf(tbuf, sizeof tbuf, "%s", args[i]);
+            arg = tbuf;
+        }
+        else {
+            arg = args[i];
+        }
+
+        tac_add_attrib(&attr, "cmd-arg", (char *)arg);
+    }
+
+    re.msg = NULL;
+    output_debug("send authorizatiom message with user: %s, tty: %s, host: %s\n", user, tty, host);
+    retval = tac_author_send(tac_fd, (char *)user, (char *)tty, (char *)host, attr);
+    output_debug("authorization result: %d\n", retval);
+
+    if(retval < 0) {
+        output_error("send of authorization message failed: %s\n", strerror(errno));
+    }
+    else {
+        retval = tac_author_read(tac_fd, &re);
+        if (retval < 0) {
+            output_debug("authorization response failed: %d\n", retval);
+        }
+        else if(re.status == AUTHOR_STATUS_PASS_ADD ||
+                    re.status == AUTHOR_STATUS_PASS_REPL) {
+            retval = 0;
+        }
+        else  {
+            output_debug("command not authorized (%d)\n", re.status);
+            retval = 1;
+        }
+    }
+
+    tac_free_attrib(&attr);
+    if(re.msg != NULL) {
+        free(re.msg);
+    }
+
+    return retval;
+}
+
+/*
+ * Build authorization cache key from user, command and arguments.
+ * Returns key length, or -1 when the key is too long to be cached.
+ */
+int build_authorization_cache_key(char *key, const char *user, const char *cmd, char **args, int argc)
+{
+    int key_len = 0;
+    int i;
+
+    // fields are separated by '\0', which can't be part of a field.
+    const char *field = user;
+    for (i=-1; i<argc; i++) {
+        if (i == 0) {
+            field = cmd;
+        }
+        else if (i > 0) {
+            field = args[i];
+        }
+
+        int field_len = strlen(field) + 1;
+        if (key_len + field_len > AUTHORIZATION_CACHE_KEY_LEN) {
+            return -1;
+        }
+
+        memcpy(key + key_len, field, field_len);
+        key_len += field_len;
+    }
+
+    return key_len;
+}
+
+/*
+ * FNV-1a hash of data, continue from hash.
+ */
+uint64_t hash_authorization_cache_data(uint64_t hash, const void *data, int data_len)
+{
+    const unsigned char *bytes = data;
+    int i;
+    for (i=0; i<data_len; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/*
+ * FNV-1a hash of authorization cache key.
+ */
+uint64_t hash_authorization_cache_key(const char *key, int key_len)
+{
+    return hash_authorization_cache_data(14695981039346656037ULL, key, key_len);
+}
+
+/*
+ * Hash of tacacs server addresses, keys and vrf, authorization cache is only valid for one server config.
+ */
+uint64_t hash_tacacs_server_config()
+{
+    uint64_t hash = 14695981039346656037ULL;
+    int server_idx;
+    for (server_idx = 0; server_idx < tac_srv_no; server_idx++) {
+        struct addrinfo *address = tac_srv[server_idx].addr;
+        if (address && address->ai_addr) {
+            hash = hash_authorization_cache_data(hash, address->ai_addr, address->ai_addrlen);
+        }
+
+        hash = hash_authorization_cache_data(hash, tac_srv[server_idx].key, strlen(tac_srv[server_idx].key) + 1);
+    }
+
+    if (__vrfname) {
+        hash = hash_authorization_cache_data(hash, __vrfname, strlen(__vrfname) + 1);
+    }
+
+    return hash;
+}
+
+/*
+ * Get monotonic time in seconds.
+ */
+time_t get_monotonic_seconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec;
+}
+
+/*
+ * Lock authorization cache.
+ */
+void lock_authorization_cache()
+{
+    if (pthread_mutex_lock(&authorization_cache->lock) == EOWNERDEAD) {
+        // a child exited while holding the lock, entries are still consistent.
+        pthread_mutex_consistent(&authorization_cache->lock);
+    }
+
+    uint64_t server_config_hash = hash_tacacs_server_config();
+    if (authorization_cache->server_config_hash != server_config_hash) {
+        // tacacs servers changed, drop all authorization result.
+        memset(authorization_cache->entries, 0, sizeof(authorization_cache->entries));
+        authorization_cache->server_config_hash = server_config_hash;
+    }
+}
+
+/*
+ * Check authorization cache, return 0 when command authorized before.
+ */
+int check_authorization_cache(const char *key, int key_len, uint64_t hash)
+{
+    int result = 1;
+    int i;
+    time_t now = get_monotonic_seconds();
+
+    lock_authorization_cache();
+    for (i=0; i<AUTHORIZATION_CACHE_PROBE; i++) {
+        authorization_cache_entry_t *entry = &authorization_cache->entries[(hash + i) & (AUTHORIZATION_CACHE_SIZE - 1)];
+        if (entry->hash == hash
+            && entry->key_len == key_len
+            && entry->expire > now
+            && memcmp(entry->key, key, key_len) == 0) {
+            result = 0;
+            break;
+        }
+    }
+
+    if (result == 0) {
+        authorization_cache->hits++;
+    }
+    else {
+        authorization_cache->misses++;
+    }
+
+    output_debug("authorization cache %s, hits: %lu, misses: %lu\n", result ? "miss" : "hit", authorization_cache->hits, authorization_cache->misses);
+    pthread_mutex_unlock(&authorization_cache->lock);
+
+    return result;
+}
+
+/*
+ * Add authorized command to authorization cache.
+ */
+void update_authorization_cache(const char *key, int key_len, uint64_t hash)
+{
+    authorization_cache_entry_t *victim = NULL;
+    int i;
+    time_t now = get_monotonic_seconds();
+
+    lock_authorization_cache();
+    for (i=0; i<AUTHORIZATION_CACHE_PROBE; i++) {
+        authorization_cache_entry_t *entry = &authorization_cache->entries[(hash + i) & (AUTHORIZATION_CACHE_SIZE - 1)];
+        if (entry->hash == hash
+            && entry->key_len == key_len
+            && memcmp(entry->key, key, key_len) == 0) {
+            victim = entry;
+            break;
+        }
+
+        // replace the entry expire first
+        if (victim == NULL || entry->expire < victim->expire) {
+            victim = entry;
+        }
+    }
+
+    victim->hash = hash;
+    victim->key_len = key_len;
+    memcpy(victim->key, key, key_len);
+    victim->expire = now + authorization_cache->ttl;
+    pthread_mutex_unlock(&authorization_cache->lock);
+}
+
+/*
+ * Get authorization cache hit count.
+ */
+unsigned long get_authorization_cache_hits()
+{
+    return authorization_cache ? authorization_cache->hits : 0;
+}
+
+/*
+ * Get authorization cache miss count.
+ */
+unsigned long get_authorization_cache_misses()
+{
+    return authorization_cache ? authorization_cache->misses : 0;
+}
+
+/*
+ * Initialize authorization cache, ttl is cache entry lifetime in seconds.
+ */
+int initialize_authorization_cache(int ttl)
+{
+    pthread_mutexattr_t attr;
+
+    if (ttl <= 0 || authorization_cache != NULL) {
+        return 0;
+    }
+
+    authorization_cache = mmap(NULL, sizeof(authorization_cache_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (authorization_cache == MAP_FAILED) {
+        output_error("failed to allocate authorization cache: %s\n", strerror(errno));
+        authorization_cache = NULL;
+        return -1;
+    }
+
+    // the lock is shared by all commands forked from current shell.
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&authorization_cache->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    authorization_cache->ttl = ttl;
+    authorization_cache->server_config_hash = hash_tacacs_server_config();
+    output_debug("authorization cache enabled, ttl: %d\n", ttl);
+    return 0;
+}
+
+/*
+ * Release authorization cache.
+ */
+void release_authorization_cache()
+{
+    if (authorization_cache == NULL) {
+        return;
+    }
+
+    pthread_mutex_destroy(&authorization_cache->lock);
+    munmap(authorization_cache, sizeof(authorization_cache_t));
+    authorization_cache = NULL;
+}
+
+/*
+ * Load authorization cache ttl from plugin config file.
+ */
+int load_authorization_cache_ttl()
+{
+    char line[256];
+    int ttl = 0;
+    FILE *config_file = fopen(plugin_config_file, "r");
+    if (config_file == NULL) {
+        // authorization cache disabled by default.
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), config_file)) {
+        if (strncmp(line, AUTHORIZATION_CACHE_TTL_OPTION, strlen(AUTHORIZATION_CACHE_TTL_OPTION)) == 0) {
+            ttl = atoi(line + strlen(AUTHORIZATION_CACHE_TTL_OPTION));
+        }
+    }
+
+    fclose(config_file);
+    return ttl;
+}
+
+/*
+ * Release authorization race reference, caller must hold race lock.
+ */
+void release_authorization_race(authorization_race_t *race)
+{
+    race->refcount--;
+    if (race->refcount) {
+        pthread_mutex_unlock(&race->lock);
+        return;
+    }
+
+    pthread_mutex_unlock(&race->lock);
+    pthread_cond_destroy(&race->cond);
+    pthread_mutex_destroy(&race->lock);
+    free(race);
+}
+
+/*
+ * Connect to tacacs server.
+ * Same as tac_connect_single, except the tac_secret and tac_encryption globals
+ * of libtac are not changed, so it's safe to connect from multiple threads.
+ */
+int connect_tacacs_server(const struct addrinfo *server, struct addrinfo *srcaddr, int timeout, const char *iface)
+{
+    int fd, flags, rc, error;
+    socklen_t len;
+    struct pollfd pfd;
+
+    fd = socket(server->ai_family, server->ai_socktype, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    // do not fail if the bind to interface fails, connection may still succeed.
+    if (iface && setsockopt(fd, SOL_SOCKET, SO_BINDTODEVICE, iface, strlen(iface) + 1) < 0) {
+        output_debug("Binding socket to device %s failed\n", iface);
+    }
+
+    if (srcaddr && bind(fd, srcaddr->ai_addr, srcaddr->ai_addrlen) < 0) {
+        goto failed;
+    }
+
+    flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        goto failed;
+    }
+
+    rc = connect(fd, server->ai_addr, server->ai_addrlen);
+    if (rc < 0 && errno == EINPROGRESS) {
+        pfd.fd = fd;
+        pfd.events = POLLOUT;
+        do {
+            rc = poll(&pfd, 1, timeout > 0 ? timeout * 1000 : -1);
+        } while (rc < 0 && errno == EINTR);
+
+        if (rc == 0) {
+            errno = ETIMEDOUT;
+            rc = -1;
+        }
+        else if (rc > 0) {
+            len = sizeof(error);
+            if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0) {
+                rc = -1;
+            }
+            else if (error) {
+                errno = error;
+                rc = -1;
+            }
+            else {
+                rc = 0;
+            }
+        }
+    }
+
+    if (rc < 0 || fcntl(fd, F_SETFL, flags) < 0) {
+        goto failed;
+    }
+
+    return fd;
+
+failed:
+    error = errno;
+    close(fd);
+    errno = error;
+    return -1;
+}
+
+/*
+ * Connect to one tacacs server for authorization race.
+ */
+void *authorization_worker(void *arg)
+{
+    authorization_worker_t *worker = (authorization_worker_t *)arg;
+    authorization_race_t *race = worker->race;
+    int server_idx = worker->server_idx;
+
+    int server_fd = connect_tacacs_server(tac_srv[server_idx].addr, tac_source_addr, tac_timeout, __vrfname);
+    int error = errno;
+
+    pthread_mutex_lock(&race->lock);
+    if (server_fd < 0) {
+        race->state[server_idx] = SERVER_CONNECT_FAILED;
+        race->error[server_idx] = error;
+    }
+    else if (race->decided) {
+        // command already authorized by other server.
+        race->state[server_idx] = SERVER_SKIPPED;
+        close(server_fd);
+    }
+    else {
+        race->state[server_idx] = SERVER_CONNECTED;
+        race->fd[server_idx] = server_fd;
+        race->connected[race->connected_count++] = server_idx;
+    }
+
+    race->pending--;
+    pthread_cond_broadcast(&race->cond);
+    release_authorization_race(race);
+    return NULL;
+}
+
+/*
+ * Send tacacs authorization request.
+ * This method based on send_tacacs_auth in https://github.com/daveolson53/tacplus-auth/blob/master/tacplus-auth.c
+ * All servers are connected in parallel, the request is sent to the connected servers until any server authorized it.
+ */
+int tacacs_authorization(
+    const char *user,
+    const char *tty,
+    const char *host,
+    const char *cmd,
+    char **args,
+    int argc)
+{
+    int result = 1, server_idx, server_fd, connected_idx = 0, connected_servers=0;
+    uint16_t task_id = (uint16_t)getpid();
+    server_state_t state[TAC_PLUS_MAXSERVERS];
+    int server_result[TAC_PLUS_MAXSERVERS];
+    int server_error[TAC_PLUS_MAXSERVERS];
+    char cache_key[AUTHORIZATION_CACHE_KEY_LEN];
+    int cache_key_len = -1;
+    uint64_t cache_hash = 0;
+    pthread_attr_t thread_attr;
+    pthread_t thread;
+
+    if (authorization_cache) {
+        cache_key_len = build_authorization_cache_key(cache_key, user, cmd, args, argc);
+        if (cache_key_len > 0) {
+            cache_hash = hash_authorization_cache_key(cache_key, cache_key_len);
+            if (check_authorization_cache(cache_key, cache_key_len, cache_hash) == 0) {
+                output_debug("%s authorized from authorization cache\n", cmd);
+                return 0;
+            }
+        }
+    }
+
+    authorization_race_t *race = (authorization_race_t *)calloc(1, sizeof(authorization_race_t));
+    if (race == NULL) {
+        output_error("Failed to allocate authorization request for %s\n", cmd);
+        return -1;
+    }
+
+    pthread_mutex_init(&race->lock, NULL);
+    pthread_cond_init(&race->cond, NULL);
+    race->refcount = tac_srv_no + 1;
+    race->pending = tac_srv_no;
+
+    pthread_attr_init(&thread_attr);
+    pthread_attr_setdetachstate(&thread_attr, PTHREAD_CREATE_DETACHED);
+    for(server_idx = 0; server_idx < tac_srv_no; server_idx++) {
+        race->workers[server_idx].race = race;
+        race->workers[server_idx].server_idx = server_idx;
+        if (pthread_create(&thread, &thread_attr, authorization_worker, &race->workers[server_idx])) {
+            // can't create thread, connect this server in current thread.
+            authorization_worker(&race->workers[server_idx]);
+        }
+    }
+    pthread_attr_destroy(&thread_attr);
+
+    // send request to servers in connected order, until any server authorized command or all servers finished.
+    pthread_mutex_lock(&race->lock);
+    while (!race->decided) {
+        if (connected_idx == race->connected_count) {
+            if (race->pending == 0) {
+                break;
+            }
+
+            pthread_cond_wait(&race->cond, &race->lock);
+            continue;
+        }
+
+        server_idx = race->connected[connected_idx++];
+        server_fd = race->fd[server_idx];
+        pthread_mutex_unlock(&race->lock);
+
+        // key and session of the request are libtac globals, only this thread set and use them.
+        tac_secret = tac_srv[server_idx].key;
+        tac_encryption = tac_srv[server_idx].key[0] ? 1 : 0;
+        server_result[server_idx] = send_authorization_message(server_fd, user, tty, host, task_id, cmd, args, argc);
+        close(server_fd);
+
+        pthread_mutex_lock(&race->lock);
+        race->state[server_idx] = SERVER_DONE;
+        if (server_result[server_idx] == 0) {
+            race->decided = 1;
+        }
+    }
+
+    // servers connected after command authorized are not requested.
+    race->decided = 1;
+    while (connected_idx < race->connected_count) {
+        server_idx = race->connected[connected_idx++];
+        race->state[server_idx] = SERVER_SKIPPED;
+        close(race->fd[server_idx]);
+    }
+
+    memcpy(state, race->state, sizeof(state));
+    memcpy(server_error, race->error, sizeof(server_error));
+    release_authorization_race(race);
+
+    for(server_idx = 0; server_idx < tac_srv_no; server_idx++) {
+        if (state[server_idx] == SERVER_CONNECT_FAILED) {
+            // connect to tacacs server failed
+            output_error("Failed to connecting to %s to request authorization for %s: %s\n", tac_ntop(tac_srv[server_idx].addr->ai_addr), cmd, strerror(server_error[server_idx]));
+            continue;
+        }
+
+        if (state[server_idx] != SERVER_DONE) {
+            continue;
+        }
+
+        // increase connected servers
+        connected_servers++;
+        if(server_result[server_idx]) {
+            // authorization failed
+            output_debug("%s not authorized from %s\n", cmd, tac_ntop(tac_srv[server_idx].addr->ai_addr));
+            if (result) {
+                result = server_result[server_idx];
+            }
+        }
+        else {
+            // authorization successed
+            output_debug("%s authorized from %s\n", cmd, tac_ntop(tac_srv[server_idx].addr->ai_addr));
+            result = 0;
+        }
+    }
+
+    // can't connect to any server
+    if(!connected_servers) {
+        result = -2;
+        output_error("Failed to connect to TACACS server(s)\n");
+    }
+
+    if (result == 0 && cache_key_len > 0) {
+        update_authorization_cache(cache_key, cache_key_len, cache_hash);
+    }
+
+    return result;
+}
+
+/*
+ * Send authorization request.
+ * This method based on build_auth_req in https://github.com/daveolson53/tacplus-auth/blob/master/tacplus-auth.c
+ */
+int authorization_with_host_and_tty(const char *user, const char *cmd, char **argv, int argc)
+{
+    // try get host name
+    char hostname[64];
+    memset(&hostname, 0, sizeof(hostname));
+
+    (void)gethostname(hostname, sizeof(hostname) -1);
+    if (!hostname[0]) {
+        snprintf(hostname, sizeof(hostname), "UNK");
+        output_error("Failed to determine hostname, passing %s\n", hostname);
+    }
+
+    // try get tty name
+    char ttyname[64];
+    memset(&ttyname, 0, sizeof(ttyname));
+
+    int i;
+    for(i=0; i<3; i++) {
+        int result;
+        if (isatty(i)) {
+            result = ttyname_r(i, ttyname, sizeof(ttyname) -1);
+            if (result) {
+                output_error("Failed to get tty name for fd %d: %s\n", i, strerror(result));
+            }
+            break;
+        }
+    }
+
+    if (!ttyname[0]) {
+        snprintf(ttyname, sizeof(ttyname), "UNK");
+        output_error("Failed to determine tty, passing %s\n", ttyname);
+    }
+
+    // send tacacs authorization request
+    return tacacs_authorization(user, ttyname, hostname, cmd, argv, argc);
+}
+
+/*
+ * Load tacacs config.
+ */
+void load_tacacs_config()
+{
+    // load config file: tacacs_config_file
+    tacacs_ctrl = parse_config_file (tacacs_config_file);
+
+    output_debug("tacacs config updated:\n");
+    int server_idx;
+    for(server_idx = 0; server_idx < tac_srv_no; server_idx++) {
+        output_debug("Server %d, address:%s, key length:%d\n", server_idx, tac_ntop(tac_srv[server_idx].addr->ai_addr),strlen(tac_srv[server_idx].key));
+    }
+
+    output_debug("TACACS+ control flag: 0x%x\n", tacacs_ctrl);
+
+    if (tacacs_ctrl & AUTHORIZATION_FLAG_TACACS) {
+        output_debug("TACACS+ per-command authorization enabled.\n");
+    }
+
+    if (tacacs_ctrl & AUTHORIZATION_FLAG_LOCAL) {
+        output_debug("Local per-command authorization enabled.\n");
+    }
+
+    if (tacacs_ctrl & PAM_TAC_DEBUG) {
+        output_debug("TACACS+ debug enabled.\n");
+    }
+}
+
+/*
+ * Load tacacs config.
+ */
+void check_and_load_changed_tacacs_config()
+{
+    struct stat attr;
+    // get config file stat, check if file changed
+    stat(tacacs_config_file, &attr);
+    char date[CONFIG_FILE_TIME_STAMP_LEN];
+    strftime(date, sizeof(date), CONFIG_FILE_TIME_STAMP_FORMAT, localtime(&(attr.st_mtime)));
+    if (difftime(attr.st_mtime, config_file_attr.st_mtime) == 0) {
+        output_debug("tacacs config file not change: last modified time: %s.\n", date);
+        return;
+    }
+
+    output_debug("tacacs config file changed: last modified time: %s.\n", date);
+
+    // config file changed, update file stat and reload config.
+    config_file_attr = attr;
+
+    // load config file
+    load_tacacs_config();
+}
+
+int is_local_user(char *user);
+char* get_user_name(char *user);
+
+/*
+ * Tacacs plugin initialization.
+ */
+void plugin_init()
+{
+    // get config file stat, will use this to check config file changed
+    stat(tacacs_config_file, &config_file_attr);
+
+    // load config file: tacacs_config_file
+    load_tacacs_config();
+
+    // authorization cache shared by all commands run from current shell, off unless enabled in plugin config.
+    initialize_authorization_cache(load_authorization_cache_ttl());
+
+    // classify login user once, commands forked from current shell inherit the result.
+    is_local_user(get_user_name(NULL));
+
+    output_debug("tacacs plugin initialized.\n");
+}
+
+/*
+ * Tacacs plugin release.
+ */
+void plugin_uninit()
+{
+    output_debug("tacacs plugin un-initialize.\n");
+
+    release_authorization_cache();
+}
+
+/*
+ * Get user classification cache slot.
+ */
+user_cache_entry_t *get_user_cache_entry(const char *user)
+{
+    unsigned int hash = 2166136261u;
+    const char *c;
+    for (c=user; *c; c++) {
+        hash ^= (unsigned char)*c;
+        hash *= 16777619u;
+    }
+
+    return &user_cache[hash & (USER_CACHE_SIZE - 1)];
+}
+
+/*
+ * Check user classification cache, drop cache when passwd file changed.
+ */
+int check_user_cache(const char *user, struct timespec *mtime)
+{
+    struct stat attr;
+    if (stat(passwd_file, &attr) != 0) {
+        output_debug("failed to get %s stat: %s\n", passwd_file, strerror(errno));
+        return ERROR_CHECK_LOCAL_USER;
+    }
+
+    *mtime = attr.st_mtim;
+    if (mtime->tv_sec != user_cache_mtime.tv_sec || mtime->tv_nsec != user_cache_mtime.tv_nsec) {
+        memset(user_cache, 0, sizeof(user_cache));
+        user_cache_mtime = *mtime;
+        return ERROR_CHECK_LOCAL_USER;
+    }
+
+    user_cache_entry_t *entry = get_user_cache_entry(user);
+    if (strcmp(entry->name, user) != 0) {
+        return ERROR_CHECK_LOCAL_USER;
+    }
+
+    return entry->result;
+}
+
+/*
+ * Check if current user is local user.
+ */
+int is_local_user(char *user)
+{
+    if (user == unknown_username) {
+        // for unknown user name, when tacacs enabled, always authorization with tacacs.
+        return IS_REMOTE_USER;
+    }
+
+    struct timespec mtime = {0, 0};
+    int result = check_user_cache(user, &mtime);
+    if (result != ERROR_CHECK_LOCAL_USER) {
+        output_debug("user: %s is %s user, from user cache.\n", user, result == IS_REMOTE_USER ? "remote" : "local");
+        return result;
+    }
+
+    struct passwd pwd;
+    struct passwd *ppwd = NULL;
+    char buf[DEFAULT_GETPWENT_SIZE_MAX];
+    int pwdresult = getpwnam_r(user, &pwd, buf, sizeof(buf), &ppwd);
+    if (pwdresult || ppwd == NULL) {
+        output_error("get user information user failed, user: %s not found\n", user);
+        return ERROR_CHECK_LOCAL_USER;
+    }
+
+    // compare passwd entry, for remote user pw_gecos will start as 'remote_user'
+    if (strncmp(ppwd->pw_gecos, REMOTE_USER_GECOS_PREFIX, strlen(REMOTE_USER_GECOS_PREFIX)) == 0) {
+        output_debug("user: %s, UID: %d, GECOS: %s is remote user.\n", user, ppwd->pw_uid, ppwd->pw_gecos);
+        result = IS_REMOTE_USER;
+    }
+    else {
+        output_debug("user: %s, UID: %d, GECOS: %s is local user.\n", user, ppwd->pw_uid, ppwd->pw_gecos);
+        result = IS_LOCAL_USER;
+    }
+
+    // only cache the result when passwd file stat available.
+    if ((mtime.tv_sec || mtime.tv_nsec) && strlen(user) < LOGIN_NAME_MAX) {
+        user_cache_entry_t *entry = get_user_cache_entry(user);
+        snprintf(entry->name, sizeof(entry->name), "%s", user);
+        entry->result = result;
+    }
+
+    return result;
+}
+
+/*
+ * Get user name.
+ */
+char* get_user_name(char *user)
+{
+    if (user != NULL && strlen(user) != 0) {
+        return user;
+    }
+
+    // uid is the real user id: https://man7.org/linux/man-pages/man2/geteuid.2.html
+    output_debug("Login user name is empty, try get user name by euid.\n");
+    uid_t uid = getuid();
+    struct passwd* userwd = getpwuid(uid);
+    if (userwd != NULL && userwd->pw_name != NULL) {
+        return userwd->pw_name;
+    }
+
+    // euid is the effective user name, may not match real user id: https://man7.org/linux/man-pages/man2/geteuid.2.html
+    output_debug("Login user name is empty, try get user name by euid.\n");
+    uid_t euid = geteuid();
+    struct passwd* euserwd = getpwuid(euid);
+    if (euserwd != NULL && euserwd->pw_name != NULL) {
+        return euserwd->pw_name;
+    }
+
+    // if can't find user name by both euid or ruid, return UNKNOWN.
+    return unknown_username;
+}
+
+/*
+ * Tacacs authorization.
+ */
+int on_shell_execve (char *user, int shell_level, char *cmd, char **argv)
+{
+    char* user_namd = get_user_name(user);
+    output_debug("Authorization parameters:\n");
+    output_debug("    Shell level: %d\n", shell_level);
+    output_debug("    Current user: %s\n", user_namd);
+    output_debug("    Command full path: %s\n", cmd);
+    output_debug("    Parameters:\n");
+    char **parameter_array_pointer = argv;
+    int argc = 0;
+    while (*parameter_array_pointer != NULL) {
+        // output parameter
+        output_debug("        %s\n", *parameter_array_pointer);
+
+        // move to next parameter
+        parameter_array_pointer++;
+        argc++;
+    }
+
+    if (shell_level > 2) {
+        // when shell_level > 1, it's a recursive command in shell script.
+        output_debug("Recursive command %s ignored.\n", cmd);
+        return 0;
+    }
+
+    // reload config file when tacacs config changed
+    check_and_load_changed_tacacs_config();
+
+    int check_local_user_result = is_local_user(user_namd);
+    if (check_local_user_result != IS_REMOTE_USER) {
+        /*
+            Return 0 to check with linux permission control in following 2 scenario:
+                1: ERROR_CHECK_LOCAL_USER: check if user is local user failed because can't get user information.
+                        In this case, as failback, check with linux permission control.
+                2: IS_LOCAL_USER: user login as local user.
+                        In this case, tacacs authorization disabled for local user.
+        */
+        output_debug("ignore TACACS+ authorization for current user, check with local permission.\n");
+        return 0;
+    }
+
+    if (tacacs_ctrl & AUTHORIZATION_FLAG_TACACS) {
+        output_debug("start TACACS+ authorization for command %s with given arguments\n", cmd);
+        int ret = authorization_with_host_and_tty(user_namd, cmd, argv, argc);
+        switch (ret) {
+            case 0:
+            break;
+            case -2:
+                // -2 means no servers, so not authorized
+                fprintf(stdout, "%s not authorized by TACACS+ with given arguments, not executing\n", cmd);
+            break;
+            default:
+                fprintf(stdout, "%s authorize failed by TACACS+ with given arguments, not executing\n", cmd);
+            break;
+        }
+
+        if ((tacacs_ctrl & AUTHORIZATION_FLAG_LOCAL) == 0) {
+            // when local authorization disabled, tacacs authorization failed will block user from run current command
+            output_debug("local authorization disabled, TACACS+ authorization result: %d\n", ret);
+            return ret;
+        }
+    }
+
+    // return 0, so bash will continue run user command and will check user permission with linux permission check.
+    output_debug("start local authorization for command %s with given arguments\n", cmd);
+    return 0;
+}